@@ -85,7 +85,8 @@ let package = Package(
       sources: [
         "src/lib/",
         "src/util/",
-        "src/xxhash/"
+        "src/xxhash/",
+        "src/thread/"
       ],
       cSettings: [
         .headerSearchPath("."),
@@ -94,7 +95,9 @@ let package = Package(
         .headerSearchPath("src/util"),
         .headerSearchPath("src/valgrind"),
         .headerSearchPath("src/xxhash"),
-        .define("HAVE_CONFIG_H")
+        .headerSearchPath("src/thread"),
+        .define("HAVE_CONFIG_H"),
+        .define("FY_NO_BLAKE3")
       ]
     ),
     .target(
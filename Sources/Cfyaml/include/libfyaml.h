@@ -61,6 +61,8 @@ struct fy_path_exec;
 struct fy_path_component;
 struct fy_path;
 struct fy_document_iterator;
+struct fy_thread_pool;
+struct fy_document_builder;
 
 
 #ifndef FY_BIT
@@ -465,6 +467,34 @@ enum fy_scalar_style {
 	FYSS_MAX,
 };
 
+/**
+ * enum fy_node_style - Node style
+ *
+ * A node may contain a hint of how it should be
+ * rendered, encoded as a style.
+ *
+ * @FYNS_ANY: No hint, let the emitter decide
+ * @FYNS_FLOW: Prefer flow style (for sequence/mappings)
+ * @FYNS_BLOCK: Prefer block style (for sequence/mappings)
+ * @FYNS_PLAIN: Plain style preferred
+ * @FYNS_SINGLE_QUOTED: Single quoted style preferred
+ * @FYNS_DOUBLE_QUOTED: Double quoted style preferred
+ * @FYNS_LITERAL: Literal style preferred (valid in block context)
+ * @FYNS_FOLDED: Folded style preferred (valid in block context)
+ * @FYNS_ALIAS: It's an alias
+ */
+enum fy_node_style {
+	FYNS_ANY = -1,
+	FYNS_FLOW,
+	FYNS_BLOCK,
+	FYNS_PLAIN,
+	FYNS_SINGLE_QUOTED,
+	FYNS_DOUBLE_QUOTED,
+	FYNS_LITERAL,
+	FYNS_FOLDED,
+	FYNS_ALIAS,
+};
+
 /**
  * struct fy_event_stream_start_data - stream start event data
  *
@@ -1498,6 +1528,116 @@ struct fy_document *
 fy_parse_load_document(struct fy_parser *fyp)
 	FY_EXPORT;
 
+/**
+ * fy_parse_load_document_filtered() - Parse the next document building only selected subtrees
+ *
+ * This method works like fy_parse_load_document() but only builds
+ * the nodes that are under the given path prefixes, along with the
+ * collections leading to them. Events outside of the selected subtrees
+ * are skipped without allocating nodes, so partially loading a large
+ * document takes a fraction of the memory and time.
+ *
+ * The path prefixes are plain slash separated components
+ * (i.e. "/spec/template" or "/items/0/name"), each of which matches
+ * either a scalar key of a mapping or the index of a sequence item.
+ * Note that the items of sequences leading to a selection are compacted,
+ * and that aliases referring to anchors outside of the selection
+ * can not be resolved.
+ *
+ * @fyp: The parser
+ * @paths: A NULL terminated array of path prefixes (up to 64)
+ *
+ * Returns:
+ * The next document from the parser stream, or NULL on error or end
+ */
+struct fy_document *
+fy_parse_load_document_filtered(struct fy_parser *fyp, const char * const *paths)
+	FY_EXPORT;
+
+/**
+ * struct fy_document_builder_cfg - document builder configuration structure.
+ *
+ * Argument to the fy_document_builder_create() method which
+ * builds documents from parser events.
+ *
+ * @parse_cfg: Parser configuration of the built documents
+ * @userdata: Opaque user data pointer
+ * @diag: Optional diagnostic interface to use; the builder takes
+ *        ownership of this reference
+ * @filter_paths: Optional NULL terminated array of path prefixes,
+ *                see fy_document_builder_set_filter()
+ */
+struct fy_document_builder_cfg {
+	struct fy_parse_cfg parse_cfg;
+	void *userdata;
+	struct fy_diag *diag;
+	const char * const *filter_paths;
+};
+
+/**
+ * fy_document_builder_create() - Create a document builder
+ *
+ * Creates a document builder with its configuration @cfg.
+ * The builder can then be used to load documents from a parser
+ * via fy_document_builder_load_document().
+ *
+ * @cfg: The configuration for the builder (may be NULL)
+ *
+ * Returns:
+ * A pointer to the builder or NULL in case of an error.
+ */
+struct fy_document_builder *
+fy_document_builder_create(const struct fy_document_builder_cfg *cfg)
+	FY_EXPORT;
+
+/**
+ * fy_document_builder_destroy() - Destroy a document builder
+ *
+ * Destroy a document builder created earlier via fy_document_builder_create().
+ *
+ * @fydb: The document builder to destroy
+ */
+void
+fy_document_builder_destroy(struct fy_document_builder *fydb)
+	FY_EXPORT;
+
+/**
+ * fy_document_builder_set_filter() - Set the path prefixes to build
+ *
+ * Set the path prefixes of the subtrees that the builder builds,
+ * replacing any previous ones. The prefixes are matched as in
+ * fy_parse_load_document_filtered() and are copied, so they need
+ * not stay valid after the call.
+ *
+ * @fydb: The document builder
+ * @paths: A NULL terminated array of path prefixes (up to 64), or NULL
+ *         to build everything
+ *
+ * Returns:
+ * 0 on success, -1 on error (in which case everything is built)
+ */
+int
+fy_document_builder_set_filter(struct fy_document_builder *fydb, const char * const *paths)
+	FY_EXPORT;
+
+/**
+ * fy_document_builder_load_document() - Build the next document from a parser
+ *
+ * Build the next document from the events of the parser, with
+ * the filter of the builder.
+ *
+ * @fydb: The document builder
+ * @fyp: The parser
+ *
+ * Returns:
+ * The next document (owned by the caller, which destroys it via
+ * fy_document_destroy()), or NULL on error or end of stream
+ */
+struct fy_document *
+fy_document_builder_load_document(struct fy_document_builder *fydb,
+				  struct fy_parser *fyp)
+	FY_EXPORT;
+
 /**
  * fy_parse_document_destroy() - Destroy a document created by fy_parse_load_document()
  *
@@ -1678,6 +1818,7 @@ enum fy_emitter_write_type {
  * @FYECF_STRIP_DOC: Strip document tags and markers when emitting
  * @FYECF_NO_ENDING_NEWLINE: Do not output ending new line (useful for single line mode)
  * @FYECF_STRIP_EMPTY_KV: Remove all keys with empty values from the output (not available in streaming mode)
+ * @FYECF_OUTPUT_BUFFERED: Coalesce writes in a 64K output buffer before calling the output method
  * @FYECF_INDENT_DEFAULT: Default emit output indent
  * @FYECF_INDENT_1: Output indent is 1
  * @FYECF_INDENT_2: Output indent is 2
@@ -1724,6 +1865,7 @@ enum fy_emitter_cfg_flags {
 	FYECF_STRIP_DOC			= FY_BIT(4),
 	FYECF_NO_ENDING_NEWLINE		= FY_BIT(5),
 	FYECF_STRIP_EMPTY_KV		= FY_BIT(6),
+	FYECF_OUTPUT_BUFFERED		= FY_BIT(7),
 	FYECF_INDENT_DEFAULT		= FYECF_INDENT(0),
 	FYECF_INDENT_1			= FYECF_INDENT(1),
 	FYECF_INDENT_2			= FYECF_INDENT(2),
@@ -1887,6 +2029,121 @@ struct fy_emitter_default_output_data {
 	bool visible;
 };
 
+/**
+ * struct fy_emitter_write_run - A run of output of the same type
+ *
+ * Describes a contiguous part of a buffered output chunk that
+ * was written with the same write type.
+ *
+ * @type: The write type of the run
+ * @len: The length of the run in bytes
+ */
+struct fy_emitter_write_run {
+	enum fy_emitter_write_type type;
+	int len;
+};
+
+/**
+ * fy_emitter_set_output_buffer() - Set the output buffer of an emitter
+ *
+ * Install an emitter owned output buffer of the given size.
+ * Writes are coalesced in the buffer and the output method is
+ * called when the buffer is full, at the end of each document,
+ * on fy_emitter_flush() and when the emitter is destroyed.
+ * A chunk always ends on a write boundary, so multi byte
+ * characters are never split; writes larger than the buffer
+ * are passed through unbuffered.
+ * The type passed to the output method is that of the first write
+ * in the chunk; when @track_types is true the per write types are
+ * available from within the output method via
+ * fy_emitter_get_write_runs().
+ *
+ * @emit: The emitter
+ * @size: The size of the output buffer, 0 to disable buffering
+ * @track_types: Keep track of the write types of the buffered output
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emitter_set_output_buffer(struct fy_emitter *emit, size_t size,
+			     bool track_types)
+	FY_EXPORT;
+
+/**
+ * fy_emitter_flush() - Flush the output buffer of an emitter
+ *
+ * Pass any buffered output to the output method.
+ *
+ * @emit: The emitter
+ *
+ * Returns:
+ * 0 on success, -1 on error (or if an output error has occured)
+ */
+int
+fy_emitter_flush(struct fy_emitter *emit)
+	FY_EXPORT;
+
+/**
+ * fy_emitter_get_write_runs() - Get the write type runs of a chunk
+ *
+ * Retrieve the write type runs of the chunk that is currently
+ * being output. Only meaningful when called from within the output
+ * method of an emitter with type tracking enabled via
+ * fy_emitter_set_output_buffer(). The lengths of the runs add up
+ * to the length of the chunk.
+ *
+ * @emit: The emitter
+ * @countp: Pointer to store the number of runs
+ *
+ * Returns:
+ * The array of runs, or NULL if there are none
+ */
+const struct fy_emitter_write_run *
+fy_emitter_get_write_runs(struct fy_emitter *emit, unsigned int *countp)
+	FY_EXPORT;
+
+/**
+ * fy_emitter_set_parallel() - Enable parallel emission of large collections
+ *
+ * Emit the items of sequences and mappings with at least @min_items
+ * items in parallel, using the threads of the given thread pool.
+ * Each thread emits a contiguous chunk of items in a private buffer,
+ * and the buffers are output in order, so the output is identical
+ * to the serial case. Oneline modes are always emitted serially.
+ * Note that the document must not be modified while being emitted.
+ *
+ * @emit: The emitter
+ * @tp: The thread pool to use, or NULL to create a private one
+ * @min_items: The minimum number of items to go parallel, 0 to disable
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emitter_set_parallel(struct fy_emitter *emit, struct fy_thread_pool *tp,
+			size_t min_items)
+	FY_EXPORT;
+
+/**
+ * fy_emitter_set_canonical() - Enable canonical (sorted keys) emission
+ *
+ * Emit the keys of mappings in the default sort order, like
+ * %FYECF_SORT_KEYS (which is set when enabling), but keep the sorted
+ * order of each mapping cached on the mapping node. Repeated dumps of
+ * the same document, for instance for content hashing or diffing,
+ * then skip re-sorting; modifying a mapping drops its cached order.
+ *
+ * @emit: The emitter
+ * @canonical: true to enable, false to disable
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emitter_set_canonical(struct fy_emitter *emit, bool canonical)
+	FY_EXPORT;
+
 /**
  * fy_emitter_default_output() - The default colorizing output method
  *
@@ -2040,6 +2297,102 @@ fy_emit_scalar_printf(struct fy_emitter *fye, enum fy_scalar_style style,
 	FY_FORMAT(printf, 5, 6)
 	FY_EXPORT;
 
+/**
+ * fy_emit_scalar_raw() - Emit a scalar without creating an event
+ *
+ * Output a scalar using the emitter's streaming state machine
+ * directly, without creating an event (or tokens) for it.
+ * The value is not copied and need only be valid during the call.
+ * The direct calls can be freely mixed with fy_emit_event();
+ * the output is identical to emitting the equivalent events.
+ *
+ * @emit: The emitter to use
+ * @style: The scalar style to use
+ * @value: Pointer to the scalar contents
+ * @len: The length of the scalar, or FY_NT for a zero terminated one
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emit_scalar_raw(struct fy_emitter *emit, enum fy_scalar_style style,
+		   const char *value, size_t len)
+	FY_EXPORT;
+
+/**
+ * fy_emit_alias_raw() - Emit an alias without creating an event
+ *
+ * Output an alias without creating an event, like
+ * fy_emit_scalar_raw() does for scalars.
+ *
+ * @emit: The emitter to use
+ * @alias: The alias (zero terminated)
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emit_alias_raw(struct fy_emitter *emit, const char *alias)
+	FY_EXPORT;
+
+/**
+ * fy_emit_sequence_start_raw() - Start a sequence without creating an event
+ *
+ * Start a sequence without creating an event. The start is held
+ * back until the next item is known, since the output of empty
+ * sequences differs.
+ *
+ * @emit: The emitter to use
+ * @style: The sequence style, FYNS_ANY, FYNS_BLOCK or FYNS_FLOW
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emit_sequence_start_raw(struct fy_emitter *emit, enum fy_node_style style)
+	FY_EXPORT;
+
+/**
+ * fy_emit_sequence_end_raw() - End a sequence without creating an event
+ *
+ * @emit: The emitter to use
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emit_sequence_end_raw(struct fy_emitter *emit)
+	FY_EXPORT;
+
+/**
+ * fy_emit_mapping_start_raw() - Start a mapping without creating an event
+ *
+ * Start a mapping without creating an event. The start is held
+ * back until the next item is known, since the output of empty
+ * mappings differs.
+ *
+ * @emit: The emitter to use
+ * @style: The mapping style, FYNS_ANY, FYNS_BLOCK or FYNS_FLOW
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emit_mapping_start_raw(struct fy_emitter *emit, enum fy_node_style style)
+	FY_EXPORT;
+
+/**
+ * fy_emit_mapping_end_raw() - End a mapping without creating an event
+ *
+ * @emit: The emitter to use
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emit_mapping_end_raw(struct fy_emitter *emit)
+	FY_EXPORT;
+
 /**
  * fy_emit_event_from_parser() - Queue (and possibly emit) an event
  * 			  	 generated by the parser.
@@ -2361,6 +2714,87 @@ char *
 fy_emit_to_string_collect(struct fy_emitter *emit, size_t *sizep)
 	FY_EXPORT;
 
+/**
+ * enum fy_emit_rope_flags - Rope emitter flags
+ *
+ * @FYERF_DEFAULT: The output is kept in a list of fixed size segments
+ * @FYERF_CONTIGUOUS: The output is kept in a single segment, which is
+ *                    grown in place using mremap() where available
+ */
+enum fy_emit_rope_flags {
+	FYERF_DEFAULT		= 0,
+	FYERF_CONTIGUOUS	= FY_BIT(0),
+};
+
+/**
+ * fy_emit_to_rope() - Create an emitter to a rope of segments
+ *
+ * Creates a special purpose emitter for output to a rope, a list
+ * of fixed size segments owned by the emitter. Unlike with
+ * fy_emit_to_string() the output is never copied while it grows,
+ * which makes a difference for very large outputs.
+ * Calls to fy_emit_event() (or fy_emit_document()) populate the rope.
+ * The contents are accessed via fy_emit_rope_iterate() or written
+ * out with fy_emit_rope_write(), and are valid until the emitter
+ * is destroyed.
+ *
+ * @flags: The emitter flags to use
+ * @rope_flags: The rope flags to use
+ *
+ * Returns:
+ * The newly created emitter or NULL on error.
+ */
+struct fy_emitter *
+fy_emit_to_rope(enum fy_emitter_cfg_flags flags, enum fy_emit_rope_flags rope_flags)
+	FY_EXPORT;
+
+/**
+ * fy_emit_rope_iterate() - Iterate over the segments of a rope emitter
+ *
+ * This method iterates over the output segments of an emitter
+ * created by fy_emit_to_rope(), in order.
+ * The iterator must be initialized to NULL before the first call.
+ * A contiguous rope has (at most) a single segment.
+ *
+ * @emit: The rope emitter
+ * @prevp: The previous segment iterator
+ * @lenp: Pointer to the length of the segment to be filled
+ *
+ * Returns:
+ * The next segment contents, or NULL at the end of the output
+ */
+const char *
+fy_emit_rope_iterate(struct fy_emitter *emit, void **prevp, size_t *lenp)
+	FY_EXPORT;
+
+/**
+ * fy_emit_rope_size() - Get the size of the rope emitter output
+ *
+ * @emit: The rope emitter
+ *
+ * Returns:
+ * The total size of the output so far
+ */
+size_t
+fy_emit_rope_size(struct fy_emitter *emit)
+	FY_EXPORT;
+
+/**
+ * fy_emit_rope_write() - Write the rope emitter output to a file descriptor
+ *
+ * Writes the output segments of an emitter created by fy_emit_to_rope()
+ * to the given file descriptor, gathering them with writev().
+ *
+ * @emit: The rope emitter
+ * @fd: The file descriptor to write to
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_emit_rope_write(struct fy_emitter *emit, int fd)
+	FY_EXPORT;
+
 /**
  * fy_node_copy() - Copy a node, associating the new node with the given document
  *
@@ -2480,40 +2914,12 @@ fy_document_insert_at(struct fy_document *fyd,
  *
  * @FYNT_SCALAR: Node is a scalar
  * @FYNT_SEQUENCE: Node is a sequence
- * @FYNT_MAPPING: Node is a mapping
- */
-enum fy_node_type {
-	FYNT_SCALAR,
-	FYNT_SEQUENCE,
-	FYNT_MAPPING,
-};
-
-/**
- * enum fy_node_style - Node style
- *
- * A node may contain a hint of how it should be
- * rendered, encoded as a style.
- *
- * @FYNS_ANY: No hint, let the emitter decide
- * @FYNS_FLOW: Prefer flow style (for sequence/mappings)
- * @FYNS_BLOCK: Prefer block style (for sequence/mappings)
- * @FYNS_PLAIN: Plain style preferred
- * @FYNS_SINGLE_QUOTED: Single quoted style preferred
- * @FYNS_DOUBLE_QUOTED: Double quoted style preferred
- * @FYNS_LITERAL: Literal style preferred (valid in block context)
- * @FYNS_FOLDED: Folded style preferred (valid in block context)
- * @FYNS_ALIAS: It's an alias
+ * @FYNT_MAPPING: Node is a mapping
  */
-enum fy_node_style {
-	FYNS_ANY = -1,
-	FYNS_FLOW,
-	FYNS_BLOCK,
-	FYNS_PLAIN,
-	FYNS_SINGLE_QUOTED,
-	FYNS_DOUBLE_QUOTED,
-	FYNS_LITERAL,
-	FYNS_FOLDED,
-	FYNS_ALIAS,
+enum fy_node_type {
+	FYNT_SCALAR,
+	FYNT_SEQUENCE,
+	FYNT_MAPPING,
 };
 
 /* maximum depth is 256 */
@@ -2672,6 +3078,46 @@ bool
 fy_node_compare_string(struct fy_node *fyn, const char *str, size_t len)
 	FY_EXPORT;
 
+/* The size of a node digest (BLAKE3) */
+#define FY_NODE_DIGEST_LEN	32
+
+/**
+ * enum fy_node_digest_flags - Node digest flags
+ *
+ * @FYNDF_KEY_ORDER: The order of the mapping keys is significant
+ * @FYNDF_NO_MEMO: Do not memoize the digests of the nodes
+ */
+enum fy_node_digest_flags {
+	FYNDF_KEY_ORDER		= FY_BIT(0),
+	FYNDF_NO_MEMO		= FY_BIT(1),
+};
+
+/**
+ * fy_node_digest() - Structural digest of a node
+ *
+ * Compute a collision resistant BLAKE3 digest of a node, suitable for
+ * deduplication and change detection. The digest is structural;
+ * it covers the node types, the tags and the scalar contents after
+ * any escaping, so it does not depend on the formatting, the
+ * styles or the comments. Unless FYNDF_KEY_ORDER is given the order
+ * of the mapping keys does not matter either.
+ * The digests are memoized on the nodes, so after modifying a
+ * document only the path from the changed node to the root is
+ * rehashed. The memoized digests are kept for the flags
+ * they were first computed with.
+ *
+ * @fyn: The node (may be NULL, which digests as an empty scalar)
+ * @flags: The digest flags
+ * @digest: Pointer to the output (sized FY_NODE_DIGEST_LEN)
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_node_digest(struct fy_node *fyn, enum fy_node_digest_flags flags,
+	       uint8_t digest[FY_NODE_DIGEST_LEN])
+	FY_EXPORT;
+
 /**
  * fy_node_compare_token() - Compare a node for equality against a token
  *
@@ -3377,6 +3823,65 @@ fy_node_by_path(struct fy_node *fyn, const char *path, size_t len,
 		enum fy_node_walk_flags flags)
 	FY_EXPORT;
 
+/* opaque precompiled path handle */
+struct fy_node_path_handle;
+
+/**
+ * fy_node_path_handle_create() - Precompile a path spec for repeated lookups
+ *
+ * Parse a path spec in the format accepted by fy_node_by_path() once,
+ * so that it can be used for lookups in many nodes and documents.
+ * The path components are stored in a single allocation together with
+ * the precomputed hash of each mapping key, so that a lookup via
+ * fy_node_by_path_handle() performs a single hash probe per level and
+ * does not allocate or copy strings.
+ *
+ * Only plain components (simple keys and sequence indexes) take the fast
+ * path; complex keys, quoted keys, anchors and merge keys are resolved
+ * exactly like fy_node_by_path() would.
+ *
+ * @path: The path spec to compile
+ * @len: The length of the path (or -1 if '\0' terminated)
+ * @flags: The extra path walk flags
+ *
+ * Returns:
+ * The created path handle, or NULL on error (i.e. malformed path)
+ */
+struct fy_node_path_handle *
+fy_node_path_handle_create(const char *path, size_t len,
+			   enum fy_node_walk_flags flags)
+	FY_EXPORT;
+
+/**
+ * fy_node_path_handle_destroy() - Destroy a precompiled path handle
+ *
+ * Destroy a path handle created by fy_node_path_handle_create().
+ *
+ * @fynph: The path handle to destroy
+ */
+void
+fy_node_path_handle_destroy(struct fy_node_path_handle *fynph)
+	FY_EXPORT;
+
+/**
+ * fy_node_by_path_handle() - Retrieve a node using a precompiled path
+ *
+ * This method will retrieve a node relative to the given node using
+ * a path handle created by fy_node_path_handle_create().
+ * The result is the same as calling fy_node_by_path() with the
+ * path spec and flags the handle was created with.
+ *
+ * @fyn: The node to use as start of the traversal operation
+ * @fynph: The path handle to use in the traversal operation
+ *
+ * Returns:
+ * The retrieved node, or NULL if not possible to be found.
+ */
+struct fy_node *
+fy_node_by_path_handle(struct fy_node *fyn,
+		       const struct fy_node_path_handle *fynph)
+	FY_EXPORT;
+
 /**
  * fy_node_get_path() - Get the path of this node
  *
@@ -5936,27 +6441,38 @@ fy_path_expr_to_document(struct fy_path_expr *expr)
  * @FYPXCF_QUIET: Quiet, do not output any information messages
  * @FYPXCF_DISABLE_RECYCLING: Disable recycling optimization
  * @FYPXCF_DISABLE_ACCELERATORS: Disable use of access accelerators (saves memory)
+ * @FYPXCF_PARALLEL: Evaluate the steps following a recursive descent in parallel
  */
 enum fy_path_exec_cfg_flags {
 	FYPXCF_QUIET			= FY_BIT(0),
 	FYPXCF_DISABLE_RECYCLING	= FY_BIT(1),
 	FYPXCF_DISABLE_ACCELERATORS	= FY_BIT(2),
+	FYPXCF_PARALLEL			= FY_BIT(3),
 };
 
+/* forward declaration of the thread pool */
+struct fy_thread_pool;
+
 /**
  * struct fy_path_exec_cfg - path expression executor configuration structure.
  *
  * Argument to the fy_path_exec_create() method which
  * performs execution of a ypath expression
  *
+ * When FYPXCF_PARALLEL is set, the steps following a recursive
+ * descent (the ** step) are evaluated on the threads of the pool.
+ * The results are identical (and in the same order) as the serial case.
+ *
  * @flags: Configuration flags
  * @userdata: Opaque user data pointer
  * @diag: Optional diagnostic interface to use
+ * @tp: The thread pool to use in parallel mode, if NULL create a private one
  */
 struct fy_path_exec_cfg {
 	enum fy_path_exec_cfg_flags flags;
 	void *userdata;
 	struct fy_diag *diag;
+	struct fy_thread_pool *tp;
 };
 
 /**
@@ -7388,6 +7904,26 @@ fy_path_get_text(struct fy_path *fypp)
 #define fy_path_get_text_alloca(_fypp) \
 	FY_ALLOCA_COPY_FREE(fy_path_get_text((_fypp)), FY_NT)
 
+/**
+ * fy_path_get_text0() - Get the textual representation of a path (borrowed)
+ *
+ * Given a path, return a pointer to a '\0' terminated string which
+ * contains the textual representation of it. The text is maintained
+ * incrementally as components are pushed and popped, so this is cheap
+ * enough to call for every event.
+ *
+ * The returned string is owned by the path and is only valid until
+ * the next event is processed (or the path is destroyed).
+ *
+ * @fypp: The path to get it's textual representation
+ *
+ * Returns:
+ * The textual representation of the path, NULL on error.
+ */
+const char *
+fy_path_get_text0(struct fy_path *fypp)
+	FY_EXPORT;
+
 /**
  * fy_path_in_root() - Check if the path is in the root of the document
  *
@@ -7863,12 +8399,23 @@ struct fy_thread_work {
  * enum fy_thread_pool_cfg_flags - Thread pool configuration flags
  *
  * These flags control the operation of the thread pool.
- * For now only the steal mode flag is defined.
  *
  * @FYTPCF_STEAL_MODE: Enable steal mode for the thread pool
+ * @FYTPCF_DEQUE_MODE: Use per thread work stealing deques; required
+ *                     for parallel execution via fy_thread_spawn()
+ *                     and takes precedence over @FYTPCF_STEAL_MODE
+ * @FYTPCF_PIN_THREADS: Pin each thread to a single CPU of the allowed
+ *                      ones, round robin
+ * @FYTPCF_NUMA_GROUP: Group the threads per NUMA node; the groups are
+ *                     spread evenly over the nodes, with consecutive
+ *                     thread ids, and each thread runs only on the CPUs
+ *                     of its node
  */
 enum fy_thread_pool_cfg_flags {
 	FYTPCF_STEAL_MODE	= FY_BIT(0),
+	FYTPCF_DEQUE_MODE	= FY_BIT(1),
+	FYTPCF_PIN_THREADS	= FY_BIT(2),
+	FYTPCF_NUMA_GROUP	= FY_BIT(3),
 };
 
 /**
@@ -7876,14 +8423,25 @@ enum fy_thread_pool_cfg_flags {
  *
  * Argument to the fy_thread_pool_create() method.
  *
+ * The CPUs the threads may run on are the ones the process is allowed
+ * to run on, further restricted by @cpu_mask when it's not NULL.
+ * CPU affinity and NUMA placement are only supported on Linux, and
+ * are ignored elsewhere.
+ *
  * @flags: Thread pool configuration flags
- * @num_threads: Number of threads, if 0 == online CPUs
+ * @num_threads: Number of threads, if 0 == online CPUs (the allowed
+ *               CPUs when placing the threads, or with a @cpu_mask)
  * @userdata: A userdata pointer
+ * @cpu_mask: Bitmask of the CPUs the threads may run on, bit N of
+ *            word N / 64 for CPU N, or NULL for no restriction
+ * @cpu_mask_bits: The number of bits of @cpu_mask
  */
 struct fy_thread_pool_cfg {
 	enum fy_thread_pool_cfg_flags flags;
 	unsigned int num_threads;
 	void *userdata;
+	const uint64_t *cpu_mask;
+	unsigned int cpu_mask_bits;
 };
 
 /**
@@ -7942,6 +8500,114 @@ const struct fy_thread_pool_cfg *
 fy_thread_pool_get_cfg(struct fy_thread_pool *tp)
 	FY_EXPORT;
 
+/**
+ * fy_thread_pool_get_thread_cpu() - Get the CPU a thread is pinned on
+ *
+ * @tp: The thread pool
+ * @id: The id of the thread (0 to number of threads - 1)
+ *
+ * Returns:
+ * The CPU the thread is pinned on, -1 if not pinned or on error
+ */
+int
+fy_thread_pool_get_thread_cpu(struct fy_thread_pool *tp, unsigned int id)
+	FY_EXPORT;
+
+/**
+ * fy_thread_pool_get_thread_node() - Get the NUMA node of a thread
+ *
+ * @tp: The thread pool
+ * @id: The id of the thread (0 to number of threads - 1)
+ *
+ * Returns:
+ * The NUMA node the thread runs on, -1 if it is not bound
+ * to a single node or on error
+ */
+int
+fy_thread_pool_get_thread_node(struct fy_thread_pool *tp, unsigned int id)
+	FY_EXPORT;
+
+/**
+ * fy_thread_pool_mem_node() - Get the NUMA node of memory
+ *
+ * Find the NUMA node of the memory page at @addr, for use
+ * as the preferred node of the join methods. Since it involves
+ * a system call it should be called once per large region.
+ *
+ * @tp: The thread pool
+ * @addr: The address of the memory
+ *
+ * Returns:
+ * The NUMA node of the memory, or -1 if unknown, or when the
+ * threads of the pool are not placed on multiple nodes
+ */
+int
+fy_thread_pool_mem_node(struct fy_thread_pool *tp, const void *addr)
+	FY_EXPORT;
+
+/**
+ * struct fy_thread_stats - Thread pool statistics
+ *
+ * The counters of a thread pool, either per thread or in total.
+ * Waiting threads spin for an adaptive number of iterations before
+ * parking (sleeping); the spinning limit of each waiter doubles when
+ * spinning paid off, and halves when it didn't. Spinning is disabled
+ * on a single CPU system.
+ *
+ * @jobs: Number of works executed
+ * @steals: Number of works stolen from another thread
+ * @spins: Number of spin iterations while waiting
+ * @spin_hits: Number of waits that completed while spinning
+ * @parks: Number of times a waiter had to park
+ * @wakes: Number of timed wakeups of parked threads
+ * @wake_latency_ns: Total time from a wakeup request to running
+ * @wake_latency_max_ns: Maximum time from a wakeup request to running
+ */
+struct fy_thread_stats {
+	uint64_t jobs;
+	uint64_t steals;
+	uint64_t spins;
+	uint64_t spin_hits;
+	uint64_t parks;
+	uint64_t wakes;
+	uint64_t wake_latency_ns;
+	uint64_t wake_latency_max_ns;
+};
+
+/**
+ * fy_thread_pool_get_stats() - Get the statistics of a thread pool
+ *
+ * Retrieve the statistics counters of a thread pool. The total
+ * includes the work performed and the waits of threads outside of
+ * the pool (i.e. the callers of the join methods).
+ * The counters are updated without locking, so while the pool is
+ * busy they are only approximately consistent.
+ *
+ * @tp: The thread pool
+ * @total: Pointer to the total statistics, or NULL
+ * @threads: Pointer to an array of fy_thread_pool_get_num_threads()
+ *           statistics, one per thread, or NULL
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_thread_pool_get_stats(struct fy_thread_pool *tp,
+			 struct fy_thread_stats *total,
+			 struct fy_thread_stats *threads)
+	FY_EXPORT;
+
+/**
+ * fy_thread_pool_reset_stats() - Reset the statistics of a thread pool
+ *
+ * Reset all the statistics counters of a thread pool to zero.
+ *
+ * @tp: The thread pool
+ */
+void
+fy_thread_pool_reset_stats(struct fy_thread_pool *tp)
+	FY_EXPORT;
+
 /*
  * fy_thread_reserve() - Reserve a thread from the pool.
  *
@@ -8079,6 +8745,102 @@ fy_thread_arg_join(struct fy_thread_pool *tp,
 		   void *arg, size_t count)
 	FY_EXPORT;
 
+/*
+ * fy_thread_work_join_node() - Submit works for execution and wait, preferring a node
+ *
+ * Same as fy_thread_work_join(), but the threads of NUMA node @node
+ * are preferred for the works, i.e. the node of the memory the works
+ * process as returned by fy_thread_pool_mem_node().
+ * In deque mode the works are always spawned; the idle threads
+ * steal from the threads of their own node first regardless.
+ *
+ * @tp: The thread pool
+ * @works: Pointer to an array of works sized @work_count
+ * @work_count: The size of the @works array
+ * @check_fn: Pointer to a check function, or NULL for no checks
+ * @node: The preferred NUMA node, or -1 for no preference
+ */
+void
+fy_thread_work_join_node(struct fy_thread_pool *tp,
+			 struct fy_thread_work *works, size_t work_count,
+			 fy_work_check_fn check_fn, int node)
+	FY_EXPORT;
+
+/*
+ * fy_thread_args_join_node() - Execute function in parallel using arguments as pointers, preferring a node
+ *
+ * Same as fy_thread_args_join(), but preferring the threads of
+ * NUMA node @node.
+ *
+ * @tp: The thread pool
+ * @fn: The function to execute in parallel
+ * @check_fn: Pointer to a check function, or NULL for no checks
+ * @args: An args array sized @count of argument pointers
+ * @count: The count of the args array items
+ * @node: The preferred NUMA node, or -1 for no preference
+ */
+void
+fy_thread_args_join_node(struct fy_thread_pool *tp,
+			 fy_work_exec_fn fn, fy_work_check_fn check_fn,
+			 void **args, size_t count, int node)
+	FY_EXPORT;
+
+/*
+ * fy_thread_arg_array_join_node() - Execute function in parallel using argument array, preferring a node
+ *
+ * Same as fy_thread_arg_array_join(), but preferring the threads of
+ * NUMA node @node.
+ *
+ * @tp: The thread pool
+ * @fn: The function to execute in parallel
+ * @check_fn: Pointer to a check function, or NULL for no checks
+ * @args: An args array of @argsize items
+ * @argsize: The size of each argument array item
+ * @count: The count of the args array items
+ * @node: The preferred NUMA node, or -1 for no preference
+ */
+void
+fy_thread_arg_array_join_node(struct fy_thread_pool *tp,
+			      fy_work_exec_fn fn, fy_work_check_fn check_fn,
+			      void *args, size_t argsize, size_t count, int node)
+	FY_EXPORT;
+
+/**
+ * fy_thread_spawn() - Spawn work for possible parallel execution
+ *
+ * Push work to the current thread's work deque, from where it is
+ * either executed later by the current thread, or stolen by an idle
+ * thread of the pool. Work may spawn further work (nested parallelism)
+ * without the need for any more threads.
+ * The work must remain valid until the matching fy_thread_sync().
+ * If the thread pool is not in deque mode the work is executed
+ * directly.
+ *
+ * @tp: The thread pool
+ * @work: The work to spawn
+ *
+ * Returns:
+ * 0 on success, -1 on error
+ */
+int
+fy_thread_spawn(struct fy_thread_pool *tp, struct fy_thread_work *work)
+	FY_EXPORT;
+
+/**
+ * fy_thread_sync() - Wait for spawned work to complete
+ *
+ * Wait until all the work spawned via fy_thread_spawn() from the
+ * current context (the executing work, or the calling thread when
+ * outside of the pool) completes. While waiting the thread executes
+ * other pending work. Executing work is always implicitly synced
+ * at its end.
+ *
+ * @tp: The thread pool
+ */
+void
+fy_thread_sync(struct fy_thread_pool *tp)
+	FY_EXPORT;
+
 /*
  * Minimal exposing of internal BLAKE3 implementation
  *
@@ -8089,6 +8851,12 @@ fy_thread_arg_join(struct fy_thread_pool *tp,
 /* BLAKE3 output length */
 #define FY_BLAKE3_OUT_LEN 32
 
+/* The maximum size of a saved BLAKE3 hasher state */
+#define FY_BLAKE3_STATE_MAX_SIZE (112 + 55 * FY_BLAKE3_OUT_LEN)
+
+/* The default log2 of the chunks per outboard tree group (16K groups) */
+#define FY_BLAKE3_OUTBOARD_GROUP_LOG 4
+
 /* opaque BLAKE3 hasher type for the user*/
 struct fy_blake3_hasher;
 
@@ -8132,7 +8900,7 @@ fy_blake3_backend_iterate(const char **prevp)
  *               0 otherwise.
  * @tp: The thread pool to use, if NULL, create a private one
  * @num_threads: Number of threads to use
- *               - 0 means default: NUM_CPUS * 3 / 2
+ *               - 0 means default: NUM_CPUS
  *               - > 0 specific number of threads
  *               - -1 disable threading entirely
  */
@@ -8248,6 +9016,155 @@ const uint8_t *
 fy_blake3_hash_file(struct fy_blake3_hasher *fyh, const char *filename)
 	FY_EXPORT;
 
+/**
+ * fy_blake3_hash_files() - BLAKE3 hash many files.
+ *
+ * Hash the given files concurrently, using the thread pool of the
+ * hasher. Small files are hashed each on its own thread, while large
+ * ones are split across all the threads. The results are the same as
+ * hashing each file with fy_blake3_hash_file().
+ *
+ * @fyh: The BLAKE3 hasher
+ * @filenames: The filenames
+ * @count: The number of files
+ * @outputs: The BLAKE3 outputs, one per file, in the order of @filenames
+ * @errs: The errno of each file (0 on success), or NULL
+ *
+ * Returns:
+ * 0 if all the files were hashed, -1 if any of them failed
+ */
+int
+fy_blake3_hash_files(struct fy_blake3_hasher *fyh, const char * const *filenames, size_t count,
+		     uint8_t (*outputs)[FY_BLAKE3_OUT_LEN], int *errs)
+	FY_EXPORT;
+
+/**
+ * fy_blake3_hasher_save_state() - Save the BLAKE3 hasher state
+ *
+ * Save the state of the hasher, i.e. after hashing a file, so that
+ * hashing can be resumed later on with more input. The state does
+ * not contain the key; it can only be restored on a hasher created
+ * with the same mode and key or context.
+ *
+ * @fyh: The BLAKE3 hasher
+ * @buf: The buffer to store the state to (may be NULL)
+ * @size: The size of the buffer
+ *
+ * Returns:
+ * The size of the state (at most FY_BLAKE3_STATE_MAX_SIZE). The
+ * state is only stored when it fits in the buffer.
+ */
+size_t
+fy_blake3_hasher_save_state(struct fy_blake3_hasher *fyh, void *buf, size_t size)
+	FY_EXPORT;
+
+/**
+ * fy_blake3_hasher_restore_state() - Restore a saved BLAKE3 hasher state
+ *
+ * Restore a state saved earlier via fy_blake3_hasher_save_state().
+ *
+ * @fyh: The BLAKE3 hasher
+ * @buf: The buffer holding the state
+ * @size: The size of the state
+ *
+ * Returns:
+ * 0 on success, -1 if the state is invalid or of a different mode
+ */
+int
+fy_blake3_hasher_restore_state(struct fy_blake3_hasher *fyh, const void *buf, size_t size)
+	FY_EXPORT;
+
+/**
+ * fy_blake3_hash_file_resume() - Resume BLAKE3 hashing of an appended file.
+ *
+ * Continue hashing the given file from the point the (restored) hasher
+ * state reached, hashing only the data appended since. The part of
+ * the file still in the state is verified against the file contents.
+ * The hasher state is updated, so it can be saved again.
+ *
+ * @fyh: The BLAKE3 hasher
+ * @filename: The filename
+ *
+ * Returns:
+ * A pointer to the BLAKE3 output (sized FY_BLAKE3_OUT_LEN) of the
+ * whole file, or NULL in case of an error (including a mismatch
+ * with the state).
+ */
+const uint8_t *
+fy_blake3_hash_file_resume(struct fy_blake3_hasher *fyh, const char *filename)
+	FY_EXPORT;
+
+/**
+ * fy_blake3_outboard_size() - Size of a BLAKE3 outboard tree
+ *
+ * Return the size of the outboard verification tree of content of
+ * the given length.
+ *
+ * @content_len: The length of the content
+ * @group_log: The log2 of the chunks (1K) per group
+ *
+ * Returns:
+ * The size of the outboard tree, or 0 if group_log is out of range
+ */
+size_t
+fy_blake3_outboard_size(uint64_t content_len, unsigned int group_log)
+	FY_EXPORT;
+
+/**
+ * fy_blake3_outboard_encode() - Hash and produce a BLAKE3 outboard tree
+ *
+ * Hash the memory area, while storing the interior chaining values of
+ * the hash tree down to groups of (1 << group_log) chunks in the
+ * outboard buffer (Bao style, the content is not copied).
+ * With it any range of the content can later be verified against the
+ * hash via fy_blake3_outboard_verify(), hashing only the groups the
+ * range overlaps. Larger groups make for a smaller outboard but more
+ * hashing per verification.
+ *
+ * @fyh: The BLAKE3 hasher
+ * @mem: Pointer to the content
+ * @size: The size of the content in bytes
+ * @group_log: The log2 of the chunks per group (i.e. FY_BLAKE3_OUTBOARD_GROUP_LOG)
+ * @outboard: The buffer for the outboard tree
+ * @outboard_size: The size of the buffer, at least fy_blake3_outboard_size()
+ *
+ * Returns:
+ * A pointer to the BLAKE3 output (sized FY_BLAKE3_OUT_LEN), or NULL
+ * in case of an error.
+ */
+const uint8_t *
+fy_blake3_outboard_encode(struct fy_blake3_hasher *fyh, const void *mem, size_t size,
+			  unsigned int group_log, void *outboard, size_t outboard_size)
+	FY_EXPORT;
+
+/**
+ * fy_blake3_outboard_verify() - Verify a range of content using an outboard tree
+ *
+ * Verify that the given range of the content matches the trusted hash,
+ * using the outboard tree produced by fy_blake3_outboard_encode().
+ * Only the groups of the content overlapping the range are accessed,
+ * so for a lazily mapped file only those pages are read.
+ * The hasher must be of the same mode (and key) as the one used
+ * for encoding.
+ *
+ * @fyh: The BLAKE3 hasher
+ * @hash: The trusted hash of the content (sized FY_BLAKE3_OUT_LEN)
+ * @outboard: The outboard tree
+ * @outboard_size: The size of the outboard tree
+ * @mem: Pointer to the start of the (whole) content
+ * @offset: The offset of the range to verify
+ * @len: The length of the range to verify
+ *
+ * Returns:
+ * 0 if the range is verified, -1 on error or verification failure
+ * (with errno set to EBADMSG).
+ */
+int
+fy_blake3_outboard_verify(struct fy_blake3_hasher *fyh, const uint8_t *hash,
+			  const void *outboard, size_t outboard_size,
+			  const void *mem, uint64_t offset, uint64_t len)
+	FY_EXPORT;
+
 #ifdef __cplusplus
 }
 #endif
@@ -401,10 +401,10 @@ static size_t blake3_compress_subtree_wide(blake3_hasher *self, const uint8_t *i
     states[1].chunk_counter = right_chunk_counter;
     states[1].out = right_cvs;
 
-    fy_thread_arg_array_join(self->hs->tp,
+    fy_thread_arg_array_join_node(self->hs->tp,
         blake3_compress_subtree_wide_thread,
         blake3_compress_subtree_wide_work_check,
-        states, sizeof(states[0]), 2);
+        states, sizeof(states[0]), 2, self->mem_node);
 
     left_n = states[0].n;
     right_n = states[1].n;
@@ -470,6 +470,7 @@ INLINE void hasher_init_base(blake3_host_state *hs, blake3_hasher *self, const u
   memcpy(self->key, key, BLAKE3_KEY_LEN);
   chunk_state_init(&self->chunk, key, flags);
   self->cv_stack_len = 0;
+  self->mem_node = -1;
 }
 
 static const uint32_t IV[8] BLAKE3_ALIGN = {
@@ -598,6 +599,12 @@ void HASHER_OP(blake3_hasher_update) (blake3_hasher *self, const void *input,
     }
   }
 
+  // Prefer the threads on the NUMA node of the input (once per update, it's
+  // a system call, and only when the thread pool spans multiple nodes).
+  if (self->hs->tp && input_len > BLAKE3_CHUNK_LEN) {
+    self->mem_node = fy_thread_pool_mem_node(self->hs->tp, input_bytes);
+  }
+
   // Now the chunk_state is clear, and we have more input. If there's more than
   // a single chunk (so, definitely not the root chunk), hash the largest whole
   // subtree we can, with the full benefits of SIMD (and maybe in the future,
@@ -721,6 +728,46 @@ void HASHER_OP(blake3_hasher_finalize) (const blake3_hasher *self, uint8_t *out,
   HASHER_OP(blake3_hasher_finalize_seek) (self, 0, out, out_len);
 }
 
+// The chaining value of the complete subtree of the given input, which
+// starts at chunk_counter. This is what the outboard tree stores for each
+// chunk group. If the subtree is the whole input, is_root gives the root
+// hash instead.
+void HASHER_OP(blake3_hasher_subtree_cv) (blake3_hasher *self, const void *input,
+                                           size_t input_len, uint64_t chunk_counter,
+                                           bool is_root, uint8_t cv[BLAKE3_OUT_LEN]) {
+  output_t output;
+  if (input_len <= BLAKE3_CHUNK_LEN) {
+    blake3_chunk_state chunk;
+    chunk_state_init(&chunk, self->key, self->chunk.flags);
+    chunk.chunk_counter = chunk_counter;
+    chunk_state_update(self, &chunk, input, input_len);
+    output = chunk_state_output(&chunk);
+  } else {
+    uint8_t parent_block[BLAKE3_BLOCK_LEN] BLAKE3_ALIGN;
+    compress_subtree_to_parent_node(self, input, input_len, self->key,
+                                    chunk_counter, self->chunk.flags, parent_block);
+    output = parent_output(parent_block, self->key, self->chunk.flags);
+  }
+  if (is_root) {
+    output_root_bytes(self, &output, 0, cv, BLAKE3_OUT_LEN);
+  } else {
+    output_chaining_value(self, &output, cv);
+  }
+}
+
+// The chaining value (or the root hash) of a parent node, given the
+// chaining values of its children.
+void HASHER_OP(blake3_hasher_parent_cv) (blake3_hasher *self,
+                                          const uint8_t block[BLAKE3_BLOCK_LEN],
+                                          bool is_root, uint8_t cv[BLAKE3_OUT_LEN]) {
+  output_t output = parent_output(block, self->key, self->chunk.flags);
+  if (is_root) {
+    output_root_bytes(self, &output, 0, cv, BLAKE3_OUT_LEN);
+  } else {
+    output_chaining_value(self, &output, cv);
+  }
+}
+
 void HASHER_OP(blake3_hasher_reset) (blake3_hasher *self) {
   chunk_state_reset(&self->chunk, self->key, 0);
   self->cv_stack_len = 0;
@@ -738,4 +785,6 @@ const blake3_hasher_ops HASHER_OP(blake3_hasher_op) = {
 	.hasher_finalize		= HASHER_OP(blake3_hasher_finalize),
 	.hasher_finalize_seek		= HASHER_OP(blake3_hasher_finalize_seek),
 	.hasher_reset			= HASHER_OP(blake3_hasher_reset),
+	.hasher_subtree_cv		= HASHER_OP(blake3_hasher_subtree_cv),
+	.hasher_parent_cv		= HASHER_OP(blake3_hasher_parent_cv),
 };
@@ -7,6 +7,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <pthread.h>
 #include <stdalign.h>
 
@@ -19,6 +20,9 @@
 #define BLAKE3_BLOCK_LEN 64
 #define BLAKE3_CHUNK_LEN 1024
 
+// maximum size of a saved hasher state (header + the chaining value stack)
+#define BLAKE3_STATE_MAX_SIZE (112 + 55 * BLAKE3_OUT_LEN)
+
 struct blake_host_state;
 struct blake_hasher;
 
@@ -133,8 +137,33 @@ void blake3_hasher_destroy(struct blake3_hasher *self);
 
 /* simple optimized method for file hashing */
 int blake3_hash_file(struct blake3_hasher *hasher, const char *filename, uint8_t output[BLAKE3_OUT_LEN]);
+/* hash many files concurrently, in the mode of the hasher; errs (if not NULL) get the errno of each file */
+int blake3_hash_files(struct blake3_hasher *hasher, const char * const *filenames, size_t count,
+		      uint8_t (*outputs)[BLAKE3_OUT_LEN], int *errs);
 void blake3_hash(struct blake3_hasher *hasher, const void *mem, size_t size, uint8_t output[BLAKE3_OUT_LEN]);
 
+/* saving and restoring the hasher state, to resume hashing (i.e. of append only files) */
+uint64_t blake3_hasher_count(const struct blake3_hasher *self);
+size_t blake3_hasher_save(const struct blake3_hasher *self, void *buf, size_t size);
+int blake3_hasher_restore(struct blake3_hasher *self, const void *buf, size_t size);
+int blake3_hash_file_resume(struct blake3_hasher *hasher, const char *filename, uint8_t output[BLAKE3_OUT_LEN]);
+
+/*
+ * outboard (bao style) verification tree, kept apart from the content;
+ * the chaining values of the tree down to groups of (1 << group_log) chunks,
+ * so that any range of the content can be verified against the root hash
+ * by hashing only the groups it overlaps
+ */
+#define BLAKE3_OUTBOARD_HEADER_LEN	16
+#define BLAKE3_OUTBOARD_GROUP_LOG	4	// default, 16K groups
+#define BLAKE3_OUTBOARD_MAX_GROUP_LOG	20
+size_t blake3_outboard_size(uint64_t content_len, unsigned int group_log);
+int blake3_outboard_encode(struct blake3_hasher *hasher, const void *mem, size_t size, unsigned int group_log,
+			   void *outboard, size_t outboard_size, uint8_t output[BLAKE3_OUT_LEN]);
+int blake3_outboard_verify(struct blake3_hasher *hasher, const uint8_t root[BLAKE3_OUT_LEN],
+			   const void *outboard, size_t outboard_size,
+			   const void *mem, uint64_t offset, uint64_t len);
+
 /* experimental CPUSIMD enable */
 int blake3_backend_cpusimd_setup(unsigned int num_cpus, unsigned int mult_fact);
 void blake3_backend_cpusimd_cleanup(void);
@@ -159,6 +188,10 @@ typedef struct blake3_hasher_ops {
 	void (*hasher_finalize)(const struct blake3_hasher *self, uint8_t *out, size_t out_len);
 	void (*hasher_finalize_seek)(const struct blake3_hasher *self, uint64_t seek, uint8_t *out, size_t out_len);
 	void (*hasher_reset)(struct blake3_hasher *self);
+	void (*hasher_subtree_cv)(struct blake3_hasher *self, const void *input, size_t input_len,
+				  uint64_t chunk_counter, bool is_root, uint8_t cv[BLAKE3_OUT_LEN]);
+	void (*hasher_parent_cv)(struct blake3_hasher *self, const uint8_t block[BLAKE3_BLOCK_LEN],
+				 bool is_root, uint8_t cv[BLAKE3_OUT_LEN]);
 } blake3_hasher_ops;
 
 #endif /* BLAKE3_H */
@@ -29,6 +29,8 @@
 #define BLAKE3_FILE_IO_BUFFER_SIZE	BLAKE3_ALLOCA_BUFFER_SIZE
 #define BLAKE3_MMAP_MIN_CHUNKSIZE	(1U << 20)	// minimum chunksize is 1MB
 #define BLAKE3_MMAP_MAX_CHUNKSIZE	SIZE_MAX
+#define BLAKE3_STREAM_BUFFER_SIZE	(4U << 20)	// each of the two pipelined buffers
+#define BLAKE3_BATCH_FILES		256		// number of small files hashed per batch
 
 static int probe_backends(blake3_host_state *hs)
 {
@@ -140,8 +142,13 @@ int blake3_host_state_setup(blake3_host_state *hs, const blake3_host_config *cfg
 
 		if (!hs->cfg.tp) {
 			memset(&tp_cfg, 0, sizeof(tp_cfg));
-			tp_cfg.flags = FYTPCF_STEAL_MODE;
-			tp_cfg.num_threads = hs->cfg.num_threads ? hs->cfg.num_threads : (hs->num_cpus * 3) / 2;
+			/*
+			 * waiting joins execute pending work, no need to oversubscribe;
+			 * grouping per NUMA node lets the hashing prefer the threads
+			 * local to the input
+			 */
+			tp_cfg.flags = FYTPCF_DEQUE_MODE | FYTPCF_NUMA_GROUP;
+			tp_cfg.num_threads = hs->cfg.num_threads ? hs->cfg.num_threads : hs->num_cpus;
 			tp_cfg.userdata = NULL;
 			hs->tp = fy_thread_pool_create(&tp_cfg);
 			if (!hs->tp)
@@ -151,6 +158,7 @@ int blake3_host_state_setup(blake3_host_state *hs, const blake3_host_config *cfg
 	}
 
 	hs->file_io_bufsz = hs->cfg.file_io_bufsz ? hs->cfg.file_io_bufsz : BLAKE3_FILE_IO_BUFFER_SIZE;
+	hs->stream_bufsz = hs->cfg.file_io_bufsz ? hs->cfg.file_io_bufsz : BLAKE3_STREAM_BUFFER_SIZE;
 	hs->mmap_min_chunk = hs->cfg.mmap_min_chunk ? hs->cfg.mmap_min_chunk : BLAKE3_MMAP_MIN_CHUNKSIZE;
 	hs->mmap_max_chunk = hs->cfg.mmap_max_chunk ? hs->cfg.mmap_max_chunk : BLAKE3_MMAP_MAX_CHUNKSIZE;
 
@@ -161,6 +169,7 @@ int blake3_host_state_setup(blake3_host_state *hs, const blake3_host_config *cfg
 		fprintf(stderr, "simd_degree: %u\n", hs->simd_degree);
 		fprintf(stderr, "mt_degree: %u\n", hs->mt_degree);
 		fprintf(stderr, "file_io_bufsz: %zu\n", hs->file_io_bufsz);
+		fprintf(stderr, "stream_bufsz: %zu\n", hs->stream_bufsz);
 		fprintf(stderr, "mmap_min_chunk: %zu\n", hs->mmap_min_chunk);
 		fprintf(stderr, "mmap_max_chunk: %zu\n", hs->mmap_max_chunk);
 
@@ -361,14 +370,214 @@ static size_t blake3_mmap_file_chunksize(int fd, dev_t dev, void *mem,
 
 #endif
 
-int blake3_hash_file(blake3_hasher *hasher, const char *filename,
-		     uint8_t output[BLAKE3_OUT_LEN])
+struct blake3_stream_read {
+	FILE *fp;
+	void *buf;
+	size_t bufsz;
+	size_t rdn;
+};
+
+struct blake3_stream_hash {
+	blake3_hasher *hasher;
+	const void *buf;
+	size_t len;
+};
+
+static void blake3_stream_read_work(void *arg)
+{
+	struct blake3_stream_read *rd = arg;
+
+	rd->rdn = fread(rd->buf, 1, rd->bufsz, rd->fp);
+}
+
+static void blake3_stream_hash_work(void *arg)
+{
+	struct blake3_stream_hash *hh = arg;
+
+	blake3_hasher_update(hh->hasher, hh->buf, hh->len);
+}
+
+/*
+ * Pipelined stream hashing, with two buffers; while one full buffer
+ * is hashed (in parallel, via the thread pool) the next one is read,
+ * so that the reads overlap with the hashing.
+ * The updates are still issued in order, each one a complete subtree
+ * when the buffer size is a power of two.
+ */
+static int blake3_hash_stream_pipelined(blake3_hasher *hasher, FILE *fp)
+{
+	blake3_host_state *hs;
+	struct fy_thread_work works[2];
+	struct blake3_stream_read rd;
+	struct blake3_stream_hash hh;
+	void *bufs[2] = { NULL, NULL };
+	size_t bufsz, len;
+	unsigned int cur;
+	int ret = -1;
+
+	hs = hasher->hs;
+	bufsz = hs->stream_bufsz;
+
+	bufs[0] = malloc(bufsz);
+	if (!bufs[0])
+		goto err_alloc;
+
+	/* prime the pipeline */
+	cur = 0;
+	len = fread(bufs[0], 1, bufsz, fp);
+
+	/* a short read is the end of the input */
+	while (len >= bufsz) {
+
+		/* the second buffer only when there is more than one */
+		if (!bufs[1]) {
+			bufs[1] = malloc(bufsz);
+			if (!bufs[1])
+				goto err_alloc;
+		}
+
+		hh.hasher = hasher;
+		hh.buf = bufs[cur];
+		hh.len = len;
+
+		rd.fp = fp;
+		rd.buf = bufs[!cur];
+		rd.bufsz = bufsz;
+		rd.rdn = 0;
+
+		memset(works, 0, sizeof(works));
+		works[0].fn = blake3_stream_hash_work;
+		works[0].arg = &hh;
+		works[1].fn = blake3_stream_read_work;
+		works[1].arg = &rd;
+		fy_thread_work_join(hs->tp, works, 2, NULL);
+
+		len = rd.rdn;
+		cur = !cur;
+	}
+
+	if (len > 0)
+		blake3_hasher_update(hasher, bufs[cur], len);
+
+	if (ferror(fp)) {
+		if (hs->cfg.debug)
+			fprintf(stderr, "read error while hashing stream - %s\n", strerror(errno));
+		goto out;
+	}
+
+	ret = 0;
+
+out:
+	free(bufs[1]);
+	free(bufs[0]);
+	return ret;
+
+err_alloc:
+	if (hs->cfg.debug)
+		fprintf(stderr, "Unable to allocate stream buffer of %zu bytes\n", bufsz);
+	goto out;
+}
+
+/*
+ * The saved hasher state, the chunk state and the chaining value stack
+ * (all little endian):
+ *   0: "B3S1"
+ *   4: flags, buf_len, blocks_compressed, cv_stack_len
+ *   8: chunk counter
+ *  16: chunk chaining value
+ *  48: chunk block buffer
+ * 112: chaining value stack (cv_stack_len * 32)
+ */
+#define BLAKE3_STATE_MAGIC	"B3S1"
+#define BLAKE3_STATE_HEADER	112
+
+uint64_t blake3_hasher_count(const blake3_hasher *self)
+{
+	return self->chunk.chunk_counter * BLAKE3_CHUNK_LEN +
+	       (uint64_t)BLAKE3_BLOCK_LEN * self->chunk.blocks_compressed +
+	       self->chunk.buf_len;
+}
+
+size_t blake3_hasher_save(const blake3_hasher *self, void *buf, size_t size)
+{
+	uint8_t *p = buf;
+	size_t need;
+
+	need = BLAKE3_STATE_HEADER + (size_t)self->cv_stack_len * BLAKE3_OUT_LEN;
+	if (!p || size < need)
+		return need;
+
+	memcpy(p, BLAKE3_STATE_MAGIC, 4);
+	p[4] = self->chunk.flags;
+	p[5] = self->chunk.buf_len;
+	p[6] = self->chunk.blocks_compressed;
+	p[7] = self->cv_stack_len;
+	store32(p + 8, counter_low(self->chunk.chunk_counter));
+	store32(p + 12, counter_high(self->chunk.chunk_counter));
+	store_cv_words(p + 16, (uint32_t *)self->chunk.cv);
+	memcpy(p + 48, self->chunk.buf, BLAKE3_BLOCK_LEN);
+	memcpy(p + BLAKE3_STATE_HEADER, self->cv_stack, (size_t)self->cv_stack_len * BLAKE3_OUT_LEN);
+
+	return need;
+}
+
+int blake3_hasher_restore(blake3_hasher *self, const void *buf, size_t size)
+{
+	const uint8_t *p = buf;
+	uint64_t counter;
+
+	if (!self || !p || size < BLAKE3_STATE_HEADER || memcmp(p, BLAKE3_STATE_MAGIC, 4))
+		return -1;
+
+	/* it must be of the same mode, and sane */
+	if (p[4] != self->chunk.flags || p[5] > BLAKE3_BLOCK_LEN ||
+	    p[6] >= BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN || (p[6] && !p[5]) ||
+	    p[7] > BLAKE3_MAX_DEPTH + 1 ||
+	    size != BLAKE3_STATE_HEADER + (size_t)p[7] * BLAKE3_OUT_LEN)
+		return -1;
+
+	/* finalization needs the chaining values of the whole chunks */
+	counter = (uint64_t)load32(p + 8) | ((uint64_t)load32(p + 12) << 32);
+	if (!counter ? p[7] != 0 : (!p[5] && p[7] < 2))
+		return -1;
+
+	self->chunk.buf_len = p[5];
+	self->chunk.blocks_compressed = p[6];
+	self->cv_stack_len = p[7];
+	self->chunk.chunk_counter = counter;
+	load_key_words(p + 16, self->chunk.cv);
+	memcpy(self->chunk.buf, p + 48, BLAKE3_BLOCK_LEN);
+	memcpy(self->cv_stack, p + BLAKE3_STATE_HEADER, (size_t)self->cv_stack_len * BLAKE3_OUT_LEN);
+	self->mem_node = -1;
+
+	return 0;
+}
+
+/* position the stream at the resume offset, verifying the tail already hashed */
+static int blake3_stream_resume(FILE *fp, uint64_t pos, const uint8_t *tail, size_t tail_len)
+{
+	uint8_t buf[BLAKE3_BLOCK_LEN];
+
+	if (fseeko(fp, (off_t)pos, SEEK_SET))
+		return -1;
+
+	if (tail_len && (fread(buf, 1, tail_len, fp) != tail_len || memcmp(buf, tail, tail_len))) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+static int blake3_hash_file_internal(blake3_hasher *hasher, const char *filename,
+				     uint8_t output[BLAKE3_OUT_LEN], bool resume)
 {
 	blake3_host_state *hs;
 	FILE *fp = NULL;
 	void *mem = NULL, *buf = NULL, *p;
 	int fd = -1, ret = -1;
-	size_t rdn, filesize, bufsz = 0, max_chunk, left, chunk;
+	size_t rdn, filesize, bufsz = 0, max_chunk, left, chunk, tail_len;
+	uint64_t offset;
 	struct stat sb;
 	dev_t dev = 0;
 	int rc;
@@ -379,10 +588,19 @@ int blake3_hash_file(blake3_hasher *hasher, const char *filename,
 	hs = hasher->hs;
 
 	if (hs->cfg.debug)
-		fprintf(stderr, "processing file %s\n", filename);
+		fprintf(stderr, "%s file %s\n", resume ? "resuming" : "processing", filename);
 
-	// reset the hasher (do not initialize again)
-	blake3_hasher_reset(hasher);
+	if (!resume) {
+		// reset the hasher (do not initialize again)
+		blake3_hasher_reset(hasher);
+		offset = 0;
+		tail_len = 0;
+	} else {
+		// continue after the bytes already hashed, the last of which are
+		// still in the chunk buffer and are verified against the file
+		offset = blake3_hasher_count(hasher);
+		tail_len = hasher->chunk.buf_len;
+	}
 
 	if (!strcmp(filename, "-")) {
 		fp = stdin;
@@ -416,6 +634,14 @@ int blake3_hash_file(blake3_hasher *hasher, const char *filename,
 			goto err_out;
 		}
 
+		if ((uint64_t)sb.st_size < offset) {
+			errno = EINVAL;
+			if (hs->cfg.debug)
+				fprintf(stderr, "file %s is shorter than the hashed state\n",
+					filename);
+			goto err_out;
+		}
+
 		filesize = (size_t)-1;
 
 		/* try to mmap */
@@ -439,6 +665,8 @@ int blake3_hash_file(blake3_hasher *hasher, const char *filename,
 						filename, strerror(errno));
 				goto err_out;
 			}
+			/* owned by the stream now */
+			fd = -1;
 		}
 	}
 
@@ -449,14 +677,35 @@ int blake3_hash_file(blake3_hasher *hasher, const char *filename,
 		max_chunk = blake3_mmap_file_chunksize(fd, dev, mem, filesize,
 						       hs->mmap_min_chunk, hs->mmap_max_chunk);
 
-		p = mem;
-		left = filesize;
+		p = mem + (offset - tail_len);
+		if (tail_len && memcmp(p, hasher->chunk.buf, tail_len)) {
+			errno = EINVAL;
+			if (hs->cfg.debug)
+				fprintf(stderr, "file %s does not match the hashed state\n",
+					filename);
+			goto err_out;
+		}
+		p += tail_len;
+		left = filesize - offset;
 		while (left > 0) {
 			chunk = left > max_chunk ? max_chunk : left;
 			blake3_hasher_update(hasher, p, chunk);
 			p += chunk;
 			left -= chunk;
 		}
+	} else if (offset > 0 && blake3_stream_resume(fp, offset - tail_len, hasher->chunk.buf, tail_len)) {
+		if (hs->cfg.debug)
+			fprintf(stderr, "unable to resume %s - %s\n",
+				filename, strerror(errno));
+		goto err_out;
+	} else if (hs->tp) {
+		/* reads overlapping the threaded hashing */
+
+		assert(fp);
+
+		rc = blake3_hash_stream_pipelined(hasher, fp);
+		if (rc)
+			goto err_out;
 	} else {
 		/* slow path using file reads */
 
@@ -511,6 +760,361 @@ err_out:
 	goto out;
 }
 
+struct blake3_batch_file {
+	blake3_hasher *hasher;
+	const char *filename;
+	uint8_t *output;
+	size_t idx;
+	int err;
+};
+
+static int blake3_hash_file_err(blake3_hasher *hasher, const char *filename, uint8_t *output)
+{
+	/* errno is per thread, return it */
+	errno = 0;
+	if (!blake3_hash_file(hasher, filename, output))
+		return 0;
+	return errno ? errno : EIO;
+}
+
+static void blake3_batch_file_work(void *arg)
+{
+	struct blake3_batch_file *bf = arg;
+
+	bf->err = blake3_hash_file_err(bf->hasher, bf->filename, bf->output);
+}
+
+static int blake3_hash_batch(blake3_host_state *hs, struct blake3_batch_file *batch, size_t count, int *errs)
+{
+	struct blake3_batch_file *bf;
+	size_t i;
+	int ret = 0;
+
+	fy_thread_arg_array_join(hs->tp, blake3_batch_file_work, NULL,
+				 batch, sizeof(batch[0]), count);
+
+	for (i = 0, bf = batch; i < count; i++, bf++) {
+		if (errs)
+			errs[bf->idx] = bf->err;
+		if (bf->err)
+			ret = -1;
+	}
+
+	return ret;
+}
+
+/*
+ * Hash many files, concurrently. The small files are hashed in batches,
+ * each file serially on its own thread (and its own copy of the hasher),
+ * while the large ones are hashed one at a time split across all the
+ * threads. The outputs are in the order of the input filenames.
+ */
+int blake3_hash_files(blake3_hasher *hasher, const char * const *filenames, size_t count,
+		      uint8_t (*outputs)[BLAKE3_OUT_LEN], int *errs)
+{
+	blake3_host_state *hs;
+	blake3_hasher *clones = NULL;
+	struct blake3_batch_file *batch = NULL, *bf;
+	struct stat sb;
+	uint64_t large_size;
+	size_t i, batch_count;
+	int num_threads, err, ret = 0;
+
+	if (!hasher || (count && (!filenames || !outputs)))
+		return -1;
+
+	hs = hasher->hs;
+
+	/* large enough to keep all the threads busy on its own */
+	num_threads = hs->tp ? fy_thread_pool_get_num_threads(hs->tp) : 0;
+	large_size = (uint64_t)hs->mt_degree * BLAKE3_CHUNK_LEN * (unsigned int)(num_threads > 0 ? num_threads : 1);
+
+	if (num_threads > 1) {
+		batch = malloc(sizeof(*batch) * BLAKE3_BATCH_FILES);
+		clones = fy_cacheline_alloc(sizeof(*clones) * BLAKE3_BATCH_FILES);
+		if (!batch || !clones) {
+			ret = -1;
+			goto out;
+		}
+	}
+
+	batch_count = 0;
+	for (i = 0; i < count; i++) {
+
+		/* single threaded, the large files and stdin, directly */
+		if (!batch || !strcmp(filenames[i], "-") ||
+		    (!stat(filenames[i], &sb) && (!S_ISREG(sb.st_mode) || (uint64_t)sb.st_size >= large_size))) {
+			err = blake3_hash_file_err(hasher, filenames[i], outputs[i]);
+			if (errs)
+				errs[i] = err;
+			if (err)
+				ret = -1;
+			continue;
+		}
+
+		/* a copy of the hasher, in the same mode */
+		memcpy(&clones[batch_count], hasher, sizeof(*hasher));
+
+		bf = &batch[batch_count++];
+		bf->hasher = &clones[batch_count - 1];
+		bf->filename = filenames[i];
+		bf->output = outputs[i];
+		bf->idx = i;
+		bf->err = 0;
+
+		if (batch_count >= BLAKE3_BATCH_FILES) {
+			if (blake3_hash_batch(hs, batch, batch_count, errs))
+				ret = -1;
+			batch_count = 0;
+		}
+	}
+
+	if (batch_count > 0 && blake3_hash_batch(hs, batch, batch_count, errs))
+		ret = -1;
+
+out:
+	if (clones)
+		fy_cacheline_free(clones);
+	if (batch)
+		free(batch);
+
+	return ret;
+}
+
+int blake3_hash_file(blake3_hasher *hasher, const char *filename,
+		     uint8_t output[BLAKE3_OUT_LEN])
+{
+	return blake3_hash_file_internal(hasher, filename, output, false);
+}
+
+int blake3_hash_file_resume(blake3_hasher *hasher, const char *filename,
+			    uint8_t output[BLAKE3_OUT_LEN])
+{
+	return blake3_hash_file_internal(hasher, filename, output, true);
+}
+
+/*
+ * The outboard tree (all little endian):
+ *  0: "B3O1"
+ *  4: group_log, 3 reserved bytes (zero)
+ *  8: content length
+ * 16: the parent nodes of the tree in pre-order, each one the chaining
+ *     values of its left and right children (64 bytes)
+ *
+ * The tree is the BLAKE3 tree itself, with the subtrees of each group
+ * of chunks (the last one may be partial) as the leaves; there are
+ * groups - 1 parent nodes.
+ */
+#define BLAKE3_OUTBOARD_MAGIC	"B3O1"
+
+struct blake3_outboard_node {
+	blake3_hasher *hasher;
+	const uint8_t *mem;
+	size_t group_len;
+	size_t start;			/* the content range of the node */
+	size_t len;
+	bool is_root;
+	uint8_t *parents;		/* where the parent nodes of the node go */
+	uint8_t cv[BLAKE3_OUT_LEN];	/* the resulting chaining value */
+};
+
+static inline uint64_t blake3_outboard_groups(uint64_t len, uint64_t group_len)
+{
+	return len ? (len + group_len - 1) / group_len : 1;
+}
+
+/* the same split as the hash tree, the largest power of 2 chunks leaving at least a byte */
+static inline uint64_t blake3_outboard_left_len(uint64_t len)
+{
+	return round_down_to_power_of_2((len - 1) / BLAKE3_CHUNK_LEN) * BLAKE3_CHUNK_LEN;
+}
+
+size_t blake3_outboard_size(uint64_t content_len, unsigned int group_log)
+{
+	if (group_log > BLAKE3_OUTBOARD_MAX_GROUP_LOG)
+		return 0;
+
+	return BLAKE3_OUTBOARD_HEADER_LEN +
+	       (size_t)(blake3_outboard_groups(content_len, (uint64_t)BLAKE3_CHUNK_LEN << group_log) - 1) *
+	       BLAKE3_BLOCK_LEN;
+}
+
+static bool blake3_outboard_encode_work_check(const void *arg)
+{
+	const struct blake3_outboard_node *n = arg;
+
+	/* only off-load to thread if we have enough input */
+	return n->len >= (size_t)n->hasher->hs->mt_degree * BLAKE3_CHUNK_LEN;
+}
+
+static void blake3_outboard_encode_node(void *arg)
+{
+	struct blake3_outboard_node *n = arg, kids[2];
+	blake3_host_state *hs = n->hasher->hs;
+	size_t left_len;
+	int i;
+
+	if (n->len <= n->group_len) {
+		hs->hasher_ops->hasher_subtree_cv(n->hasher, n->mem + n->start, n->len,
+						  n->start / BLAKE3_CHUNK_LEN, n->is_root, n->cv);
+		return;
+	}
+
+	left_len = blake3_outboard_left_len(n->len);
+
+	for (i = 0; i < 2; i++) {
+		kids[i].hasher = n->hasher;
+		kids[i].mem = n->mem;
+		kids[i].group_len = n->group_len;
+		kids[i].is_root = false;
+	}
+	kids[0].start = n->start;
+	kids[0].len = left_len;
+	kids[0].parents = n->parents + BLAKE3_BLOCK_LEN;
+	kids[1].start = n->start + left_len;
+	kids[1].len = n->len - left_len;
+	kids[1].parents = n->parents + blake3_outboard_groups(left_len, n->group_len) * BLAKE3_BLOCK_LEN;
+
+	/* the subtrees write to disjoint parts of the outboard */
+	if (hs->tp) {
+		fy_thread_arg_array_join_node(hs->tp,
+				blake3_outboard_encode_node,
+				blake3_outboard_encode_work_check,
+				kids, sizeof(kids[0]), 2, n->hasher->mem_node);
+	} else {
+		blake3_outboard_encode_node(&kids[0]);
+		blake3_outboard_encode_node(&kids[1]);
+	}
+
+	memcpy(n->parents, kids[0].cv, BLAKE3_OUT_LEN);
+	memcpy(n->parents + BLAKE3_OUT_LEN, kids[1].cv, BLAKE3_OUT_LEN);
+	hs->hasher_ops->hasher_parent_cv(n->hasher, n->parents, n->is_root, n->cv);
+}
+
+int blake3_outboard_encode(blake3_hasher *hasher, const void *mem, size_t size, unsigned int group_log,
+			   void *outboard, size_t outboard_size, uint8_t output[BLAKE3_OUT_LEN])
+{
+	struct blake3_outboard_node root;
+	uint8_t *p = outboard;
+
+	if (!hasher || !mem || !p || group_log > BLAKE3_OUTBOARD_MAX_GROUP_LOG ||
+	    outboard_size < blake3_outboard_size(size, group_log)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	memcpy(p, BLAKE3_OUTBOARD_MAGIC, 4);
+	p[4] = (uint8_t)group_log;
+	p[5] = p[6] = p[7] = 0;
+	store32(p + 8, counter_low(size));
+	store32(p + 12, counter_high(size));
+
+	// Prefer the threads on the NUMA node of the content
+	if (hasher->hs->tp && size > BLAKE3_CHUNK_LEN)
+		hasher->mem_node = fy_thread_pool_mem_node(hasher->hs->tp, mem);
+
+	root.hasher = hasher;
+	root.mem = mem;
+	root.group_len = (size_t)BLAKE3_CHUNK_LEN << group_log;
+	root.start = 0;
+	root.len = size;
+	root.is_root = true;
+	root.parents = p + BLAKE3_OUTBOARD_HEADER_LEN;
+
+	blake3_outboard_encode_node(&root);
+
+	if (output)
+		memcpy(output, root.cv, BLAKE3_OUT_LEN);
+
+	return 0;
+}
+
+struct blake3_outboard_verify_ctx {
+	blake3_hasher *hasher;
+	const uint8_t *mem;
+	size_t group_len;
+	size_t start;			/* the range to verify */
+	size_t end;
+};
+
+/* verify the node, going down only to the children the range overlaps */
+static int blake3_outboard_verify_node(const struct blake3_outboard_verify_ctx *ctx,
+				       size_t start, size_t len, bool is_root,
+				       const uint8_t *parents, const uint8_t expected[BLAKE3_OUT_LEN])
+{
+	blake3_host_state *hs = ctx->hasher->hs;
+	uint8_t cv[BLAKE3_OUT_LEN];
+	size_t left_len;
+
+	if (len <= ctx->group_len) {
+		hs->hasher_ops->hasher_subtree_cv(ctx->hasher, ctx->mem + start, len,
+						  start / BLAKE3_CHUNK_LEN, is_root, cv);
+		return memcmp(cv, expected, BLAKE3_OUT_LEN) ? -1 : 0;
+	}
+
+	hs->hasher_ops->hasher_parent_cv(ctx->hasher, parents, is_root, cv);
+	if (memcmp(cv, expected, BLAKE3_OUT_LEN))
+		return -1;
+
+	left_len = blake3_outboard_left_len(len);
+
+	if (ctx->start < start + left_len &&
+	    blake3_outboard_verify_node(ctx, start, left_len, false,
+					parents + BLAKE3_BLOCK_LEN, parents))
+		return -1;
+
+	if (ctx->end > start + left_len &&
+	    blake3_outboard_verify_node(ctx, start + left_len, len - left_len, false,
+					parents + blake3_outboard_groups(left_len, ctx->group_len) * BLAKE3_BLOCK_LEN,
+					parents + BLAKE3_OUT_LEN))
+		return -1;
+
+	return 0;
+}
+
+int blake3_outboard_verify(blake3_hasher *hasher, const uint8_t root[BLAKE3_OUT_LEN],
+			   const void *outboard, size_t outboard_size,
+			   const void *mem, uint64_t offset, uint64_t len)
+{
+	struct blake3_outboard_verify_ctx ctx;
+	const uint8_t *p = outboard;
+	unsigned int group_log;
+	uint64_t size;
+
+	if (!hasher || !root || !p || !mem || outboard_size < BLAKE3_OUTBOARD_HEADER_LEN ||
+	    memcmp(p, BLAKE3_OUTBOARD_MAGIC, 4)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	group_log = p[4];
+	size = (uint64_t)load32(p + 8) | ((uint64_t)load32(p + 12) << 32);
+	if (group_log > BLAKE3_OUTBOARD_MAX_GROUP_LOG || size > SIZE_MAX ||
+	    outboard_size != blake3_outboard_size(size, group_log) ||
+	    offset > size || len > size - offset) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* nothing to verify */
+	if (!len)
+		return 0;
+
+	ctx.hasher = hasher;
+	ctx.mem = mem;
+	ctx.group_len = (size_t)BLAKE3_CHUNK_LEN << group_log;
+	ctx.start = (size_t)offset;
+	ctx.end = (size_t)(offset + len);
+
+	if (blake3_outboard_verify_node(&ctx, 0, (size_t)size, true,
+					p + BLAKE3_OUTBOARD_HEADER_LEN, root)) {
+		errno = EBADMSG;
+		return -1;
+	}
+
+	return 0;
+}
+
 void blake3_hash(struct blake3_hasher *hasher,
 		 const void *mem, size_t size, uint8_t output[BLAKE3_OUT_LEN])
 {
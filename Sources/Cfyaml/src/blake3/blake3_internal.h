@@ -52,6 +52,7 @@ typedef struct blake3_hasher {
 	// reference implementation does things.
 	uint8_t cv_stack[(BLAKE3_MAX_DEPTH + 1) * BLAKE3_OUT_LEN] BLAKE3_ALIGN;
 	uint8_t cv_stack_len;
+	int mem_node;			// NUMA node of the input being hashed, -1 if unknown
 } blake3_hasher BLAKE3_ALIGN;
 
 typedef void (*blake3_hash_many_f)(const uint8_t *const *inputs, size_t num_inputs,
@@ -137,6 +138,7 @@ typedef struct blake3_host_state {
 	struct fy_thread_pool *tp;
 
 	size_t file_io_bufsz;
+	size_t stream_bufsz;		/* each of the pipelined stream buffers */
 	size_t mmap_min_chunk;
 	size_t mmap_max_chunk;
 
@@ -112,6 +112,77 @@ const uint8_t *fy_blake3_hash_file(struct fy_blake3_hasher *fyh, const char *fil
 	return fyh->output;
 }
 
+int fy_blake3_hash_files(struct fy_blake3_hasher *fyh, const char * const *filenames, size_t count,
+			 uint8_t (*outputs)[FY_BLAKE3_OUT_LEN], int *errs)
+{
+	if (!fyh)
+		return -1;
+
+	return blake3_hash_files(fyh->hasher, filenames, count, outputs, errs);
+}
+
+size_t fy_blake3_hasher_save_state(struct fy_blake3_hasher *fyh, void *buf, size_t size)
+{
+	if (!fyh)
+		return 0;
+
+	return blake3_hasher_save(fyh->hasher, buf, size);
+}
+
+int fy_blake3_hasher_restore_state(struct fy_blake3_hasher *fyh, const void *buf, size_t size)
+{
+	if (!fyh || !buf)
+		return -1;
+
+	return blake3_hasher_restore(fyh->hasher, buf, size);
+}
+
+const uint8_t *fy_blake3_hash_file_resume(struct fy_blake3_hasher *fyh, const char *filename)
+{
+	int rc;
+
+	if (!fyh || !filename)
+		return NULL;
+
+	rc = blake3_hash_file_resume(fyh->hasher, filename, fyh->output);
+	if (rc)
+		return NULL;
+
+	return fyh->output;
+}
+
+size_t fy_blake3_outboard_size(uint64_t content_len, unsigned int group_log)
+{
+	return blake3_outboard_size(content_len, group_log);
+}
+
+const uint8_t *fy_blake3_outboard_encode(struct fy_blake3_hasher *fyh, const void *mem, size_t size,
+					 unsigned int group_log, void *outboard, size_t outboard_size)
+{
+	int rc;
+
+	if (!fyh || !mem || !outboard)
+		return NULL;
+
+	rc = blake3_outboard_encode(fyh->hasher, mem, size, group_log,
+				    outboard, outboard_size, fyh->output);
+	if (rc)
+		return NULL;
+
+	return fyh->output;
+}
+
+int fy_blake3_outboard_verify(struct fy_blake3_hasher *fyh, const uint8_t *hash,
+			      const void *outboard, size_t outboard_size,
+			      const void *mem, uint64_t offset, uint64_t len)
+{
+	if (!fyh || !hash || !outboard || !mem)
+		return -1;
+
+	return blake3_outboard_verify(fyh->hasher, hash, outboard, outboard_size,
+				      mem, offset, len);
+}
+
 const uint8_t *fy_blake3_hash(struct fy_blake3_hasher *fyh, const void *mem, size_t size)
 {
 	if (!fyh || !mem)
@@ -0,0 +1,740 @@
+/*
+ * fy-b3bench.c - blake3 backend and thread scaling benchmark
+ *
+ * Copyright (c) 2023 Pantelis Antoniou <pantelis.antoniou@konsulko.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <ctype.h>
+#include <assert.h>
+
+#include <blake3.h>
+
+#define OPT_MIN_SIZE		128
+#define OPT_MAX_SIZE		129
+#define OPT_MAX_FILE_SIZE	130
+#define OPT_SIZE_STEP		131
+#define OPT_BACKENDS		132
+#define OPT_THREADS		133
+#define OPT_MODES		134
+#define OPT_MMAP_CHUNKS		135
+#define OPT_MIN_TIME		136
+#define OPT_TMPDIR		137
+#define OPT_FORMAT		138
+#define OPT_COLD		139
+
+#define B3BENCH_MAX_LIST	64
+#define B3BENCH_MAX_SIZES	64
+
+/* a result within this fraction of the best counts as the best */
+#define B3BENCH_SLACK		0.05
+
+enum b3bench_mode {
+	B3BM_MEM,	/* in memory buffer */
+	B3BM_MMAP,	/* file, mmap */
+	B3BM_READ,	/* file, buffered read */
+	B3BM_COUNT
+};
+
+static const char *mode_names[B3BM_COUNT] = {
+	[B3BM_MEM]	= "mem",
+	[B3BM_MMAP]	= "mmap",
+	[B3BM_READ]	= "read",
+};
+
+enum b3bench_format {
+	B3BF_CSV,
+	B3BF_JSON,
+};
+
+struct b3bench_result {
+	enum b3bench_mode mode;
+	const char *backend;
+	unsigned int threads;
+	size_t mmap_chunk;	/* 0 is the default heuristic */
+	size_t size;
+	unsigned long long iterations;
+	double seconds;
+	double bytes_per_sec;
+	bool ok;
+};
+
+struct b3bench {
+	size_t sizes[B3BENCH_MAX_SIZES];
+	unsigned int num_sizes;
+	size_t max_file_size;
+	const char *backends[B3BENCH_MAX_LIST];
+	unsigned int num_backends;
+	unsigned int threads[B3BENCH_MAX_LIST];
+	unsigned int num_threads;
+	size_t mmap_chunks[B3BENCH_MAX_LIST];
+	unsigned int num_mmap_chunks;
+	bool modes[B3BM_COUNT];
+	double min_time;
+	const char *tmpdir;
+	enum b3bench_format format;
+	bool cold;
+
+	uint8_t *mem;
+	char *files[B3BENCH_MAX_SIZES];
+	uint8_t refs[B3BENCH_MAX_SIZES][BLAKE3_OUT_LEN];
+	bool has_ref[B3BENCH_MAX_SIZES];
+
+	struct b3bench_result *results;
+	size_t num_results;
+	size_t alloc_results;
+};
+
+static struct option lopts[] = {
+	{"min-size",		required_argument,	0,	OPT_MIN_SIZE },
+	{"max-size",		required_argument,	0,	OPT_MAX_SIZE },
+	{"max-file-size",	required_argument,	0,	OPT_MAX_FILE_SIZE },
+	{"size-step",		required_argument,	0,	OPT_SIZE_STEP },
+	{"backends",		required_argument,	0,	OPT_BACKENDS },
+	{"threads",		required_argument,	0,	OPT_THREADS },
+	{"modes",		required_argument,	0,	OPT_MODES },
+	{"mmap-chunks",		required_argument,	0,	OPT_MMAP_CHUNKS },
+	{"min-time",		required_argument,	0,	OPT_MIN_TIME },
+	{"tmpdir",		required_argument,	0,	OPT_TMPDIR },
+	{"format",		required_argument,	0,	OPT_FORMAT },
+	{"cold",		no_argument,		0,	OPT_COLD },
+	{"help",		no_argument,		0,	'h' },
+	{0,			0,              	0,	 0  },
+};
+
+static void display_usage(FILE *fp, const char *progname)
+{
+	const char *s;
+
+	s = strrchr(progname, '/');
+	if (s != NULL)
+		progname = s + 1;
+
+	fprintf(fp, "Usage:\n\t%s [options]\n", progname);
+	fprintf(fp, "\noptions:\n");
+	fprintf(fp, "\t--min-size <n>            : Smallest input size (default 64)\n");
+	fprintf(fp, "\t--max-size <n>            : Largest input size (default 1G)\n");
+	fprintf(fp, "\t--max-file-size <n>       : Largest file size for the file modes (default max-size)\n");
+	fprintf(fp, "\t--size-step <n>           : Size multiplier between runs (default 4)\n");
+	fprintf(fp, "\t--backends <list>         : Backends to run, 'auto' is the default selection\n");
+	fprintf(fp, "\t                            (default: auto and all the available backends)\n");
+	fprintf(fp, "\t--threads <list>          : Thread counts, 1 is single threaded (default: 1,2,4,... up to the CPUs)\n");
+	fprintf(fp, "\t--modes <list>            : Input modes, mem, mmap, read (default: all)\n");
+	fprintf(fp, "\t--mmap-chunks <list>      : mmap chunk sizes, 'auto' is the default heuristic\n");
+	fprintf(fp, "\t                            (auto is always measured, as the baseline)\n");
+	fprintf(fp, "\t--min-time <ms>           : Minimum time to spend on each measurement (default 250)\n");
+	fprintf(fp, "\t--tmpdir <dir>            : Directory for the input files (default $TMPDIR or /tmp)\n");
+	fprintf(fp, "\t--format <csv|json>       : Output format, CSV or JSON lines (default csv)\n");
+	fprintf(fp, "\t--cold                    : Drop the input file pages from the cache before each run\n");
+	fprintf(fp, "\t--help, -h                : Display help message\n");
+	fprintf(fp, "\nsizes accept K, M and G suffixes (powers of 1024), lists are comma separated.\n");
+	fprintf(fp, "Results go to stdout, a summary of the best backend and mmap chunk to stderr.\n");
+}
+
+static int parse_size(const char *str, size_t *sizep)
+{
+	unsigned long long v;
+	char *end;
+
+	errno = 0;
+	v = strtoull(str, &end, 10);
+	if (errno || end == str)
+		return -1;
+
+	switch (toupper((unsigned char)*end)) {
+	case 'G':
+		v <<= 10;
+		/* fall-through */
+	case 'M':
+		v <<= 10;
+		/* fall-through */
+	case 'K':
+		v <<= 10;
+		end++;
+		break;
+	case '\0':
+		break;
+	default:
+		return -1;
+	}
+	if (*end)
+		return -1;
+
+	*sizep = (size_t)v;
+	return 0;
+}
+
+/* split a comma separated list in place, returns the number of items or -1 */
+static int split_list(char *str, char **items, unsigned int max_items)
+{
+	unsigned int count;
+	char *s;
+
+	count = 0;
+	for (s = strtok(str, ","); s; s = strtok(NULL, ",")) {
+		if (count >= max_items)
+			return -1;
+		items[count++] = s;
+	}
+	return count > 0 ? (int)count : -1;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void default_backends(struct b3bench *b)
+{
+	const blake3_backend_info *bei;
+	uint64_t backends;
+	unsigned int i;
+
+	b->backends[b->num_backends++] = "auto";
+
+	backends = blake3_get_selectable_backends() &
+		   blake3_get_detected_backends();
+	for (i = 0; i < B3BID_COUNT && b->num_backends < B3BENCH_MAX_LIST; i++) {
+		if (!(backends & ((uint64_t)1 << i)))
+			continue;
+		bei = blake3_get_backend_info(i);
+		if (bei)
+			b->backends[b->num_backends++] = bei->name;
+	}
+}
+
+static void default_threads(struct b3bench *b)
+{
+	unsigned int n, num_cpus;
+	long scval;
+
+	scval = sysconf(_SC_NPROCESSORS_ONLN);
+	num_cpus = scval > 0 ? (unsigned int)scval : 1;
+
+	for (n = 1; n < num_cpus && b->num_threads < B3BENCH_MAX_LIST - 1; n <<= 1)
+		b->threads[b->num_threads++] = n;
+	b->threads[b->num_threads++] = num_cpus;
+}
+
+static int create_file(struct b3bench *b, unsigned int idx)
+{
+	size_t size, left, n;
+	ssize_t wrn;
+	char *path;
+	int fd;
+
+	size = b->sizes[idx];
+	if (asprintf(&path, "%s/fy-b3bench-XXXXXX", b->tmpdir) < 0)
+		return -1;
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "Error: unable to create file in %s: %s\n", b->tmpdir, strerror(errno));
+		free(path);
+		return -1;
+	}
+
+	/* same content as the memory buffer, so the hashes must match */
+	for (left = size; left > 0; left -= (size_t)wrn) {
+		n = left > (64 << 20) ? (64 << 20) : left;
+		wrn = write(fd, b->mem + (size - left), n);
+		if (wrn <= 0) {
+			fprintf(stderr, "Error: unable to write %s: %s\n", path, strerror(errno));
+			goto err_out;
+		}
+	}
+	close(fd);
+
+	b->files[idx] = path;
+	return 0;
+
+err_out:
+	close(fd);
+	unlink(path);
+	free(path);
+	return -1;
+}
+
+static void drop_file_cache(const char *path)
+{
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return;
+#if defined(POSIX_FADV_DONTNEED)
+	(void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+	close(fd);
+}
+
+static int hash_once(struct b3bench *b, struct blake3_hasher *hasher,
+		     enum b3bench_mode mode, unsigned int idx, uint8_t output[BLAKE3_OUT_LEN])
+{
+	if (mode == B3BM_MEM) {
+		blake3_hash(hasher, b->mem, b->sizes[idx], output);
+		return 0;
+	}
+	return blake3_hash_file(hasher, b->files[idx], output);
+}
+
+static int add_result(struct b3bench *b, const struct b3bench_result *r)
+{
+	struct b3bench_result *results;
+	size_t alloc;
+
+	if (b->num_results >= b->alloc_results) {
+		alloc = b->alloc_results ? b->alloc_results * 2 : 64;
+		results = realloc(b->results, alloc * sizeof(*results));
+		if (!results)
+			return -1;
+		b->results = results;
+		b->alloc_results = alloc;
+	}
+	b->results[b->num_results++] = *r;
+	return 0;
+}
+
+static void output_header(struct b3bench *b)
+{
+	if (b->format == B3BF_CSV)
+		printf("mode,backend,threads,mmap_chunk,size,iterations,seconds,bytes_per_sec,ok\n");
+}
+
+static void output_result(struct b3bench *b, const struct b3bench_result *r)
+{
+	if (b->format == B3BF_CSV)
+		printf("%s,%s,%u,%zu,%zu,%llu,%.6f,%.0f,%d\n",
+				mode_names[r->mode], r->backend, r->threads, r->mmap_chunk,
+				r->size, r->iterations, r->seconds, r->bytes_per_sec, r->ok);
+	else
+		printf("{\"mode\":\"%s\",\"backend\":\"%s\",\"threads\":%u,\"mmap_chunk\":%zu,"
+		       "\"size\":%zu,\"iterations\":%llu,\"seconds\":%.6f,\"bytes_per_sec\":%.0f,\"ok\":%s}\n",
+				mode_names[r->mode], r->backend, r->threads, r->mmap_chunk,
+				r->size, r->iterations, r->seconds, r->bytes_per_sec, r->ok ? "true" : "false");
+	fflush(stdout);
+}
+
+static int run_config(struct b3bench *b, enum b3bench_mode mode, const char *backend,
+		      unsigned int threads, size_t mmap_chunk)
+{
+	blake3_host_config host_cfg;
+	struct blake3_host_state *host_state = NULL;
+	struct blake3_hasher *hasher = NULL;
+	struct b3bench_result r;
+	uint8_t output[BLAKE3_OUT_LEN];
+	unsigned long long iterations, batch, i;
+	double start, elapsed;
+	unsigned int idx;
+	int rc;
+
+	memset(&host_cfg, 0, sizeof(host_cfg));
+	host_cfg.backend = backend;
+	host_cfg.no_mthread = threads <= 1;
+	host_cfg.num_threads = threads;
+	host_cfg.no_mmap = mode == B3BM_READ;
+	host_cfg.mmap_min_chunk = mmap_chunk;
+	host_cfg.mmap_max_chunk = mmap_chunk;
+
+	host_state = blake3_host_state_create(&host_cfg);
+	if (!host_state) {
+		fprintf(stderr, "Error: unable to create host state (backend %s, threads %u)\n", backend, threads);
+		goto err_out;
+	}
+
+	hasher = blake3_hasher_create(host_state, NULL, NULL, 0);
+	if (!hasher) {
+		fprintf(stderr, "Error: unable to create hasher\n");
+		goto err_out;
+	}
+
+	for (idx = 0; idx < b->num_sizes; idx++) {
+
+		if (mode != B3BM_MEM && !b->files[idx])
+			continue;
+
+		/* batches double until the minimum time is reached */
+		iterations = 0;
+		elapsed = 0.0;
+		batch = 1;
+		rc = 0;
+		do {
+			start = now();
+			for (i = 0; i < batch && !rc; i++) {
+				if (b->cold && mode != B3BM_MEM) {
+					/* keep the cache dropping out of the measurement */
+					elapsed += now() - start;
+					drop_file_cache(b->files[idx]);
+					start = now();
+				}
+				rc = hash_once(b, hasher, mode, idx, output);
+			}
+			elapsed += now() - start;
+			iterations += batch;
+			batch <<= 1;
+		} while (!rc && elapsed < b->min_time);
+
+		if (rc) {
+			fprintf(stderr, "Error: hashing failed (mode %s, size %zu)\n", mode_names[mode], b->sizes[idx]);
+			goto err_out;
+		}
+
+		/* the first result of each size is the reference for all the others */
+		if (!b->has_ref[idx]) {
+			memcpy(b->refs[idx], output, BLAKE3_OUT_LEN);
+			b->has_ref[idx] = true;
+		}
+
+		memset(&r, 0, sizeof(r));
+		r.mode = mode;
+		r.backend = backend;
+		r.threads = threads;
+		r.mmap_chunk = mmap_chunk;
+		r.size = b->sizes[idx];
+		r.iterations = iterations;
+		r.seconds = elapsed;
+		r.bytes_per_sec = elapsed > 0.0 ? (double)r.size * (double)iterations / elapsed : 0.0;
+		r.ok = !memcmp(b->refs[idx], output, BLAKE3_OUT_LEN);
+
+		output_result(b, &r);
+		if (add_result(b, &r))
+			goto err_out;
+
+		if (!r.ok)
+			fprintf(stderr, "Error: hash mismatch (mode %s, backend %s, threads %u, size %zu)\n",
+					mode_names[mode], backend, threads, r.size);
+	}
+
+	blake3_hasher_destroy(hasher);
+	blake3_host_state_destroy(host_state);
+	return 0;
+
+err_out:
+	blake3_hasher_destroy(hasher);
+	blake3_host_state_destroy(host_state);
+	return -1;
+}
+
+static const struct b3bench_result *
+find_result(struct b3bench *b, enum b3bench_mode mode, const char *backend,
+	    unsigned int threads, size_t mmap_chunk, size_t size)
+{
+	const struct b3bench_result *r;
+	size_t i;
+
+	for (i = 0; i < b->num_results; i++) {
+		r = &b->results[i];
+		if (r->mode == mode && !strcmp(r->backend, backend) && r->threads == threads &&
+		    r->mmap_chunk == mmap_chunk && r->size == size)
+			return r;
+	}
+	return NULL;
+}
+
+/* point out where the default choices are not the best ones measured */
+static void summarize(struct b3bench *b)
+{
+	const struct b3bench_result *r, *ra, *best;
+	unsigned int m, t, idx, k;
+	size_t i;
+
+	for (i = 0; i < b->num_results; i++) {
+		if (!b->results[i].ok) {
+			fprintf(stderr, "summary: hash mismatches found, the results are not valid\n");
+			break;
+		}
+	}
+
+	for (m = 0; m < B3BM_COUNT; m++) {
+		for (t = 0; t < b->num_threads; t++) {
+			for (idx = 0; idx < b->num_sizes; idx++) {
+
+				/* the default backend selection against the others */
+				ra = find_result(b, m, "auto", b->threads[t], 0, b->sizes[idx]);
+				best = NULL;
+				for (k = 0; k < b->num_backends; k++) {
+					r = find_result(b, m, b->backends[k], b->threads[t], 0, b->sizes[idx]);
+					if (r && (!best || r->bytes_per_sec > best->bytes_per_sec))
+						best = r;
+				}
+				if (ra && best && best != ra &&
+				    ra->bytes_per_sec < best->bytes_per_sec * (1.0 - B3BENCH_SLACK))
+					fprintf(stderr, "summary: %s threads=%u size=%zu: backend %s is %.1f%% faster than auto\n",
+							mode_names[m], b->threads[t], b->sizes[idx], best->backend,
+							100.0 * (best->bytes_per_sec / ra->bytes_per_sec - 1.0));
+
+				/* the default mmap chunk heuristic against fixed chunks */
+				if (m != B3BM_MMAP)
+					continue;
+				for (k = 0; k < b->num_backends; k++) {
+					ra = find_result(b, m, b->backends[k], b->threads[t], 0, b->sizes[idx]);
+					if (!ra)
+						continue;
+					best = ra;
+					for (i = 0; i < b->num_mmap_chunks; i++) {
+						r = find_result(b, m, b->backends[k], b->threads[t], b->mmap_chunks[i], b->sizes[idx]);
+						if (r && r->bytes_per_sec > best->bytes_per_sec)
+							best = r;
+					}
+					if (best != ra && ra->bytes_per_sec < best->bytes_per_sec * (1.0 - B3BENCH_SLACK))
+						fprintf(stderr, "summary: mmap backend=%s threads=%u size=%zu: chunk %zu is %.1f%% faster than auto\n",
+								b->backends[k], b->threads[t], b->sizes[idx], best->mmap_chunk,
+								100.0 * (best->bytes_per_sec / ra->bytes_per_sec - 1.0));
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	struct b3bench bench, *b = &bench;
+	char *items[B3BENCH_MAX_LIST];
+	size_t min_size = 64, max_size = (size_t)1 << 30, max_file_size = 0, size, step = 4;
+	unsigned int m, k, t, c, idx;
+	int i, opt, lidx, count, opti;
+	int exitcode = EXIT_FAILURE;
+	bool modes_set = false;
+
+	memset(b, 0, sizeof(*b));
+	b->min_time = 0.25;
+	b->format = B3BF_CSV;
+	b->tmpdir = getenv("TMPDIR");
+	if (!b->tmpdir || !b->tmpdir[0])
+		b->tmpdir = "/tmp";
+
+	while ((opt = getopt_long_only(argc, argv, "h", lopts, &lidx)) != -1) {
+		switch (opt) {
+
+		case OPT_MIN_SIZE:
+		case OPT_MAX_SIZE:
+		case OPT_MAX_FILE_SIZE:
+		case OPT_SIZE_STEP:
+			if (parse_size(optarg, &size) || !size) {
+				fprintf(stderr, "Error: bad size %s\n\n", optarg);
+				goto err_out_usage;
+			}
+			if (opt == OPT_MIN_SIZE)
+				min_size = size;
+			else if (opt == OPT_MAX_SIZE)
+				max_size = size;
+			else if (opt == OPT_MAX_FILE_SIZE)
+				max_file_size = size;
+			else if (size < 2) {
+				fprintf(stderr, "Error: bad size-step %s (must be >= 2)\n\n", optarg);
+				goto err_out_usage;
+			} else
+				step = size;
+			break;
+
+		case OPT_BACKENDS:
+			count = split_list(optarg, items, B3BENCH_MAX_LIST);
+			if (count < 0) {
+				fprintf(stderr, "Error: bad backend list\n\n");
+				goto err_out_usage;
+			}
+			for (i = 0; i < count; i++)
+				b->backends[i] = items[i];
+			b->num_backends = count;
+			break;
+
+		case OPT_THREADS:
+			count = split_list(optarg, items, B3BENCH_MAX_LIST);
+			if (count < 0) {
+				fprintf(stderr, "Error: bad thread list\n\n");
+				goto err_out_usage;
+			}
+			for (i = 0; i < count; i++) {
+				opti = atoi(items[i]);
+				if (opti <= 0) {
+					fprintf(stderr, "Error: bad thread count %s (must be > 0)\n\n", items[i]);
+					goto err_out_usage;
+				}
+				b->threads[i] = (unsigned int)opti;
+			}
+			b->num_threads = count;
+			break;
+
+		case OPT_MODES:
+			count = split_list(optarg, items, B3BENCH_MAX_LIST);
+			if (count < 0) {
+				fprintf(stderr, "Error: bad mode list\n\n");
+				goto err_out_usage;
+			}
+			for (i = 0; i < count; i++) {
+				for (m = 0; m < B3BM_COUNT; m++) {
+					if (!strcmp(items[i], mode_names[m]))
+						break;
+				}
+				if (m >= B3BM_COUNT) {
+					fprintf(stderr, "Error: bad mode %s (must be mem, mmap or read)\n\n", items[i]);
+					goto err_out_usage;
+				}
+				b->modes[m] = true;
+			}
+			modes_set = true;
+			break;
+
+		case OPT_MMAP_CHUNKS:
+			count = split_list(optarg, items, B3BENCH_MAX_LIST - 1);
+			if (count < 0) {
+				fprintf(stderr, "Error: bad mmap chunk list\n\n");
+				goto err_out_usage;
+			}
+			/* the heuristic is always measured, it's the baseline for the summary */
+			b->num_mmap_chunks = 0;
+			b->mmap_chunks[b->num_mmap_chunks++] = 0;
+			for (i = 0; i < count; i++) {
+				if (!strcmp(items[i], "auto"))
+					continue;
+				if (parse_size(items[i], &size) || !size) {
+					fprintf(stderr, "Error: bad mmap chunk %s\n\n", items[i]);
+					goto err_out_usage;
+				}
+				b->mmap_chunks[b->num_mmap_chunks++] = size;
+			}
+			break;
+
+		case OPT_MIN_TIME:
+			opti = atoi(optarg);
+			if (opti < 0) {
+				fprintf(stderr, "Error: bad min-time=%d (must be >= 0)\n\n", opti);
+				goto err_out_usage;
+			}
+			b->min_time = (double)opti / 1000.0;
+			break;
+
+		case OPT_TMPDIR:
+			b->tmpdir = optarg;
+			break;
+
+		case OPT_FORMAT:
+			if (!strcmp(optarg, "csv"))
+				b->format = B3BF_CSV;
+			else if (!strcmp(optarg, "json"))
+				b->format = B3BF_JSON;
+			else {
+				fprintf(stderr, "Error: bad format %s (must be csv or json)\n\n", optarg);
+				goto err_out_usage;
+			}
+			break;
+
+		case OPT_COLD:
+			b->cold = true;
+			break;
+
+		case 'h' :
+			display_usage(stdout, argv[0]);
+			goto ok_out;
+		default:
+			goto err_out_usage;
+		}
+	}
+
+	if (optind < argc) {
+		fprintf(stderr, "Error: unexpected argument %s\n\n", argv[optind]);
+		goto err_out_usage;
+	}
+
+	if (min_size > max_size) {
+		fprintf(stderr, "Error: min-size must not be larger than max-size\n\n");
+		goto err_out_usage;
+	}
+
+	if (!modes_set) {
+		for (m = 0; m < B3BM_COUNT; m++)
+			b->modes[m] = true;
+	}
+	if (!b->num_backends)
+		default_backends(b);
+	if (!b->num_threads)
+		default_threads(b);
+	if (!b->num_mmap_chunks)
+		b->mmap_chunks[b->num_mmap_chunks++] = 0;
+	b->max_file_size = max_file_size ? max_file_size : max_size;
+
+	for (size = min_size; b->num_sizes < B3BENCH_MAX_SIZES; ) {
+		b->sizes[b->num_sizes++] = size;
+		if (size > max_size / step)
+			break;
+		size *= step;
+		if (size > max_size)
+			break;
+	}
+
+	b->mem = malloc(max_size);
+	if (!b->mem) {
+		fprintf(stderr, "Error: unable to allocate %zu bytes\n", max_size);
+		goto err_out;
+	}
+	/* not all zeroes, just in case */
+	for (size = 0; size < max_size; size++)
+		b->mem[size] = (uint8_t)(size % 251);
+
+	if (b->modes[B3BM_MMAP] || b->modes[B3BM_READ]) {
+		for (idx = 0; idx < b->num_sizes; idx++) {
+			if (b->sizes[idx] > b->max_file_size)
+				continue;
+			if (create_file(b, idx))
+				goto err_out;
+		}
+	}
+
+	output_header(b);
+
+	for (m = 0; m < B3BM_COUNT; m++) {
+		if (!b->modes[m])
+			continue;
+		for (k = 0; k < b->num_backends; k++) {
+			for (t = 0; t < b->num_threads; t++) {
+				/* the chunk size only matters when mmapping */
+				for (c = 0; c < (m == B3BM_MMAP ? b->num_mmap_chunks : 1); c++) {
+					if (run_config(b, m, b->backends[k], b->threads[t],
+						       m == B3BM_MMAP ? b->mmap_chunks[c] : 0))
+						goto err_out;
+				}
+			}
+		}
+	}
+
+	summarize(b);
+
+ok_out:
+	exitcode = EXIT_SUCCESS;
+
+out:
+	for (idx = 0; idx < b->num_sizes; idx++) {
+		if (!b->files[idx])
+			continue;
+		unlink(b->files[idx]);
+		free(b->files[idx]);
+	}
+	free(b->results);
+	free(b->mem);
+	return exitcode;
+
+err_out_usage:
+	display_usage(stderr, argv[0]);
+err_out:
+	exitcode = EXIT_FAILURE;
+	goto out;
+}
@@ -43,6 +43,11 @@
 #define OPT_RAW			139
 #define OPT_QUIET		140
 #define OPT_KEYED		141
+#define OPT_BATCH		142
+#define OPT_RESUME		143
+
+/* the suffix of the hasher state file kept next to each file in resume mode */
+#define B3SUM_STATE_SUFFIX	".b3state"
 
 static struct option lopts[] = {
 	{"check",		no_argument,		0,	'c' },
@@ -52,6 +57,8 @@ static struct option lopts[] = {
 	{"length",		required_argument,	0,	'l' },
 	{"quiet",		no_argument,		0,	OPT_QUIET },
 	{"keyed",		no_argument,		0,	OPT_KEYED },
+	{"batch",		no_argument,		0,	OPT_BATCH },
+	{"resume",		no_argument,		0,	OPT_RESUME },
 
 	{"num-threads",		required_argument,	0,	OPT_NUM_THREADS },
 	{"no-mmap",		no_argument,		0,	OPT_NO_MMAP },
@@ -86,8 +93,10 @@ static void display_usage(FILE *fp, const char *progname)
 	fprintf(fp, "\t--check, -c               : Read files with BLAKE3 checksums and check files\n");
 	fprintf(fp, "\t--quiet                   : Do not print OK for checked files that are correct\n");
 	fprintf(fp, "\t--keyed                   : Keyed mode with secret key read from <stdin> (32 raw bytes)\n");
+	fprintf(fp, "\t--batch                   : Hash all the files concurrently, output in order\n");
+	fprintf(fp, "\t--resume                  : Hash only what was appended since the last run (state in <file>%s)\n", B3SUM_STATE_SUFFIX);
 	fprintf(fp, "\ntuning options:\n");
-	fprintf(fp, "\t--num-threads <n>         : Number of threads to use (default: number of CPUs * 3 / 2)\n");
+	fprintf(fp, "\t--num-threads <n>         : Number of threads to use (default: number of CPUs)\n");
 	fprintf(fp, "\t--no-mmap                 : Disable file mmap\n");
 	fprintf(fp, "\t--no-mthread              : Disable multithreading\n");
 	fprintf(fp, "\t--buffer-size <n>         : Buffer size for file I/O\n");
@@ -132,26 +141,18 @@ static void list_backends(const char *name)
 	}
 }
 
-static int do_hash_file(struct blake3_hasher *hasher, const char *filename, bool no_names, bool raw, unsigned int length)
+static int do_output_hash(const char *filename, const uint8_t *output, bool no_names, bool raw, unsigned int length)
 {
 	static const char *hexb = "0123456789abcdef";
-	uint8_t output[BLAKE3_OUT_LEN];
 	size_t filename_sz, line_sz, outsz;
 	ssize_t wrn;
 	uint8_t v;
-	void *outp;
+	const void *outp;
 	char *line, *s;
 	unsigned int i;
-	int rc;
 
 	filename_sz = strlen(filename);
 
-	rc = blake3_hash_file(hasher, filename, output);
-	if (rc) {
-		fprintf(stderr, "Failed to hash file: \"%s\", error: %s\n", filename, strerror(errno));
-		return -1;
-	}
-
 	if (!raw) {
 		/* output line (optimized) */
 		line_sz = (length * 2);		/* the hex output */
@@ -189,6 +190,107 @@ static int do_hash_file(struct blake3_hasher *hasher, const char *filename, bool
 	return 0;
 }
 
+static int do_hash_file(struct blake3_hasher *hasher, const char *filename, bool no_names, bool raw, unsigned int length)
+{
+	uint8_t output[BLAKE3_OUT_LEN];
+	int rc;
+
+	rc = blake3_hash_file(hasher, filename, output);
+	if (rc) {
+		fprintf(stderr, "Failed to hash file: \"%s\", error: %s\n", filename, strerror(errno));
+		return -1;
+	}
+
+	return do_output_hash(filename, output, no_names, raw, length);
+}
+
+static int do_hash_file_resume(struct blake3_hasher *hasher, const char *filename, bool no_names, bool raw, unsigned int length)
+{
+	uint8_t output[BLAKE3_OUT_LEN];
+	uint8_t state[BLAKE3_STATE_MAX_SIZE + 1];
+	char *state_filename, *tmp_filename;
+	size_t filename_sz, state_sz, wrn;
+	FILE *fp;
+	int rc;
+
+	filename_sz = strlen(filename);
+	state_filename = alloca(filename_sz + sizeof(B3SUM_STATE_SUFFIX));
+	memcpy(state_filename, filename, filename_sz);
+	memcpy(state_filename + filename_sz, B3SUM_STATE_SUFFIX, sizeof(B3SUM_STATE_SUFFIX));
+	tmp_filename = alloca(filename_sz + sizeof(B3SUM_STATE_SUFFIX) + 4);
+	memcpy(tmp_filename, state_filename, filename_sz + sizeof(B3SUM_STATE_SUFFIX) - 1);
+	memcpy(tmp_filename + filename_sz + sizeof(B3SUM_STATE_SUFFIX) - 1, ".tmp", 5);
+
+	/* resume from the saved state; any problem means hashing all over again */
+	rc = -1;
+	fp = fopen(state_filename, "rb");
+	if (fp) {
+		state_sz = fread(state, 1, sizeof(state), fp);
+		fclose(fp);
+		if (!blake3_hasher_restore(hasher, state, state_sz))
+			rc = blake3_hash_file_resume(hasher, filename, output);
+	}
+	if (rc)
+		rc = blake3_hash_file(hasher, filename, output);
+	if (rc) {
+		fprintf(stderr, "Failed to hash file: \"%s\", error: %s\n", filename, strerror(errno));
+		return -1;
+	}
+
+	state_sz = blake3_hasher_save(hasher, state, sizeof(state));
+	assert(state_sz <= sizeof(state));
+
+	fp = fopen(tmp_filename, "wb");
+	if (!fp) {
+		fprintf(stderr, "Failed to create state file: \"%s\", error: %s\n", tmp_filename, strerror(errno));
+		return -1;
+	}
+	wrn = fwrite(state, 1, state_sz, fp);
+	rc = fclose(fp);
+	if (wrn != state_sz || rc || rename(tmp_filename, state_filename)) {
+		fprintf(stderr, "Failed to save state file: \"%s\", error: %s\n", state_filename, strerror(errno));
+		unlink(tmp_filename);
+		return -1;
+	}
+
+	return do_output_hash(filename, output, no_names, raw, length);
+}
+
+/* returns the number of files hashed and output successfully */
+static int do_hash_files(struct blake3_hasher *hasher, const char * const *filenames, int count,
+			 bool no_names, bool raw, unsigned int length)
+{
+	uint8_t (*outputs)[BLAKE3_OUT_LEN];
+	int *errs;
+	int i, num_ok;
+
+	outputs = malloc(sizeof(*outputs) * count);
+	errs = malloc(sizeof(*errs) * count);
+	if (!outputs || !errs) {
+		fprintf(stderr, "Unable to allocate batch of %d files\n", count);
+		free(errs);
+		free(outputs);
+		return 0;
+	}
+
+	blake3_hash_files(hasher, filenames, (size_t)count, outputs, errs);
+
+	num_ok = 0;
+	for (i = 0; i < count; i++) {
+		if (errs[i]) {
+			fprintf(stderr, "Failed to hash file: \"%s\", error: %s\n", filenames[i], strerror(errs[i]));
+			continue;
+		}
+		if (!do_output_hash(filenames[i], outputs[i], no_names, raw, length))
+			num_ok++;
+	}
+
+	free(errs);
+	free(outputs);
+
+	return num_ok;
+}
+
 static int do_check_file(struct blake3_hasher *hasher, const char *check_filename, bool quiet)
 {
 	char *hash, *filename;
@@ -310,7 +412,7 @@ int main(int argc, char *argv[])
 	size_t buffer_size = 0;
 	bool no_names = false, raw = false, quiet = false, keyed = false;
 	bool no_mmap = false, no_mthread = false, debug = false, enable_cpusimd = false;
-	bool do_list_backends = false, check = false, derive_key = false;
+	bool do_list_backends = false, check = false, derive_key = false, batch = false, resume = false;
 	unsigned int mt_degree = 0, num_threads = 0, cpusimd_num_cpus = 0, cpusimd_mult_fact = 0, length = BLAKE3_OUT_LEN;
 	const char *backend = NULL, *context = NULL;
 	uint8_t key[BLAKE3_OUT_LEN];
@@ -338,6 +440,12 @@ int main(int argc, char *argv[])
 		case OPT_KEYED:
 			keyed = true;
 			break;
+		case OPT_BATCH:
+			batch = true;
+			break;
+		case OPT_RESUME:
+			resume = true;
+			break;
 
 		case 'l':
 			opti = atoi(optarg);;
@@ -441,6 +549,16 @@ int main(int argc, char *argv[])
 		goto err_out_usage;
 	}
 
+	if (batch && check) {
+		fprintf(stderr, "Error: --batch and --check may not be used together\n\n");
+		goto err_out_usage;
+	}
+
+	if (resume && (check || batch)) {
+		fprintf(stderr, "Error: --resume may not be used together with --check or --batch\n\n");
+		goto err_out_usage;
+	}
+
 	if (check && length != BLAKE3_OUT_LEN) {
 		fprintf(stderr, "Error: --check and --length may not be used together\n\n");
 		goto err_out_usage;
@@ -497,6 +615,23 @@ int main(int argc, char *argv[])
 	if (!length)
 		length = BLAKE3_OUT_LEN;
 
+	/* all the files in one go */
+	if (batch && argc > optind) {
+		if (keyed) {
+			for (i = optind; i < argc; i++) {
+				if (!strcmp(argv[i], "-")) {
+					fprintf(stderr, "Cannot use <stdin> in keyed mode\n");
+					goto err_out_usage;
+				}
+			}
+		}
+		num_ok = do_hash_files(hasher, (const char * const *)(argv + optind), argc - optind,
+				       no_names, raw, length);
+		if (num_inputs != num_ok)
+			goto err_out;
+		goto ok_out;
+	}
+
 	/* we will get in the loop even when no arguments (we'll do stdin instead) */
 	num_ok = 0;
 	i = optind;
@@ -510,10 +645,18 @@ int main(int argc, char *argv[])
 			goto err_out_usage;
 		}
 
-		if (!check)
-			rc = do_hash_file(hasher, filename, no_names, raw, length);
-		else
+		/* there's no state to keep for <stdin> */
+		if (resume && !strcmp(filename, "-")) {
+			fprintf(stderr, "Cannot use <stdin> in resume mode\n");
+			goto err_out_usage;
+		}
+
+		if (check)
 			rc = do_check_file(hasher, filename, quiet);
+		else if (resume)
+			rc = do_hash_file_resume(hasher, filename, no_names, raw, length);
+		else
+			rc = do_hash_file(hasher, filename, no_names, raw, length);
 		if (!rc)
 			num_ok++;
 
@@ -410,7 +410,7 @@ static void test_worker_thread_sum_fn(void *arg)
 	s->sum = sum;
 }
 
-void test_thread_join_sum(unsigned int num_threads, unsigned int count, bool steal_mode, unsigned int times)
+void test_thread_join_sum(unsigned int num_threads, unsigned int count, enum fy_thread_pool_cfg_flags flags, unsigned int times)
 {
 	struct fy_thread_pool_cfg tp_cfg;
 	struct fy_thread_pool *tp;
@@ -421,13 +421,16 @@ void test_thread_join_sum(unsigned int num_threads, unsigned int count, bool ste
 	int rc;
 	uint64_t sum_single, sum_multi;
 	struct sum_args args[2];
+	struct fy_thread_stats stats;
 	long long table_multi[times];
 	long long ns;
 
 	(void)rc;
 
 	fprintf(stderr, "**********************************************************************\n");
-	fprintf(stderr, "%s: steal_mode=%s\n", __func__, steal_mode ? "true" : "false");
+	fprintf(stderr, "%s: mode=%s\n", __func__,
+			(flags & FYTPCF_DEQUE_MODE) ? "deque" :
+			(flags & FYTPCF_STEAL_MODE) ? "steal" : "standard");
 
 	values = malloc(count * sizeof(*values));
 	assert(values);
@@ -453,7 +456,7 @@ void test_thread_join_sum(unsigned int num_threads, unsigned int count, bool ste
 		num_cpus = num_threads;
 
 	memset(&tp_cfg, 0, sizeof(tp_cfg));
-	tp_cfg.flags = steal_mode ? FYTPCF_STEAL_MODE : 0;
+	tp_cfg.flags = flags;
 	tp_cfg.num_threads = num_cpus;
 	tp_cfg.userdata = NULL;
 
@@ -501,6 +504,14 @@ void test_thread_join_sum(unsigned int num_threads, unsigned int count, bool ste
 	ns /= times;
 	fprintf(stderr, " : average %lldus\n", ns / 1000);
 
+	rc = fy_thread_pool_get_stats(tp, &stats, NULL);
+	assert(!rc);
+	fprintf(stderr, "%s: jobs=%"PRIu64" steals=%"PRIu64" spins=%"PRIu64" spin_hits=%"PRIu64" parks=%"PRIu64
+			" wakes=%"PRIu64" wake_latency avg=%"PRIu64"ns max=%"PRIu64"ns\n", __func__,
+			stats.jobs, stats.steals, stats.spins, stats.spin_hits, stats.parks,
+			stats.wakes, stats.wakes ? stats.wake_latency_ns / stats.wakes : 0,
+			stats.wake_latency_max_ns);
+
 	fy_thread_pool_destroy(tp);
 
 	free(values);
@@ -514,8 +525,9 @@ int thread_test(unsigned int num_threads)
 	test_thread_latency(num_threads);
 	test_thread_join_steal(num_threads);
 #endif
-	test_thread_join_sum(num_threads, 1 << 20, false, 10);	/* 1M of values */
-	test_thread_join_sum(num_threads, 1 << 20, true, 10);	/* 1M of values */
+	test_thread_join_sum(num_threads, 1 << 20, 0, 10);			/* 1M of values */
+	test_thread_join_sum(num_threads, 1 << 20, FYTPCF_STEAL_MODE, 10);	/* 1M of values */
+	test_thread_join_sum(num_threads, 1 << 20, FYTPCF_DEQUE_MODE, 10);	/* 1M of values */
 
 	return 0;
 }
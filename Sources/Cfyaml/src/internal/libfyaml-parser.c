@@ -97,7 +97,7 @@ static struct option lopts[] = {
 #define LIBYAML_MODES	""
 #endif
 
-#define MODES	"parse|scan|copy|testsuite|dump|dump2|build|walk|reader|compose|iterate|comment|pathspec|shell-split|parse-timing" LIBYAML_MODES
+#define MODES	"parse|scan|copy|testsuite|dump|dump2|build|walk|reader|compose|iterate|comment|pathspec|shell-split|parse-timing|build-timing|emit-timing" LIBYAML_MODES
 
 static void display_usage(FILE *fp, char *progname)
 {
@@ -766,7 +766,7 @@ process_event(struct fy_parser *fyp, struct fy_event *fye, struct fy_path *path,
 				fy_path_in_mapping_value(path) ? 'V' : '-',
 			fy_path_in_collection_root(path) ? '/' : '-',
 			fy_path_depth(path),
-			fy_path_get_text_alloca(path),
+			fy_path_get_text0(path),
 			fy_token_dump_format(fy_event_get_token(fye), tbuf, sizeof(tbuf)));
 
 	switch (fye->type) {
@@ -4109,6 +4109,300 @@ int do_parse_timing(int argc, char *argv[], bool disable_mmap)
 	return 0;
 }
 
+int do_build_timing(int argc, char *argv[], const struct fy_parse_cfg *cfg)
+{
+	static const struct {
+		const char *name;
+		unsigned int flags;
+		bool events;
+	} methods[] = {
+		{ "events",	0,			true	},
+		{ "builder",	0,			false	},
+		{ "recursive",	FYPCF_PREFER_RECURSIVE,	false	},
+	};
+	struct fy_parse_cfg pcfg;
+	struct fy_parser *fyp;
+	struct fy_event *fye;
+	struct fy_document *fyd;
+	struct timespec before, after;
+	void *blob;
+	size_t blob_size, count;
+	int64_t ns, best;
+	unsigned int j, k;
+	int i, rc;
+
+	for (i = optind; i < argc; i++) {
+
+		blob = fy_blob_read(argv[i], &blob_size);
+		if (!blob) {
+			fprintf(stderr, "Unable to read %s\n", argv[i]);
+			return -1;
+		}
+
+		printf("file=%s size=%zu\n", argv[i], blob_size);
+
+		for (j = 0; j < sizeof(methods)/sizeof(methods[0]); j++) {
+
+			pcfg = *cfg;
+			pcfg.flags &= ~FYPCF_PREFER_RECURSIVE;
+			pcfg.flags |= methods[j].flags;
+
+			best = INT64_MAX;
+			count = 0;
+			for (k = 0; k < 5; k++) {
+				fyp = fy_parser_create(&pcfg);
+				if (!fyp) {
+					free(blob);
+					return -1;
+				}
+				rc = fy_parser_set_string(fyp, blob, blob_size);
+				assert(!rc);
+
+				clock_gettime(CLOCK_MONOTONIC, &before);
+				count = 0;
+				if (methods[j].events) {
+					while ((fye = fy_parser_parse(fyp)) != NULL) {
+						fy_parser_event_free(fyp, fye);
+						count++;
+					}
+				} else {
+					while ((fyd = fy_parse_load_document(fyp)) != NULL) {
+						fy_parse_document_destroy(fyp, fyd);
+						count++;
+					}
+				}
+				clock_gettime(CLOCK_MONOTONIC, &after);
+				ns = (int64_t)(after.tv_sec - before.tv_sec) * (int64_t)1000000000UL +
+				     (int64_t)(after.tv_nsec - before.tv_nsec);
+				if (ns < best)
+					best = ns;
+
+				rc = fy_parser_get_stream_error(fyp) ? -1 : 0;
+				fy_parser_destroy(fyp);
+				if (rc) {
+					fprintf(stderr, "%s: parse error on %s\n", methods[j].name, argv[i]);
+					free(blob);
+					return -1;
+				}
+			}
+
+			printf("%-10s %zu %s in %"PRId64"ns\n", methods[j].name, count,
+					methods[j].events ? "events" : "documents", best);
+		}
+
+		free(blob);
+	}
+
+	return 0;
+}
+
+struct emit_timing_output {
+	char *buf;
+	size_t size;
+	size_t alloc;
+};
+
+static int emit_timing_output(struct fy_emitter *emit, enum fy_emitter_write_type type,
+			      const char *str, int len, void *userdata)
+{
+	struct emit_timing_output *out = userdata;
+	char *buf;
+	size_t alloc;
+
+	if (out->size + len > out->alloc) {
+		alloc = out->alloc ? out->alloc : 65536;
+		while (out->size + len > alloc)
+			alloc *= 2;
+		buf = realloc(out->buf, alloc);
+		if (!buf)
+			return -1;
+		out->buf = buf;
+		out->alloc = alloc;
+	}
+	memcpy(out->buf + out->size, str, len);
+	out->size += len;
+
+	return len;
+}
+
+static enum fy_scalar_style emit_timing_scalar_style(struct fy_node *fyn)
+{
+	switch (fy_node_get_style(fyn)) {
+	case FYNS_PLAIN:
+		return FYSS_PLAIN;
+	case FYNS_SINGLE_QUOTED:
+		return FYSS_SINGLE_QUOTED;
+	case FYNS_DOUBLE_QUOTED:
+		return FYSS_DOUBLE_QUOTED;
+	case FYNS_LITERAL:
+		return FYSS_LITERAL;
+	case FYNS_FOLDED:
+		return FYSS_FOLDED;
+	default:
+		break;
+	}
+	return FYSS_ANY;
+}
+
+static enum fy_node_style emit_timing_collection_style(struct fy_node *fyn)
+{
+	enum fy_node_style style;
+
+	style = fy_node_get_style(fyn);
+	return style == FYNS_FLOW || style == FYNS_BLOCK ? style : FYNS_ANY;
+}
+
+/* emit the node tree as a stream of events, or via the direct interface */
+static int emit_timing_node(struct fy_emitter *emit, struct fy_node *fyn, bool raw)
+{
+	struct fy_node_pair *fynp;
+	struct fy_node *fyni;
+	const char *text;
+	void *iter;
+	size_t len;
+	int rc;
+
+	switch (fy_node_get_type(fyn)) {
+	case FYNT_SCALAR:
+		text = fy_node_get_scalar(fyn, &len);
+		if (fy_node_is_alias(fyn)) {
+			text = fy_node_get_scalar0(fyn);
+			if (raw)
+				return fy_emit_alias_raw(emit, text);
+			return fy_emit_eventf(emit, FYET_ALIAS, text);
+		}
+		if (raw)
+			return fy_emit_scalar_raw(emit, emit_timing_scalar_style(fyn), text, len);
+		return fy_emit_eventf(emit, FYET_SCALAR, emit_timing_scalar_style(fyn), text, len, NULL, NULL);
+
+	case FYNT_SEQUENCE:
+		rc = raw ? fy_emit_sequence_start_raw(emit, emit_timing_collection_style(fyn)) :
+			   fy_emit_eventf(emit, FYET_SEQUENCE_START, emit_timing_collection_style(fyn), NULL, NULL);
+		iter = NULL;
+		while (!rc && (fyni = fy_node_sequence_iterate(fyn, &iter)) != NULL)
+			rc = emit_timing_node(emit, fyni, raw);
+		if (rc)
+			return rc;
+		return raw ? fy_emit_sequence_end_raw(emit) : fy_emit_eventf(emit, FYET_SEQUENCE_END);
+
+	case FYNT_MAPPING:
+		rc = raw ? fy_emit_mapping_start_raw(emit, emit_timing_collection_style(fyn)) :
+			   fy_emit_eventf(emit, FYET_MAPPING_START, emit_timing_collection_style(fyn), NULL, NULL);
+		iter = NULL;
+		while (!rc && (fynp = fy_node_mapping_iterate(fyn, &iter)) != NULL) {
+			rc = emit_timing_node(emit, fy_node_pair_key(fynp), raw);
+			if (!rc)
+				rc = emit_timing_node(emit, fy_node_pair_value(fynp), raw);
+		}
+		if (rc)
+			return rc;
+		return raw ? fy_emit_mapping_end_raw(emit) : fy_emit_eventf(emit, FYET_MAPPING_END);
+	}
+
+	return -1;
+}
+
+int do_emit_timing(int argc, char *argv[], const struct fy_parse_cfg *cfg)
+{
+	static const struct {
+		const char *name;
+		bool raw;
+	} methods[] = {
+		{ "events",	false	},
+		{ "direct",	true	},
+	};
+	struct emit_timing_output out, ref;
+	struct fy_emitter_cfg ecfg;
+	struct fy_emitter *emit;
+	struct fy_document *fyd;
+	struct timespec before, after;
+	int64_t ns, best;
+	unsigned int j, k;
+	int i, rc;
+
+	memset(&ref, 0, sizeof(ref));
+	memset(&out, 0, sizeof(out));
+
+	for (i = optind; i < argc; i++) {
+
+		fyd = fy_document_build_from_file(cfg, argv[i]);
+		if (!fyd) {
+			fprintf(stderr, "Unable to build %s\n", argv[i]);
+			rc = -1;
+			goto out;
+		}
+
+		/* anchors and tags are not emitted, with the same output for both */
+		printf("file=%s\n", argv[i]);
+
+		for (j = 0; j < sizeof(methods)/sizeof(methods[0]); j++) {
+
+			best = INT64_MAX;
+			for (k = 0; k < 5; k++) {
+
+				out.size = 0;
+
+				memset(&ecfg, 0, sizeof(ecfg));
+				ecfg.output = emit_timing_output;
+				ecfg.userdata = &out;
+				ecfg.flags = FYECF_DEFAULT;
+				emit = fy_emitter_create(&ecfg);
+				if (!emit) {
+					fy_document_destroy(fyd);
+					rc = -1;
+					goto out;
+				}
+
+				clock_gettime(CLOCK_MONOTONIC, &before);
+				rc = fy_emit_eventf(emit, FYET_STREAM_START);
+				if (!rc)
+					rc = fy_emit_eventf(emit, FYET_DOCUMENT_START, 1, NULL, NULL);
+				if (!rc && fy_document_root(fyd))
+					rc = emit_timing_node(emit, fy_document_root(fyd), methods[j].raw);
+				if (!rc)
+					rc = fy_emit_eventf(emit, FYET_DOCUMENT_END, 1);
+				if (!rc)
+					rc = fy_emit_eventf(emit, FYET_STREAM_END);
+				clock_gettime(CLOCK_MONOTONIC, &after);
+
+				fy_emitter_destroy(emit);
+
+				if (rc) {
+					fprintf(stderr, "%s: emit error on %s\n", methods[j].name, argv[i]);
+					fy_document_destroy(fyd);
+					goto out;
+				}
+
+				ns = (int64_t)(after.tv_sec - before.tv_sec) * (int64_t)1000000000UL +
+				     (int64_t)(after.tv_nsec - before.tv_nsec);
+				if (ns < best)
+					best = ns;
+			}
+
+			/* all methods must produce the same output */
+			if (j == 0) {
+				free(ref.buf);
+				ref = out;
+				memset(&out, 0, sizeof(out));
+			} else if (out.size != ref.size || memcmp(out.buf, ref.buf, out.size)) {
+				fprintf(stderr, "%s: output differs on %s\n", methods[j].name, argv[i]);
+				fy_document_destroy(fyd);
+				rc = -1;
+				goto out;
+			}
+
+			printf("%-10s %zu bytes in %"PRId64"ns\n", methods[j].name, ref.size, best);
+		}
+
+		fy_document_destroy(fyd);
+	}
+	rc = 0;
+out:
+	free(out.buf);
+	free(ref.buf);
+	return rc;
+}
+
 int apply_flags_option(const char *arg, unsigned int *flagsp,
 		int (*modify_flags)(const char *what, unsigned int *flagsp))
 {
@@ -4304,7 +4598,9 @@ int main(int argc, char *argv[])
 	    strcmp(mode, "crash") &&
 	    strcmp(mode, "badutf8") &&
 	    strcmp(mode, "shell-split") &&
-	    strcmp(mode, "parse-timing")
+	    strcmp(mode, "parse-timing") &&
+	    strcmp(mode, "build-timing") &&
+	    strcmp(mode, "emit-timing")
 #if defined(HAVE_LIBYAML) && HAVE_LIBYAML
 	    && strcmp(mode, "libyaml-scan")
 	    && strcmp(mode, "libyaml-parse")
@@ -4566,6 +4862,18 @@ int main(int argc, char *argv[])
 			/* fprintf(stderr, "do_parse_timing() error %d\n", rc); */
 			goto cleanup;
 		}
+	} else if (!strcmp(mode, "build-timing")) {
+		rc = do_build_timing(argc, argv, &cfg);
+		if (rc < 0) {
+			/* fprintf(stderr, "do_build_timing() error %d\n", rc); */
+			goto cleanup;
+		}
+	} else if (!strcmp(mode, "emit-timing")) {
+		rc = do_emit_timing(argc, argv, &cfg);
+		if (rc < 0) {
+			/* fprintf(stderr, "do_emit_timing() error %d\n", rc); */
+			goto cleanup;
+		}
 	}
 #if defined(HAVE_LIBYAML) && HAVE_LIBYAML
 	if (!strcmp(mode, "libyaml-diff")) {
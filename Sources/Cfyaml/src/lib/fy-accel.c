@@ -60,7 +60,7 @@ fy_accel_hash_to_pos(struct fy_accel *xl, const void *hash, unsigned int nbucket
 		break;
 	default:
 		/* sigh, what ever */
-		pos = XXH32(hash, xl->hd->size, 0);
+		pos = XXH3_64bits(hash, xl->hd->size);
 		break;
 	}
 
@@ -318,6 +318,29 @@ fy_accel_lookup(struct fy_accel *xl, const void *key)
 	return xle ? xle->value : NULL;
 }
 
+const void *
+fy_accel_lookup_by_hash(struct fy_accel *xl, const void *hash,
+			bool (*match)(const void *key, const void *arg),
+			const void *arg)
+{
+	struct fy_accel_entry_list *xlel;
+	struct fy_accel_entry *xle;
+	unsigned int pos;
+
+	if (!xl || !hash || !match)
+		return NULL;
+
+	pos = fy_accel_hash_to_pos(xl, hash, xl->nbuckets);
+	xlel = &xl->buckets[pos];
+
+	for (xle = fy_accel_entry_list_first(xlel); xle; xle = fy_accel_entry_next(xlel, xle)) {
+		if (fy_accel_hash_eq(xl, hash, xle->hash) && match(xle->key, arg))
+			return xle->value;
+	}
+
+	return NULL;
+}
+
 int
 fy_accel_remove(struct fy_accel *xl, const void *data)
 {
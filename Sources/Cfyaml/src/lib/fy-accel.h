@@ -63,6 +63,12 @@ int fy_accel_insert(struct fy_accel *xl, const void *key, const void *value);
 const void *fy_accel_lookup(struct fy_accel *xl, const void *key);
 int fy_accel_remove(struct fy_accel *xl, const void *key);
 
+/* lookup using a precomputed hash; match() replaces the descriptor eq() */
+const void *
+fy_accel_lookup_by_hash(struct fy_accel *xl, const void *hash,
+			bool (*match)(const void *key, const void *arg),
+			const void *arg);
+
 struct fy_accel_entry_iter {
 	struct fy_accel *xl;
 	const void *key;
@@ -1548,6 +1548,14 @@ int fy_atom_memcmp(struct fy_atom *atom, const void *ptr, size_t len)
 	if (c == -1 && !len)
 		return 0;
 
+	/* out of data on ptr, atom is longer */
+	if (!len)
+		return 1;
+
+	/* out of data on atom, atom is shorter */
+	if (c == -1)
+		return -1;
+
 	return ct > c ? -1 : 1;
 }
 
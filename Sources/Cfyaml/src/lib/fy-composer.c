@@ -258,7 +258,7 @@ fy_composer_process_event_private(struct fy_composer *fyc, struct fy_event *fye,
 		}
 
 		/* append to the tail */
-		fy_path_component_list_add_tail(&fypp->components, fypc);
+		fy_path_push_component(fypp, fypc);
 
 	} else if (is_collection && is_end) {
 
@@ -287,7 +287,7 @@ fy_composer_process_event_private(struct fy_composer *fyc, struct fy_event *fye,
 
 	if (is_collection && is_end) {
 		/* for the end of a collection, pop the last component */
-		fypc = fy_path_component_list_pop_tail(&fypp->components);
+		fypc = fy_path_pop_component(fypp);
 		assert(fypc);
 
 		assert(fypc == fypc_last);
@@ -332,11 +332,11 @@ fy_composer_halt(struct fy_composer *fyc, struct fy_path *fypp, enum fy_composer
 
 	/* pump FYET_NONEs to clean the stack */
 
-	while ((fypc = fy_path_component_list_tail(&fypp->components)) != NULL) {
+	while (fy_path_component_list_tail(&fypp->components) != NULL) {
 
 		ops->process_event(fyc, fypp, &ev_none.e);
 
-		fy_path_component_list_del(&fypp->components, fypc);
+		fypc = fy_path_pop_component(fypp);
 		fy_path_component_free(fypc);
 	}
 
@@ -31,7 +31,8 @@ static const struct fy_hash_desc hd_anchor;
 static const struct fy_hash_desc hd_nanchor;
 static const struct fy_hash_desc hd_mapping;
 
-int fy_node_hash_uint(struct fy_node *fyn, unsigned int *hashp);
+int fy_node_hash_u64(struct fy_node *fyn, uint64_t *hashp);
+static uint64_t fy_node_hash_simple_key(const char *key, size_t len);
 
 static struct fy_node *
 fy_node_by_path_internal(struct fy_node *fyn,
@@ -789,6 +790,7 @@ int fy_node_free(struct fy_node *fyn)
 		fyn->sequence_end = NULL;
 		break;
 	case FYNT_MAPPING:
+		fy_node_mapping_sorted_invalidate(fyn);
 		while ((fynp = fy_node_pair_list_pop(&fyn->mapping)) != NULL) {
 			if (fyn->xl)
 				fy_accel_remove(fyn->xl, fynp->key);
@@ -806,6 +808,8 @@ int fy_node_free(struct fy_node *fyn)
 		free(fyn->xl);
 	}
 
+	free(atomic_load(&fyn->digest));
+
 	fy_node_cleanup_path_expr_data(fyn);
 
 	free(fyn);
@@ -1090,6 +1094,7 @@ void fy_node_mark_synthetic(struct fy_node *fyn)
 {
 	if (!fyn)
 		return;
+	fy_node_digest_invalidate(fyn);
 	fyn->synthetic = true;
 	while ((fyn = fy_node_get_document_parent(fyn)) != NULL)
 		fyn->synthetic = true;
@@ -1929,6 +1934,39 @@ struct fy_document *fy_parse_load_document_with_builder(struct fy_parser *fyp)
 	return fyd;
 }
 
+struct fy_document *
+fy_parse_load_document_filtered(struct fy_parser *fyp, const char * const *paths)
+{
+	struct fy_document_builder_cfg cfg;
+	struct fy_document *fyd;
+	int rc;
+
+	if (!fyp)
+		return NULL;
+
+	if (!fyp->fydb) {
+		memset(&cfg, 0, sizeof(cfg));
+		cfg.parse_cfg = fyp->cfg;
+		cfg.userdata = fyp;
+		cfg.diag = fy_diag_ref(fyp->diag);
+
+		fyp->fydb = fy_document_builder_create(&cfg);
+		if (!fyp->fydb)
+			return NULL;
+	}
+
+	rc = fy_document_builder_set_filter(fyp->fydb, paths);
+	if (rc)
+		return NULL;
+
+	fyd = fy_parse_load_document_with_builder(fyp);
+
+	/* the filter is only for this document */
+	fy_document_builder_set_filter(fyp->fydb, NULL);
+
+	return fyd;
+}
+
 struct fy_document *fy_parse_load_document(struct fy_parser *fyp)
 {
 	if (!fyp)
@@ -2095,6 +2133,12 @@ int fy_node_copy_to_scalar(struct fy_document *fyd, struct fy_node *fyn_to, stru
 	if (!fyn)
 		return -1;
 
+	fy_node_digest_invalidate(fyn_to);
+
+	/* a key replaced in place changes the order of its mapping */
+	if (fyn_to->parent && fyn_to->parent->type == FYNT_MAPPING)
+		fy_node_mapping_sorted_invalidate(fyn_to->parent);
+
 	/* the node is guaranteed to be a scalar */
 	fy_token_unref(fyn_to->tag);
 	fyn_to->tag = NULL;
@@ -2116,6 +2160,8 @@ int fy_node_copy_to_scalar(struct fy_document *fyd, struct fy_node *fyn_to, stru
 			fy_node_list_add_tail(&fyn_to->sequence, fyni);
 		break;
 	case FYNT_MAPPING:
+		fy_node_mapping_sorted_invalidate(fyn);
+		fy_node_mapping_sorted_invalidate(fyn_to);
 		fy_node_pair_list_init(&fyn_to->mapping);
 		while ((fynp = fy_node_pair_list_pop(&fyn->mapping)) != NULL) {
 			if (fyn->xl)
@@ -2219,6 +2265,8 @@ int fy_node_insert(struct fy_node *fyn_to, struct fy_node *fyn_from)
 	fyd = fyn_to->fyd;
 	assert(fyd);
 
+	fy_node_digest_invalidate(fyn_to);
+
 	fyn_parent = fy_node_get_document_parent(fyn_to);
 	fynp = NULL;
 	if (fyn_parent) {
@@ -2229,6 +2277,9 @@ int fy_node_insert(struct fy_node *fyn_to, struct fy_node *fyn_from)
 				"Illegal NULL source node");
 
 		if (fyn_parent->type == FYNT_MAPPING) {
+			/* the node may be a key, changing the order of the mapping */
+			fy_node_mapping_sorted_invalidate(fyn_parent);
+
 			/* find mapping pair that contains the `to` node */
 			for (fynp = fy_node_pair_list_head(&fyn_parent->mapping); fynp;
 					fynp = fy_node_pair_next(&fyn_parent->mapping, fynp)) {
@@ -2262,6 +2313,7 @@ int fy_node_insert(struct fy_node *fyn_to, struct fy_node *fyn_from)
 					"Illegal mapping node found");
 
 			fy_node_pair_list_del(&fyn_parent->mapping, fynp);
+			fy_node_mapping_sorted_invalidate(fyn_parent);
 			if (fyn_parent->xl)
 				fy_accel_remove(fyn_parent->xl, fynp->key);
 			/* this will also delete fyn_to */
@@ -2384,6 +2436,7 @@ int fy_node_insert(struct fy_node *fyn_to, struct fy_node *fyn_from)
 						"fy_node_copy() failed");
 
 				fy_node_pair_list_add_tail(&fyn_to->mapping, fynpj);
+				fy_node_mapping_sorted_invalidate(fyn_to);
 				if (fyn_to->xl)
 					fy_accel_insert(fyn_to->xl, fynpj->key, fynpj);
 
@@ -2720,6 +2773,8 @@ static int fy_resolve_merge_key_populate(struct fy_document *fyd, struct fy_node
 		fynpn->value = fy_node_copy(fyd, fynpi->value);
 
 		fy_node_pair_list_insert_after(&fyn->mapping, fynp, fynpn);
+		fy_node_mapping_sorted_invalidate(fyn);
+		fy_node_digest_invalidate(fyn);
 		if (fyn->xl)
 			fy_accel_insert(fyn->xl, fynpn->key, fynpn);
 	}
@@ -2813,6 +2868,8 @@ static int fy_resolve_anchor_node(struct fy_document *fyd, struct fy_node *fyn)
 				/* remove this node pair */
 				if (!rc) {
 					fy_node_pair_list_del(&fyn->mapping, fynp);
+					fy_node_mapping_sorted_invalidate(fyn);
+					fy_node_digest_invalidate(fyn);
 					if (fyn->xl)
 						fy_accel_remove(fyn->xl, fynp->key);
 					fy_node_pair_detach_and_free(fynp);
@@ -2934,9 +2991,11 @@ void fy_document_purge_anchors(struct fy_document *fyd)
 	if (fy_document_is_accelerated(fyd)) {
 		fy_accel_cleanup(fyd->axl);
 		free(fyd->axl);
+		fyd->axl = NULL;
 
 		fy_accel_cleanup(fyd->naxl);
 		free(fyd->naxl);
+		fyd->naxl = NULL;
 	}
 }
 
@@ -3126,7 +3185,7 @@ struct fy_document *fy_document_create(const struct fy_parse_cfg *cfg)
 	fyd->diag = diag;
 
 	fy_anchor_list_init(&fyd->anchors);
-	if (fy_document_is_accelerated(fyd)) {
+	if (fy_document_can_be_accelerated(fyd)) {
 		fyd->axl = malloc(sizeof(*fyd->axl));
 		fyd_error_check(fyd, fyd->axl, err_out,
 				"malloc() failed");
@@ -3509,6 +3568,7 @@ int fy_node_pair_set_key(struct fy_node_pair *fynp, struct fy_node *fyn)
 
 	fy_node_detach_and_free(fynp->key);
 	fynp->key = fyn;
+	fy_node_mapping_sorted_invalidate(fyn_map);
 
 	if (fyn_map && fyn_map->xl)
 		fy_accel_insert(fyn_map->xl, fynp->key, fynp);
@@ -4204,11 +4264,9 @@ fy_node_by_path_internal(struct fy_node *fyn,
 			if (idx < 0)
 				return NULL;
 
+			/* the separator is consumed by the next component */
 			s = end_idx;
 
-			if (s < e && *s == '/')
-				s++;
-
 			break;
 		}
 
@@ -4557,6 +4615,329 @@ regular_path_lookup:
 	return fy_node_by_path_internal(fyn, path, len, flags);
 }
 
+#define FYNPHCF_KEY	FY_BIT(0)	/* lookup as a simple key */
+#define FYNPHCF_INDEX	FY_BIT(1)	/* lookup as a sequence index */
+
+struct fy_node_path_handle_component {
+	const char *key;
+	size_t len;
+	uint64_t hash;
+	unsigned int flags;
+	int idx;
+	size_t offset;		/* of the component in the path text */
+};
+
+struct fy_node_path_handle {
+	enum fy_node_walk_flags flags;
+	bool generic;		/* punt everything to fy_node_by_path() */
+	bool trailing_slash;
+	const char *path;
+	size_t pathlen;
+	struct fy_node_path_handle_component merge;
+	int count;
+	struct fy_node_path_handle_component comp[0];
+};
+
+static bool
+fy_node_path_handle_parse_index(const char *s, const char *e, bool json, int *idxp)
+{
+	bool negative;
+	int idx, digits;
+
+	if (!json && s < e && *s == '[') {
+		/* must be terminated by ']' */
+		if (e[-1] != ']')
+			return false;
+		s++;
+		e--;
+	}
+
+	negative = !json && s < e && *s == '-';
+	if (negative)
+		s++;
+
+	/* keep it short, anything that may overflow goes the slow way */
+	for (idx = 0, digits = 0; s < e && digits < 9; s++, digits++) {
+		if (*s < '0' || *s > '9')
+			return false;
+		idx = idx * 10 + (*s - '0');
+	}
+	if (s < e || !digits)
+		return false;
+
+	*idxp = negative ? -idx : idx;
+	return true;
+}
+
+struct fy_node_path_handle *
+fy_node_path_handle_create(const char *path, size_t len,
+			   enum fy_node_walk_flags flags)
+{
+	struct fy_node_path_handle *fynph = NULL;
+	struct fy_node_path_handle_component *comp = NULL;
+	enum fy_node_walk_flags ptr_flags;
+	const char *s, *e, *ss, *ee, *p;
+	char *buf, *t;
+	size_t size;
+	int count, w, rlen, code_length;
+	uint8_t code[4];
+	char c;
+	bool json, slow;
+
+	if (!path)
+		return NULL;
+
+	if (len == (size_t)-1)
+		len = strlen(path);
+
+	/* verify that the path string is well formed UTF8 */
+	for (s = path, e = s + len; s < e; s += w) {
+		if (fy_utf8_get(s, e - s, &w) < 0)
+			return NULL;
+	}
+
+	/* there can't be more components than separators + 1 */
+	for (s = path, count = 1; s < e; s++) {
+		if (*s == '/')
+			count++;
+	}
+
+	/* the path copy and the unescaped keys follow the components */
+	size = sizeof(*fynph) + count * sizeof(*comp) + 2 * (len + 1);
+	fynph = malloc(size);
+	if (!fynph)
+		goto err_out;
+	memset(fynph, 0, sizeof(*fynph));
+
+	buf = (char *)&fynph->comp[count];
+	memcpy(buf, path, len);
+	buf[len] = '\0';
+	t = buf + len + 1;
+
+	fynph->flags = flags;
+	fynph->path = buf;
+	fynph->pathlen = len;
+	fynph->trailing_slash = len > 0 && buf[len - 1] == '/';
+
+	fynph->merge.key = "<<";
+	fynph->merge.len = 2;
+	fynph->merge.hash = fy_node_hash_simple_key(fynph->merge.key, fynph->merge.len);
+	fynph->merge.flags = FYNPHCF_KEY;
+
+	ptr_flags = flags & FYNWF_PTR(FYNWF_PTR_MASK);
+	if (ptr_flags != FYNWF_PTR_YAML && ptr_flags != FYNWF_PTR_JSON) {
+		fynph->generic = true;
+		return fynph;
+	}
+	json = ptr_flags == FYNWF_PTR_JSON;
+
+	s = buf;
+	e = buf + len;
+
+	/* paths starting with an alias */
+	if (!json && (flags & FYNWF_FOLLOW)) {
+		for (p = s; p < e && isspace(*p); p++)
+			;
+		if (p < e && *p == '*') {
+			fynph->generic = true;
+			return fynph;
+		}
+	}
+
+	/* a json pointer must start with a separator */
+	if (json && s < e && *s != '/') {
+		fynph->generic = true;
+		return fynph;
+	}
+
+	slow = false;
+	while (!slow && s < e) {
+
+		if (!json) {
+			while (s < e && *s == '/')
+				s++;
+			if (s >= e)
+				break;
+		} else
+			s++;	/* skip over the separator */
+
+		assert(fynph->count < count);
+		comp = &fynph->comp[fynph->count++];
+		comp->offset = (size_t)((json ? s - 1 : s) - buf);
+
+		ss = s;
+		while (s < e && (c = *s) != '/') {
+			s++;
+			/* quotes and escapes may hide separators, leave it to the slow path */
+			if (!json && (c == '\\' || c == '"' || c == '\''))
+				slow = true;
+		}
+		ee = s;
+
+		if (slow)
+			break;
+
+		if (fy_node_path_handle_parse_index(ss, ee, json, &comp->idx))
+			comp->flags |= FYNPHCF_INDEX;
+
+		if (!json) {
+			/* anything but a simple key is parsed as YAML by the slow path */
+			if (!is_simple_key(ss, ee - ss))
+				continue;
+			comp->key = ss;
+			comp->len = ee - ss;
+		} else {
+			comp->key = t;
+
+			while (ss < ee) {
+				c = *ss;
+				if (c == '~') {
+					/* unterminated ~ escape */
+					if (ss + 1 >= ee) {
+						slow = true;
+						break;
+					}
+					*t++ = ss[1] == '0' ? '~' : '/';
+					ss += 2;
+				} else if (c == '%' && (flags & FYNWF_URI_ENCODED)) {
+					code_length = sizeof(code);
+					p = fy_uri_esc(ss, ee - ss, code, &code_length);
+					/* bad % escape sequence */
+					if (!p) {
+						slow = true;
+						break;
+					}
+					memcpy(t, code, code_length);
+					t += code_length;
+					ss = p;
+				} else {
+					p = ss;
+					while (p < ee && *p != '~' && *p != '%')
+						p++;
+					if (p == ss)
+						p++;
+					rlen = p - ss;
+					memcpy(t, ss, rlen);
+					t += rlen;
+					ss = p;
+				}
+			}
+			if (slow)
+				break;
+			comp->len = t - comp->key;
+			*t++ = '\0';
+		}
+
+		comp->hash = fy_node_hash_simple_key(comp->key, comp->len);
+		comp->flags |= FYNPHCF_KEY;
+	}
+
+	/* the component that failed is resolved by the slow path */
+	if (slow && comp)
+		comp->flags = 0;
+
+	return fynph;
+
+err_out:
+	free(fynph);
+	return NULL;
+}
+
+void fy_node_path_handle_destroy(struct fy_node_path_handle *fynph)
+{
+	free(fynph);
+}
+
+static bool fy_node_path_handle_key_match(const void *key, const void *arg)
+{
+	struct fy_node *fyn_key = (struct fy_node *)key;
+	const struct fy_node_path_handle_component *comp = arg;
+
+	if (!fyn_key)
+		return comp->len == 0;
+
+	return fy_node_is_scalar(fyn_key) && !fy_node_is_alias(fyn_key) &&
+	       !fy_token_memcmp(fyn_key->scalar, comp->key, comp->len);
+}
+
+static struct fy_node_pair *
+fy_node_path_handle_lookup_pair(struct fy_node *fyn,
+				const struct fy_node_path_handle_component *comp)
+{
+	struct fy_node_pair *fynpi;
+
+	if (fyn->xl)
+		return (void *)fy_accel_lookup_by_hash(fyn->xl, &comp->hash,
+				fy_node_path_handle_key_match, comp);
+
+	for (fynpi = fy_node_pair_list_head(&fyn->mapping); fynpi;
+		fynpi = fy_node_pair_next(&fyn->mapping, fynpi)) {
+
+		if (fynpi->key && fy_node_path_handle_key_match(fynpi->key, comp))
+			return fynpi;
+	}
+
+	return NULL;
+}
+
+struct fy_node *
+fy_node_by_path_handle(struct fy_node *fyn,
+		       const struct fy_node_path_handle *fynph)
+{
+	const struct fy_node_path_handle_component *comp;
+	struct fy_node_pair *fynp;
+	enum fy_node_walk_flags flags;
+	int i;
+
+	if (!fyn || !fynph)
+		return NULL;
+
+	flags = fynph->flags;
+	if (fynph->generic)
+		return fy_node_by_path(fyn, fynph->path, fynph->pathlen, flags);
+
+	for (i = 0; fyn && i < fynph->count; i++) {
+		comp = &fynph->comp[i];
+
+		fyn = fy_node_follow_aliases(fyn, flags, true);
+		if (!fyn || fy_node_is_scalar(fyn))
+			return NULL;
+
+		if (fy_node_is_sequence(fyn)) {
+			if (!(comp->flags & FYNPHCF_INDEX))
+				goto slow_path;
+
+			fyn = fy_node_sequence_get_by_index(fyn, comp->idx);
+			if (fynph->trailing_slash)
+				fyn = fy_node_follow_aliases(fyn, flags, false);
+			continue;
+		}
+
+		if (!(comp->flags & FYNPHCF_KEY))
+			goto slow_path;
+
+		fynp = fy_node_path_handle_lookup_pair(fyn, comp);
+		if (!fynp) {
+			/* merge keys are handled by the slow path */
+			if ((flags & FYNWF_FOLLOW) &&
+			    (flags & FYNWF_PTR(FYNWF_PTR_MASK)) == FYNWF_PTR_YAML &&
+			    fy_node_path_handle_lookup_pair(fyn, &fynph->merge))
+				goto slow_path;
+			return NULL;
+		}
+
+		fyn = fynp->value;
+		if (fynph->trailing_slash)
+			fyn = fy_node_follow_aliases(fyn, flags, true);
+	}
+
+	return fyn;
+
+slow_path:
+	return fy_node_by_path_internal(fyn, fynph->path + comp->offset,
+					fynph->pathlen - comp->offset, flags);
+}
+
 static char *
 fy_node_get_reference_internal(struct fy_node *fyn_base, struct fy_node *fyn, bool near)
 {
@@ -5387,6 +5768,7 @@ int fy_node_set_tag(struct fy_node *fyn, const char *data, size_t len)
 
 	fy_token_unref(fyn->tag);
 	fyn->tag = fyt;
+	fy_node_digest_invalidate(fyn);
 
 	/* take away the input reference */
 	fy_input_unref(fyi);
@@ -5404,6 +5786,7 @@ int fy_node_remove_tag(struct fy_node *fyn)
 
 	fy_token_unref(fyn->tag);
 	fyn->tag = NULL;
+	fy_node_digest_invalidate(fyn);
 
 	return 0;
 }
@@ -5609,6 +5992,7 @@ int fy_node_mapping_append(struct fy_node *fyn_map,
 		return -1;
 
 	fy_node_pair_list_add_tail(&fyn_map->mapping, fynp);
+	fy_node_mapping_sorted_invalidate(fyn_map);
 	if (fyn_map->xl)
 		fy_accel_insert(fyn_map->xl , fyn_key, fynp);
 
@@ -5636,6 +6020,7 @@ int fy_node_mapping_prepend(struct fy_node *fyn_map,
 	if (fyn_value)
 		fyn_value->attached = true;
 	fy_node_pair_list_add(&fyn_map->mapping, fynp);
+	fy_node_mapping_sorted_invalidate(fyn_map);
 	if (fyn_map->xl)
 		fy_accel_insert(fyn_map->xl, fyn_key, fynp);
 
@@ -5670,6 +6055,8 @@ int fy_node_mapping_remove(struct fy_node *fyn_map, struct fy_node_pair *fynp)
 		return -1;
 
 	fy_node_pair_list_del(&fyn_map->mapping, fynp);
+	fy_node_mapping_sorted_invalidate(fyn_map);
+	fy_node_digest_invalidate(fyn_map);
 	if (fyn_map->xl)
 		fy_accel_remove(fyn_map->xl, fynp->key);
 
@@ -5710,6 +6097,7 @@ struct fy_node *fy_node_mapping_remove_by_key(struct fy_node *fyn_map, struct fy
 	fynp->value = NULL;
 
 	fy_node_pair_list_del(&fyn_map->mapping, fynp);
+	fy_node_mapping_sorted_invalidate(fyn_map);
 	if (fyn_map->xl)
 		fy_accel_remove(fyn_map->xl, fynp->key);
 
@@ -5846,6 +6234,88 @@ void fy_node_mapping_fill_array(struct fy_node *fyn_map,
 
 }
 
+/*
+ * The default sort, with the sort keys computed once per pair instead
+ * of on every comparison. The order is: mappings, sequences, aliases,
+ * scalars and missing keys last; aliases and scalars are sorted by
+ * their text, everything else keeps its original order.
+ */
+struct fy_node_mapping_sort_key {
+	struct fy_node_pair *fynp;
+	const char *text;
+	size_t len;
+	int rank;
+	int idx;
+};
+
+static int fy_node_mapping_sort_key_cmp(const void *a, const void *b)
+{
+	const struct fy_node_mapping_sort_key *ka = a, *kb = b;
+	size_t len;
+	int ret;
+
+	if (ka->rank != kb->rank)
+		return ka->rank < kb->rank ? -1 : 1;
+
+	if (ka->text && kb->text) {
+		len = ka->len < kb->len ? ka->len : kb->len;
+		ret = memcmp(ka->text, kb->text, len);
+		if (ret)
+			return ret;
+		if (ka->len != kb->len)
+			return ka->len < kb->len ? -1 : 1;
+	}
+
+	return ka->idx < kb->idx ? -1 : ka->idx > kb->idx ? 1 : 0;
+}
+
+static int fy_node_mapping_sort_default(struct fy_node_pair **fynpp, int count)
+{
+	struct fy_node_mapping_sort_key *keys, *k;
+	struct fy_node *fyn_key;
+	int i;
+
+	if (count < 2)
+		return 0;
+
+	keys = malloc(count * sizeof(*keys));
+	if (!keys)
+		return -1;
+
+	for (i = 0, k = keys; i < count; i++, k++) {
+		k->fynp = fynpp[i];
+		k->text = NULL;
+		k->len = 0;
+		k->idx = i;
+
+		fyn_key = k->fynp->key;
+		if (!fyn_key)
+			k->rank = 4;
+		else if (fyn_key->type == FYNT_MAPPING)
+			k->rank = 0;
+		else if (fyn_key->type == FYNT_SEQUENCE)
+			k->rank = 1;
+		else {
+			k->rank = fy_node_is_alias(fyn_key) ? 2 : 3;
+			k->text = fy_token_get_text(fyn_key->scalar, &k->len);
+			if (!k->text)
+				goto err_out;
+		}
+	}
+
+	qsort(keys, count, sizeof(*keys), fy_node_mapping_sort_key_cmp);
+
+	for (i = 0; i < count; i++)
+		fynpp[i] = keys[i].fynp;
+
+	free(keys);
+	return 0;
+
+err_out:
+	free(keys);
+	return -1;
+}
+
 void fy_node_mapping_perform_sort(struct fy_node *fyn_map,
 		fy_node_mapping_sort_fn key_cmp, void *arg,
 		struct fy_node_pair **fynpp, int count)
@@ -5853,6 +6323,10 @@ void fy_node_mapping_perform_sort(struct fy_node *fyn_map,
 	struct fy_node_mapping_sort_ctx ctx;
 	struct fy_node_cmp_arg def_arg;
 
+	/* the default sort ignores arg */
+	if (!key_cmp && !fy_node_mapping_sort_default(fynpp, count))
+		return;
+
 	if (!key_cmp) {
 		def_arg.cmp_fn = fy_node_scalar_cmp_default;
 		def_arg.arg = arg;
@@ -5911,6 +6385,27 @@ void fy_node_mapping_release_array(struct fy_node *fyn_map, struct fy_node_pair
 	free(fynpp);
 }
 
+struct fy_node_pair **fy_node_mapping_sorted(struct fy_node *fyn_map)
+{
+	struct fy_node_pair **fynpp, **cached;
+
+	cached = atomic_load(&fyn_map->sorted);
+	if (cached)
+		return cached;
+
+	fynpp = fy_node_mapping_sort_array(fyn_map, NULL, NULL, NULL);
+	if (!fynpp)
+		return NULL;
+
+	/* concurrent emitters of the same document may race here; first one wins */
+	if (!atomic_compare_exchange_strong(&fyn_map->sorted, &cached, fynpp)) {
+		free(fynpp);
+		return cached;
+	}
+
+	return fynpp;
+}
+
 int fy_node_mapping_sort(struct fy_node *fyn_map,
 		fy_node_mapping_sort_fn key_cmp,
 		void *arg)
@@ -5922,6 +6417,8 @@ int fy_node_mapping_sort(struct fy_node *fyn_map,
 	if (!fynpp)
 		return -1;
 
+	fy_node_mapping_sorted_invalidate(fyn_map);
+	fy_node_digest_invalidate(fyn_map);
 	fy_node_pair_list_init(&fyn_map->mapping);
 	for (i = 0; i < count; i++) {
 		fynpi = fynpp[i];
@@ -6502,7 +6999,7 @@ bool fy_document_is_accelerated(struct fy_document *fyd)
 static int hd_anchor_hash(struct fy_accel *xl, const void *key, void *userdata, void *hash)
 {
 	struct fy_token *fyt = (void *)key;
-	unsigned int *hashp = hash;
+	uint64_t *hashp = hash;
 	const char *text;
 	size_t len;
 
@@ -6510,7 +7007,7 @@ static int hd_anchor_hash(struct fy_accel *xl, const void *key, void *userdata,
 	if (!text)
 		return -1;
 
-	*hashp = XXH32(text, len, 2654435761U);
+	*hashp = XXH3_64bits(text, len);
 	return 0;
 }
 
@@ -6531,7 +7028,7 @@ static bool hd_anchor_eq(struct fy_accel *xl, const void *hash, const void *key1
 }
 
 static const struct fy_hash_desc hd_anchor = {
-	.size = sizeof(unsigned int),
+	.size = sizeof(uint64_t),
 	.max_bucket_grow_limit = 6,	/* TODO allow tuning */
 	.hash = hd_anchor_hash,
 	.eq = hd_anchor_eq,
@@ -6540,10 +7037,10 @@ static const struct fy_hash_desc hd_anchor = {
 static int hd_nanchor_hash(struct fy_accel *xl, const void *key, void *userdata, void *hash)
 {
 	struct fy_node *fyn = (void *)key;
-	unsigned int *hashp = hash;
+	uint64_t *hashp = hash;
 	uintptr_t ptr = (uintptr_t)fyn;
 
-	*hashp = XXH32(&ptr, sizeof(ptr), 2654435761U);
+	*hashp = XXH3_64bits(&ptr, sizeof(ptr));
 
 	return 0;
 }
@@ -6556,7 +7053,7 @@ static bool hd_nanchor_eq(struct fy_accel *xl, const void *hash, const void *key
 }
 
 static const struct fy_hash_desc hd_nanchor = {
-	.size = sizeof(unsigned int),
+	.size = sizeof(uint64_t),
 	.max_bucket_grow_limit = 6,	/* TODO allow tuning */
 	.hash = hd_nanchor_hash,
 	.eq = hd_nanchor_eq,
@@ -6565,7 +7062,7 @@ static const struct fy_hash_desc hd_nanchor = {
 
 static int hd_mapping_hash(struct fy_accel *xl, const void *key, void *userdata, void *hash)
 {
-	return fy_node_hash_uint((struct fy_node *)key, hash);
+	return fy_node_hash_u64((struct fy_node *)key, hash);
 }
 
 static bool hd_mapping_eq(struct fy_accel *xl, const void *hash, const void *key1, const void *key2, void *userdata)
@@ -6574,107 +7071,314 @@ static bool hd_mapping_eq(struct fy_accel *xl, const void *hash, const void *key
 }
 
 static const struct fy_hash_desc hd_mapping = {
-	.size = sizeof(unsigned int),
+	.size = sizeof(uint64_t),
 	.max_bucket_grow_limit = 6,	/* TODO allow tuning */
 	.hash = hd_mapping_hash,
 	.eq = hd_mapping_eq,
 };
 
-typedef void (*fy_hash_update_fn)(void *state, const void *ptr, size_t size);
+/* the seeds keep the different kinds of nodes apart */
+#define FY_NODE_HASH_SEED_SCALAR	0x73U	/* 's' */
+#define FY_NODE_HASH_SEED_ALIAS		0x41U	/* 'A' */
+#define FY_NODE_HASH_SEED_SEQUENCE	0x53U	/* 'S' */
+#define FY_NODE_HASH_SEED_MAPPING	0x4dU	/* 'M' */
 
-static int
-fy_node_hash_internal(struct fy_node *fyn, fy_hash_update_fn update_fn, void *state)
+static int fy_node_hash_u64_cmp(const void *a, const void *b)
+{
+	uint64_t ha = *(const uint64_t *)a, hb = *(const uint64_t *)b;
+
+	return ha < hb ? -1 : ha > hb ? 1 : 0;
+}
+
+int fy_node_hash_u64(struct fy_node *fyn, uint64_t *hashp)
 {
 	struct fy_node *fyni;
 	struct fy_node_pair *fynp;
-	struct fy_node_pair **fynpp;
-	struct fy_token_iter iter;
+	XXH64_state_t state;
+	uint64_t *items = NULL;
+	uint64_t h, kv[2];
+	const char *text;
+	size_t len;
 	int i, count, rc;
-	const struct fy_iter_chunk *ic;
 
 	if (!fyn) {
-		/* NULL */
-		update_fn(state, "s", 1);	/* as zero length scalar */
+		/* NULL hashes as zero length scalar */
+		*hashp = XXH3_64bits_withSeed("", 0, FY_NODE_HASH_SEED_SCALAR);
 		return 0;
 	}
 
 	switch (fyn->type) {
-	case FYNT_SEQUENCE:
-		/* SEQUENCE */
-		update_fn(state, "S", 1);
+	case FYNT_SCALAR:
+		/* one shot over the content, the common case for keys */
+		text = fy_token_get_text(fyn->scalar, &len);
+		if (!text)
+			return -1;
+		*hashp = XXH3_64bits_withSeed(text, len,
+				!fy_node_is_alias(fyn) ? FY_NODE_HASH_SEED_SCALAR : FY_NODE_HASH_SEED_ALIAS);
+		return 0;
 
+	case FYNT_SEQUENCE:
+		XXH64_reset(&state, FY_NODE_HASH_SEED_SEQUENCE);
 		for (fyni = fy_node_list_head(&fyn->sequence); fyni;
 		     fyni = fy_node_next(&fyn->sequence, fyni)) {
 
-			rc = fy_node_hash_internal(fyni, update_fn, state);
+			rc = fy_node_hash_u64(fyni, &h);
 			if (rc)
 				return rc;
+			XXH64_update(&state, &h, sizeof(h));
 		}
-
-		break;
+		*hashp = XXH64_digest(&state);
+		return 0;
 
 	case FYNT_MAPPING:
+		/* order independent; hash the pairs, and sort the pair hashes */
 		count = fy_node_mapping_item_count(fyn);
+		if (count > 0) {
+			items = malloc(sizeof(*items) * count);
+			if (!items)
+				return -1;
+		}
+
+		i = 0;
+		for (fynp = fy_node_pair_list_head(&fyn->mapping); fynp;
+		     fynp = fy_node_pair_next(&fyn->mapping, fynp)) {
+
+			rc = fy_node_hash_u64(fynp->key, &kv[0]);
+			if (!rc)
+				rc = fy_node_hash_u64(fynp->value, &kv[1]);
+			if (rc) {
+				free(items);
+				return rc;
+			}
+			items[i++] = XXH3_64bits(kv, sizeof(kv));
+		}
+		assert(i == count);
+
+		if (count > 1)
+			qsort(items, count, sizeof(*items), fy_node_hash_u64_cmp);
+
+		*hashp = XXH3_64bits_withSeed(items, sizeof(*items) * count, FY_NODE_HASH_SEED_MAPPING);
+		free(items);
+		return 0;
+	}
+
+	return -1;
+}
+
+/* the BLAKE3 hasher is not part of every build of the library (FY_NO_BLAKE3) */
+#ifndef FY_NO_BLAKE3
+
+struct fy_node_digest_ctx {
+	struct fy_blake3_hasher *fyh;
+	enum fy_node_digest_flags flags;
+};
+
+static int fy_node_digest_pair_cmp(const void *a, const void *b)
+{
+	return memcmp(a, b, 2 * FY_NODE_DIGEST_LEN);
+}
+
+static inline unsigned int
+fy_node_digest_memo_slot(struct fy_node *fyn, enum fy_node_digest_flags flags)
+{
+	return fyn->type != FYNT_SCALAR && (flags & FYNDF_KEY_ORDER) ? 1 : 0;
+}
+
+static bool fy_node_digest_memo_get(struct fy_node *fyn, enum fy_node_digest_flags flags,
+				    uint8_t digest[FY_NODE_DIGEST_LEN])
+{
+	struct fy_node_digest_memo *memo;
+	unsigned int slot;
 
-		fynpp = alloca(sizeof(*fynpp) * (count + 1));
+	memo = fyn ? atomic_load(&fyn->digest) : NULL;
+	if (!memo)
+		return false;
 
-		fy_node_mapping_fill_array(fyn, fynpp, count);
-		fy_node_mapping_perform_sort(fyn, NULL, NULL, fynpp, count);
+	slot = fy_node_digest_memo_slot(fyn, flags);
+	if (!(atomic_load(&memo->state) & FY_NODE_DIGEST_MEMO_VALID(slot)))
+		return false;
 
-		/* MAPPING */
-		update_fn(state, "M", 1);
+	memcpy(digest, memo->digest[slot], FY_NODE_DIGEST_LEN);
+	return true;
+}
+
+static int fy_node_digest_memo_put(struct fy_node *fyn, enum fy_node_digest_flags flags,
+				   const uint8_t digest[FY_NODE_DIGEST_LEN])
+{
+	struct fy_node_digest_memo *memo, *cached;
+	unsigned int slot;
+
+	memo = atomic_load(&fyn->digest);
+	if (!memo) {
+		memo = malloc(sizeof(*memo));
+		if (!memo)
+			return -1;
+		atomic_init(&memo->state, 0);
+
+		/* concurrent digests of the same document may race here; first one wins */
+		cached = NULL;
+		if (!atomic_compare_exchange_strong(&fyn->digest, &cached, memo)) {
+			free(memo);
+			memo = cached;
+		}
+	}
+
+	/* only one writer per slot, the others computed the same digest */
+	slot = fy_node_digest_memo_slot(fyn, flags);
+	if (atomic_fetch_or(&memo->state, FY_NODE_DIGEST_MEMO_BUSY(slot)) & FY_NODE_DIGEST_MEMO_BUSY(slot))
+		return 0;
 
-		for (i = 0; i < count; i++) {
-			fynp = fynpp[i];
+	memcpy(memo->digest[slot], digest, FY_NODE_DIGEST_LEN);
+	atomic_fetch_or(&memo->state, FY_NODE_DIGEST_MEMO_VALID(slot));
 
-			/* MAPPING KEY */
-			update_fn(state, "K", 1);
-			rc = fy_node_hash_internal(fynp->key, update_fn, state);
+	return 0;
+}
+
+/*
+ * The digest of a node is the BLAKE3 hash of its type, its tag (the
+ * length as 64 bit little endian, followed by the tag) and then either
+ * the scalar content or the digests of the items of the collection.
+ * Mapping pairs are (key, value) digests, in digest order unless the
+ * key order is significant.
+ */
+static int fy_node_digest_internal(struct fy_node_digest_ctx *ctx, struct fy_node *fyn,
+				   uint8_t digest[FY_NODE_DIGEST_LEN])
+{
+	struct fy_node *fyni;
+	struct fy_node_pair *fynp;
+	struct fy_token_iter iter;
+	const struct fy_iter_chunk *ic;
+	uint8_t *items = NULL, *p;
+	uint8_t hdr[9];
+	const char *tag;
+	size_t tag_len, items_len = 0;
+	int i, count, rc;
+
+	if (fy_node_digest_memo_get(fyn, ctx->flags, digest))
+		return 0;
+
+	/* the items first, the hasher is for a single node at a time */
+	if (fyn && fyn->type == FYNT_SEQUENCE) {
+		count = fy_node_sequence_item_count(fyn);
+		items_len = (size_t)count * FY_NODE_DIGEST_LEN;
+		if (count > 0 && !(items = malloc(items_len)))
+			return -1;
+
+		for (fyni = fy_node_list_head(&fyn->sequence), p = items; fyni;
+		     fyni = fy_node_next(&fyn->sequence, fyni), p += FY_NODE_DIGEST_LEN) {
+
+			rc = fy_node_digest_internal(ctx, fyni, p);
 			if (rc)
-				return rc;
+				goto err_out;
+		}
 
-			/* MAPPING VALUE */
-			update_fn(state, "V", 1);
-			rc = fy_node_hash_internal(fynp->value, update_fn, state);
+	} else if (fyn && fyn->type == FYNT_MAPPING) {
+		count = fy_node_mapping_item_count(fyn);
+		items_len = (size_t)count * 2 * FY_NODE_DIGEST_LEN;
+		if (count > 0 && !(items = malloc(items_len)))
+			return -1;
+
+		for (fynp = fy_node_pair_list_head(&fyn->mapping), p = items; fynp;
+		     fynp = fy_node_pair_next(&fyn->mapping, fynp), p += 2 * FY_NODE_DIGEST_LEN) {
+
+			rc = fy_node_digest_internal(ctx, fynp->key, p);
 			if (rc)
-				return rc;
+				goto err_out;
+			rc = fy_node_digest_internal(ctx, fynp->value, p + FY_NODE_DIGEST_LEN);
+			if (rc)
+				goto err_out;
 		}
 
-		break;
+		if (!(ctx->flags & FYNDF_KEY_ORDER) && count > 1)
+			qsort(items, count, 2 * FY_NODE_DIGEST_LEN, fy_node_digest_pair_cmp);
+	}
 
-	case FYNT_SCALAR:
-		update_fn(state, !fy_node_is_alias(fyn) ? "s" : "A", 1);
+	if (!fyn)
+		hdr[0] = 's';	/* as zero length scalar */
+	else if (fyn->type == FYNT_SEQUENCE)
+		hdr[0] = 'S';
+	else if (fyn->type == FYNT_MAPPING)
+		hdr[0] = 'M';
+	else
+		hdr[0] = !fy_node_is_alias(fyn) ? 's' : 'A';
 
+	tag = fy_node_get_tag(fyn, &tag_len);
+	for (i = 0; i < 8; i++)
+		hdr[1 + i] = (uint8_t)((uint64_t)tag_len >> (8 * i));
+
+	fy_blake3_hasher_reset(ctx->fyh);
+	fy_blake3_hasher_update(ctx->fyh, hdr, sizeof(hdr));
+	if (tag_len)
+		fy_blake3_hasher_update(ctx->fyh, tag, tag_len);
+
+	if (fyn && fyn->type == FYNT_SCALAR) {
 		fy_token_iter_start(fyn->scalar, &iter);
 		ic = NULL;
 		while ((ic = fy_token_iter_chunk_next(&iter, ic, &rc)) != NULL)
-			update_fn(state, ic->str, ic->len);
+			fy_blake3_hasher_update(ctx->fyh, ic->str, ic->len);
 		fy_token_iter_finish(&iter);
+	} else if (items_len)
+		fy_blake3_hasher_update(ctx->fyh, items, items_len);
 
-		break;
-	}
+	memcpy(digest, fy_blake3_hasher_finalize(ctx->fyh), FY_NODE_DIGEST_LEN);
 
-	return 0;
-}
+	free(items);
+	items = NULL;
 
-static void update_xx32(void *state, const void *ptr, size_t size)
-{
-	XXH32_update(state, ptr, size);
+	if (!fyn || (ctx->flags & FYNDF_NO_MEMO))
+		return 0;
+
+	return fy_node_digest_memo_put(fyn, ctx->flags, digest);
+
+err_out:
+	free(items);
+	return -1;
 }
 
-int fy_node_hash_uint(struct fy_node *fyn, unsigned int *hashp)
+int fy_node_digest(struct fy_node *fyn, enum fy_node_digest_flags flags,
+		   uint8_t digest[FY_NODE_DIGEST_LEN])
 {
-	XXH32_state_t state;
+	struct fy_blake3_hasher_cfg cfg;
+	struct fy_node_digest_ctx ctx;
 	int rc;
 
-	XXH32_reset(&state, 2654435761U);
+	if (!digest)
+		return -1;
 
-	rc = fy_node_hash_internal(fyn, update_xx32, &state);
-	if (rc)
-		return rc;
+	/* unchanged since the last time? */
+	if (fy_node_digest_memo_get(fyn, flags, digest))
+		return 0;
 
-	*hashp = XXH32_digest(&state);
-	return 0;
+	/* the nodes are small, no point in threads */
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.num_threads = -1;
+
+	ctx.fyh = fy_blake3_hasher_create(&cfg);
+	if (!ctx.fyh)
+		return -1;
+	ctx.flags = flags;
+
+	rc = fy_node_digest_internal(&ctx, fyn, digest);
+
+	fy_blake3_hasher_destroy(ctx.fyh);
+
+	return rc;
+}
+
+#else
+
+int fy_node_digest(struct fy_node *fyn, enum fy_node_digest_flags flags,
+		   uint8_t digest[FY_NODE_DIGEST_LEN])
+{
+	return -1;
+}
+
+#endif
+
+/* same as fy_node_hash_u64() of a non-alias scalar with that content */
+static uint64_t fy_node_hash_simple_key(const char *key, size_t len)
+{
+	return XXH3_64bits_withSeed(key, len, FY_NODE_HASH_SEED_SCALAR);
 }
 
 struct fy_document_state *fy_document_get_document_state(struct fy_document *fyd)
@@ -6956,6 +7660,8 @@ fy_node_pair_update_with_value(struct fy_node_pair *fynp, struct fy_node *fyn)
 	fyn_parent = fynp->parent;
 
 	fy_node_pair_list_add_tail(&fyn_parent->mapping, fynp);
+	fy_node_mapping_sorted_invalidate(fyn_parent);
+	fy_node_digest_invalidate(fyn_parent);
 	if (fyn_parent->xl) {
 		rc = fy_accel_insert(fyn_parent->xl, fynp->key, fynp);
 		fyd_error_check(fyn->fyd, !rc, err_out,
@@ -6966,6 +7672,7 @@ fy_node_pair_update_with_value(struct fy_node_pair *fynp, struct fy_node *fyn)
 
 err_out:
 	fy_node_pair_list_del(&fyn_parent->mapping, fynp);
+	fy_node_mapping_sorted_invalidate(fyn_parent);
 	if (fyn)
 		fyn->attached = false;
 	fynp->value = NULL;
@@ -6982,6 +7689,7 @@ fy_node_sequence_add_item(struct fy_node *fyn_parent, struct fy_node *fyn)
 	fyn->parent = fyn_parent;
 	fy_node_list_add_tail(&fyn_parent->sequence, fyn);
 	fyn->attached = true;
+	fy_node_digest_invalidate(fyn_parent);
 	return 0;
 }
 
@@ -16,6 +16,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 
 #include <libfyaml.h>
 
@@ -68,6 +69,8 @@ struct fy_node {
 	bool key_root : 1;		/* node is the root of key fy_node_get_parent() will return NULL */
 	void *meta;
 	struct fy_accel *xl;		/* mapping access accelerator */
+	_Atomic(struct fy_node_pair **) sorted;	/* cached default sort order of a mapping */
+	_Atomic(struct fy_node_digest_memo *) digest;	/* memoized fy_node_digest() */
 	struct fy_path_expr_node_data *pxnd;
 	union {
 		struct fy_token *scalar;
@@ -146,6 +149,48 @@ struct fy_node_pair **fy_node_mapping_sort_array(struct fy_node *fyn_map,
 
 void fy_node_mapping_release_array(struct fy_node *fyn_map, struct fy_node_pair **fynpp);
 
+struct fy_node_pair **fy_node_mapping_sorted(struct fy_node *fyn_map);
+
+/* must be called whenever the pairs (or the keys) of a mapping change */
+static inline void fy_node_mapping_sorted_invalidate(struct fy_node *fyn_map)
+{
+	struct fy_node_pair **fynpp;
+
+	if (fyn_map && (fynpp = atomic_exchange(&fyn_map->sorted, NULL)) != NULL)
+		free(fynpp);
+}
+
+/*
+ * the memoized fy_node_digest() of a node, one slot for each key order;
+ * scalars do not depend on it and only use the first one
+ */
+#define FY_NODE_DIGEST_MEMO_SLOTS	2
+#define FY_NODE_DIGEST_MEMO_BUSY(_s)	(1U << (2 * (_s)))
+#define FY_NODE_DIGEST_MEMO_VALID(_s)	(2U << (2 * (_s)))
+
+struct fy_node_digest_memo {
+	atomic_uint state;	/* busy and valid bits of the slots */
+	uint8_t digest[FY_NODE_DIGEST_MEMO_SLOTS][FY_NODE_DIGEST_LEN];
+};
+
+/*
+ * must be called whenever a node changes, the digests of all its parents
+ * are stale too; a collection is only memoized when all its items are,
+ * so stop at the first parent without a digest
+ */
+static inline void fy_node_digest_invalidate(struct fy_node *fyn)
+{
+	struct fy_node_digest_memo *memo;
+
+	if (!fyn)
+		return;
+
+	free(atomic_exchange(&fyn->digest, NULL));
+	while ((fyn = fyn->parent) != NULL &&
+	       (memo = atomic_exchange(&fyn->digest, NULL)) != NULL)
+		free(memo);
+}
+
 struct fy_node_walk_ctx {
 	unsigned int max_depth;
 	unsigned int next_slot;
@@ -49,6 +49,7 @@ fy_document_builder_reset(struct fy_document_builder *fydb)
 		c->fynp = NULL;
 	}
 	fydb->next = 0;
+	fydb->skip_depth = 0;
 
 	if (fydb->fyd) {
 		fy_document_destroy(fydb->fyd);
@@ -58,6 +59,215 @@ fy_document_builder_reset(struct fy_document_builder *fydb)
 	fydb->doc_done = false;
 }
 
+static struct fy_document_builder_filter *
+fy_document_builder_filter_create(const char *path)
+{
+	struct fy_document_builder_filter *f;
+	struct fy_document_builder_filter_component *fc;
+	const char *s, *e;
+	unsigned int count;
+	size_t len;
+	char *t;
+	int idx, digits;
+
+	len = strlen(path);
+
+	/* count the non empty components */
+	for (s = path, e = s + len, count = 0; s < e; ) {
+		while (s < e && *s == '/')
+			s++;
+		if (s >= e)
+			break;
+		count++;
+		while (s < e && *s != '/')
+			s++;
+	}
+
+	f = malloc(sizeof(*f) + count * sizeof(*fc) + len + 1);
+	if (!f)
+		return NULL;
+
+	t = (char *)&f->comp[count];
+	memcpy(t, path, len + 1);
+
+	f->count = count;
+	for (s = t, e = s + len, fc = f->comp; s < e; fc++) {
+		while (s < e && *s == '/')
+			s++;
+		if (s >= e)
+			break;
+		fc->text = s;
+		while (s < e && *s != '/')
+			s++;
+		fc->len = (size_t)(s - fc->text);
+
+		/* a component may also select a sequence item */
+		for (idx = 0, digits = 0; digits < (int)fc->len && digits < 9; digits++) {
+			if (fc->text[digits] < '0' || fc->text[digits] > '9')
+				break;
+			idx = idx * 10 + (fc->text[digits] - '0');
+		}
+		fc->idx = digits == (int)fc->len ? idx : -1;
+	}
+
+	return f;
+}
+
+int
+fy_document_builder_set_filter(struct fy_document_builder *fydb, const char * const *paths)
+{
+	struct fy_document_builder_filter *f;
+	unsigned int i;
+	bool select_all;
+
+	if (!fydb)
+		return -1;
+
+	for (i = 0; i < fydb->filter_count; i++)
+		free(fydb->filters[i]);
+	fydb->filter_count = 0;
+	fydb->filter_root = 0;
+
+	if (!paths)
+		return 0;
+
+	select_all = false;
+	for (i = 0; paths[i]; i++) {
+		if (i >= FY_DOCUMENT_BUILDER_MAX_FILTERS)
+			goto err_out;
+
+		f = fy_document_builder_filter_create(paths[i]);
+		if (!f)
+			goto err_out;
+
+		fydb->filters[fydb->filter_count++] = f;
+
+		/* an empty path (i.e. "/") selects everything */
+		if (!f->count)
+			select_all = true;
+		else
+			fydb->filter_root |= (uint64_t)1 << i;
+	}
+
+	if (select_all)
+		fydb->filter_root = 0;
+
+	return 0;
+
+err_out:
+	fy_document_builder_set_filter(fydb, NULL);
+	return -1;
+}
+
+static bool
+fy_document_builder_filter_key_match(struct fy_node *fyn_key,
+				     const struct fy_document_builder_filter_component *fc)
+{
+	return fyn_key && fyn_key->type == FYNT_SCALAR && fyn_key->style != FYNS_ALIAS &&
+	       !fy_token_memcmp(fyn_key->scalar, fc->text, fc->len);
+}
+
+/* work out what to do with the node of a newly pushed context */
+static void
+fy_document_builder_filter_ctx(struct fy_document_builder *fydb,
+			       struct fy_document_builder_ctx *cp,
+			       struct fy_document_builder_ctx *c)
+{
+	const struct fy_document_builder_filter_component *fc;
+	struct fy_node *fyn_key;
+	unsigned int i, depth;
+	uint64_t match;
+	bool matched, complete;
+
+	if (!fydb->filter_count)
+		return;
+
+	/* the root */
+	if (!cp) {
+		c->filter_match = fydb->filter_root;
+		return;
+	}
+
+	/* everything under a selected node is built */
+	if (!cp->filter_match)
+		return;
+
+	fyn_key = NULL;
+	switch (cp->s) {
+	case FYDBS_MAP_KEY:
+		/* keys must be built to match them */
+		c->filter_match = cp->filter_match;
+		c->is_key = true;
+		return;
+
+	case FYDBS_MAP_VAL:
+		/* a skipped (complex) key leaves no pair */
+		if (!cp->fynp) {
+			c->skip = true;
+			return;
+		}
+		fyn_key = cp->fynp->key;
+		break;
+
+	case FYDBS_SEQ:
+		break;
+
+	default:
+		return;
+	}
+
+	/* the root is not part of the path */
+	depth = fydb->next - 2;
+
+	match = 0;
+	complete = false;
+	for (i = 0; i < fydb->filter_count; i++) {
+		if (!(cp->filter_match & ((uint64_t)1 << i)))
+			continue;
+
+		assert(depth < fydb->filters[i]->count);
+		fc = &fydb->filters[i]->comp[depth];
+
+		if (cp->s == FYDBS_SEQ)
+			matched = fc->idx >= 0 && fc->idx == cp->idx;
+		else
+			matched = fy_document_builder_filter_key_match(fyn_key, fc);
+		if (!matched)
+			continue;
+
+		if (depth + 1 >= fydb->filters[i]->count)
+			complete = true;
+		else
+			match |= (uint64_t)1 << i;
+	}
+
+	if (complete)
+		c->filter_match = 0;
+	else if (match)
+		c->filter_match = match;
+	else
+		c->skip = true;
+}
+
+static bool
+fy_document_builder_ctx_skip(struct fy_document_builder *fydb,
+			     struct fy_document_builder_ctx *c,
+			     enum fy_event_type etype)
+{
+	bool is_collection;
+
+	if (c->skip)
+		return true;
+
+	/* not filtered, or the root which is always built */
+	if (!c->filter_match || fydb->next == 1)
+		return false;
+
+	/* keys are matched only when scalars; only collections may contain a selection */
+	is_collection = etype == FYET_MAPPING_START || etype == FYET_SEQUENCE_START;
+	return c->is_key ? is_collection : !is_collection;
+}
+
 static const struct fy_document_builder_cfg docbuilder_default_cfg = {
 	.parse_cfg = {
 		.flags = FYPCF_DEFAULT_DOC,
@@ -88,6 +298,11 @@ fy_document_builder_create(const struct fy_document_builder_cfg *cfg)
 	if (!fydb->stack)
 		goto err_out;
 
+	/* the filters are compiled, the paths are not kept */
+	fydb->cfg.filter_paths = NULL;
+	if (cfg->filter_paths && fy_document_builder_set_filter(fydb, cfg->filter_paths))
+		goto err_out;
+
 	return fydb;
 
 err_out:
@@ -107,6 +322,7 @@ fy_document_builder_destroy(struct fy_document_builder *fydb)
 		return;
 
 	fy_document_builder_reset(fydb);
+	fy_document_builder_set_filter(fydb, NULL);
 
 	fy_diag_unref(fydb->cfg.diag);
 	if (fydb->stack)
@@ -218,6 +434,7 @@ fy_document_builder_set_in_document(struct fy_document_builder *fydb, struct fy_
 	c = &fydb->stack[++fydb->next - 1];
 	memset(c, 0, sizeof(*c));
 	c->s = FYDBS_NODE;
+	fy_document_builder_filter_ctx(fydb, NULL, c);
 
 	return 0;
 }
@@ -309,6 +526,29 @@ fy_document_builder_process_event(struct fy_document_builder *fydb, struct fy_ev
 	/* the top state must always be NODE for processing the event */
 	assert(c->s == FYDBS_NODE);
 
+	/* nodes outside of the selection are skipped without building them */
+	if (fydb->skip_depth ||
+	    (etype != FYET_MAPPING_END && etype != FYET_SEQUENCE_END &&
+	     fy_document_builder_ctx_skip(fydb, c, etype))) {
+
+		switch (etype) {
+		case FYET_MAPPING_START:
+		case FYET_SEQUENCE_START:
+			fydb->skip_depth++;
+			break;
+		case FYET_MAPPING_END:
+		case FYET_SEQUENCE_END:
+			assert(fydb->skip_depth > 0);
+			fydb->skip_depth--;
+			break;
+		default:
+			break;
+		}
+		if (fydb->skip_depth)
+			return 0;
+		goto skipped;
+	}
+
 	switch (etype) {
 	case FYET_SCALAR:
 	case FYET_ALIAS:
@@ -425,11 +665,45 @@ push:
 	c = &fydb->stack[++fydb->next - 1];
 	memset(c, 0, sizeof(*c));
 	c->s = FYDBS_NODE;
+	fy_document_builder_filter_ctx(fydb, fydb->next > 1 ? c - 1 : NULL, c);
 	return 0;
 
 err_out:
 	return -1;
 
+skipped:
+	/* the root is never skipped */
+	assert(fydb->next > 1);
+	fydb->next--;
+	c = &fydb->stack[fydb->next - 1];
+
+	switch (c->s) {
+	case FYDBS_MAP_KEY:
+		/* skipped complex key, skip the value too */
+		c->fynp = NULL;
+		c->s = FYDBS_MAP_VAL;
+		break;
+
+	case FYDBS_MAP_VAL:
+		/* drop the pair */
+		fy_node_pair_free(c->fynp);
+		c->fynp = NULL;
+		c->s = FYDBS_MAP_KEY;
+		break;
+
+	case FYDBS_SEQ:
+		c->idx++;
+		break;
+
+	default:
+		/* unexpected state */
+		FYDB_TOKEN_ERROR(fydb, fyt, FYEM_DOC,
+				"Unexpected skipped node in state %s\n",
+					fy_document_builder_state_txt[c->s]);
+		goto err_out;
+	}
+	goto push;
+
 complete:
 	assert(fydb->next > 0);
 	c = &fydb->stack[fydb->next - 1];
@@ -486,8 +760,8 @@ complete:
 			fynp->value->parent = fyn_parent;
 
 		fy_node_pair_list_add_tail(&c->fyn->mapping, fynp);
-		if (fyn->xl) {
-			rc = fy_accel_insert(fyn->xl, fynp->key, fynp);
+		if (c->fyn->xl) {
+			rc = fy_accel_insert(c->fyn->xl, fynp->key, fynp);
 			assert(!rc);
 		}
 		if (fynp->key)
@@ -504,6 +778,7 @@ complete:
 		fyn->parent = fyn_parent;
 		fy_node_list_add_tail(&c->fyn->sequence, fyn);
 		fyn->attached = true;
+		c->idx++;
 		goto push;
 
 	case FYDBS_NODE:
@@ -522,7 +797,7 @@ fy_document_builder_load_document(struct fy_document_builder *fydb,
 	struct fy_eventp *fyep = NULL;
 	int rc;
 
-	if (fyp->state == FYPS_END)
+	if (!fydb || !fyp || fyp->state == FYPS_END)
 		return NULL;
 
 	while (!fy_document_builder_is_document_complete(fydb) &&
@@ -32,12 +32,24 @@ struct fy_document_builder_ctx {
 	enum fy_document_builder_state s;
 	struct fy_node *fyn;
 	struct fy_node_pair *fynp;	/* for mapping */
+	uint64_t filter_match;		/* filters still matching; 0 builds everything */
+	int idx;			/* next sequence item index */
+	bool skip : 1;			/* outside of the selection */
+	bool is_key : 1;		/* mapping key, matched against the filters */
 };
 
-struct fy_document_builder_cfg {
-	struct fy_parse_cfg parse_cfg;
-	void *userdata;
-	struct fy_diag *diag;
+/* maximum number of filter paths (bits of filter_match) */
+#define FY_DOCUMENT_BUILDER_MAX_FILTERS	64
+
+struct fy_document_builder_filter_component {
+	const char *text;
+	size_t len;
+	int idx;			/* -1 if not a valid sequence index */
+};
+
+struct fy_document_builder_filter {
+	unsigned int count;
+	struct fy_document_builder_filter_component comp[0];
 };
 
 struct fy_document_builder {
@@ -50,17 +62,15 @@ struct fy_document_builder {
 	unsigned int alloc;
 	unsigned int max_depth;
 	struct fy_document_builder_ctx *stack;
+	unsigned int skip_depth;	/* nesting inside a skipped node */
+	unsigned int filter_count;
+	uint64_t filter_root;		/* filters matching the root */
+	struct fy_document_builder_filter *filters[FY_DOCUMENT_BUILDER_MAX_FILTERS];
 };
 
-struct fy_document_builder *
-fy_document_builder_create(const struct fy_document_builder_cfg *cfg);
-
 void
 fy_document_builder_reset(struct fy_document_builder *fydb);
 
-void
-fy_document_builder_destroy(struct fy_document_builder *fydb);
-
 struct fy_document *
 fy_document_builder_get_document(struct fy_document_builder *fydb);
 
@@ -88,10 +98,6 @@ fy_document_builder_set_in_document(struct fy_document_builder *fydb, struct fy_
 int
 fy_document_builder_process_event(struct fy_document_builder *fydb, struct fy_eventp *fyep);
 
-struct fy_document *
-fy_document_builder_load_document(struct fy_document_builder *fydb,
-				  struct fy_parser *fyp);
-
 struct fy_document *
 fy_document_builder_event_document(struct fy_document_builder *fydb, struct fy_eventp_list *evpl);
 
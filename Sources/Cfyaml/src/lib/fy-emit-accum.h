@@ -32,6 +32,36 @@ struct fy_emit_accum {
 	enum fy_lb_mode lb_mode;
 };
 
+/*
+ * Backing stores of the accumulators that outgrow their inplace buffer
+ * are taken from (and returned to) a per thread pool, so the transient
+ * accumulators (token text, path text, comments) don't churn the
+ * allocator.
+ */
+
+/* stores larger than this are never pooled */
+#define FY_EMIT_ACCUM_POOL_MAX_SIZE	(64 * 1024)
+/* maximum number of pooled stores (per thread) */
+#define FY_EMIT_ACCUM_POOL_MAX_COUNT	8
+/* stores up to this size are never trimmed */
+#define FY_EMIT_ACCUM_POOL_TRIM_MIN	(4 * 1024)
+
+struct fy_emit_accum_stats {
+	unsigned long long grows;	/* number of (re)allocations */
+	unsigned long long pool_hits;	/* stores reused from the pool */
+	unsigned long long pool_misses;	/* stores allocated afresh */
+	unsigned long long trims;	/* stores freed by the trim policy */
+	size_t pooled;			/* currently pooled stores */
+	size_t pooled_size;		/* and their total size */
+};
+
+void *fy_emit_accum_pool_get(size_t *sizep);
+bool fy_emit_accum_pool_put(void *buf, size_t size);
+void fy_emit_accum_pool_trim(void);
+void fy_emit_accum_pool_release_thread(void);
+void fy_emit_accum_pool_note_grow(size_t size);
+void fy_emit_accum_get_stats(struct fy_emit_accum_stats *stats);
+
 static inline void
 fy_emit_accum_init(struct fy_emit_accum *ea,
 		   void *inplace, size_t inplacesz,
@@ -58,7 +88,8 @@ fy_emit_accum_reset(struct fy_emit_accum *ea)
 static inline void
 fy_emit_accum_cleanup(struct fy_emit_accum *ea)
 {
-	if (ea->accum && ea->accum != ea->inplace)
+	if (ea->accum && ea->accum != ea->inplace &&
+	    !fy_emit_accum_pool_put(ea->accum, ea->alloc))
 		free(ea->accum);
 	ea->accum = ea->inplace;
 	ea->alloc = ea->inplacesz;
@@ -94,7 +125,15 @@ fy_emit_accum_grow(struct fy_emit_accum *ea, size_t need)
 		asz *= 2;
 	} while (asz < atleast);
 	assert(asz > ea->inplacesz);
-	new_accum = realloc(ea->accum == ea->inplace ? NULL : ea->accum, asz);
+	if (ea->accum == ea->inplace) {
+		/* first move out of the inplace buffer, try the pool */
+		new_accum = fy_emit_accum_pool_get(&asz);
+		if (!new_accum)
+			new_accum = malloc(asz);
+	} else {
+		fy_emit_accum_pool_note_grow(asz);
+		new_accum = realloc(ea->accum, asz);
+	}
 	if (!new_accum)	/* out of memory */
 		return -1;
 	if (ea->accum && ea->accum == ea->inplace)
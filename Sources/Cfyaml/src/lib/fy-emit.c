@@ -17,12 +17,19 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <errno.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <pthread.h>
 
 #include <libfyaml.h>
 
 #include "fy-parse.h"
 #include "fy-emit.h"
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
 static inline struct fy_token_list *token_recycle_list(struct fy_emitter *emit, struct fy_parser *fyp)
 {
 	if (fyp && fyp->recycled_token_list)
@@ -37,7 +44,21 @@ static inline void fy_emit_token_unref(struct fy_emitter *emit, struct fy_parser
 	fy_token_unref_rl(token_recycle_list(emit, fyp), fyt);
 }
 
+/* state of the direct (event-less) interface */
+struct fy_emit_raw {
+	enum fy_event_type pending;	/* collection start held back */
+	enum fy_node_style pending_style;
+	enum fy_event_type next;	/* type of the item after the one handled */
+	struct fy_input input;		/* the (borrowed) scalar content */
+	struct fy_token scalar;
+	struct fy_token alias;
+	struct fy_token seq_start[2];	/* block, flow */
+	struct fy_token map_start[2];	/* block, flow */
+};
+
 /* fwd decl */
+static int fy_emit_raw_flush(struct fy_emitter *emit, enum fy_event_type next);
+static void fy_emit_raw_destroy(struct fy_emitter *emit);
 void fy_emit_write(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len);
 void fy_emit_printf(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *fmt, ...)
 		__attribute__((format(printf, 3, 4)));
@@ -188,18 +209,165 @@ void fy_emit_scalar(struct fy_emitter *emit, struct fy_node *fyn, int flags, int
 void fy_emit_sequence(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent);
 void fy_emit_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent);
 
-void fy_emit_write(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len)
+static void fy_emit_output_chunk(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len)
 {
-	int c, w;
-	const char *m, *e;
 	int outlen;
 
-	if (!len)
-		return;
-
 	outlen = emit->cfg.output(emit, type, str, len, emit->cfg.userdata);
 	if (outlen != len)
 		emit->output_error = true;
+}
+
+static int fy_emit_output_run_add(struct fy_emitter *emit, enum fy_emitter_write_type type, int len)
+{
+	struct fy_emitter_write_run *runs;
+	unsigned int alloc;
+
+	/* merge with the previous run if it's of the same type */
+	if (emit->oruns_count > 0 && emit->oruns[emit->oruns_count - 1].type == type) {
+		emit->oruns[emit->oruns_count - 1].len += len;
+		return 0;
+	}
+
+	if (emit->oruns_count >= emit->oruns_alloc) {
+		alloc = emit->oruns_alloc ? emit->oruns_alloc * 2 : 64;
+		runs = realloc(emit->oruns, sizeof(*runs) * alloc);
+		if (!runs)
+			return -1;
+		emit->oruns = runs;
+		emit->oruns_alloc = alloc;
+	}
+	runs = &emit->oruns[emit->oruns_count++];
+	runs->type = type;
+	runs->len = len;
+
+	return 0;
+}
+
+static void fy_emit_output_iov_add(struct fy_emitter *emit, const char *str, size_t len)
+{
+	struct iovec *iov;
+
+	assert(emit->oiov_count <= emit->oiov_alloc);
+	iov = &emit->oiov[emit->oiov_count++];
+	iov->iov_base = (void *)str;
+	iov->iov_len = len;
+}
+
+static void fy_emit_output_gather_flush(struct fy_emitter *emit)
+{
+	struct iovec *iov, *iove;
+	ssize_t wrn;
+	int cnt;
+
+	/* close the pending buffer segment */
+	if (emit->obuf_len > emit->obuf_seg)
+		fy_emit_output_iov_add(emit, emit->obuf + emit->obuf_seg,
+				       emit->obuf_len - emit->obuf_seg);
+
+	iov = emit->oiov;
+	iove = iov + emit->oiov_count;
+	while (iov < iove && !emit->output_error) {
+
+		cnt = (int)(iove - iov);
+		if (cnt > IOV_MAX)
+			cnt = IOV_MAX;
+
+		do {
+			wrn = writev(emit->ofd, iov, cnt);
+		} while (wrn == -1 && (errno == EAGAIN || errno == EINTR));
+
+		if (wrn <= 0) {
+			emit->output_error = true;
+			break;
+		}
+
+		/* skip over what was written, a partial write updates the iov in place */
+		while (iov < iove && (size_t)wrn >= iov->iov_len) {
+			wrn -= iov->iov_len;
+			iov++;
+		}
+		if (wrn > 0) {
+			iov->iov_base = (char *)iov->iov_base + wrn;
+			iov->iov_len -= wrn;
+		}
+	}
+
+	emit->oiov_count = 0;
+	emit->obuf_len = 0;
+	emit->obuf_seg = 0;
+	emit->oruns_count = 0;
+}
+
+void fy_emit_output_flush(struct fy_emitter *emit)
+{
+	if (emit->oiov) {
+		fy_emit_output_gather_flush(emit);
+		return;
+	}
+
+	if (!emit->obuf_len)
+		return;
+
+	/* the chunk is reported as being of the type of the first write */
+	fy_emit_output_chunk(emit, emit->oruns_count ? emit->oruns[0].type : fyewt_plain_scalar,
+			     emit->obuf, (int)emit->obuf_len);
+	emit->obuf_len = 0;
+	emit->oruns_count = 0;
+}
+
+static void fy_emit_output_buffered(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len)
+{
+	/* never split a write, a chunk always ends on a write boundary */
+	if (emit->obuf_len + len > emit->obuf_size) {
+		fy_emit_output_flush(emit);
+
+		/* too large to buffer, pass it through */
+		if ((size_t)len > emit->obuf_size && emit->oiov) {
+			fy_emit_output_iov_add(emit, str, len);
+			fy_emit_output_flush(emit);
+			return;
+		}
+		if ((size_t)len > emit->obuf_size) {
+			if (emit->obuf_track_types) {
+				emit->oruns_count = 0;
+				if (fy_emit_output_run_add(emit, type, len))
+					emit->output_error = true;
+			}
+			fy_emit_output_chunk(emit, type, str, len);
+			emit->oruns_count = 0;
+			return;
+		}
+	}
+
+	/* without type tracking only the first type is kept */
+	if (emit->obuf_track_types || !emit->oruns_count) {
+		if (fy_emit_output_run_add(emit, type, len))
+			emit->output_error = true;
+	}
+
+	memcpy(emit->obuf + emit->obuf_len, str, len);
+	emit->obuf_len += len;
+}
+
+static void fy_emit_output_gather(struct fy_emitter *emit, const char *str, int len)
+{
+	/* room for the pending buffer segment and the direct chunk */
+	if (emit->oiov_count + 2 > emit->oiov_alloc)
+		fy_emit_output_flush(emit);
+
+	if (emit->obuf_len > emit->obuf_seg) {
+		fy_emit_output_iov_add(emit, emit->obuf + emit->obuf_seg,
+				       emit->obuf_len - emit->obuf_seg);
+		emit->obuf_seg = emit->obuf_len;
+	}
+	fy_emit_output_iov_add(emit, str, len);
+}
+
+static void fy_emit_update_position(struct fy_emitter *emit, const char *str, int len)
+{
+	int c, w;
+	const char *m, *e;
 
 	e = str + len;
 	while ((c = fy_utf8_get(str, (e - str), &w)) >= 0) {
@@ -232,6 +400,35 @@ void fy_emit_write(struct fy_emitter *emit, enum fy_emitter_write_type type, con
 	}
 }
 
+static inline void fy_emit_output(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len)
+{
+	if (!emit->obuf)
+		fy_emit_output_chunk(emit, type, str, len);
+	else
+		fy_emit_output_buffered(emit, type, str, len);
+}
+
+void fy_emit_write(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len)
+{
+	if (!len)
+		return;
+
+	fy_emit_output(emit, type, str, len);
+	fy_emit_update_position(emit, str, len);
+}
+
+/* str points to the source input, which stays put for the whole emit */
+void fy_emit_write_direct(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len)
+{
+	if (!emit->oiov || len < FY_EMIT_GATHER_MIN) {
+		fy_emit_write(emit, type, str, len);
+		return;
+	}
+
+	fy_emit_output_gather(emit, str, len);
+	fy_emit_update_position(emit, str, len);
+}
+
 void fy_emit_puts(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str)
 {
 	fy_emit_write(emit, type, str, strlen(str));
@@ -241,6 +438,13 @@ void fy_emit_putc(struct fy_emitter *emit, enum fy_emitter_write_type type, int
 {
 	char buf[FY_UTF8_FORMAT_BUFMIN];
 
+	/* plain ascii is the common case */
+	if (c > 0 && c < 0x80) {
+		buf[0] = (char)c;
+		fy_emit_write(emit, type, buf, 1);
+		return;
+	}
+
 	fy_utf8_format(c, buf, fyue_none);
 	fy_emit_puts(emit, type, buf);
 }
@@ -274,31 +478,56 @@ void fy_emit_printf(struct fy_emitter *emit, enum fy_emitter_write_type type, co
 	va_end(ap);
 }
 
+#define FY_EMIT_WS_16	"                "
+
+/* a line break followed by spaces; whitespace is written as a slice of it */
+static const char fy_emit_ws_table[] = "\n"
+	FY_EMIT_WS_16 FY_EMIT_WS_16 FY_EMIT_WS_16 FY_EMIT_WS_16
+	FY_EMIT_WS_16 FY_EMIT_WS_16 FY_EMIT_WS_16 FY_EMIT_WS_16;
+
+#define FY_EMIT_WS_MAX	((int)sizeof(fy_emit_ws_table) - 2)
+
+/* spaces only, so the position is updated directly */
+static void fy_emit_write_spaces(struct fy_emitter *emit, enum fy_emitter_write_type type, int len)
+{
+	int chunk;
+
+	for (; len > 0; len -= chunk) {
+		chunk = len > FY_EMIT_WS_MAX ? FY_EMIT_WS_MAX : len;
+		fy_emit_output(emit, type, fy_emit_ws_table + 1, chunk);
+		emit->column += chunk;
+	}
+}
+
 void fy_emit_write_ws(struct fy_emitter *emit)
 {
-	fy_emit_putc(emit, fyewt_whitespace, ' ');
+	fy_emit_write_spaces(emit, fyewt_whitespace, 1);
 	emit->flags |= FYEF_WHITESPACE;
 }
 
 void fy_emit_write_indent(struct fy_emitter *emit, int indent)
 {
 	int len;
-	char *ws;
 
 	indent = indent > 0 ? indent : 0;
 
 	if (!fy_emit_indentation(emit) || emit->column > indent ||
-	    (emit->column == indent && !fy_emit_whitespace(emit)))
-		fy_emit_putc(emit, fyewt_linebreak, '\n');
-
-	if (emit->column < indent) {
-		len = indent - emit->column;
-		ws = alloca(len + 1);
-		memset(ws, ' ', len);
-		ws[len] = '\0';
-		fy_emit_write(emit, fyewt_indent, ws, len);
+	    (emit->column == indent && !fy_emit_whitespace(emit))) {
+		/*
+		 * When the write types are not reported separately the
+		 * line break and the indentation go out in a single write.
+		 */
+		len = 0;
+		if (emit->obuf && !emit->obuf_track_types)
+			len = indent > FY_EMIT_WS_MAX ? FY_EMIT_WS_MAX : indent;
+		fy_emit_output(emit, fyewt_linebreak, fy_emit_ws_table, 1 + len);
+		emit->column = len;
+		emit->line++;
 	}
 
+	if (emit->column < indent)
+		fy_emit_write_spaces(emit, fyewt_indent, indent - emit->column);
+
 	emit->flags |= FYEF_WHITESPACE | FYEF_INDENTATION;
 }
 
@@ -654,12 +883,22 @@ void fy_emit_common_node_preamble(struct fy_emitter *emit,
 	}
 }
 
+static inline bool fy_emit_json_fast(const struct fy_emitter *emit);
+static void fy_emit_json_node(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent);
+
 void fy_emit_node_internal(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent, bool is_key)
 {
 	enum fy_node_type type;
 	struct fy_anchor *fya;
 	struct fy_token *fyt_anchor = NULL;
 
+	/* a whole JSON tree goes out via the JSON emitter */
+	if ((flags & DDNF_ROOT) && fyn && fy_emit_json_fast(emit)) {
+		fy_emit_common_node_preamble(emit, NULL, NULL, flags, indent);
+		fy_emit_json_node(emit, fyn, flags, indent);
+		return;
+	}
+
 	if (!(emit->cfg.flags & FYECF_STRIP_LABELS)) {
 		fya = fy_document_lookup_anchor_by_node(emit->fyd, fyn);
 		if (fya)
@@ -728,7 +967,7 @@ void fy_emit_token_write_plain(struct fy_emitter *emit, struct fy_token *fyt, in
 	/* simple case first (90% of cases) */
 	str = fy_token_get_direct_output(fyt, &len);
 	if (str && fy_token_atom_style(fyt) == FYAS_PLAIN) {
-		fy_emit_write(emit, wtype, str, len);
+		fy_emit_write_direct(emit, wtype, str, len);
 		goto out;
 	}
 
@@ -811,7 +1050,7 @@ void fy_emit_token_write_alias(struct fy_emitter *emit, struct fy_token *fyt, in
 	/* try direct output first (99% of cases) */
 	str = fy_token_get_direct_output(fyt, &len);
 	if (str) {
-		fy_emit_write(emit, fyewt_alias, str, len);
+		fy_emit_write_direct(emit, fyewt_alias, str, len);
 		return;
 	}
 
@@ -862,7 +1101,7 @@ void fy_emit_token_write_quoted(struct fy_emitter *emit, struct fy_token *fyt, i
 	/* simple case of direct output (large amount of cases) */
 	str = fy_token_get_direct_output(fyt, &len);
 	if (str && fy_token_atom_style(fyt) == target_style) {
-		fy_emit_write(emit, wtype, str, len);
+		fy_emit_write_direct(emit, wtype, str, len);
 		goto out;
 	}
 
@@ -1082,6 +1321,145 @@ out:
 			flags, indent, wtype);
 }
 
+/* length of the leading run of str that can be output in JSON without escaping */
+static size_t fy_emit_json_unescaped_span(const char *str, size_t len)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+	const uint64_t highs = 0x8080808080808080ULL;
+	uint64_t v, q, b, d;
+	size_t i;
+	int c;
+
+	/* eight bytes at a time; any byte < 0x20, '"', '\\', 0x7f or >= 0x80 stops */
+	for (i = 0; i + sizeof(v) <= len; i += sizeof(v)) {
+		memcpy(&v, str + i, sizeof(v));
+		q = v ^ (ones * '"');
+		b = v ^ (ones * '\\');
+		d = v ^ (ones * 0x7f);
+		if ((((v - ones * 0x20) & ~v) |
+		     ((q - ones) & ~q) |
+		     ((b - ones) & ~b) |
+		     ((d - ones) & ~d) | v) & highs)
+			break;
+	}
+
+	for (; i < len; i++) {
+		c = (uint8_t)str[i];
+		if (c < 0x20 || c == '"' || c == '\\' || c >= 0x7f)
+			break;
+	}
+
+	return i;
+}
+
+static void fy_emit_accum_json_u(struct fy_emit_accum *ea, unsigned int u)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	char buf[6];
+
+	buf[0] = '\\';
+	buf[1] = 'u';
+	buf[2] = hex[(u >> 12) & 15];
+	buf[3] = hex[(u >> 8) & 15];
+	buf[4] = hex[(u >> 4) & 15];
+	buf[5] = hex[u & 15];
+	fy_emit_accum_utf8_write_raw(ea, buf, sizeof(buf));
+}
+
+/*
+ * JSON double quoted output of a direct output scalar, escaping runs
+ * instead of going through the atom iterator one character at a time.
+ * Returns false without emitting anything when the generic path
+ * must be used (no direct output or invalid UTF8).
+ */
+static bool fy_emit_json_write_quoted(struct fy_emitter *emit, struct fy_token *fyt, int flags)
+{
+	enum fy_emitter_write_type wtype;
+	const char *str, *s, *e;
+	size_t len, run;
+	uint32_t hi_surrogate, lo_surrogate;
+	int c, w;
+
+	str = fy_token_get_direct_output(fyt, &len);
+	/* double quoted direct output goes out verbatim, as in the generic path */
+	if (!str || fy_token_atom_style(fyt) == FYAS_DOUBLE_QUOTED)
+		return false;
+
+	wtype = (flags & DDNF_SIMPLE_SCALAR_KEY) ?
+			fyewt_double_quoted_scalar_key : fyewt_double_quoted_scalar;
+
+	run = fy_emit_json_unescaped_span(str, len);
+	if (run == len) {
+		fy_emit_write_indicator(emit, di_double_quote_start, flags, 0, wtype);
+		fy_emit_write_direct(emit, wtype, str, len);
+		fy_emit_write_indicator(emit, di_double_quote_end, flags, 0, wtype);
+		return true;
+	}
+
+	fy_emit_accum_start(&emit->ea, emit->column, fylb_cr_nl);
+
+	s = str;
+	e = str + len;
+	while (s < e) {
+		fy_emit_accum_utf8_write_raw(&emit->ea, s, run);
+		s += run;
+		if (s >= e)
+			break;
+
+		c = fy_utf8_get(s, e - s, &w);
+		if (c < 0) {
+			fy_emit_accum_finish(&emit->ea);
+			return false;
+		}
+
+		switch (c) {
+		case '\b':
+			fy_emit_accum_utf8_write_raw(&emit->ea, "\\b", 2);
+			break;
+		case '\f':
+			fy_emit_accum_utf8_write_raw(&emit->ea, "\\f", 2);
+			break;
+		case '\n':
+			fy_emit_accum_utf8_write_raw(&emit->ea, "\\n", 2);
+			break;
+		case '\r':
+			fy_emit_accum_utf8_write_raw(&emit->ea, "\\r", 2);
+			break;
+		case '\t':
+			fy_emit_accum_utf8_write_raw(&emit->ea, "\\t", 2);
+			break;
+		case '"':
+			fy_emit_accum_utf8_write_raw(&emit->ea, "\\\"", 2);
+			break;
+		case '\\':
+			fy_emit_accum_utf8_write_raw(&emit->ea, "\\\\", 2);
+			break;
+		default:
+			if (fy_is_printq(c) && fy_is_json_unescaped(c)) {
+				fy_emit_accum_utf8_write_raw(&emit->ea, s, w);
+			} else if ((unsigned int)c <= 0xffff) {
+				fy_emit_accum_json_u(&emit->ea, c);
+			} else {
+				hi_surrogate = 0xd800 | ((((c >> 16) & 0x1f) - 1) << 6) | ((c >> 10) & 0x3f);
+				lo_surrogate = 0xdc00 | (c & 0x3ff);
+				fy_emit_accum_json_u(&emit->ea, hi_surrogate);
+				fy_emit_accum_json_u(&emit->ea, lo_surrogate);
+			}
+			break;
+		}
+		s += w;
+
+		run = fy_emit_json_unescaped_span(s, e - s);
+	}
+
+	fy_emit_write_indicator(emit, di_double_quote_start, flags, 0, wtype);
+	fy_emit_output_accum(emit, wtype, &emit->ea);
+	fy_emit_accum_finish(&emit->ea);
+	fy_emit_write_indicator(emit, di_double_quote_end, flags, 0, wtype);
+
+	return true;
+}
+
 bool fy_emit_token_write_block_hints(struct fy_emitter *emit, struct fy_token *fyt, int flags, int indent, char *chompp)
 {
 	char chomp = '\0';
@@ -1388,7 +1766,8 @@ void fy_emit_token_scalar(struct fy_emitter *emit, struct fy_token *fyt, int fla
 		fy_emit_token_write_plain(emit, fyt, flags, indent);
 		break;
 	case FYNS_DOUBLE_QUOTED:
-		fy_emit_token_write_quoted(emit, fyt, flags, indent, '"');
+		if (!fy_emit_is_json_mode(emit) || !fy_emit_json_write_quoted(emit, fyt, flags))
+			fy_emit_token_write_quoted(emit, fyt, flags, indent, '"');
 		break;
 	case FYNS_SINGLE_QUOTED:
 		fy_emit_token_write_quoted(emit, fyt, flags, indent, '\'');
@@ -1504,11 +1883,59 @@ static void fy_emit_sequence_item_epilog(struct fy_emitter *emit, struct fy_emit
 	sc->flags &= ~DDNF_SEQ;
 }
 
+static void fy_emit_sequence_item(struct fy_emitter *emit, struct fy_emit_save_ctx *sc,
+				  struct fy_node *fyni, bool last)
+{
+	struct fy_token *fyt_value;
+
+	fyt_value = fy_node_value_token(fyni);
+
+	fy_emit_sequence_item_prolog(emit, sc, fyt_value);
+	fy_emit_node_internal(emit, fyni, (sc->flags & ~DDNF_ROOT), sc->indent, false);
+	fy_emit_sequence_item_epilog(emit, sc, last, fyt_value);
+}
+
+static int fy_emit_parallel(struct fy_emitter *emit, struct fy_emit_save_ctx *sc,
+			    void **items, size_t count, bool mapping);
+
+static int fy_emit_sequence_parallel(struct fy_emitter *emit, struct fy_emit_save_ctx *sc,
+				     struct fy_node *fyn)
+{
+	struct fy_node *fyni, **items = NULL, **itemsn;
+	size_t count, alloc;
+	int rc;
+
+	/* do not bother collecting sequences that are too small */
+	for (count = 0, fyni = fy_node_list_head(&fyn->sequence);
+	     fyni && count < emit->parallel_min;
+	     count++, fyni = fy_node_next(&fyn->sequence, fyni))
+		;
+	if (count < emit->parallel_min)
+		return 1;
+
+	count = alloc = 0;
+	for (fyni = fy_node_list_head(&fyn->sequence); fyni; fyni = fy_node_next(&fyn->sequence, fyni)) {
+		if (count >= alloc) {
+			alloc = alloc ? alloc * 2 : emit->parallel_min;
+			itemsn = realloc(items, alloc * sizeof(*items));
+			if (!itemsn) {
+				free(items);
+				return 1;
+			}
+			items = itemsn;
+		}
+		items[count++] = fyni;
+	}
+
+	rc = fy_emit_parallel(emit, sc, (void **)items, count, false);
+	free(items);
+
+	return rc;
+}
+
 void fy_emit_sequence(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent)
 {
 	struct fy_node *fyni, *fynin;
-	struct fy_token *fyt_value;
-	bool last;
 	struct fy_emit_save_ctx sct, *sc = &sct;
 
 	memset(sc, 0, sizeof(*sc));
@@ -1523,15 +1950,11 @@ void fy_emit_sequence(struct fy_emitter *emit, struct fy_node *fyn, int flags, i
 
 	fy_emit_sequence_prolog(emit, sc);
 
-	for (fyni = fy_node_list_head(&fyn->sequence); fyni; fyni = fynin) {
-
-		fynin = fy_node_next(&fyn->sequence, fyni);
-		last = !fynin;
-		fyt_value = fy_node_value_token(fyni);
-
-		fy_emit_sequence_item_prolog(emit, sc, fyt_value);
-		fy_emit_node_internal(emit, fyni, (sc->flags & ~DDNF_ROOT), sc->indent, false);
-		fy_emit_sequence_item_epilog(emit, sc, last, fyt_value);
+	if (!emit->tp || fy_emit_sequence_parallel(emit, sc, fyn) > 0) {
+		for (fyni = fy_node_list_head(&fyn->sequence); fyni; fyni = fynin) {
+			fynin = fy_node_next(&fyn->sequence, fyni);
+			fy_emit_sequence_item(emit, sc, fyni, !fynin);
+		}
 	}
 
 	fy_emit_sequence_epilog(emit, sc);
@@ -1652,12 +2075,88 @@ static void fy_emit_mapping_value_epilog(struct fy_emitter *emit, struct fy_emit
 	sc->flags &= ~DDNF_MAP;
 }
 
-void fy_emit_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent)
+static int fy_emit_mapping_pair(struct fy_emitter *emit, struct fy_emit_save_ctx *sc,
+				struct fy_node_pair *fynp, bool last)
 {
-	struct fy_node_pair *fynp, *fynpn, **fynpp = NULL;
 	struct fy_token *fyt_key, *fyt_value;
-	bool last, simple_key, used_malloc = false;
-	int aflags, i, count;
+	bool simple_key;
+	int aflags;
+
+	fyt_key = fy_node_value_token(fynp->key);
+	fyt_value = fy_node_value_token(fynp->value);
+
+	FYD_NODE_ERROR_CHECK(fynp->fyd, fynp->key, FYEM_INTERNAL,
+			!fy_emit_is_json_mode(emit) ||
+				(fynp->key && fynp->key->type == FYNT_SCALAR),
+				err_out, "Non scalar keys are not allowed in JSON emit mode");
+
+	simple_key = false;
+	if (fynp->key) {
+		switch (fynp->key->type) {
+		case FYNT_SCALAR:
+			aflags = fy_token_text_analyze(fynp->key->scalar);
+			simple_key = fy_emit_is_json_mode(emit) ||
+				     !!(aflags & FYTTAF_CAN_BE_SIMPLE_KEY);
+			break;
+		case FYNT_SEQUENCE:
+			simple_key = fy_node_list_empty(&fynp->key->sequence);
+			break;
+		case FYNT_MAPPING:
+			simple_key = fy_node_pair_list_empty(&fynp->key->mapping);
+			break;
+		}
+	}
+
+	fy_emit_mapping_key_prolog(emit, sc, fyt_key, simple_key);
+	if (fynp->key)
+		fy_emit_node_internal(emit, fynp->key, (sc->flags & ~DDNF_ROOT), sc->indent, true);
+	fy_emit_mapping_key_epilog(emit, sc, fyt_key);
+
+	fy_emit_mapping_value_prolog(emit, sc, fyt_value);
+	if (fynp->value)
+		fy_emit_node_internal(emit, fynp->value, (sc->flags & ~DDNF_ROOT), sc->indent, false);
+	fy_emit_mapping_value_epilog(emit, sc, last, fyt_value);
+
+	return 0;
+
+err_out:
+	return -1;
+}
+
+static int fy_emit_mapping_parallel(struct fy_emitter *emit, struct fy_emit_save_ctx *sc,
+				    struct fy_node *fyn, struct fy_node_pair **fynpp, int count)
+{
+	struct fy_node_pair *fynp, **items;
+	int rc, i;
+
+	if (!fynpp)
+		count = fy_node_mapping_item_count(fyn);
+	if (count < 0 || (size_t)count < emit->parallel_min)
+		return 1;
+
+	/* the sorted/filtered pairs are already there */
+	if (fynpp)
+		return fy_emit_parallel(emit, sc, (void **)fynpp, count, true);
+
+	items = malloc(count * sizeof(*items));
+	if (!items)
+		return 1;
+
+	for (i = 0, fynp = fy_node_pair_list_head(&fyn->mapping); fynp && i < count;
+	     fynp = fy_node_pair_next(&fyn->mapping, fynp))
+		items[i++] = fynp;
+
+	rc = fy_emit_parallel(emit, sc, (void **)items, i, true);
+	free(items);
+
+	return rc;
+}
+
+void fy_emit_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent)
+{
+	struct fy_node_pair *fynp, *fynpn, **fynpp = NULL, **fynpps = NULL;
+	bool used_malloc = false;
+	int i, j, count = 0, rc;
 	struct fy_emit_save_ctx sct, *sc = &sct;
 
 	memset(sc, 0, sizeof(*sc));
@@ -1672,9 +2171,20 @@ void fy_emit_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, in
 
 	fy_emit_mapping_prolog(emit, sc);
 
+	/* canonical mode uses the sort order cached on the mapping */
+	if ((emit->cfg.flags & FYECF_SORT_KEYS) && emit->canonical)
+		fynpps = fy_node_mapping_sorted(fyn);
+
 	if (!(emit->cfg.flags & (FYECF_SORT_KEYS | FYECF_STRIP_EMPTY_KV))) {
 		fynp = fy_node_pair_list_head(&fyn->mapping);
 		fynpp = NULL;
+	} else if (fynpps && !(emit->cfg.flags & FYECF_STRIP_EMPTY_KV)) {
+		/* used as is */
+		fynpp = fynpps;
+		for (count = 0; fynpp[count]; count++)
+			;
+		i = 0;
+		fynp = fynpp[i];
 	} else {
 		count = fy_node_mapping_item_count(fyn);
 
@@ -1689,8 +2199,8 @@ void fy_emit_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, in
 
 		/* fill (removing empty KVs) */
 		i = 0;
-		for (fynp = fy_node_pair_list_head(&fyn->mapping); fynp;
-				fynp = fy_node_pair_next(&fyn->mapping, fynp)) {
+		for (j = 0, fynp = fynpps ? fynpps[0] : fy_node_pair_list_head(&fyn->mapping); fynp;
+				fynp = fynpps ? fynpps[++j] : fy_node_pair_next(&fyn->mapping, fynp)) {
 
 			/* strip key/value pair from the output if it's empty */
 			if ((emit->cfg.flags & FYECF_STRIP_EMPTY_KV) && fy_node_is_empty(fynp->value))
@@ -1701,14 +2211,21 @@ void fy_emit_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, in
 		count = i;
 		fynpp[count] = NULL;
 
-		/* sort the keys */
-		if (emit->cfg.flags & FYECF_SORT_KEYS)
+		/* sort the keys (unless already in sorted order) */
+		if ((emit->cfg.flags & FYECF_SORT_KEYS) && !fynpps)
 			fy_node_mapping_perform_sort(fyn, NULL, NULL, fynpp, count);
 
 		i = 0;
 		fynp = fynpp[i];
 	}
 
+	/* large mappings are emitted in parallel when possible */
+	rc = emit->tp ? fy_emit_mapping_parallel(emit, sc, fyn, fynpp, count) : 1;
+	if (rc < 0)
+		goto err_out;
+	if (!rc)
+		fynp = NULL;
+
 	for (; fynp; fynp = fynpn) {
 
 		if (!fynpp)
@@ -1716,41 +2233,8 @@ void fy_emit_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, in
 		else
 			fynpn = fynpp[++i];
 
-		last = !fynpn;
-		fyt_key = fy_node_value_token(fynp->key);
-		fyt_value = fy_node_value_token(fynp->value);
-
-		FYD_NODE_ERROR_CHECK(fynp->fyd, fynp->key, FYEM_INTERNAL,
-				!fy_emit_is_json_mode(emit) ||
-					(fynp->key && fynp->key->type == FYNT_SCALAR),
-					err_out, "Non scalar keys are not allowed in JSON emit mode");
-
-		simple_key = false;
-		if (fynp->key) {
-			switch (fynp->key->type) {
-			case FYNT_SCALAR:
-				aflags = fy_token_text_analyze(fynp->key->scalar);
-				simple_key = fy_emit_is_json_mode(emit) ||
-					     !!(aflags & FYTTAF_CAN_BE_SIMPLE_KEY);
-				break;
-			case FYNT_SEQUENCE:
-				simple_key = fy_node_list_empty(&fynp->key->sequence);
-				break;
-			case FYNT_MAPPING:
-				simple_key = fy_node_pair_list_empty(&fynp->key->mapping);
-				break;
-			}
-		}
-
-		fy_emit_mapping_key_prolog(emit, sc, fyt_key, simple_key);
-		if (fynp->key)
-			fy_emit_node_internal(emit, fynp->key, (sc->flags & ~DDNF_ROOT), sc->indent, true);
-		fy_emit_mapping_key_epilog(emit, sc, fyt_key);
-
-		fy_emit_mapping_value_prolog(emit, sc, fyt_value);
-		if (fynp->value)
-			fy_emit_node_internal(emit, fynp->value, (sc->flags & ~DDNF_ROOT), sc->indent, false);
-		fy_emit_mapping_value_epilog(emit, sc, last, fyt_value);
+		if (fy_emit_mapping_pair(emit, sc, fynp, !fynpn))
+			goto err_out;
 	}
 
 	if (fynpp && used_malloc)
@@ -1758,21 +2242,371 @@ void fy_emit_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, in
 
 	fy_emit_mapping_epilog(emit, sc);
 
-err_out:
 	return;
+
+err_out:
+	if (fynpp && used_malloc)
+		free(fynpp);
 }
 
-int fy_emit_common_document_start(struct fy_emitter *emit,
-				  struct fy_document_state *fyds,
-				  bool root_tag_or_anchor)
+/*
+ * Parallel emission of the items of large collections.
+ *
+ * The items are split in contiguous chunks, each emitted on a thread of
+ * the pool by a private emitter into its own buffer (along with the
+ * write type runs). The parent emits the indentation that would precede
+ * the first item of each chunk, so the chunk emitter starts in the same
+ * column/whitespace state that the serial emitter would be in, and then
+ * replays the chunk output in order. The output is identical to the
+ * serial case.
+ *
+ * Oneline modes are not handled, since items there do not start with
+ * an indentation point.
+ */
+struct fy_emit_parallel_chunk {
+	struct fy_emitter emit;
+	struct fy_emit_save_ctx sc;
+	struct fy_emit_accum ea;
+	void **items;
+	size_t count;
+	bool mapping : 1;
+	bool last : 1;
+	bool error : 1;
+};
+
+static int fy_emit_parallel_output(struct fy_emitter *emit, enum fy_emitter_write_type type,
+				   const char *str, int len, void *userdata)
 {
-	struct fy_token *fyt_chk;
-	const char *td_handle, *td_prefix;
-	size_t td_handle_size, td_prefix_size;
-	enum fy_emitter_cfg_flags flags = emit->cfg.flags;
-	enum fy_emitter_cfg_flags vd_flags = flags & FYECF_VERSION_DIR(FYECF_VERSION_DIR_MASK);
-	enum fy_emitter_cfg_flags td_flags = flags & FYECF_TAG_DIR(FYECF_TAG_DIR_MASK);
-	enum fy_emitter_cfg_flags dsm_flags = flags & FYECF_DOC_START_MARK(FYECF_DOC_START_MARK_MASK);
+	struct fy_emit_parallel_chunk *c = userdata;
+
+	if (fy_emit_accum_utf8_write_raw(&c->ea, str, len) ||
+	    fy_emit_output_run_add(emit, type, len))
+		return -1;
+	return len;
+}
+
+static void fy_emit_parallel_chunk_work(void *arg)
+{
+	struct fy_emit_parallel_chunk *c = arg;
+	size_t i;
+	bool last;
+
+	for (i = 0; i < c->count; i++) {
+		last = c->last && i == c->count - 1;
+		if (!c->mapping)
+			fy_emit_sequence_item(&c->emit, &c->sc, c->items[i], last);
+		else if (fy_emit_mapping_pair(&c->emit, &c->sc, c->items[i], last)) {
+			c->error = true;
+			break;
+		}
+	}
+}
+
+static bool fy_emit_parallel_prepare_pair(struct fy_emitter *emit, struct fy_node_pair *fynp);
+
+static void fy_emit_parallel_prepare_token(struct fy_token *fyt)
+{
+	size_t len;
+
+	/* only shared tokens may be accessed by more than one thread */
+	if (!fyt || fyt->refs <= 1)
+		return;
+
+	(void)fy_token_get_text(fyt, &len);
+	if (fyt->type == FYTT_SCALAR)
+		(void)fy_token_text_analyze(fyt);
+}
+
+/*
+ * The only errors while emitting items are non scalar keys in JSON mode;
+ * those trees are left to the serial path, so that the diagnostics are
+ * reported once and in order. Returns false for such a tree.
+ */
+static bool fy_emit_parallel_prepare(struct fy_emitter *emit, struct fy_node *fyn)
+{
+	struct fy_node_pair *fynp;
+	struct fy_node *fyni;
+
+	if (!fyn)
+		return true;
+
+	fy_emit_parallel_prepare_token(fyn->tag);
+
+	switch (fyn->type) {
+	case FYNT_SCALAR:
+		fy_emit_parallel_prepare_token(fyn->scalar);
+		break;
+
+	case FYNT_SEQUENCE:
+		for (fyni = fy_node_list_head(&fyn->sequence); fyni;
+		     fyni = fy_node_next(&fyn->sequence, fyni))
+			if (!fy_emit_parallel_prepare(emit, fyni))
+				return false;
+		break;
+
+	case FYNT_MAPPING:
+		for (fynp = fy_node_pair_list_head(&fyn->mapping); fynp;
+		     fynp = fy_node_pair_next(&fyn->mapping, fynp))
+			if (!fy_emit_parallel_prepare_pair(emit, fynp))
+				return false;
+		break;
+	}
+
+	return true;
+}
+
+static bool fy_emit_parallel_prepare_pair(struct fy_emitter *emit, struct fy_node_pair *fynp)
+{
+	if (fy_emit_is_json_mode(emit) && (!fynp->key || fynp->key->type != FYNT_SCALAR))
+		return false;
+
+	return fy_emit_parallel_prepare(emit, fynp->key) &&
+	       fy_emit_parallel_prepare(emit, fynp->value);
+}
+
+/* 0 when emitted, 1 when the serial path should be used, -1 on error */
+static int fy_emit_parallel(struct fy_emitter *emit, struct fy_emit_save_ctx *sc,
+			    void **items, size_t count, bool mapping)
+{
+	struct fy_emitter_cfg cfg;
+	struct fy_emit_parallel_chunk *chunks = NULL, *c;
+	const struct fy_emitter_write_run *run;
+	const char *text;
+	size_t num_chunks, chunk_size, i, start, len;
+	unsigned int j;
+	void **args = NULL;
+	int rc;
+
+	if (fy_emit_is_oneline(emit) || !count)
+		return 1;
+
+	num_chunks = (size_t)fy_thread_pool_get_num_threads(emit->tp) * FY_EMIT_PARALLEL_CHUNKS_PER_THREAD;
+	if (num_chunks <= 1)
+		return 1;
+	if (num_chunks > count)
+		num_chunks = count;
+
+	/* fill in the lazily generated token state of shared tokens,
+	 * and leave the items that can fail to the serial path */
+	for (i = 0; i < count; i++) {
+		if (!(mapping ? fy_emit_parallel_prepare_pair(emit, items[i]) :
+				fy_emit_parallel_prepare(emit, items[i])))
+			return 1;
+	}
+
+	chunk_size = (count + num_chunks - 1) / num_chunks;
+	num_chunks = (count + chunk_size - 1) / chunk_size;
+
+	chunks = malloc(sizeof(*chunks) * num_chunks);
+	args = malloc(sizeof(*args) * num_chunks);
+	if (!chunks || !args) {
+		free(args);
+		free(chunks);
+		return 1;
+	}
+	memset(chunks, 0, sizeof(*chunks) * num_chunks);
+
+	cfg = emit->cfg;
+	cfg.flags &= ~FYECF_OUTPUT_BUFFERED;
+	cfg.output = fy_emit_parallel_output;
+	cfg.diag = emit->diag;
+
+	for (i = 0, start = 0, c = chunks; i < num_chunks; i++, c++, start += chunk_size) {
+		c->items = items + start;
+		c->count = start + chunk_size <= count ? chunk_size : count - start;
+		c->mapping = mapping;
+		c->last = i == num_chunks - 1;
+		c->sc = *sc;
+
+		cfg.userdata = c;
+		if (fy_emit_setup(&c->emit, &cfg))
+			break;
+		fy_emit_accum_init(&c->ea, NULL, 0, 0, fylb_cr_nl);
+
+		c->emit.fyd = emit->fyd;
+		c->emit.fyds = emit->fyds;
+		c->emit.source_json = emit->source_json;
+		c->emit.force_json = emit->force_json;
+		c->emit.canonical = emit->canonical;
+		c->emit.flow_level = emit->flow_level;
+		/* the state after the indentation of the first item */
+		c->emit.column = sc->indent > 0 ? sc->indent : 0;
+		c->emit.flags = (emit->flags & ~FYEF_OPEN_ENDED) | FYEF_WHITESPACE | FYEF_INDENTATION;
+
+		args[i] = c;
+	}
+
+	/* failed to setup, nothing was output yet */
+	if (i < num_chunks) {
+		num_chunks = i;
+		rc = 1;
+		goto out;
+	}
+
+	/* prefer the threads on the node of the document's nodes */
+	fy_thread_args_join_node(emit->tp, fy_emit_parallel_chunk_work, NULL, args, num_chunks,
+				 fy_thread_pool_mem_node(emit->tp, items[0]));
+
+	rc = 0;
+	for (i = 0, c = chunks; i < num_chunks; i++, c++) {
+
+		/* a chunk failing on its first item has nothing to indent */
+		if (c->error && !c->emit.oruns_count) {
+			rc = -1;
+			break;
+		}
+
+		fy_emit_write_indent(emit, sc->indent);
+
+		text = fy_emit_accum_get(&c->ea, &len);
+		for (j = 0, run = c->emit.oruns; j < c->emit.oruns_count; j++, run++) {
+			fy_emit_output(emit, run->type, text, run->len);
+			text += run->len;
+		}
+
+		emit->column = c->emit.column;
+		emit->line += c->emit.line;
+		emit->flags = c->emit.flags;
+		if (c->emit.output_error)
+			emit->output_error = true;
+		sc->flags = c->sc.flags;
+
+		if (c->error) {
+			rc = -1;
+			break;
+		}
+	}
+
+out:
+	for (i = 0, c = chunks; i < num_chunks; i++, c++) {
+		/* the document state belongs to the parent */
+		c->emit.fyd = NULL;
+		c->emit.fyds = NULL;
+		fy_emit_accum_cleanup(&c->ea);
+		fy_emit_cleanup(&c->emit);
+	}
+	free(args);
+	free(chunks);
+
+	return rc;
+}
+
+/*
+ * JSON emission; same output as the generic path but without the
+ * YAML only machinery (anchors, comments, styles, block layouts).
+ * Sorted or filtered keys and comments go through the generic path.
+ */
+static inline bool fy_emit_json_fast(const struct fy_emitter *emit)
+{
+	return fy_emit_is_json_mode(emit) &&
+	       !(emit->cfg.flags & (FYECF_SORT_KEYS | FYECF_STRIP_EMPTY_KV | FYECF_OUTPUT_COMMENTS));
+}
+
+static void fy_emit_json_node(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent);
+
+static void fy_emit_json_sequence(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent)
+{
+	struct fy_node *fyni, *fynin;
+	bool oneline = fy_emit_is_oneline(emit);
+	int old_indent = indent;
+
+	flags |= DDNF_FLOW;
+	fy_emit_write_indicator(emit, di_left_bracket, flags, indent, fyewt_indicator);
+	if (!oneline)
+		indent = fy_emit_increase_indent(emit, flags, indent);
+	flags = (flags & ~DDNF_ROOT) | DDNF_SEQ;
+
+	for (fyni = fy_node_list_head(&fyn->sequence); fyni; fyni = fynin) {
+		fynin = fy_node_next(&fyn->sequence, fyni);
+
+		if (!oneline)
+			fy_emit_write_indent(emit, indent);
+		fy_emit_json_node(emit, fyni, flags, indent);
+		if (fynin)
+			fy_emit_write_indicator(emit, di_comma, flags, indent, fyewt_indicator);
+		else if (!oneline)
+			fy_emit_write_indent(emit, old_indent);
+	}
+
+	fy_emit_write_indicator(emit, di_right_bracket, flags, old_indent, fyewt_indicator);
+}
+
+static void fy_emit_json_mapping(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent)
+{
+	struct fy_node_pair *fynp, *fynpn;
+	struct fy_token *fyt_key;
+	bool oneline = fy_emit_is_oneline(emit);
+	int old_indent = indent, kflags;
+
+	flags |= DDNF_FLOW;
+	fy_emit_write_indicator(emit, di_left_brace, flags, indent, fyewt_indicator);
+	if (!oneline && !fy_node_pair_list_empty(&fyn->mapping))
+		indent = fy_emit_increase_indent(emit, flags, indent);
+	flags = DDNF_MAP | DDNF_FLOW;
+
+	for (fynp = fy_node_pair_list_head(&fyn->mapping); fynp; fynp = fynpn) {
+		fynpn = fy_node_pair_next(&fyn->mapping, fynp);
+
+		FYD_NODE_ERROR_CHECK(fynp->fyd, fynp->key, FYEM_INTERNAL,
+				fynp->key && fynp->key->type == FYNT_SCALAR,
+				err_out, "Non scalar keys are not allowed in JSON emit mode");
+
+		fyt_key = fynp->key->scalar;
+		kflags = flags | DDNF_SIMPLE;
+		if (fyt_key && fyt_key->type == FYTT_SCALAR)
+			kflags |= DDNF_SIMPLE_SCALAR_KEY;
+
+		if (!oneline)
+			fy_emit_write_indent(emit, indent);
+
+		/* all JSON keys are double quoted */
+		fy_emit_token_scalar(emit, fyt_key, kflags, indent, FYNS_DOUBLE_QUOTED, fynp->key->tag);
+
+		if (fyt_key && fyt_key->type == FYTT_ALIAS)
+			fy_emit_write_ws(emit);
+		fy_emit_write_indicator(emit, di_colon, kflags & ~DDNF_MAP, indent, fyewt_indicator);
+
+		if (fynp->value)
+			fy_emit_json_node(emit, fynp->value, flags, indent);
+
+		if (fynpn)
+			fy_emit_write_indicator(emit, di_comma, flags, indent, fyewt_indicator);
+		else if (!oneline)
+			fy_emit_write_indent(emit, old_indent);
+	}
+
+	fy_emit_write_indicator(emit, di_right_brace, flags, old_indent, fyewt_indicator);
+
+err_out:
+	return;
+}
+
+static void fy_emit_json_node(struct fy_emitter *emit, struct fy_node *fyn, int flags, int indent)
+{
+	switch (fyn->type) {
+	case FYNT_SCALAR:
+		fy_emit_token_scalar(emit, fyn->scalar, flags, indent, fyn->style, fyn->tag);
+		break;
+	case FYNT_SEQUENCE:
+		fy_emit_json_sequence(emit, fyn, flags, indent);
+		break;
+	case FYNT_MAPPING:
+		fy_emit_json_mapping(emit, fyn, flags, indent);
+		break;
+	}
+}
+
+int fy_emit_common_document_start(struct fy_emitter *emit,
+				  struct fy_document_state *fyds,
+				  bool root_tag_or_anchor)
+{
+	struct fy_token *fyt_chk;
+	const char *td_handle, *td_prefix;
+	size_t td_handle_size, td_prefix_size;
+	enum fy_emitter_cfg_flags flags = emit->cfg.flags;
+	enum fy_emitter_cfg_flags vd_flags = flags & FYECF_VERSION_DIR(FYECF_VERSION_DIR_MASK);
+	enum fy_emitter_cfg_flags td_flags = flags & FYECF_TAG_DIR(FYECF_TAG_DIR_MASK);
+	enum fy_emitter_cfg_flags dsm_flags = flags & FYECF_DOC_START_MARK(FYECF_DOC_START_MARK_MASK);
 	bool vd, td, dsm;
 	bool had_non_default_tag = false;
 
@@ -1937,6 +2771,10 @@ int fy_emit_common_document_end(struct fy_emitter *emit, bool override_state, bo
 	/* stop our association with the document */
 	emit->fyds = NULL;
 
+	/* the document is complete, push out anything buffered */
+	if (emit->obuf)
+		fy_emit_output_flush(emit);
+
 	return 0;
 }
 
@@ -1976,6 +2814,10 @@ int fy_emit_common_explicit_document_end(struct fy_emitter *emit)
 	/* stop our association with the document */
 	emit->fyds = NULL;
 
+	/* the document is complete, push out anything buffered */
+	if (emit->obuf)
+		fy_emit_output_flush(emit);
+
 	return 0;
 }
 
@@ -2020,9 +2862,176 @@ void fy_emit_reset(struct fy_emitter *emit, bool reset_events)
 	if (reset_events) {
 		while ((fyep = fy_eventp_list_pop(&emit->queued_events)) != NULL)
 			fy_eventp_release(fyep);
+		if (emit->raw)
+			emit->raw->pending = FYET_NONE;
 	}
 }
 
+/*
+ * Per thread pool of accumulator backing stores.
+ *
+ * The pooled stores are kept sorted by size and a get takes the smallest
+ * one that fits. When the pool is full a larger store evicts the
+ * smallest one. The pool keeps a high water mark of the store sizes
+ * in use; a trim (on emitter cleanup) frees the larger pooled stores
+ * above it and halves it, so that the stores of a one-off huge scalar
+ * are eventually released.
+ */
+struct fy_emit_accum_pool {
+	unsigned int count;
+	struct {
+		void *buf;
+		size_t size;
+	} stores[FY_EMIT_ACCUM_POOL_MAX_COUNT];
+	size_t high_water;
+	bool registered;	/* the thread exit destructor is set */
+	struct fy_emit_accum_stats stats;
+};
+
+static __thread struct fy_emit_accum_pool fy_emit_accum_pool;
+static pthread_once_t fy_emit_accum_pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t fy_emit_accum_pool_key;
+static bool fy_emit_accum_pool_key_ok;
+
+static void fy_emit_accum_pool_release(void *arg)
+{
+	struct fy_emit_accum_pool *pool = arg;
+
+	while (pool->count > 0)
+		free(pool->stores[--pool->count].buf);
+	pool->stats.pooled_size = 0;
+}
+
+static void fy_emit_accum_pool_key_create(void)
+{
+	fy_emit_accum_pool_key_ok = !pthread_key_create(&fy_emit_accum_pool_key,
+							fy_emit_accum_pool_release);
+}
+
+void fy_emit_accum_pool_release_thread(void)
+{
+	fy_emit_accum_pool_release(&fy_emit_accum_pool);
+}
+
+/*
+ * The thread exit destructor never runs for the thread that calls exit()
+ * (usually the main thread), so release its pool when the library is
+ * unloaded. The key is deleted too, so that the threads still alive do
+ * not call into an unloaded library on exit.
+ */
+static void __attribute__((destructor)) fy_emit_accum_pool_fini(void)
+{
+	fy_emit_accum_pool_release_thread();
+	if (fy_emit_accum_pool_key_ok) {
+		pthread_key_delete(fy_emit_accum_pool_key);
+		fy_emit_accum_pool_key_ok = false;
+	}
+}
+
+static void fy_emit_accum_pool_remove(struct fy_emit_accum_pool *pool, unsigned int idx)
+{
+	pool->stats.pooled_size -= pool->stores[idx].size;
+	memmove(&pool->stores[idx], &pool->stores[idx + 1],
+		(pool->count - idx - 1) * sizeof(pool->stores[0]));
+	pool->count--;
+}
+
+void *fy_emit_accum_pool_get(size_t *sizep)
+{
+	struct fy_emit_accum_pool *pool = &fy_emit_accum_pool;
+	unsigned int i;
+	void *buf;
+
+	for (i = 0; i < pool->count && pool->stores[i].size < *sizep; i++)
+		;
+	if (i >= pool->count) {
+		pool->stats.pool_misses++;
+		pool->stats.grows++;
+		buf = NULL;
+	} else {
+		buf = pool->stores[i].buf;
+		*sizep = pool->stores[i].size;
+		fy_emit_accum_pool_remove(pool, i);
+		pool->stats.pool_hits++;
+	}
+
+	/* the size of the store that's actually in use */
+	if (*sizep > pool->high_water)
+		pool->high_water = *sizep;
+
+	return buf;
+}
+
+bool fy_emit_accum_pool_put(void *buf, size_t size)
+{
+	struct fy_emit_accum_pool *pool = &fy_emit_accum_pool;
+	unsigned int i;
+
+	if (size > FY_EMIT_ACCUM_POOL_MAX_SIZE)
+		goto out_trim;
+
+	/* the pooled stores are freed on thread exit */
+	if (!pool->registered) {
+		pthread_once(&fy_emit_accum_pool_once, fy_emit_accum_pool_key_create);
+		if (!fy_emit_accum_pool_key_ok ||
+		    pthread_setspecific(fy_emit_accum_pool_key, pool))
+			return false;
+		pool->registered = true;
+	}
+
+	if (pool->count >= FY_EMIT_ACCUM_POOL_MAX_COUNT) {
+		if (size <= pool->stores[0].size)
+			goto out_trim;
+		free(pool->stores[0].buf);
+		fy_emit_accum_pool_remove(pool, 0);
+		pool->stats.trims++;
+	}
+
+	for (i = pool->count; i > 0 && pool->stores[i - 1].size > size; i--)
+		pool->stores[i] = pool->stores[i - 1];
+	pool->stores[i].buf = buf;
+	pool->stores[i].size = size;
+	pool->count++;
+	pool->stats.pooled_size += size;
+
+	return true;
+
+out_trim:
+	pool->stats.trims++;
+	return false;
+}
+
+void fy_emit_accum_pool_trim(void)
+{
+	struct fy_emit_accum_pool *pool = &fy_emit_accum_pool;
+
+	while (pool->count > 0 &&
+	       pool->stores[pool->count - 1].size > FY_EMIT_ACCUM_POOL_TRIM_MIN &&
+	       pool->stores[pool->count - 1].size > pool->high_water) {
+		free(pool->stores[pool->count - 1].buf);
+		fy_emit_accum_pool_remove(pool, pool->count - 1);
+		pool->stats.trims++;
+	}
+	pool->high_water /= 2;
+}
+
+void fy_emit_accum_pool_note_grow(size_t size)
+{
+	struct fy_emit_accum_pool *pool = &fy_emit_accum_pool;
+
+	if (size > pool->high_water)
+		pool->high_water = size;
+	pool->stats.grows++;
+}
+
+void fy_emit_accum_get_stats(struct fy_emit_accum_stats *stats)
+{
+	struct fy_emit_accum_pool *pool = &fy_emit_accum_pool;
+
+	*stats = pool->stats;
+	stats->pooled = pool->count;
+}
+
 int fy_emit_setup(struct fy_emitter *emit, const struct fy_emitter_cfg *cfg)
 {
 	struct fy_diag *diag;
@@ -2047,6 +3056,12 @@ int fy_emit_setup(struct fy_emitter *emit, const struct fy_emitter_cfg *cfg)
 
 	emit->diag = diag;
 
+	if ((emit->cfg.flags & FYECF_OUTPUT_BUFFERED) &&
+	    fy_emitter_set_output_buffer(emit, FY_EMIT_OUTPUT_BUFFER_DEFAULT, false)) {
+		fy_diag_unref(diag);
+		return -1;
+	}
+
 	fy_emit_accum_init(&emit->ea, emit->ea_inplace_buf, sizeof(emit->ea_inplace_buf), 0, fylb_cr_nl);
 	fy_eventp_list_init(&emit->queued_events);
 
@@ -2089,6 +3104,20 @@ void fy_emit_cleanup(struct fy_emitter *emit)
 	struct fy_eventp *fyep;
 	struct fy_token *fyt;
 
+	/* whatever is left in the output buffer goes out before the finalizer */
+	if (emit->obuf) {
+		fy_emit_output_flush(emit);
+		free(emit->obuf);
+	}
+	if (emit->oruns)
+		free(emit->oruns);
+	if (emit->oiov)
+		free(emit->oiov);
+
+	/* destroy the thread pool if we're the ones created it */
+	if (emit->tp && emit->tp_owned)
+		fy_thread_pool_destroy(emit->tp);
+
 	/* call the finalizer if it exists */
 	if (emit->finalizer)
 		emit->finalizer(emit);
@@ -2103,10 +3132,13 @@ void fy_emit_cleanup(struct fy_emitter *emit)
 	while ((fyep = fy_eventp_list_pop(&emit->recycled_eventp)) != NULL)
 		fy_eventp_free(fyep);
 
+	fy_emit_raw_destroy(emit);
+
 	if (!emit->fyd && emit->fyds)
 		fy_document_state_unref(emit->fyds);
 
 	fy_emit_accum_cleanup(&emit->ea);
+	fy_emit_accum_pool_trim();
 
 	while ((fyep = fy_eventp_list_pop(&emit->queued_events)) != NULL)
 		fy_eventp_release(fyep);
@@ -2294,6 +3326,118 @@ void fy_emitter_set_finalizer(struct fy_emitter *emit,
 	emit->finalizer = finalizer;
 }
 
+int fy_emitter_set_output_buffer(struct fy_emitter *emit, size_t size, bool track_types)
+{
+	char *obuf;
+
+	if (!emit || size > INT_MAX)
+		return -1;
+
+	/* flush whatever is pending using the old buffer */
+	if (emit->obuf)
+		fy_emit_output_flush(emit);
+
+	if (!size) {
+		if (emit->obuf)
+			free(emit->obuf);
+		if (emit->oiov)
+			free(emit->oiov);
+		emit->oiov = NULL;
+		emit->oiov_alloc = 0;
+		emit->obuf = NULL;
+		emit->obuf_size = 0;
+		emit->obuf_track_types = false;
+		return 0;
+	}
+
+	if (size != emit->obuf_size) {
+		obuf = realloc(emit->obuf, size);
+		if (!obuf)
+			return -1;
+		emit->obuf = obuf;
+		emit->obuf_size = size;
+	}
+	emit->obuf_track_types = track_types;
+
+	return 0;
+}
+
+int fy_emitter_flush(struct fy_emitter *emit)
+{
+	if (!emit)
+		return -1;
+
+	if (emit->obuf)
+		fy_emit_output_flush(emit);
+
+	return emit->output_error ? -1 : 0;
+}
+
+const struct fy_emitter_write_run *
+fy_emitter_get_write_runs(struct fy_emitter *emit, unsigned int *countp)
+{
+	if (!emit || !countp)
+		return NULL;
+
+	if (!emit->obuf_track_types || !emit->oruns_count) {
+		*countp = 0;
+		return NULL;
+	}
+
+	*countp = emit->oruns_count;
+	return emit->oruns;
+}
+
+int fy_emitter_set_parallel(struct fy_emitter *emit, struct fy_thread_pool *tp,
+			    size_t min_items)
+{
+	struct fy_thread_pool_cfg tp_cfg;
+
+	if (!emit)
+		return -1;
+
+	/* a private pool is reused when asked for again */
+	if (!tp && emit->tp_owned)
+		tp = emit->tp;
+
+	if (emit->tp && (!min_items || tp != emit->tp)) {
+		if (emit->tp_owned)
+			fy_thread_pool_destroy(emit->tp);
+		emit->tp = NULL;
+		emit->tp_owned = false;
+	}
+	emit->parallel_min = 0;
+
+	if (!min_items)
+		return 0;
+
+	if (!tp) {
+		memset(&tp_cfg, 0, sizeof(tp_cfg));
+		tp_cfg.flags = FYTPCF_STEAL_MODE;
+		tp_cfg.num_threads = 0;	/* number of online CPUs */
+		tp = fy_thread_pool_create(&tp_cfg);
+		if (!tp)
+			return -1;
+		emit->tp_owned = true;
+	}
+	emit->tp = tp;
+	emit->parallel_min = min_items;
+
+	return 0;
+}
+
+int fy_emitter_set_canonical(struct fy_emitter *emit, bool canonical)
+{
+	if (!emit)
+		return -1;
+
+	emit->canonical = canonical;
+	if (canonical)
+		emit->cfg.flags |= FYECF_SORT_KEYS;
+
+	return 0;
+}
+
 struct fy_emit_buffer_state {
 	char **bufp;
 	size_t *sizep;
@@ -2323,8 +3467,12 @@ static int do_buffer_output(struct fy_emitter *emit, enum fy_emitter_write_type
 		if (!state->allocate_buffer)
 			return 0;
 
+		/* grow geometrically, so that large outputs are not copied over and over */
+		size = state->size * 2;
+		if (size < state->need)
+			size = state->need;
 		pagesize = sysconf(_SC_PAGESIZE);
-		size = state->need + pagesize - 1;
+		size = size + pagesize - 1;
 		size = size - size % pagesize;
 
 		bufnew = realloc(state->buf, size);
@@ -2427,6 +3575,10 @@ fy_emitter_collect_str_internal(struct fy_emitter *emit, char **bufp, size_t *si
 	if (!sizep)
 		sizep = state->sizep;
 
+	/* pending buffered output goes before the terminating zero */
+	if (emit->obuf)
+		fy_emit_output_flush(emit);
+
 	/* terminating zero */
 	rc = do_buffer_output(emit, fyewt_terminating_zero, "\0", 1, state);
 	if (rc != 1)
@@ -2500,77 +3652,349 @@ out_err:
 	return rc;
 }
 
-int fy_emit_document_to_buffer(struct fy_document *fyd, enum fy_emitter_cfg_flags flags, char *buf, size_t size)
+int fy_emit_document_to_buffer(struct fy_document *fyd, enum fy_emitter_cfg_flags flags, char *buf, size_t size)
+{
+	int rc;
+
+	rc = fy_emit_str_internal(fyd, flags, NULL, &buf, &size, false);
+	if (rc != 0)
+		return -1;
+	return size;
+}
+
+char *fy_emit_document_to_string(struct fy_document *fyd, enum fy_emitter_cfg_flags flags)
+{
+	char *buf;
+	size_t size;
+	int rc;
+
+	buf = NULL;
+	size = 0;
+	rc = fy_emit_str_internal(fyd, flags, NULL, &buf, &size, true);
+	if (rc != 0)
+		return NULL;
+	return buf;
+}
+
+struct fy_emitter *
+fy_emit_to_buffer(enum fy_emitter_cfg_flags flags, char *buf, size_t size)
+{
+	if (!buf)
+		return NULL;
+
+	return fy_emitter_create_str_internal(flags, &buf, &size, false);
+}
+
+char *
+fy_emit_to_buffer_collect(struct fy_emitter *emit, size_t *sizep)
+{
+	int rc;
+	char *buf;
+
+	if (!emit || !sizep)
+		return NULL;
+
+	rc = fy_emitter_collect_str_internal(emit, &buf, sizep);
+	if (rc) {
+		*sizep = 0;
+		return NULL;
+	}
+	return buf;
+}
+
+struct fy_emitter *
+fy_emit_to_string(enum fy_emitter_cfg_flags flags)
+{
+	return fy_emitter_create_str_internal(flags, NULL, NULL, true);
+}
+
+char *
+fy_emit_to_string_collect(struct fy_emitter *emit, size_t *sizep)
+{
+	int rc;
+	char *buf;
+
+	if (!emit || !sizep)
+		return NULL;
+
+	rc = fy_emitter_collect_str_internal(emit, &buf, sizep);
+	if (rc) {
+		*sizep = 0;
+		return NULL;
+	}
+	return buf;
+}
+
+/*
+ * Rope output; the output is kept in a list of fixed size segments so
+ * that it never has to be copied (or be held twice) while growing.
+ * In contiguous mode a single segment is grown instead, in place with
+ * mremap() where available.
+ */
+struct fy_emit_rope_segment {
+	struct fy_emit_rope_segment *next;
+	size_t size;
+	size_t len;
+	char data[];
+};
+
+struct fy_emit_rope_state {
+	enum fy_emit_rope_flags flags;
+	struct fy_emit_rope_segment *head;
+	struct fy_emit_rope_segment *tail;
+	size_t total;
+	/* contiguous mode */
+	char *buf;
+	size_t size;
+	bool mapped;
+};
+
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+#define FY_EMIT_ROPE_HAVE_MREMAP
+#endif
+
+static int fy_emit_rope_grow_contiguous(struct fy_emit_rope_state *state, size_t need)
+{
+	size_t size;
+	char *buf;
+
+	size = state->size ? state->size : FY_EMIT_ROPE_SEGMENT_SIZE;
+	while (size < need)
+		size *= 2;
+
+#ifdef FY_EMIT_ROPE_HAVE_MREMAP
+	if (!state->buf)
+		buf = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	else
+		buf = mremap(state->buf, state->size, size, MREMAP_MAYMOVE);
+	if (buf == MAP_FAILED)
+		return -1;
+	state->mapped = true;
+#else
+	buf = realloc(state->buf, size);
+	if (!buf)
+		return -1;
+#endif
+	state->buf = buf;
+	state->size = size;
+
+	return 0;
+}
+
+static int do_rope_output(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int leni, void *userdata)
+{
+	struct fy_emit_rope_state *state = userdata;
+	struct fy_emit_rope_segment *seg;
+	size_t len, left, chunk;
+
+	len = (size_t)leni;
+
+	if (state->flags & FYERF_CONTIGUOUS) {
+		if (state->total + len > state->size &&
+		    fy_emit_rope_grow_contiguous(state, state->total + len))
+			return -1;
+		memcpy(state->buf + state->total, str, len);
+		state->total += len;
+		return leni;
+	}
+
+	for (left = len; left > 0; left -= chunk, str += chunk) {
+		seg = state->tail;
+		if (!seg || seg->len >= seg->size) {
+			seg = malloc(sizeof(*seg) + FY_EMIT_ROPE_SEGMENT_SIZE);
+			if (!seg)
+				return -1;
+			seg->next = NULL;
+			seg->size = FY_EMIT_ROPE_SEGMENT_SIZE;
+			seg->len = 0;
+			if (state->tail)
+				state->tail->next = seg;
+			else
+				state->head = seg;
+			state->tail = seg;
+		}
+		chunk = seg->size - seg->len;
+		if (chunk > left)
+			chunk = left;
+		memcpy(seg->data + seg->len, str, chunk);
+		seg->len += chunk;
+	}
+	state->total += len;
+
+	return leni;
+}
+
+static void
+fy_emitter_rope_finalizer(struct fy_emitter *emit)
+{
+	struct fy_emit_rope_state *state;
+	struct fy_emit_rope_segment *seg;
+
+	if (!emit || !(state = emit->cfg.userdata))
+		return;
+
+	while ((seg = state->head) != NULL) {
+		state->head = seg->next;
+		free(seg);
+	}
+#ifdef FY_EMIT_ROPE_HAVE_MREMAP
+	if (state->buf && state->mapped)
+		munmap(state->buf, state->size);
+#else
+	if (state->buf)
+		free(state->buf);
+#endif
+	free(state);
+
+	emit->cfg.userdata = NULL;
+}
+
+struct fy_emitter *
+fy_emit_to_rope(enum fy_emitter_cfg_flags flags, enum fy_emit_rope_flags rope_flags)
+{
+	struct fy_emitter *emit;
+	struct fy_emitter_cfg emit_cfg;
+	struct fy_emit_rope_state *state;
+
+	state = malloc(sizeof(*state));
+	if (!state)
+		return NULL;
+	memset(state, 0, sizeof(*state));
+	state->flags = rope_flags;
+
+	memset(&emit_cfg, 0, sizeof(emit_cfg));
+	emit_cfg.output = do_rope_output;
+	emit_cfg.userdata = state;
+	emit_cfg.flags = flags;
+
+	emit = fy_emitter_create(&emit_cfg);
+	if (!emit)
+		goto err_out;
+
+	/* set finalizer to cleanup */
+	fy_emitter_set_finalizer(emit, fy_emitter_rope_finalizer);
+
+	return emit;
+
+err_out:
+	free(state);
+	return NULL;
+}
+
+static struct fy_emit_rope_state *
+fy_emit_rope_state(struct fy_emitter *emit)
 {
-	int rc;
+	if (!emit || emit->cfg.output != do_rope_output)
+		return NULL;
 
-	rc = fy_emit_str_internal(fyd, flags, NULL, &buf, &size, false);
-	if (rc != 0)
-		return -1;
-	return size;
+	/* pending buffered output goes to the rope first */
+	if (emit->obuf)
+		fy_emit_output_flush(emit);
+
+	return emit->cfg.userdata;
 }
 
-char *fy_emit_document_to_string(struct fy_document *fyd, enum fy_emitter_cfg_flags flags)
+const char *
+fy_emit_rope_iterate(struct fy_emitter *emit, void **prevp, size_t *lenp)
 {
-	char *buf;
-	size_t size;
-	int rc;
+	struct fy_emit_rope_state *state;
+	struct fy_emit_rope_segment *seg;
 
-	buf = NULL;
-	size = 0;
-	rc = fy_emit_str_internal(fyd, flags, NULL, &buf, &size, true);
-	if (rc != 0)
+	if (!prevp || !lenp || !(state = fy_emit_rope_state(emit)))
 		return NULL;
-	return buf;
+
+	if (state->flags & FYERF_CONTIGUOUS) {
+		if (*prevp || !state->total)
+			return NULL;
+		*prevp = state->buf;
+		*lenp = state->total;
+		return state->buf;
+	}
+
+	seg = *prevp ? ((struct fy_emit_rope_segment *)*prevp)->next : state->head;
+	if (!seg)
+		return NULL;
+	*prevp = seg;
+	*lenp = seg->len;
+	return seg->data;
 }
 
-struct fy_emitter *
-fy_emit_to_buffer(enum fy_emitter_cfg_flags flags, char *buf, size_t size)
+size_t
+fy_emit_rope_size(struct fy_emitter *emit)
 {
-	if (!buf)
-		return NULL;
+	struct fy_emit_rope_state *state;
 
-	return fy_emitter_create_str_internal(flags, &buf, &size, false);
+	state = fy_emit_rope_state(emit);
+	return state ? state->total : 0;
 }
 
-char *
-fy_emit_to_buffer_collect(struct fy_emitter *emit, size_t *sizep)
+int
+fy_emit_rope_write(struct fy_emitter *emit, int fd)
 {
-	int rc;
-	char *buf;
+	struct iovec iov[FY_EMIT_GATHER_IOV], *iovp, *iove;
+	const char *data;
+	void *iter;
+	size_t len;
+	ssize_t wrn;
+	int cnt;
 
-	if (!emit || !sizep)
-		return NULL;
+	if (!fy_emit_rope_state(emit) || fd < 0)
+		return -1;
 
-	rc = fy_emitter_collect_str_internal(emit, &buf, sizep);
-	if (rc) {
-		*sizep = 0;
-		return NULL;
+	iter = NULL;
+	data = fy_emit_rope_iterate(emit, &iter, &len);
+	while (data) {
+		/* gather the next batch of segments */
+		for (cnt = 0; data && cnt < FY_EMIT_GATHER_IOV; cnt++) {
+			iov[cnt].iov_base = (void *)data;
+			iov[cnt].iov_len = len;
+			data = fy_emit_rope_iterate(emit, &iter, &len);
+		}
+
+		iovp = iov;
+		iove = iov + cnt;
+		while (iovp < iove) {
+			do {
+				wrn = writev(fd, iovp, (int)(iove - iovp) > IOV_MAX ? IOV_MAX : (int)(iove - iovp));
+			} while (wrn == -1 && (errno == EAGAIN || errno == EINTR));
+
+			if (wrn <= 0)
+				return -1;
+
+			/* skip over what was written, a partial write updates the iov in place */
+			while (iovp < iove && (size_t)wrn >= iovp->iov_len) {
+				wrn -= iovp->iov_len;
+				iovp++;
+			}
+			if (wrn > 0) {
+				iovp->iov_base = (char *)iovp->iov_base + wrn;
+				iovp->iov_len -= wrn;
+			}
+		}
 	}
-	return buf;
-}
 
-struct fy_emitter *
-fy_emit_to_string(enum fy_emitter_cfg_flags flags)
-{
-	return fy_emitter_create_str_internal(flags, NULL, NULL, true);
+	return 0;
 }
 
-char *
-fy_emit_to_string_collect(struct fy_emitter *emit, size_t *sizep)
+/* emit straight to fd, gathering source scalars and buffered output for writev */
+static int fy_emit_setup_gather(struct fy_emitter *emit, int fd)
 {
 	int rc;
-	char *buf;
 
-	if (!emit || !sizep)
-		return NULL;
+	rc = fy_emitter_set_output_buffer(emit, FY_EMIT_OUTPUT_BUFFER_DEFAULT, false);
+	if (rc)
+		return rc;
 
-	rc = fy_emitter_collect_str_internal(emit, &buf, sizep);
-	if (rc) {
-		*sizep = 0;
-		return NULL;
-	}
-	return buf;
+	/* one extra slot for closing the pending buffer segment on flush */
+	emit->oiov = malloc(sizeof(*emit->oiov) * (FY_EMIT_GATHER_IOV + 1));
+	if (!emit->oiov)
+		return -1;
+	emit->oiov_alloc = FY_EMIT_GATHER_IOV;
+	emit->oiov_count = 0;
+	emit->obuf_seg = 0;
+	emit->ofd = fd;
+
+	return 0;
 }
 
 static int do_file_output(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int leni, void *userdata)
@@ -2592,7 +4016,7 @@ int fy_emit_document_to_fp(struct fy_document *fyd, enum fy_emitter_cfg_flags fl
 {
 	struct fy_emitter emit_state, *emit = &emit_state;
 	struct fy_emitter_cfg emit_cfg;
-	int rc;
+	int fd, rc;
 
 	if (!fp)
 		return -1;
@@ -2603,6 +4027,11 @@ int fy_emit_document_to_fp(struct fy_document *fyd, enum fy_emitter_cfg_flags fl
 	emit_cfg.flags = flags;
 	fy_emit_setup(emit, &emit_cfg);
 
+	/* for a real file go straight to the fd, anything stdio buffered goes first */
+	fd = fileno(fp);
+	if (fd >= 0 && !fflush(fp))
+		fy_emit_setup_gather(emit, fd);
+
 	fy_emit_prepare_document_state(emit, fyd->fyds);
 
 	rc = 0;
@@ -2690,6 +4119,8 @@ int fy_emit_document_to_fd(struct fy_document *fyd, enum fy_emitter_cfg_flags fl
 	emit_cfg.flags = flags;
 	fy_emit_setup(emit, &emit_cfg);
 
+	fy_emit_setup_gather(emit, fd);
+
 	fy_emit_prepare_document_state(emit, fyd->fyds);
 
 	rc = 0;
@@ -2808,6 +4239,10 @@ bool fy_emit_streaming_sequence_empty(struct fy_emitter *emit)
 {
 	struct fy_eventp *fyepn;
 
+	/* direct interface, the next item is known */
+	if (emit->raw && emit->raw->next != FYET_NONE)
+		return emit->raw->next == FYET_SEQUENCE_END;
+
 	fyepn = fy_emit_peek_next_event(emit);
 
 	/* should never happen, check on debugging mode */
@@ -2822,6 +4257,10 @@ bool fy_emit_streaming_mapping_empty(struct fy_emitter *emit)
 {
 	struct fy_eventp *fyepn;
 
+	/* direct interface, the next item is known */
+	if (emit->raw && emit->raw->next != FYET_NONE)
+		return emit->raw->next == FYET_MAPPING_END;
+
 	fyepn = fy_emit_peek_next_event(emit);
 
 	/* should never happen, check on debugging mode */
@@ -3340,6 +4779,61 @@ static int fy_emit_handle_mapping_value(struct fy_emitter *emit, struct fy_parse
 	return ret;
 }
 
+static int fy_emit_handle_event(struct fy_emitter *emit, struct fy_parser *fyp, struct fy_eventp *fyep)
+{
+	int ret;
+
+	switch (emit->state) {
+	case FYES_STREAM_START:
+		ret = fy_emit_handle_stream_start(emit, fyp, fyep);
+		break;
+
+	case FYES_FIRST_DOCUMENT_START:
+	case FYES_DOCUMENT_START:
+		ret = fy_emit_handle_document_start(emit, fyp, fyep,
+				emit->state == FYES_FIRST_DOCUMENT_START);
+		break;
+
+	case FYES_DOCUMENT_CONTENT:
+		ret = fy_emit_handle_document_content(emit, fyp, fyep);
+		break;
+
+	case FYES_DOCUMENT_END:
+		ret = fy_emit_handle_document_end(emit, fyp, fyep);
+		break;
+
+	case FYES_SEQUENCE_FIRST_ITEM:
+	case FYES_SEQUENCE_ITEM:
+		ret = fy_emit_handle_sequence_item(emit, fyp, fyep,
+				emit->state == FYES_SEQUENCE_FIRST_ITEM);
+		break;
+
+	case FYES_MAPPING_FIRST_KEY:
+	case FYES_MAPPING_KEY:
+		ret = fy_emit_handle_mapping_key(emit, fyp, fyep,
+				emit->state == FYES_MAPPING_FIRST_KEY);
+		break;
+
+	case FYES_MAPPING_SIMPLE_VALUE:
+	case FYES_MAPPING_VALUE:
+		ret = fy_emit_handle_mapping_value(emit, fyp, fyep,
+				emit->state == FYES_MAPPING_SIMPLE_VALUE);
+		break;
+
+	case FYES_END:
+		ret = -1;
+		break;
+
+	default:
+		assert(1);      /* Invalid state. */
+		ret = 0;
+		break;
+	}
+
+	return ret;
+}
+
+
 int fy_emit_event_from_parser(struct fy_emitter *emit, struct fy_parser *fyp, struct fy_event *fye)
 {
 	struct fy_eventp *fyep;
@@ -3354,55 +4848,24 @@ int fy_emit_event_from_parser(struct fy_emitter *emit, struct fy_parser *fyp, st
 
 	fyep = container_of(fye, struct fy_eventp, e);
 
+	/* a collection start of the direct interface is still pending */
+	if (emit->raw && emit->raw->pending != FYET_NONE) {
+		ret = fy_emit_raw_flush(emit, fye->type);
+		if (ret) {
+			if (!fyp)
+				fy_eventp_release(fyep);
+			else
+				fy_parse_eventp_recycle(fyp, fyep);
+			return ret;
+		}
+	}
+
 	fy_eventp_list_add_tail(&emit->queued_events, fyep);
 
 	ret = 0;
 	while ((fyep = fy_emit_next_event(emit)) != NULL) {
 
-		switch (emit->state) {
-		case FYES_STREAM_START:
-			ret = fy_emit_handle_stream_start(emit, fyp, fyep);
-			break;
-
-		case FYES_FIRST_DOCUMENT_START:
-		case FYES_DOCUMENT_START:
-			ret = fy_emit_handle_document_start(emit, fyp, fyep,
-					emit->state == FYES_FIRST_DOCUMENT_START);
-			break;
-
-		case FYES_DOCUMENT_CONTENT:
-			ret = fy_emit_handle_document_content(emit, fyp, fyep);
-			break;
-
-		case FYES_DOCUMENT_END:
-			ret = fy_emit_handle_document_end(emit, fyp, fyep);
-			break;
-
-		case FYES_SEQUENCE_FIRST_ITEM:
-		case FYES_SEQUENCE_ITEM:
-			ret = fy_emit_handle_sequence_item(emit, fyp, fyep,
-					emit->state == FYES_SEQUENCE_FIRST_ITEM);
-			break;
-
-		case FYES_MAPPING_FIRST_KEY:
-		case FYES_MAPPING_KEY:
-			ret = fy_emit_handle_mapping_key(emit, fyp, fyep,
-					emit->state == FYES_MAPPING_FIRST_KEY);
-			break;
-
-		case FYES_MAPPING_SIMPLE_VALUE:
-		case FYES_MAPPING_VALUE:
-			ret = fy_emit_handle_mapping_value(emit, fyp, fyep,
-					emit->state == FYES_MAPPING_SIMPLE_VALUE);
-			break;
-
-		case FYES_END:
-			ret = -1;
-			break;
-
-		default:
-			assert(1);      /* Invalid state. */
-		}
+		ret = fy_emit_handle_event(emit, fyp, fyep);
 
 		/* always release the event */
 		if (!fyp)
@@ -3422,6 +4885,277 @@ int fy_emit_event(struct fy_emitter *emit, struct fy_event *fye)
 	return fy_emit_event_from_parser(emit, NULL, fye);
 }
 
+/*
+ * Direct interface.
+ *
+ * The streaming state machine is driven with transient events on the
+ * stack, using tokens (and an input for the scalar content) embedded in
+ * the emitter, so nothing is allocated (or queued) per call. The only
+ * lookahead that is required, whether a collection is empty, is handled
+ * by holding back a collection start until the next call.
+ *
+ * The embedded tokens keep a reference for the emitter, so the
+ * references the state machine holds never free them.
+ */
+static void fy_emit_raw_token_init(struct fy_token *fyt, enum fy_token_type type)
+{
+	memset(fyt, 0, sizeof(*fyt));
+	fyt->type = type;
+	fyt->refs = 1;
+	fy_atom_reset(&fyt->handle);
+}
+
+static void fy_emit_raw_token_reset(struct fy_token *fyt)
+{
+	if (fyt->text0) {
+		free(fyt->text0);
+		fyt->text0 = NULL;
+	}
+	fyt->analyze_flags = 0;
+	fyt->text_len = 0;
+	fyt->text = NULL;
+}
+
+static struct fy_emit_raw *fy_emit_raw_get(struct fy_emitter *emit)
+{
+	struct fy_emit_raw *raw;
+
+	if (emit->raw)
+		return emit->raw;
+
+	raw = malloc(sizeof(*raw));
+	if (!raw)
+		return NULL;
+	memset(raw, 0, sizeof(*raw));
+
+	raw->pending = FYET_NONE;
+	raw->next = FYET_NONE;
+	fy_emit_raw_token_init(&raw->scalar, FYTT_SCALAR);
+	fy_emit_raw_token_init(&raw->alias, FYTT_ALIAS);
+	fy_emit_raw_token_init(&raw->seq_start[0], FYTT_BLOCK_SEQUENCE_START);
+	fy_emit_raw_token_init(&raw->seq_start[1], FYTT_FLOW_SEQUENCE_START);
+	fy_emit_raw_token_init(&raw->map_start[0], FYTT_BLOCK_MAPPING_START);
+	fy_emit_raw_token_init(&raw->map_start[1], FYTT_FLOW_MAPPING_START);
+
+	emit->raw = raw;
+
+	return raw;
+}
+
+static void fy_emit_raw_destroy(struct fy_emitter *emit)
+{
+	struct fy_emit_raw *raw = emit->raw;
+
+	if (!raw)
+		return;
+
+	fy_emit_raw_token_reset(&raw->scalar);
+	fy_emit_raw_token_reset(&raw->alias);
+	free(raw);
+	emit->raw = NULL;
+}
+
+static int fy_emit_raw_dispatch(struct fy_emitter *emit, struct fy_eventp *fyep,
+				struct fy_token **fytp)
+{
+	int ret;
+
+	if (emit->state == FYES_NONE)
+		emit->state = FYES_STREAM_START;
+
+	/* the reference handed over with the event */
+	if (fytp && *fytp)
+		fy_token_ref(*fytp);
+
+	ret = fy_emit_handle_event(emit, NULL, fyep);
+
+	/* not taken over by the state machine */
+	if (fytp && *fytp)
+		fy_emit_token_unref(emit, NULL, *fytp);
+
+	return ret;
+}
+
+static int fy_emit_raw_flush(struct fy_emitter *emit, enum fy_event_type next)
+{
+	struct fy_emit_raw *raw = emit->raw;
+	struct fy_eventp fyep_local, *fyep = &fyep_local;
+	struct fy_event *fye = &fyep->e;
+	struct fy_token *fyt;
+	int idx, ret;
+
+	if (!raw || raw->pending == FYET_NONE)
+		return 0;
+
+	memset(fyep, 0, sizeof(*fyep));
+	fye->type = raw->pending;
+
+	idx = raw->pending_style == FYNS_FLOW ? 1 : 0;
+	if (raw->pending == FYET_SEQUENCE_START)
+		fyt = &raw->seq_start[idx];
+	else
+		fyt = &raw->map_start[idx];
+	if (raw->pending_style == FYNS_ANY)
+		fyt = NULL;
+
+	raw->pending = FYET_NONE;
+	raw->next = next;
+
+	if (fye->type == FYET_SEQUENCE_START) {
+		fye->sequence_start.sequence_start = fyt;
+		ret = fy_emit_raw_dispatch(emit, fyep, &fye->sequence_start.sequence_start);
+	} else {
+		fye->mapping_start.mapping_start = fyt;
+		ret = fy_emit_raw_dispatch(emit, fyep, &fye->mapping_start.mapping_start);
+	}
+
+	raw->next = FYET_NONE;
+
+	return ret;
+}
+
+/* the direct interface can not run ahead of queued events */
+static bool fy_emit_raw_usable(struct fy_emitter *emit)
+{
+	return fy_eventp_list_empty(&emit->queued_events) && fy_emit_raw_get(emit);
+}
+
+static int fy_emit_raw_scalar_or_alias(struct fy_emitter *emit, enum fy_event_type type,
+				       enum fy_scalar_style style, const char *value, size_t len)
+{
+	struct fy_emit_raw *raw;
+	struct fy_eventp fyep_local, *fyep = &fyep_local;
+	struct fy_event *fye = &fyep->e;
+	struct fy_token *fyt;
+	int ret;
+
+	if (!emit)
+		return -1;
+
+	if (!value && (len || type == FYET_ALIAS)) {
+		fy_error(emit->diag, "NULL value, illegal %s\n",
+				type == FYET_SCALAR ? "SCALAR" : "ALIAS");
+		return -1;
+	}
+	if (!value)
+		value = "";
+	if (len == FY_NT)
+		len = strlen(value);
+
+	if (!fy_emit_raw_usable(emit)) {
+		if (type == FYET_SCALAR)
+			return fy_emit_eventf(emit, FYET_SCALAR, style, value, len, NULL, NULL);
+		return fy_emit_eventf(emit, FYET_ALIAS, value);
+	}
+	raw = emit->raw;
+
+	ret = fy_emit_raw_flush(emit, type);
+	if (ret)
+		return ret;
+
+	fyt = type == FYET_SCALAR ? &raw->scalar : &raw->alias;
+
+	/* drop whatever was generated for the previous content */
+	fy_emit_raw_token_reset(fyt);
+	fy_input_init_from_data(&raw->input, value, len, &fyt->handle);
+
+	memset(fyep, 0, sizeof(*fyep));
+	fye->type = type;
+	if (type == FYET_SCALAR) {
+		fyt->scalar.style = style;
+		fye->scalar.value = fyt;
+		return fy_emit_raw_dispatch(emit, fyep, &fye->scalar.value);
+	}
+
+	fye->alias.anchor = fyt;
+	return fy_emit_raw_dispatch(emit, fyep, &fye->alias.anchor);
+}
+
+int fy_emit_scalar_raw(struct fy_emitter *emit, enum fy_scalar_style style,
+		       const char *value, size_t len)
+{
+	if (style != FYSS_ANY && (unsigned int)style >= FYSS_MAX)
+		return -1;
+
+	return fy_emit_raw_scalar_or_alias(emit, FYET_SCALAR, style, value, len);
+}
+
+int fy_emit_alias_raw(struct fy_emitter *emit, const char *alias)
+{
+	return fy_emit_raw_scalar_or_alias(emit, FYET_ALIAS, FYSS_PLAIN, alias, FY_NT);
+}
+
+static int fy_emit_raw_collection_start(struct fy_emitter *emit, enum fy_event_type type,
+					enum fy_node_style style)
+{
+	struct fy_emit_raw *raw;
+	int ret;
+
+	if (!emit)
+		return -1;
+
+	if (style != FYNS_ANY && style != FYNS_FLOW && style != FYNS_BLOCK) {
+		fy_error(emit->diag, "illegal style for %s_START\n",
+				type == FYET_MAPPING_START ? "MAPPING" : "SEQUENCE");
+		return -1;
+	}
+
+	if (!fy_emit_raw_usable(emit))
+		return fy_emit_eventf(emit, type, style, NULL, NULL);
+	raw = emit->raw;
+
+	ret = fy_emit_raw_flush(emit, type);
+	if (ret)
+		return ret;
+
+	/* held back until we know whether it's empty */
+	raw->pending = type;
+	raw->pending_style = style;
+
+	return 0;
+}
+
+static int fy_emit_raw_collection_end(struct fy_emitter *emit, enum fy_event_type type)
+{
+	struct fy_eventp fyep_local, *fyep = &fyep_local;
+	int ret;
+
+	if (!emit)
+		return -1;
+
+	if (!fy_emit_raw_usable(emit))
+		return fy_emit_eventf(emit, type);
+
+	ret = fy_emit_raw_flush(emit, type);
+	if (ret)
+		return ret;
+
+	memset(fyep, 0, sizeof(*fyep));
+	fyep->e.type = type;
+
+	return fy_emit_raw_dispatch(emit, fyep, NULL);
+}
+
+int fy_emit_sequence_start_raw(struct fy_emitter *emit, enum fy_node_style style)
+{
+	return fy_emit_raw_collection_start(emit, FYET_SEQUENCE_START, style);
+}
+
+int fy_emit_sequence_end_raw(struct fy_emitter *emit)
+{
+	return fy_emit_raw_collection_end(emit, FYET_SEQUENCE_END);
+}
+
+int fy_emit_mapping_start_raw(struct fy_emitter *emit, enum fy_node_style style)
+{
+	return fy_emit_raw_collection_start(emit, FYET_MAPPING_START, style);
+}
+
+int fy_emit_mapping_end_raw(struct fy_emitter *emit)
+{
+	return fy_emit_raw_collection_end(emit, FYET_MAPPING_END);
+}
+
 struct fy_document_state *
 fy_emitter_get_document_state(struct fy_emitter *emit)
 {
@@ -32,6 +32,7 @@
 struct fy_document;
 struct fy_emitter;
 struct fy_document_state;
+struct fy_emit_raw;
 
 enum fy_emitter_state {
 	FYES_NONE,		/* when not using the raw emitter interface */
@@ -63,6 +64,21 @@ struct fy_emit_save_ctx {
 	int s_indent;
 };
 
+/* output buffer size used for FYECF_OUTPUT_BUFFERED */
+#define FY_EMIT_OUTPUT_BUFFER_DEFAULT	(64 * 1024)
+
+/* gathered (writev) output; shorter direct writes are simply copied */
+#define FY_EMIT_GATHER_IOV		256
+#define FY_EMIT_GATHER_MIN		32
+
+/* size of each rope output segment */
+#define FY_EMIT_ROPE_SEGMENT_SIZE	(64 * 1024)
+
+/* minimum number of collection items to go parallel (when enabled) */
+#define FY_EMIT_PARALLEL_MIN_ITEMS	1024
+/* number of chunks per thread (for load balancing) */
+#define FY_EMIT_PARALLEL_CHUNKS_PER_THREAD	4
+
 /* internal flags */
 #define DDNF_ROOT		0x0001
 #define DDNF_SEQ		0x0002
@@ -82,6 +98,9 @@ struct fy_emitter {
 	bool force_json : 1;		/* force JSON mode unconditionally */
 	bool suppress_recycling_force : 1;
 	bool suppress_recycling : 1;
+	bool obuf_track_types : 1;	/* keep the per write type runs */
+	bool tp_owned : 1;		/* the thread pool was created by us */
+	bool canonical : 1;		/* sorted keys, with the order cached on the mappings */
 
 	/* current document */
 	struct fy_emitter_cfg cfg;	/* yeah, it isn't worth just to save a few bytes */
@@ -106,6 +125,28 @@ struct fy_emitter {
 	unsigned int sc_stack_top;
 	struct fy_emit_save_ctx sc_stack_inplace[16];
 
+	/* output buffer (coalesces writes to cfg.output) */
+	char *obuf;
+	size_t obuf_size;
+	size_t obuf_len;
+	struct fy_emitter_write_run *oruns;
+	unsigned int oruns_count;
+	unsigned int oruns_alloc;
+
+	/* gathered output to ofd, when oiov != NULL */
+	int ofd;
+	struct iovec *oiov;
+	unsigned int oiov_count;
+	unsigned int oiov_alloc;
+	size_t obuf_seg;		/* start of the obuf part not yet in oiov */
+
+	/* direct (event-less) interface, allocated on first use */
+	struct fy_emit_raw *raw;
+
+	/* parallel emission of large collections, when tp != NULL */
+	struct fy_thread_pool *tp;
+	size_t parallel_min;
+
 	/* recycled */
 	struct fy_eventp_list recycled_eventp;
 	struct fy_token_list recycled_token;
@@ -121,6 +162,8 @@ int fy_emit_setup(struct fy_emitter *emit, const struct fy_emitter_cfg *cfg);
 void fy_emit_cleanup(struct fy_emitter *emit);
 
 void fy_emit_write(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len);
+void fy_emit_write_direct(struct fy_emitter *emit, enum fy_emitter_write_type type, const char *str, int len);
+void fy_emit_output_flush(struct fy_emitter *emit);
 
 static inline bool fy_emit_whitespace(struct fy_emitter *emit)
 {
@@ -199,6 +199,25 @@ struct fy_input *fy_input_from_malloc_data(char *data, size_t size,
 	return fyi;
 }
 
+/* in place setup of a caller owned input (which is never freed) */
+void fy_input_init_from_data(struct fy_input *fyi, const char *data, size_t size,
+			     struct fy_atom *handle)
+{
+	if (data && size == (size_t)-1)
+		size = strlen(data);
+
+	memset(fyi, 0, sizeof(*fyi));
+	fyi->state = FYIS_NONE;
+	fyi->refs = 1;
+
+	fyi->cfg.type = fyit_memory;
+	fyi->cfg.userdata = NULL;
+	fyi->cfg.memory.data = data;
+	fyi->cfg.memory.size = size;
+
+	fy_input_from_data_setup(fyi, handle, false);
+}
+
 void fy_input_close(struct fy_input *fyi)
 {
 	if (!fyi)
@@ -183,6 +183,8 @@ struct fy_input *fy_input_from_data(const char *data, size_t size,
 				    struct fy_atom *handle, bool simple);
 struct fy_input *fy_input_from_malloc_data(char *data, size_t size,
 					   struct fy_atom *handle, bool simple);
+void fy_input_init_from_data(struct fy_input *fyi, const char *data, size_t size,
+			     struct fy_atom *handle);
 
 void fy_input_close(struct fy_input *fyi);
 
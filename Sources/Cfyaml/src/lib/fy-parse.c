@@ -804,8 +804,9 @@ int fy_parse_setup(struct fy_parser *fyp, const struct fy_parse_cfg *cfg)
 	fy_input_list_init(&fyp->queued_inputs);
 
 	fyp->state = FYPS_NONE;
-	fy_parse_state_log_list_init(&fyp->state_stack);
-	fy_parse_state_log_list_init(&fyp->recycled_parse_state_log);
+	fyp->state_stack = fyp->state_stack_inplace;
+	fyp->state_stack_alloc = sizeof(fyp->state_stack_inplace)/sizeof(fyp->state_stack_inplace[0]);
+	fyp->state_stack_top = 0;
 
 	fy_eventp_list_init(&fyp->recycled_eventp);
 	fy_token_list_init(&fyp->recycled_token);
@@ -865,7 +866,11 @@ void fy_parse_cleanup(struct fy_parser *fyp)
 	fy_parse_simple_key_list_recycle_all(fyp, &fyp->simple_keys);
 	fy_token_list_unref_all(&fyp->queued_tokens);
 
-	fy_parse_parse_state_log_list_recycle_all(fyp, &fyp->state_stack);
+	if (fyp->state_stack && fyp->state_stack != fyp->state_stack_inplace)
+		free(fyp->state_stack);
+	fyp->state_stack = fyp->state_stack_inplace;
+	fyp->state_stack_alloc = sizeof(fyp->state_stack_inplace)/sizeof(fyp->state_stack_inplace[0]);
+	fyp->state_stack_top = 0;
 	fy_parse_flow_list_recycle_all(fyp, &fyp->flow_stack);
 	fy_parse_streaming_alias_list_recycle_all(fyp, &fyp->streaming_aliases);
 
@@ -885,7 +890,6 @@ void fy_parse_cleanup(struct fy_parser *fyp)
 	/* and vacuum (free everything) */
 	fy_parse_indent_vacuum(fyp);
 	fy_parse_simple_key_vacuum(fyp);
-	fy_parse_parse_state_log_vacuum(fyp);
 	fy_parse_flow_vacuum(fyp);
 	fy_parse_streaming_alias_vacuum(fyp);
 
@@ -4089,7 +4093,7 @@ int fy_reader_fetch_plain_scalar_handle(struct fy_reader *fyr, int c, int indent
 	bool last_ptr;
 	struct fy_mark mark, last_mark;
 	bool is_multiline, has_lb, has_ws, ends_with_eof, is_merge_key;
-	bool has_json_esc;
+	bool has_json_esc, pending_json_esc;
 #ifdef ATOM_SIZE_CHECK
 	size_t tlength;
 #endif
@@ -4129,6 +4133,7 @@ int fy_reader_fetch_plain_scalar_handle(struct fy_reader *fyr, int c, int indent
 	has_lb = false;
 	has_ws = false;
 	has_json_esc = false;
+	pending_json_esc = false;
 
 	length = 0;
 	breaks_found = 0;
@@ -4186,6 +4191,8 @@ int fy_reader_fetch_plain_scalar_handle(struct fy_reader *fyr, int c, int indent
 		}
 		if (run > 0) {
 			length += run;
+			/* the blanks and breaks turned out to be content */
+			has_json_esc |= pending_json_esc;
 			if (breaks_found) {
 				/* minimum 1 sep, or more for consecutive */
 				length += breaks_found > 1 ? (breaks_found_length - first_break_length) : 1;
@@ -4224,6 +4231,8 @@ int fy_reader_fetch_plain_scalar_handle(struct fy_reader *fyr, int c, int indent
 			if (flow_level > 0 && (c == ',' || c == '[' || c == ']' || c == '{' || c == '}'))
 				break;
 
+			/* the blanks and breaks turned out to be content */
+			has_json_esc |= pending_json_esc;
 			if (breaks_found) {
 				/* minimum 1 sep, or more for consecutive */
 				length += breaks_found > 1 ? (breaks_found_length - first_break_length) : 1;
@@ -4260,7 +4269,8 @@ int fy_reader_fetch_plain_scalar_handle(struct fy_reader *fyr, int c, int indent
 		if (!(fy_is_blank(c) || fy_reader_is_lb(fyr, c)))
 			break;
 
-		has_json_esc = true;
+		/* blanks and breaks need escaping, but only if more content follows */
+		pending_json_esc = true;
 
 		/* consume blanks */
 		breaks_found = 0;
@@ -5259,13 +5269,20 @@ void fy_scan_token_free(struct fy_parser *fyp, struct fy_token *fyt)
 
 int fy_parse_state_push(struct fy_parser *fyp, enum fy_parser_state state)
 {
-	struct fy_parse_state_log *fypsl;
+	enum fy_parser_state *states;
 
-	fypsl = fy_parse_parse_state_log_alloc(fyp);
-	fyp_error_check(fyp, fypsl != NULL, err_out,
-			"fy_parse_state_log_alloc() failed!");
-	fypsl->state = state;
-	fy_parse_state_log_list_push(&fyp->state_stack, fypsl);
+	if (fyp->state_stack_top >= fyp->state_stack_alloc) {
+		states = realloc(fyp->state_stack == fyp->state_stack_inplace ? NULL : fyp->state_stack,
+				sizeof(fyp->state_stack[0]) * fyp->state_stack_alloc * 2);
+		fyp_error_check(fyp, states != NULL, err_out,
+				"realloc() failed!");
+
+		if (fyp->state_stack == fyp->state_stack_inplace)
+			memcpy(states, fyp->state_stack, sizeof(fyp->state_stack[0]) * fyp->state_stack_top);
+		fyp->state_stack = states;
+		fyp->state_stack_alloc *= 2;
+	}
+	fyp->state_stack[fyp->state_stack_top++] = state;
 
 	return 0;
 err_out:
@@ -5274,18 +5291,10 @@ err_out:
 
 enum fy_parser_state fy_parse_state_pop(struct fy_parser *fyp)
 {
-	struct fy_parse_state_log *fypsl;
-	enum fy_parser_state state;
-
-	fypsl = fy_parse_state_log_list_pop(&fyp->state_stack);
-	if (!fypsl)
+	if (!fyp->state_stack_top)
 		return FYPS_NONE;
 
-	state = fypsl->state;
-
-	fy_parse_parse_state_log_recycle(fyp, fypsl);
-
-	return state;
+	return fyp->state_stack[--fyp->state_stack_top];
 }
 
 void fy_parse_state_set(struct fy_parser *fyp, enum fy_parser_state state)
@@ -5589,7 +5598,7 @@ int fy_parse_stream_start(struct fy_parser *fyp)
 
 	fy_parse_indent_list_recycle_all(fyp, &fyp->indent_stack);
 	fy_parse_simple_key_list_recycle_all(fyp, &fyp->simple_keys);
-	fy_parse_parse_state_log_list_recycle_all(fyp, &fyp->state_stack);
+	fyp->state_stack_top = 0;
 	fy_parse_flow_list_recycle_all(fyp, &fyp->flow_stack);
 
 	fy_token_unref_rl(fyp->recycled_token_list, fyp->stream_end_token);
@@ -6655,7 +6664,7 @@ static void fy_parse_input_reset(struct fy_parser *fyp)
 		fy_input_unref(fyi);
 	}
 
-	fy_parse_parse_state_log_list_recycle_all(fyp, &fyp->state_stack);
+	fyp->state_stack_top = 0;
 
 	fyp->stream_start_produced = false;
 	fyp->stream_end_produced = false;
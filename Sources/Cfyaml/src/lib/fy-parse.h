@@ -134,12 +134,6 @@ enum fy_parser_state {
 	FYPS_END
 };
 
-struct fy_parse_state_log {
-	struct list_head node;
-	enum fy_parser_state state;
-};
-FY_PARSE_TYPE_DECL(parse_state_log);
-
 struct fy_streaming_alias {
 	struct list_head node;
 	struct fy_token *anchor;
@@ -219,7 +213,10 @@ struct fy_parser {
 	struct fy_simple_key_list simple_keys;
 	/* state stack */
 	enum fy_parser_state state;
-	struct fy_parse_state_log_list state_stack;
+	enum fy_parser_state *state_stack;
+	unsigned int state_stack_alloc;
+	unsigned int state_stack_top;
+	enum fy_parser_state state_stack_inplace[64];
 
 	/* current parse document */
 	struct fy_document_state *current_document_state;
@@ -233,7 +230,6 @@ struct fy_parser {
 	/* recycling lists */
 	struct fy_indent_list recycled_indent;
 	struct fy_simple_key_list recycled_simple_key;
-	struct fy_parse_state_log_list recycled_parse_state_log;
 	struct fy_flow_list recycled_flow;
 	struct fy_streaming_alias_list recycled_streaming_alias;
 
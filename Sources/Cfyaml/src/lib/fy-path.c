@@ -34,6 +34,8 @@ static int fy_path_setup(struct fy_path *fypp)
 	fy_path_component_list_init(&fypp->recycled_component);
 	fy_path_component_list_init(&fypp->components);
 
+	fy_emit_accum_init(&fypp->text, NULL, 0, 0, fylb_cr_nl);
+
 	return 0;
 }
 
@@ -54,6 +56,8 @@ static void fy_path_cleanup(struct fy_path *fypp)
 
 	while ((fypc = fy_path_component_list_pop(&fypp->recycled_component)) != NULL)
 		fy_path_component_free(fypc);
+
+	fy_emit_accum_cleanup(&fypp->text);
 }
 
 struct fy_path *fy_path_create(void)
@@ -91,6 +95,11 @@ void fy_path_reset(struct fy_path *fypp)
 
 	while ((fypc = fy_path_component_list_pop(&fypp->components)) != NULL)
 		fy_path_component_free(fypc);
+
+	fypp->depth = 0;
+	fypp->text_last = NULL;
+	fypp->text_final_len = 0;
+	fy_emit_accum_reset(&fypp->text);
 }
 
 struct fy_path_component *fy_path_component_alloc(struct fy_path *fypp)
@@ -231,6 +240,39 @@ struct fy_path_component *fy_path_component_create_sequence(struct fy_path *fypp
 	return fypc;
 }
 
+void fy_path_push_component(struct fy_path *fypp, struct fy_path_component *fypc)
+{
+	if (!fypp || !fypc)
+		return;
+
+	fy_path_component_list_add_tail(&fypp->components, fypc);
+	fypp->depth++;
+}
+
+struct fy_path_component *fy_path_pop_component(struct fy_path *fypp)
+{
+	struct fy_path_component *fypc, *fypc_last;
+
+	if (!fypp)
+		return NULL;
+
+	fypc = fy_path_component_list_pop_tail(&fypp->components);
+	if (!fypc)
+		return NULL;
+
+	assert(fypp->depth > 0);
+	fypp->depth--;
+
+	/* the new last component may change again; its text is no longer final */
+	fypc_last = fy_path_component_list_tail(&fypp->components);
+	if (fypc_last && fypp->text_last == fypc_last) {
+		fypp->text_last = fy_path_component_prev(&fypp->components, fypc_last);
+		fypp->text_final_len = fypc_last->text_start;
+	}
+
+	return fypc;
+}
+
 bool fy_path_component_is_mapping(struct fy_path_component *fypc)
 {
 	return fypc && fypc->type == FYPCT_MAP;
@@ -312,127 +354,167 @@ static int fy_path_component_get_text_internal(struct fy_emit_accum *ea, struct
 	return 0;
 }
 
-static int fy_path_get_text_internal(struct fy_emit_accum *ea, struct fy_path *fypp)
+static int fy_path_component_append_text(struct fy_emit_accum *ea, struct fy_path *fypp,
+					 struct fy_path_component *fypc)
 {
-	struct fy_path_component *fypc;
 	struct fy_document *fyd;
 	char *doctxt;
 	const char *text;
 	size_t len;
 	bool local_key = false;
-	int rc, count;
 
-	if (fypp->parent) {
-		rc = fy_path_get_text_internal(ea, fypp->parent);
-		assert(!rc);
-		if (rc)
-			return -1;
-	}
-
-	/* OK, we have to iterate and rebuild the paths */
-	for (fypc = fy_path_component_list_head(&fypp->components), count = 0; fypc;
-			fypc = fy_path_component_next(&fypp->components, fypc), count++) {
-
-		fy_emit_accum_utf8_put_raw(ea, '/');
+	fy_emit_accum_utf8_put_raw(ea, '/');
 
-		switch (fypc->type) {
-		case FYPCT_NONE:
-			abort();
+	switch (fypc->type) {
+	case FYPCT_NONE:
+		abort();
 
-		case FYPCT_MAP:
+	case FYPCT_MAP:
 
-			if (!fypc->map.has_key || fypc->map.root)
-				break;
+		if (!fypc->map.has_key || fypc->map.root)
+			break;
 
-			/* key reference ? wrap in .key(X)*/
-			local_key = false;
-			if (fypc->map.await_key)
-				local_key = true;
+		/* key reference ? wrap in .key(X)*/
+		local_key = false;
+		if (fypc->map.await_key)
+			local_key = true;
 
-			if (local_key)
-				fy_emit_accum_utf8_write_raw(ea, ".key(", 5);
+		if (local_key)
+			fy_emit_accum_utf8_write_raw(ea, ".key(", 5);
 
-			if (!fypc->map.is_complex_key) {
+		if (!fypc->map.is_complex_key) {
 
-				if (fypc->map.scalar.key) {
-					text = fy_token_get_text(fypc->map.scalar.key, &len);
-					assert(text);
-					if (!text)
-						return -1;
-					if (fypc->map.scalar.key->type == FYTT_ALIAS)
-						fy_emit_accum_utf8_put_raw(ea, '*');
-					fy_emit_accum_utf8_write_raw(ea, text, len);
-				} else {
-					fy_emit_accum_utf8_write_raw(ea, ".null()", 7);
-				}
+			if (fypc->map.scalar.key) {
+				text = fy_token_get_text(fypc->map.scalar.key, &len);
+				assert(text);
+				if (!text)
+					return -1;
+				if (fypc->map.scalar.key->type == FYTT_ALIAS)
+					fy_emit_accum_utf8_put_raw(ea, '*');
+				fy_emit_accum_utf8_write_raw(ea, text, len);
 			} else {
-				if (fypc->map.complex_key)
-					fyd = fypc->map.complex_key;
-				else
-					fyd = fy_document_builder_peek_document(fypp->fydb);
-
-				/* complex key */
-				if (fyd) {
-					doctxt = fy_emit_document_to_string(fyd,
-						FYECF_WIDTH_INF | FYECF_INDENT_DEFAULT |
-						FYECF_MODE_FLOW_ONELINE | FYECF_NO_ENDING_NEWLINE);
-				} else
-					doctxt = NULL;
-
-				if (doctxt) {
-					fy_emit_accum_utf8_write_raw(ea, doctxt, strlen(doctxt));
-					free(doctxt);
-				} else {
-					fy_emit_accum_utf8_write_raw(ea, "<X>", 3);
-				}
+				fy_emit_accum_utf8_write_raw(ea, ".null()", 7);
 			}
+		} else {
+			if (fypc->map.complex_key)
+				fyd = fypc->map.complex_key;
+			else
+				fyd = fy_document_builder_peek_document(fypp->fydb);
 
-			if (local_key)
-				fy_emit_accum_utf8_put_raw(ea, ')');
+			/* complex key */
+			if (fyd) {
+				doctxt = fy_emit_document_to_string(fyd,
+					FYECF_WIDTH_INF | FYECF_INDENT_DEFAULT |
+					FYECF_MODE_FLOW_ONELINE | FYECF_NO_ENDING_NEWLINE);
+			} else
+				doctxt = NULL;
+
+			if (doctxt) {
+				fy_emit_accum_utf8_write_raw(ea, doctxt, strlen(doctxt));
+				free(doctxt);
+			} else {
+				fy_emit_accum_utf8_write_raw(ea, "<X>", 3);
+			}
+		}
 
-			break;
+		if (local_key)
+			fy_emit_accum_utf8_put_raw(ea, ')');
 
-		case FYPCT_SEQ:
+		break;
 
-			/* not started filling yet */
-			if (fypc->seq.idx < 0)
-				break;
+	case FYPCT_SEQ:
 
-			fy_emit_accum_utf8_printf_raw(ea, "%d", fypc->seq.idx);
+		/* not started filling yet */
+		if (fypc->seq.idx < 0)
 			break;
-		}
+
+		fy_emit_accum_utf8_printf_raw(ea, "%d", fypc->seq.idx);
+		break;
 	}
 
 	return 0;
 }
 
-char *fy_path_get_text(struct fy_path *fypp)
+static int fy_path_get_text_internal(struct fy_emit_accum *ea, struct fy_path *fypp)
 {
-	struct fy_emit_accum ea;	/* use an emit accumulator */
-	char *path = NULL;
-	size_t len;
+	struct fy_path_component *fypc;
 	int rc;
 
-	/* no inplace buffer; we will need the malloc'ed contents anyway */
-	fy_emit_accum_init(&ea, NULL, 0, 0, fylb_cr_nl);
+	if (fypp->parent) {
+		rc = fy_path_get_text_internal(ea, fypp->parent);
+		assert(!rc);
+		if (rc)
+			return -1;
+	}
 
-	fy_emit_accum_start(&ea, 0, fylb_cr_nl);
+	/* OK, we have to iterate and rebuild the paths */
+	for (fypc = fy_path_component_list_head(&fypp->components); fypc;
+			fypc = fy_path_component_next(&fypp->components, fypc)) {
 
-	rc = fy_path_get_text_internal(&ea, fypp);
-	if (rc)
-		goto err_out;
+		rc = fy_path_component_append_text(ea, fypp, fypc);
+		if (rc)
+			return -1;
+	}
 
-	if (fy_emit_accum_empty(&ea))
-		fy_emit_accum_utf8_printf_raw(&ea, "/");
+	return 0;
+}
 
-	fy_emit_accum_make_0_terminated(&ea);
+const char *fy_path_get_text0(struct fy_path *fypp)
+{
+	struct fy_path_component *fypc, *fypc_last;
+	struct fy_emit_accum_state s;
+	int rc;
 
-	path = fy_emit_accum_steal(&ea, &len);
+	if (!fypp)
+		return NULL;
 
-err_out:
-	fy_emit_accum_cleanup(&ea);
+	if (fypp->parent) {
+		/* complex key paths change with the parent, rebuild */
+		fy_emit_accum_reset(&fypp->text);
+		rc = fy_path_get_text_internal(&fypp->text, fypp);
+		if (rc)
+			return NULL;
+	} else {
+		/* drop the text of the components that may have changed */
+		memset(&s, 0, sizeof(s));
+		s.next = fypp->text_final_len;
+		fy_emit_accum_rewind_state(&fypp->text, &s);
+
+		/* only the last component can change until it's popped,
+		 * so the text of all the previous ones is final */
+		fypc_last = fy_path_component_list_tail(&fypp->components);
+		fypc = fypp->text_last ?
+			fy_path_component_next(&fypp->components, fypp->text_last) :
+			fy_path_component_list_head(&fypp->components);
+		for (; fypc; fypc = fy_path_component_next(&fypp->components, fypc)) {
+
+			fypc->text_start = fypp->text.next;
+			rc = fy_path_component_append_text(&fypp->text, fypp, fypc);
+			if (rc)
+				return NULL;
+
+			if (fypc != fypc_last) {
+				fypp->text_last = fypc;
+				fypp->text_final_len = fypp->text.next;
+			}
+		}
+	}
+
+	if (fy_emit_accum_empty(&fypp->text))
+		fy_emit_accum_utf8_put_raw(&fypp->text, '/');
+
+	return fy_emit_accum_get0(&fypp->text);
+}
 
-	return path;
+char *fy_path_get_text(struct fy_path *fypp)
+{
+	const char *text;
+
+	text = fy_path_get_text0(fypp);
+	if (!text)
+		return NULL;
+
+	return strdup(text);
 }
 
 char *fy_path_component_get_text(struct fy_path_component *fypc)
@@ -463,20 +545,10 @@ err_out:
 
 int fy_path_depth(struct fy_path *fypp)
 {
-	struct fy_path_component *fypc;
-	int depth;
-
 	if (!fypp)
 		return 0;
 
-	depth = fy_path_depth(fypp->parent);
-	for (fypc = fy_path_component_list_head(&fypp->components); fypc;
-			fypc = fy_path_component_next(&fypp->components, fypc)) {
-
-		depth++;
-	}
-
-	return depth;
+	return fy_path_depth(fypp->parent) + fypp->depth;
 }
 
 struct fy_path *fy_path_parent(struct fy_path *fypp)
@@ -64,6 +64,7 @@ struct fy_path_component {
 		struct fy_path_sequence_state seq;
 	};
 	void *user_data;
+	size_t text_start;		/* offset in the path text */
 };
 FY_TYPE_DECL_LIST(path_component);
 
@@ -93,6 +94,10 @@ struct fy_path {
 	struct fy_document_builder *fydb;	/* for complex keys */
 	struct fy_path *parent;			/* when we have a parent */
 	void *user_data;
+	int depth;				/* number of components */
+	struct fy_emit_accum text;		/* incrementally built path text */
+	struct fy_path_component *text_last;	/* last component with final text */
+	size_t text_final_len;			/* text length up to and including it */
 };
 FY_TYPE_DECL_LIST(path);
 
@@ -111,4 +116,7 @@ void fy_path_component_clear_state(struct fy_path_component *fypc);
 struct fy_path_component *fy_path_component_create_mapping(struct fy_path *fypp);
 struct fy_path_component *fy_path_component_create_sequence(struct fy_path *fypp);
 
+void fy_path_push_component(struct fy_path *fypp, struct fy_path_component *fypc);
+struct fy_path_component *fy_path_pop_component(struct fy_path *fypp);
+
 #endif
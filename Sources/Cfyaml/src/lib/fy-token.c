@@ -641,11 +641,49 @@ const struct fy_mark *fy_token_end_mark(struct fy_token *fyt)
 	return NULL;
 }
 
+/*
+ * Atoms that can be output directly hold their content verbatim, so
+ * the analysis can walk the bytes instead of going through the atom
+ * iterator; everything else uses the iterator.
+ */
+struct fy_token_analyze_src {
+	const char *s;
+	const char *e;
+	struct fy_atom_iter *iter;
+};
+
+static inline int fy_token_analyze_peek(struct fy_token_analyze_src *src, int *widthp)
+{
+	int c;
+
+	if (src->iter) {
+		*widthp = 0;
+		return fy_atom_iter_utf8_peek(src->iter);
+	}
+
+	c = fy_utf8_get(src->s, (size_t)(src->e - src->s), widthp);
+	return c >= 0 ? c : -1;
+}
+
+static inline int fy_token_analyze_get(struct fy_token_analyze_src *src)
+{
+	int c, w;
+
+	if (src->iter)
+		return fy_atom_iter_utf8_get(src->iter);
+
+	c = fy_token_analyze_peek(src, &w);
+	if (c >= 0)
+		src->s += w;
+	return c;
+}
+
 int fy_token_text_analyze(struct fy_token *fyt)
 {
+	struct fy_token_analyze_src src;
 	struct fy_atom_iter iter;
 	enum fy_atom_style style;
-	int c, cn, cnn, cp, col;
+	int c, cn, cnn, cp, col, w;
 	uint8_t col0si, col0ei;	/* mask for --- ... at indent 0 */
 	int flags;
 
@@ -678,12 +716,19 @@ int fy_token_text_analyze(struct fy_token *fyt)
 	if (!fy_atom_style_is_block(style))
 		flags |= FYTTAF_DIRECT_OUTPUT;
 
-	fy_atom_iter_start(&fyt->handle, &iter);
+	memset(&src, 0, sizeof(src));
+	if (fyt->handle.direct_output && fyt->type != FYTT_TAG) {
+		src.s = fy_atom_data(&fyt->handle);
+		src.e = src.s + fy_atom_size(&fyt->handle);
+	} else {
+		fy_atom_iter_start(&fyt->handle, &iter);
+		src.iter = &iter;
+	}
 
 	col = 0;
 
 	/* get first character */
-	cn = fy_atom_iter_utf8_get(&iter);
+	cn = fy_token_analyze_get(&src);
 	if (cn < 0) {
 		/* empty? */
 		flags |= FYTTAF_EMPTY | FYTTAF_CAN_BE_DOUBLE_QUOTED | FYTTAF_CAN_BE_UNQUOTED_PATH_KEY | FYTTAF_CAN_BE_SIMPLE_KEY;
@@ -715,7 +760,7 @@ int fy_token_text_analyze(struct fy_token *fyt)
 		flags &= ~FYTTAF_CAN_BE_PLAIN_FLOW;
 
 	if ((flags & (FYTTAF_CAN_BE_PLAIN | FYTTAF_CAN_BE_PLAIN_FLOW))) {
-		cnn = fy_atom_iter_utf8_peek(&iter);
+		cnn = fy_token_analyze_peek(&src, &w);
 		if (fy_is_blankz_m(cnn, fy_token_atom_lb_mode(fyt)) && fy_is_indicator_before_space(cn))
 			flags &= ~(FYTTAF_CAN_BE_PLAIN | FYTTAF_CAN_BE_PLAIN_FLOW);
 	}
@@ -741,7 +786,7 @@ int fy_token_text_analyze(struct fy_token *fyt)
 		}
 
 		/* can be -1 on end */
-		cn = fy_atom_iter_utf8_get(&iter);
+		cn = fy_token_analyze_get(&src);
 
 		/* zero can't be output, only in double quoted mode */
 		if (c == 0) {
@@ -823,7 +868,8 @@ int fy_token_text_analyze(struct fy_token *fyt)
 		}
 	}
 out:
-	fy_atom_iter_finish(&iter);
+	if (src.iter)
+		fy_atom_iter_finish(&iter);
 	fyt->analyze_flags = flags;
 	return flags;
 }
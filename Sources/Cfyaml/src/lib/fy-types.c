@@ -29,6 +29,5 @@
 /* parse only types */
 FY_PARSE_TYPE_DEFINE_SIMPLE(indent);
 FY_PARSE_TYPE_DEFINE_SIMPLE(simple_key);
-FY_PARSE_TYPE_DEFINE_SIMPLE(parse_state_log);
 FY_PARSE_TYPE_DEFINE_SIMPLE(flow);
 FY_PARSE_TYPE_DEFINE_SIMPLE(streaming_alias);
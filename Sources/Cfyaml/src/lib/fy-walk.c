@@ -3623,6 +3623,7 @@ fy_path_expr_build_from_string(const struct fy_path_parse_cfg *pcfg,
 
 struct fy_path_exec *fy_path_exec_create(const struct fy_path_exec_cfg *xcfg)
 {
+	struct fy_thread_pool_cfg tp_cfg;
 	struct fy_path_exec *fypx;
 
 	fypx = malloc(sizeof(*fypx));
@@ -3638,6 +3639,21 @@ struct fy_path_exec *fy_path_exec_create(const struct fy_path_exec_cfg *xcfg)
 	fypx->supress_recycling = !!(fypx->cfg.flags & FYPXCF_DISABLE_RECYCLING) ||
 		                  (getenv("FY_VALGRIND") &&
 				   !getenv("FY_VALGRIND_RECYCLING"));
+
+	if (fypx->cfg.flags & FYPXCF_PARALLEL) {
+		if (!fypx->cfg.tp) {
+			memset(&tp_cfg, 0, sizeof(tp_cfg));
+			tp_cfg.flags = FYTPCF_STEAL_MODE;
+			tp_cfg.num_threads = 0;	/* number of online CPUs */
+			fypx->tp = fy_thread_pool_create(&tp_cfg);
+			if (!fypx->tp) {
+				free(fypx);
+				return NULL;
+			}
+		} else
+			fypx->tp = fypx->cfg.tp;
+	}
+
 	return fypx;
 }
 
@@ -3663,6 +3679,11 @@ void fy_path_exec_destroy(struct fy_path_exec *fypx)
 	if (!fypx)
 		return;
 	fy_path_exec_cleanup(fypx);
+
+	/* destroy the thread pool if we're the ones created it */
+	if (fypx->tp && !fypx->cfg.tp)
+		fy_thread_pool_destroy(fypx->tp);
+
 	free(fypx);
 }
 
@@ -4252,6 +4273,373 @@ fy_scalar_walk_result_to_expr(struct fy_path_exec *fypx, struct fy_walk_result *
 	return exprt;
 }
 
+/*
+ * Parallel execution of the steps following a recursive descent.
+ *
+ * The nodes under the descent are collected in document order and are
+ * split in contiguous chunks. Each chunk is evaluated on a thread of the
+ * pool using a private executor (and recycle list), and the per chunk
+ * results are spliced back in order, so the result is identical to the
+ * serial case.
+ *
+ * Only steps that are guaranteed to not modify the document are allowed,
+ * i.e. no aliases (which set up lazy resolution data), no parent/root
+ * traversal (which escape the subtree) and no steps that operate on the
+ * whole result set (methods, unique filtering).
+ */
+struct fy_path_exec_chunk {
+	struct fy_path_exec *fypx;
+	struct fy_walk_result_list fwr_recycle;
+	struct fy_path_expr *expr;
+	struct fy_path_expr *exprn;
+	int level;
+	struct fy_node **nodes;
+	size_t count;
+	struct fy_walk_result *output;
+};
+
+static bool
+fy_path_expr_is_parallel_safe(struct fy_path_expr *expr, bool *need_textp)
+{
+	struct fy_path_expr *exprn;
+
+	switch (expr->type) {
+	case fpet_this:
+	case fpet_every_child:
+	case fpet_every_child_r:
+	case fpet_filter_collection:
+	case fpet_filter_scalar:
+	case fpet_filter_sequence:
+	case fpet_filter_mapping:
+	case fpet_seq_index:
+	case fpet_seq_slice:
+	case fpet_multi:
+	case fpet_chain:
+	case fpet_logical_or:
+	case fpet_logical_and:
+		break;
+
+	case fpet_map_key:
+		/* complex keys are compared against a private document */
+		if (expr->fyt && expr->fyt->map_key.fyd)
+			return false;
+		break;
+
+	case fpet_eq:
+	case fpet_neq:
+	case fpet_lt:
+	case fpet_gt:
+	case fpet_lte:
+	case fpet_gte:
+	case fpet_scalar:
+	case fpet_plus:
+	case fpet_minus:
+	case fpet_mult:
+	case fpet_div:
+		*need_textp = true;
+		break;
+
+	default:
+		return false;
+	}
+
+	for (exprn = fy_path_expr_list_head(&expr->children); exprn;
+		exprn = fy_path_expr_next(&expr->children, exprn)) {
+		if (!fy_path_expr_is_parallel_safe(exprn, need_textp))
+			return false;
+	}
+
+	return true;
+}
+
+static void
+fy_path_expr_prepare_parallel_text(struct fy_path_expr *expr)
+{
+	struct fy_path_expr *exprn;
+
+	/* the text of the expression tokens is cached lazily, do it now */
+	if (expr->fyt)
+		(void)fy_token_get_text0(expr->fyt);
+
+	for (exprn = fy_path_expr_list_head(&expr->children); exprn;
+		exprn = fy_path_expr_next(&expr->children, exprn))
+		fy_path_expr_prepare_parallel_text(exprn);
+}
+
+static void
+fy_node_prepare_parallel_token(struct fy_token *fyt, bool need_text)
+{
+	size_t len;
+
+	if (!fyt)
+		return;
+
+	/* make sure all the lazily computed state is there */
+	(void)fy_token_get_text(fyt, &len);
+	(void)fy_token_get_text_length(fyt);
+	if (need_text) {
+		(void)fy_token_get_text0(fyt);
+		(void)fy_token_text_analyze(fyt);
+	}
+}
+
+bool
+fy_path_exec_can_execute_parallel(struct fy_path_exec *fypx, struct fy_path_expr *expr,
+				  struct fy_path_expr *exprn, struct fy_walk_result *input)
+{
+	struct fy_path_expr *exprt;
+	bool need_text;
+
+	if (!fypx || !fypx->tp || !(fypx->cfg.flags & FYPXCF_PARALLEL))
+		return false;
+
+	/* only a descent on a single node followed by more steps */
+	if (!input || input->type != fwrt_node_ref || exprn->type != fpet_every_child_r ||
+	    !fy_path_expr_next(&expr->children, exprn))
+		return false;
+
+	need_text = false;
+	for (exprt = fy_path_expr_next(&expr->children, exprn); exprt;
+		exprt = fy_path_expr_next(&expr->children, exprt)) {
+		if (!fy_path_expr_is_parallel_safe(exprt, &need_text))
+			return false;
+	}
+
+	return true;
+}
+
+static void fy_path_exec_chunk_work(void *arg)
+{
+	struct fy_path_exec_chunk *c = arg;
+	struct fy_path_expr *exprn;
+	struct fy_walk_result *fwr;
+	size_t i;
+
+	for (i = 0; i < c->count; i++) {
+
+		fwr = fy_path_exec_walk_result_create(c->fypx, fwrt_node_ref, c->nodes[i]);
+		assert(fwr);
+
+		for (exprn = c->exprn; exprn && fwr; exprn = fy_path_expr_next(&c->expr->children, exprn))
+			fwr = fy_path_expr_execute(c->fypx, c->level, exprn, fwr, c->expr->type);
+
+		if (fwr)
+			fy_walk_result_list_add_tail(&c->output->refs, fwr);
+	}
+}
+
+static int
+fy_path_exec_collect_nodes(struct fy_node *fyn, struct fy_node ***nodesp,
+			   size_t *countp, size_t *allocp, bool need_text)
+{
+	struct fy_node **nodes;
+	struct fy_node_pair *fynp;
+	struct fy_node *fyni;
+	void *prevp;
+	size_t alloc;
+	int rc;
+
+	/* aliases resolve lazily, not possible to do in parallel */
+	if (fy_node_is_alias(fyn))
+		return 1;
+
+	if (*countp >= *allocp) {
+		alloc = *allocp ? *allocp * 2 : 1024;
+		nodes = realloc(*nodesp, alloc * sizeof(*nodes));
+		if (!nodes)
+			return -1;
+		*nodesp = nodes;
+		*allocp = alloc;
+	}
+	(*nodesp)[(*countp)++] = fyn;
+
+	switch (fyn->type) {
+	case FYNT_SCALAR:
+		fy_node_prepare_parallel_token(fyn->scalar, need_text);
+		break;
+
+	case FYNT_SEQUENCE:
+		prevp = NULL;
+		while ((fyni = fy_node_sequence_iterate(fyn, &prevp)) != NULL) {
+			rc = fy_path_exec_collect_nodes(fyni, nodesp, countp, allocp, need_text);
+			if (rc)
+				return rc;
+		}
+		break;
+
+	case FYNT_MAPPING:
+		prevp = NULL;
+		while ((fynp = fy_node_mapping_iterate(fyn, &prevp)) != NULL) {
+			/* keys are not part of the descent, but they are looked up */
+			if (fynp->key) {
+				if (fy_node_is_alias(fynp->key))
+					return 1;
+				if (fy_node_is_scalar(fynp->key))
+					fy_node_prepare_parallel_token(fynp->key->scalar, need_text);
+			}
+			if (!fynp->value)
+				continue;
+			rc = fy_path_exec_collect_nodes(fynp->value, nodesp, countp, allocp, need_text);
+			if (rc)
+				return rc;
+		}
+		break;
+	}
+
+	return 0;
+}
+
+struct fy_walk_result *
+fy_path_expr_execute_parallel(struct fy_path_exec *fypx, int level, struct fy_path_expr *expr,
+			      struct fy_path_expr *exprn, struct fy_walk_result *input)
+{
+	struct fy_path_exec_cfg xcfg;
+	struct fy_path_exec_chunk *chunks = NULL, *c;
+	struct fy_walk_result_list *fwrl;
+	struct fy_walk_result *output = NULL, *fwr;
+	struct fy_path_expr *exprt;
+	struct fy_node **nodes = NULL;
+	size_t count, alloc, num_chunks, chunk_size, i, start;
+	void **args = NULL;
+	bool need_text;
+	int rc;
+
+	assert(input && input->type == fwrt_node_ref);
+
+	need_text = false;
+	for (exprt = fy_path_expr_next(&expr->children, exprn); exprt;
+		exprt = fy_path_expr_next(&expr->children, exprt)) {
+		(void)fy_path_expr_is_parallel_safe(exprt, &need_text);
+		fy_path_expr_prepare_parallel_text(exprt);
+	}
+
+	count = alloc = 0;
+	rc = fy_path_exec_collect_nodes(input->fyn, &nodes, &count, &alloc, need_text);
+	if (rc < 0)
+		goto err_out;
+
+	/* not possible, fallback to serial execution */
+	if (rc > 0) {
+		free(nodes);
+		output = input;
+		for (exprt = exprn; exprt && output; exprt = fy_path_expr_next(&expr->children, exprt))
+			output = fy_path_expr_execute(fypx, level, exprt, output, expr->type);
+		return output;
+	}
+
+	/* re-use input for output root */
+	fy_walk_result_clean(input);
+	output = input;
+	input = NULL;
+
+	output->type = fwrt_refs;
+	fy_walk_result_list_init(&output->refs);
+
+	/* not worth it, do it here */
+	num_chunks = (size_t)fy_thread_pool_get_num_threads(fypx->tp) * FY_PATH_EXEC_PARALLEL_CHUNKS_PER_THREAD;
+	if (count < FY_PATH_EXEC_PARALLEL_MIN_NODES || num_chunks <= 1) {
+		num_chunks = 1;
+		chunk_size = count;
+	} else {
+		if (num_chunks > count)
+			num_chunks = count;
+		chunk_size = (count + num_chunks - 1) / num_chunks;
+		num_chunks = (count + chunk_size - 1) / chunk_size;
+	}
+
+	chunks = malloc(sizeof(*chunks) * num_chunks);
+	if (!chunks)
+		goto err_out;
+	memset(chunks, 0, sizeof(*chunks) * num_chunks);
+
+	args = malloc(sizeof(*args) * num_chunks);
+	if (!args)
+		goto err_out;
+
+	xcfg = fypx->cfg;
+	xcfg.flags &= ~FYPXCF_PARALLEL;
+	xcfg.tp = NULL;
+
+	for (i = 0, start = 0, c = chunks; i < num_chunks; i++, c++, start += chunk_size) {
+		c->expr = expr;
+		c->exprn = fy_path_expr_next(&expr->children, exprn);
+		c->level = level;
+		c->nodes = nodes + start;
+		c->count = start + chunk_size <= count ? chunk_size : count - start;
+		fy_walk_result_list_init(&c->fwr_recycle);
+
+		/* a single chunk is executed serially by us */
+		if (num_chunks == 1)
+			c->fypx = fy_path_exec_ref(fypx);
+		else {
+			c->fypx = fy_path_exec_create(&xcfg);
+			if (!c->fypx)
+				goto err_out;
+			fy_path_exec_set_result_recycle_list(c->fypx, &c->fwr_recycle);
+		}
+
+		c->output = fy_path_exec_walk_result_create(c->fypx, fwrt_refs);
+		if (!c->output)
+			goto err_out;
+
+		args[i] = c;
+	}
+
+	if (num_chunks == 1)
+		fy_path_exec_chunk_work(chunks);
+	else
+		fy_thread_args_join(fypx->tp, fy_path_exec_chunk_work, NULL, args, num_chunks);
+
+	/* merge back in document order, and hand over the recycled results */
+	fwrl = fy_path_exec_walk_result_rl(fypx);
+	for (i = 0, c = chunks; i < num_chunks; i++, c++) {
+		list_splice_tail_init(&c->output->refs._lh, &output->refs._lh);
+		fy_walk_result_free(c->output);
+		c->output = NULL;
+
+		if (c->fypx == fypx)
+			continue;
+
+		if (fwrl)
+			list_splice_tail_init(&c->fwr_recycle._lh, &fwrl->_lh);
+		else {
+			while ((fwr = fy_walk_result_list_pop(&c->fwr_recycle)) != NULL)
+				free(fwr);
+		}
+		/* the results now use the recycle list of the parent */
+		fy_path_exec_set_result_recycle_list(c->fypx, fwrl);
+	}
+
+	for (i = 0, c = chunks; i < num_chunks; i++, c++)
+		fy_path_exec_unref(c->fypx);
+
+	free(args);
+	free(chunks);
+	free(nodes);
+
+	return output;
+
+err_out:
+	if (chunks) {
+		for (i = 0, c = chunks; i < num_chunks; i++, c++) {
+			if (c->output)
+				fy_walk_result_free(c->output);
+			if (c->fypx && c->fypx != fypx) {
+				while ((fwr = fy_walk_result_list_pop(&c->fwr_recycle)) != NULL)
+					free(fwr);
+				fy_path_exec_set_result_recycle_list(c->fypx, NULL);
+			}
+			fy_path_exec_unref(c->fypx);
+		}
+	}
+	free(args);
+	free(chunks);
+	free(nodes);
+	fy_walk_result_free(output);
+	fy_walk_result_free(input);
+	return NULL;
+}
+
 struct fy_walk_result *
 fy_path_expr_execute(struct fy_path_exec *fypx, int level, struct fy_path_expr *expr,
 		     struct fy_walk_result *input, enum fy_path_expr_type ptype)
@@ -4332,6 +4720,12 @@ fy_path_expr_execute(struct fy_path_exec *fypx, int level, struct fy_path_expr *
 		for (exprn = fy_path_expr_list_head(&expr->children); exprn;
 			exprn = fy_path_expr_next(&expr->children, exprn)) {
 
+			/* a recursive descent followed by more steps may go parallel */
+			if (fy_path_exec_can_execute_parallel(fypx, expr, exprn, output)) {
+				output = fy_path_expr_execute_parallel(fypx, level + 1, expr, exprn, output);
+				break;
+			}
+
 			output = fy_path_expr_execute(fypx, level + 1, exprn, output, expr->type);
 			if (!output)
 				break;
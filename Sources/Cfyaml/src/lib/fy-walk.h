@@ -354,8 +354,14 @@ struct fy_path_exec {
 	struct fy_walk_result_list *fwr_recycle;
 	int refs;
 	bool supress_recycling;
+	struct fy_thread_pool *tp;	/* parallel mode only */
 };
 
+/* minimum number of nodes under a recursive descent to go parallel */
+#define FY_PATH_EXEC_PARALLEL_MIN_NODES	1024
+/* number of chunks per thread (for load balancing) */
+#define FY_PATH_EXEC_PARALLEL_CHUNKS_PER_THREAD	4
+
 struct fy_path_exec *fy_path_exec_create(const struct fy_path_exec_cfg *xcfg);
 struct fy_path_exec *fy_path_exec_create_on_document(struct fy_document *fyd);
 void fy_path_exec_destroy(struct fy_path_exec *fypx);
@@ -389,6 +395,13 @@ struct fy_walk_result *
 fy_path_expr_execute(struct fy_path_exec *fypx, int level, struct fy_path_expr *expr,
 		     struct fy_walk_result *input, enum fy_path_expr_type ptype);
 
+bool
+fy_path_exec_can_execute_parallel(struct fy_path_exec *fypx, struct fy_path_expr *expr,
+				  struct fy_path_expr *exprn, struct fy_walk_result *input);
+struct fy_walk_result *
+fy_path_expr_execute_parallel(struct fy_path_exec *fypx, int level, struct fy_path_expr *expr,
+			      struct fy_path_expr *exprn, struct fy_walk_result *input);
+
 static inline struct fy_walk_result_list *
 fy_path_exec_walk_result_rl(struct fy_path_exec *fypx)
 {
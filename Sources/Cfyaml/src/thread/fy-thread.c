@@ -19,10 +19,13 @@
 #include <unistd.h>
 #include <errno.h>
 #include <limits.h>
+#include <time.h>
 
 #if defined(__linux__)
 #include <sys/syscall.h>
 #include <linux/futex.h>
+#include <sched.h>
+#include <dirent.h>
 #endif
 
 #include "fy-diag.h"
@@ -42,10 +45,87 @@
 
 static void *fy_worker_thread_standard(void *arg);
 static void *fy_worker_thread_steal(void *arg);
+static void *fy_worker_thread_deque(void *arg);
 
-static void fy_thread_work_join_standard(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn);
-static void fy_thread_work_join_steal(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn);
-static void fy_thread_work_join_steal_2(struct fy_thread_pool *tp, struct fy_thread_work works[2], fy_work_check_fn check_fn);
+static void fy_thread_work_join_standard(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn, int node);
+static void fy_thread_work_join_steal(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn, int node);
+static void fy_thread_work_join_steal_2(struct fy_thread_pool *tp, struct fy_thread_work works[2], fy_work_check_fn check_fn, int node);
+static void fy_thread_work_join_deque(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn);
+
+static inline void fy_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+static inline uint64_t fy_thread_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline void fy_thread_stat_add(_Atomic(uint64_t) *p, uint64_t v)
+{
+	atomic_fetch_add_explicit(p, v, memory_order_relaxed);
+}
+
+static inline void fy_thread_stat_max(_Atomic(uint64_t) *p, uint64_t v)
+{
+	uint64_t old;
+
+	old = atomic_load_explicit(p, memory_order_relaxed);
+	while (v > old && !atomic_compare_exchange_weak_explicit(p, &old, v,
+				memory_order_relaxed, memory_order_relaxed))
+		;
+}
+
+static inline void fy_thread_stat_wake(struct fy_thread_stats_atomic *st, uint64_t wake_ns)
+{
+	uint64_t now, lat;
+
+	now = fy_thread_now_ns();
+	lat = now > wake_ns ? now - wake_ns : 0;
+	fy_thread_stat_add(&st->wakes, 1);
+	fy_thread_stat_add(&st->wake_latency_ns, lat);
+	fy_thread_stat_max(&st->wake_latency_max_ns, lat);
+}
+
+static inline struct fy_thread_stats_atomic *fy_thread_pool_current_stats(struct fy_thread_pool *tp)
+{
+	struct fy_thread *t;
+
+	t = pthread_getspecific(tp->key);
+	return t ? &t->stats : &tp->ext_stats;
+}
+
+/*
+ * Adaptive spinning; the spin limit doubles every time spinning
+ * paid off, and halves every time the thread had to park anyway.
+ */
+static inline unsigned int fy_thread_spin_limit(_Atomic(unsigned int) *spinp)
+{
+	return atomic_load_explicit(spinp, memory_order_relaxed);
+}
+
+static inline void fy_thread_spin_adapt(struct fy_thread_pool *tp, _Atomic(unsigned int) *spinp, bool hit)
+{
+	unsigned int l;
+
+	if (!tp->spin_max)
+		return;
+
+	l = atomic_load_explicit(spinp, memory_order_relaxed);
+	if (hit)
+		l = l < tp->spin_max / 2 ? l * 2 : tp->spin_max;
+	else
+		l = l / 2 > FY_THREAD_SPIN_MIN ? l / 2 : FY_THREAD_SPIN_MIN;
+	atomic_store_explicit(spinp, l, memory_order_relaxed);
+}
 
 #if defined(__linux__) && !defined(FY_THREAD_PORTABLE)
 
@@ -55,25 +135,40 @@ static inline int futex(_Atomic(uint32_t) *uaddr, int futex_op, uint32_t val, co
 	return syscall(SYS_futex, uaddr, futex_op, val, timeout, uaddr2, val3);
 }
 
+/*
+ * The futex word is 0 (idle), 1 (posted), or 2 (the waiter is parked),
+ * so posting only pays for the wake syscall when the waiter is parked.
+ * There can only be a single waiter.
+ */
+#define FUTEX_IDLE	0
+#define FUTEX_POSTED	1
+#define FUTEX_PARKED	2
+
 static inline int fwait(_Atomic(uint32_t) *futexp)
 {
 	long s;
-	uint32_t one = 1;
+	uint32_t v;
+
+	for (;;) {
+		v = FUTEX_POSTED;
+		if (atomic_compare_exchange_strong(futexp, &v, FUTEX_IDLE))
+			return 0;
+
+		/* announce that we're parking; if it was posted meanwhile retry */
+		if (v == FUTEX_IDLE && !atomic_compare_exchange_strong(futexp, &v, FUTEX_PARKED))
+			continue;
 
-	while (!atomic_compare_exchange_strong(futexp, &one, 0)) {
-		s = futex(futexp, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
-		if (s == -1 && errno != EAGAIN)
+		s = futex(futexp, FUTEX_WAIT_PRIVATE, FUTEX_PARKED, NULL, NULL, 0);
+		if (s == -1 && errno != EAGAIN && errno != EINTR)
 			return -1;
 	}
-	return 0;
 }
 
 static inline int fpost(_Atomic(uint32_t) *futexp)
 {
 	long s;
-	uint32_t zero = 0;
 
-	if (atomic_compare_exchange_strong(futexp, &zero, 1)) {
+	if (atomic_exchange(futexp, FUTEX_POSTED) == FUTEX_PARKED) {
 		s = futex(futexp, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
 		if (s == -1)
 			return -1;
@@ -88,7 +183,7 @@ static inline void fy_thread_init_sync(struct fy_thread *t)
 	atomic_store(&t->done, 0);
 }
 
-static inline struct fy_thread_work *fy_worker_wait_for_work(struct fy_thread *t)
+static inline struct fy_thread_work *fy_worker_park_for_work(struct fy_thread *t)
 {
 	struct fy_thread_work *w;
 	int rc __FY_DEBUG_UNUSED__;
@@ -125,13 +220,17 @@ static inline int fy_thread_submit_work_internal(struct fy_thread *t, struct fy_
 	if (!atomic_compare_exchange_strong(&t->work, &exp_work, work))
 		return -1;
 
+	/* only timestamp when there's going to be a wakeup */
+	if (atomic_load(&t->submit) == FUTEX_PARKED)
+		atomic_store(&t->wake_ns, fy_thread_now_ns());
+
 	rc = fpost(&t->submit);
 	assert(!rc);
 
 	return 0;
 }
 
-static inline int fy_thread_wait_work_internal(struct fy_thread *t)
+static inline void fy_thread_park_for_work_done(struct fy_thread *t)
 {
 	const struct fy_thread_work *work;
 
@@ -139,8 +238,6 @@ static inline int fy_thread_wait_work_internal(struct fy_thread *t)
 		fwait(&t->done);
 
 	atomic_store(&t->done, 0);
-
-	return 0;
 }
 
 void fy_worker_thread_shutdown(struct fy_thread *t)
@@ -158,6 +255,18 @@ void fy_worker_thread_shutdown(struct fy_thread *t)
 		atomic_store(&t->work, NULL);
 }
 
+static inline void fy_thread_pool_park(struct fy_thread_pool *tp, _Atomic(uint32_t) *seqp, uint32_t seq)
+{
+	/* returns immediately if the sequence has changed */
+	futex(seqp, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+}
+
+static inline void fy_thread_pool_wake(struct fy_thread_pool *tp, _Atomic(uint32_t) *seqp, bool all)
+{
+	atomic_fetch_add(seqp, 1);
+	futex(seqp, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+}
+
 #else
 
 /* portable pthread implementation */
@@ -171,7 +280,7 @@ static inline void fy_thread_init_sync(struct fy_thread *t)
 	pthread_cond_init(&t->wait_cond, NULL);
 }
 
-static inline struct fy_thread_work *fy_worker_wait_for_work(struct fy_thread *t)
+static inline struct fy_thread_work *fy_worker_park_for_work(struct fy_thread *t)
 {
 	struct fy_thread_work *work;
 
@@ -214,6 +323,7 @@ static inline int fy_thread_submit_work_internal(struct fy_thread *t, struct fy_
 		assert(exp_work == WORK_SHUTDOWN);
 		ret = -1;
 	} else {
+		atomic_store(&t->wake_ns, fy_thread_now_ns());
 		pthread_cond_signal(&t->cond);
 		ret = 0;
 	}
@@ -222,7 +332,7 @@ static inline int fy_thread_submit_work_internal(struct fy_thread *t, struct fy_
 	return ret;
 }
 
-static inline int fy_thread_wait_work_internal(struct fy_thread *t)
+static inline void fy_thread_park_for_work_done(struct fy_thread *t)
 {
 	const struct fy_thread_work *work;
 
@@ -230,8 +340,6 @@ static inline int fy_thread_wait_work_internal(struct fy_thread *t)
 	while ((work = atomic_load(&t->work)) != NULL)
 		pthread_cond_wait(&t->wait_cond, &t->wait_lock);
 	pthread_mutex_unlock(&t->wait_lock);
-
-	return 0;
 }
 
 void fy_worker_thread_shutdown(struct fy_thread *t)
@@ -243,23 +351,100 @@ void fy_worker_thread_shutdown(struct fy_thread *t)
 	pthread_join(t->tid, NULL);
 }
 
+static inline void fy_thread_pool_park(struct fy_thread_pool *tp, _Atomic(uint32_t) *seqp, uint32_t seq)
+{
+	pthread_mutex_lock(&tp->park_lock);
+	while (atomic_load(seqp) == seq)
+		pthread_cond_wait(&tp->park_cond, &tp->park_lock);
+	pthread_mutex_unlock(&tp->park_lock);
+}
+
+static inline void fy_thread_pool_wake(struct fy_thread_pool *tp, _Atomic(uint32_t) *seqp, bool all)
+{
+	/* the condition is shared, so always wake everyone */
+	pthread_mutex_lock(&tp->park_lock);
+	atomic_fetch_add(seqp, 1);
+	pthread_cond_broadcast(&tp->park_cond);
+	pthread_mutex_unlock(&tp->park_lock);
+}
+
 #endif
 
-static inline struct fy_thread *fy_thread_reserve_internal(struct fy_thread_pool *tp)
+static inline struct fy_thread_work *fy_worker_wait_for_work(struct fy_thread *t)
+{
+	struct fy_thread_work *w;
+	unsigned int i, limit;
+	uint64_t wake_ns;
+
+	/* spin for a while, back to back work is common */
+	limit = fy_thread_spin_limit(&t->spin);
+	for (i = 0; i < limit; i++) {
+		if ((w = atomic_load_explicit(&t->work, memory_order_acquire)) != NULL)
+			break;
+		fy_cpu_relax();
+	}
+	if (i < limit) {
+		fy_thread_stat_add(&t->stats.spins, i);
+		fy_thread_stat_add(&t->stats.spin_hits, 1);
+		fy_thread_spin_adapt(t->tp, &t->spin, true);
+		return w;
+	}
+	fy_thread_stat_add(&t->stats.spins, limit);
+	fy_thread_spin_adapt(t->tp, &t->spin, false);
+
+	/* park, clearing any stale wake time first */
+	atomic_store(&t->wake_ns, 0);
+	fy_thread_stat_add(&t->stats.parks, 1);
+	w = fy_worker_park_for_work(t);
+	if ((wake_ns = atomic_load(&t->wake_ns)) != 0)
+		fy_thread_stat_wake(&t->stats, wake_ns);
+
+	return w;
+}
+
+static inline int fy_thread_wait_work_internal(struct fy_thread *t)
+{
+	struct fy_thread_stats_atomic *st;
+	unsigned int i, limit;
+
+	st = fy_thread_pool_current_stats(t->tp);
+
+	limit = fy_thread_spin_limit(&t->wait_spin);
+	for (i = 0; i < limit; i++) {
+		if (atomic_load_explicit(&t->work, memory_order_acquire) == NULL)
+			break;
+		fy_cpu_relax();
+	}
+	fy_thread_stat_add(&st->spins, i);
+	fy_thread_spin_adapt(t->tp, &t->wait_spin, i < limit);
+	if (i < limit) {
+		fy_thread_stat_add(&st->spin_hits, 1);
+		return 0;
+	}
+
+	fy_thread_stat_add(&st->parks, 1);
+	fy_thread_park_for_work_done(t);
+
+	return 0;
+}
+
+/* reserve a free thread, out of the ones in @mask when not NULL */
+static inline struct fy_thread *fy_thread_reserve_mask(struct fy_thread_pool *tp, const uint64_t *mask)
 {
 	struct fy_thread *t;
 	unsigned int slot;
 	_Atomic(uint64_t) *free;
-	uint64_t exp, v;
+	uint64_t exp, v, m;
 	unsigned int i, num_threads_words;
 
 	t = NULL;
 
 	num_threads_words = FY_BIT64_COUNT(tp->num_threads);
 	for (i = 0, free = tp->freep; i < num_threads_words; i++, free++) {
+		m = mask ? mask[i] : (uint64_t)-1;
 		v = atomic_load(free);
-		while (v) {
-			slot = FY_BIT64_LOWEST(v);
+		while (v & m) {
+			slot = FY_BIT64_LOWEST(v & m);
 			assert(v & FY_BIT64(slot));
 			exp = v;		/* expecting the previous value */
 			v &= ~FY_BIT64(slot);	/* clear this bit */
@@ -276,6 +461,25 @@ static inline struct fy_thread *fy_thread_reserve_internal(struct fy_thread_pool
 	return NULL;
 }
 
+static inline struct fy_thread *fy_thread_reserve_internal(struct fy_thread_pool *tp)
+{
+	return fy_thread_reserve_mask(tp, NULL);
+}
+
+/* reserve a free thread, preferring the ones of the given node */
+static inline struct fy_thread *fy_thread_reserve_internal_node(struct fy_thread_pool *tp, int node)
+{
+	struct fy_thread *t;
+
+	if (node >= 0 && tp->nodep && (unsigned int)node < tp->num_nodes) {
+		t = fy_thread_reserve_mask(tp, tp->nodep + (size_t)node * FY_BIT64_COUNT(tp->num_threads));
+		if (t)
+			return t;
+	}
+
+	return fy_thread_reserve_internal(tp);
+}
+
 static inline void fy_thread_unreserve_internal(struct fy_thread *t)
 {
 	struct fy_thread_pool *tp;
@@ -335,7 +539,7 @@ struct fy_thread *fy_thread_reserve(struct fy_thread_pool *tp)
 		return NULL;
 
 	/* only valid for non-work stealing thread pools */
-	if (tp->cfg.flags & FYTPCF_STEAL_MODE)
+	if (tp->cfg.flags & (FYTPCF_STEAL_MODE | FYTPCF_DEQUE_MODE))
 		return NULL;
 
 	return fy_thread_reserve_internal(tp);
@@ -352,7 +556,7 @@ void fy_thread_unreserve(struct fy_thread *t)
 	assert(tp);
 
 	/* only valid for non-work stealing thread pools */
-	if (tp->cfg.flags & FYTPCF_STEAL_MODE)
+	if (tp->cfg.flags & (FYTPCF_STEAL_MODE | FYTPCF_DEQUE_MODE))
 		return;
 
 	fy_thread_unreserve_internal(t);
@@ -381,7 +585,7 @@ int fy_thread_submit_work(struct fy_thread *t, struct fy_thread_work *work)
 	if (!t || !work)
 		return -1;
 
-	if (t->tp->cfg.flags & FYTPCF_STEAL_MODE)
+	if (t->tp->cfg.flags & (FYTPCF_STEAL_MODE | FYTPCF_DEQUE_MODE))
 		return -1;
 
 	return fy_thread_submit_work_internal(t, work);
@@ -392,7 +596,7 @@ int fy_thread_wait_work(struct fy_thread *t)
 	if (!t)
 		return -1;
 
-	if (t->tp->cfg.flags & FYTPCF_STEAL_MODE)
+	if (t->tp->cfg.flags & (FYTPCF_STEAL_MODE | FYTPCF_DEQUE_MODE))
 		return -1;
 
 	return fy_thread_wait_work_internal(t);
@@ -406,7 +610,20 @@ void fy_thread_pool_cleanup(struct fy_thread_pool *tp)
 	if (!tp)
 		return;
 
-	if (tp->threads) {
+	if (tp->threads && (tp->cfg.flags & FYTPCF_DEQUE_MODE)) {
+		atomic_store(&tp->shutdown, true);
+		fy_thread_pool_wake(tp, &tp->wake_seq, true);
+		for (i = 0, t = tp->threads; i < tp->num_threads; i++, t++)
+			pthread_join(t->tid, NULL);
+
+		pthread_mutex_destroy(&tp->inject_lock);
+#if !(defined(__linux__) && !defined(FY_THREAD_PORTABLE))
+		pthread_mutex_destroy(&tp->park_lock);
+		pthread_cond_destroy(&tp->park_cond);
+#endif
+		fy_cacheline_free(tp->threads);
+
+	} else if (tp->threads) {
 		/* get out of steal mode */
 		for (i = 0, t = tp->threads; i < tp->num_threads; i++, t++) {
 			fy_worker_thread_shutdown(t);
@@ -415,17 +632,211 @@ void fy_thread_pool_cleanup(struct fy_thread_pool *tp)
 		fy_cacheline_free(tp->threads);
 	}
 
+	if (tp->cpu_mask)
+		free(tp->cpu_mask);
+
 	memset(tp, 0, sizeof(*tp));
 }
 
+#if defined(__linux__)
+
+/* no need for numaif.h just for those */
+#define FY_MPOL_F_NODE	(1 << 0)
+#define FY_MPOL_F_ADDR	(1 << 1)
+
+struct fy_thread_placement {
+	cpu_set_t allowed;
+	int cpu_node[CPU_SETSIZE];
+	unsigned int cpus[CPU_SETSIZE];
+	cpu_set_t sets[];	/* one per thread */
+};
+
+/* parse a kernel CPU list, i.e. "0-3,8,10-11" */
+static void fy_thread_parse_cpulist(const char *s, cpu_set_t *set)
+{
+	unsigned long lo, hi;
+	char *e;
+
+	CPU_ZERO(set);
+	for (;;) {
+		lo = strtoul(s, &e, 10);
+		if (e == s)
+			break;
+		hi = lo;
+		s = e;
+		if (*s == '-') {
+			hi = strtoul(s + 1, &e, 10);
+			if (e == s + 1)
+				break;
+			s = e;
+		}
+		for (; lo <= hi && lo < CPU_SETSIZE; lo++)
+			CPU_SET(lo, set);
+		if (*s != ',')
+			break;
+		s++;
+	}
+}
+
+/* fill in the NUMA node of each CPU, returns the number of nodes */
+static unsigned int fy_thread_cpu_nodes(int *cpu_node)
+{
+	char path[64], buf[4096];
+	struct dirent *de;
+	cpu_set_t set;
+	unsigned int node, num_nodes, cpu;
+	DIR *dir;
+	FILE *fp;
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		cpu_node[cpu] = 0;
+
+	/* no sysfs node information is a single node */
+	num_nodes = 1;
+	dir = opendir("/sys/devices/system/node");
+	if (!dir)
+		return num_nodes;
+
+	while ((de = readdir(dir)) != NULL) {
+		if (sscanf(de->d_name, "node%u", &node) != 1 || node >= FY_THREAD_MAX_NODES)
+			continue;
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+		fp = fopen(path, "r");
+		if (!fp)
+			continue;
+		if (fgets(buf, sizeof(buf), fp)) {
+			fy_thread_parse_cpulist(buf, &set);
+			for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+				if (CPU_ISSET(cpu, &set))
+					cpu_node[cpu] = (int)node;
+			}
+			if (node >= num_nodes)
+				num_nodes = node + 1;
+		}
+		fclose(fp);
+	}
+	closedir(dir);
+
+	return num_nodes;
+}
+
+/* the CPUs the process may run on, restricted by the configuration mask */
+static int fy_thread_allowed_cpus(const struct fy_thread_pool_cfg *cfg, unsigned int num_cpus, cpu_set_t *set)
+{
+	unsigned int cpu;
+
+	if (sched_getaffinity(0, sizeof(*set), set)) {
+		CPU_ZERO(set);
+		for (cpu = 0; cpu < num_cpus && cpu < CPU_SETSIZE; cpu++)
+			CPU_SET(cpu, set);
+	}
+
+	if (cfg->cpu_mask) {
+		for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, set) &&
+			    (cpu >= cfg->cpu_mask_bits || !(cfg->cpu_mask[cpu / 64] & FY_BIT64(cpu & 63))))
+				CPU_CLR(cpu, set);
+		}
+	}
+
+	return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+/* the node of the CPUs in the set, if they're all on the same one */
+static int fy_thread_set_node(const cpu_set_t *set, const int *cpu_node)
+{
+	unsigned int cpu;
+	int node;
+
+	node = -1;
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, set))
+			continue;
+		if (node >= 0 && cpu_node[cpu] != node)
+			return -1;
+		node = cpu_node[cpu];
+	}
+
+	return node;
+}
+
+/*
+ * Work out the CPUs of each thread, filling in the CPU and node
+ * of each thread and the per node thread bitmasks.
+ */
+static void fy_thread_pool_place(struct fy_thread_pool *tp, struct fy_thread_placement *pl)
+{
+	unsigned int group_start[FY_THREAD_MAX_NODES], group_len[FY_THREAD_MAX_NODES];
+	unsigned int i, j, n, cpu, node, g, num_groups, first, last_g, num_threads_words;
+	struct fy_thread *t;
+	cpu_set_t *set;
+	bool grouped, pinned;
+
+	grouped = !!(tp->cfg.flags & FYTPCF_NUMA_GROUP);
+	pinned = !!(tp->cfg.flags & FYTPCF_PIN_THREADS);
+	num_threads_words = FY_BIT64_COUNT(tp->num_threads);
+
+	/* the allowed CPUs, ordered by node when grouping */
+	n = 0;
+	num_groups = 0;
+	for (node = 0; node < (grouped ? tp->num_nodes : 1); node++) {
+		for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (!CPU_ISSET(cpu, &pl->allowed) || (grouped && pl->cpu_node[cpu] != (int)node))
+				continue;
+			/* a new group for each node with allowed CPUs */
+			if (!num_groups || (grouped && pl->cpu_node[pl->cpus[n - 1]] != (int)node)) {
+				group_start[num_groups] = n;
+				group_len[num_groups++] = 0;
+			}
+			group_len[num_groups - 1]++;
+			pl->cpus[n++] = cpu;
+		}
+	}
+	assert(n > 0 && num_groups > 0);
+
+	first = 0;
+	last_g = 0;
+	for (i = 0, t = tp->threads; i < tp->num_threads; i++, t++) {
+		set = &pl->sets[i];
+		CPU_ZERO(set);
+
+		/* consecutive threads, spread evenly over the groups */
+		g = grouped ? (unsigned int)(((uint64_t)i * num_groups) / tp->num_threads) : 0;
+		if (g != last_g) {
+			first = i;
+			last_g = g;
+		}
+
+		if (pinned) {
+			cpu = pl->cpus[group_start[g] + (i - first) % group_len[g]];
+			CPU_SET(cpu, set);
+			t->cpu = (int)cpu;
+		} else {
+			for (j = 0; j < group_len[g]; j++)
+				CPU_SET(pl->cpus[group_start[g] + j], set);
+			t->cpu = -1;
+		}
+
+		t->node = fy_thread_set_node(set, pl->cpu_node);
+		if (tp->nodep && t->node >= 0)
+			tp->nodep[(size_t)t->node * num_threads_words + i / 64] |= FY_BIT64(i & 63);
+	}
+}
+
+#endif
+
 int fy_thread_pool_setup(struct fy_thread_pool *tp, const struct fy_thread_pool_cfg *cfg)
 {
 	struct fy_thread *t;
-	unsigned int i, num_threads, num_threads_words;
-	size_t size, free_offset, loot_offset, thread_bitmask_size;
+	unsigned int i, num_threads, num_threads_words, num_cpus;
+	size_t size, free_offset, loot_offset, deques_offset, nodes_offset, thread_bitmask_size;
 	void *(*start_routine)(void *);
 	long scval;
 	int rc __FY_DEBUG_UNUSED__;
+#if defined(__linux__)
+	struct fy_thread_placement *pl = NULL;
+	cpu_set_t allowed;
+#endif
 
 	assert(tp);
 
@@ -437,15 +848,58 @@ int fy_thread_pool_setup(struct fy_thread_pool *tp, const struct fy_thread_pool_
 	} else
 		tp->cfg = *cfg;
 
-	if (!tp->cfg.num_threads) {
-		scval = sysconf(_SC_NPROCESSORS_ONLN);
-		assert(scval > 0);
-		num_threads = (unsigned int)scval;
-	} else
+	/* keep our own copy of the CPU mask */
+	if (tp->cfg.cpu_mask) {
+		size = FY_BIT64_SIZE(tp->cfg.cpu_mask_bits);
+		tp->cpu_mask = malloc(size ? size : sizeof(uint64_t));
+		if (!tp->cpu_mask)
+			goto err_out;
+		memcpy(tp->cpu_mask, tp->cfg.cpu_mask, size);
+		tp->cfg.cpu_mask = tp->cpu_mask;
+	}
+
+	scval = sysconf(_SC_NPROCESSORS_ONLN);
+	assert(scval > 0);
+	num_cpus = (unsigned int)scval;
+
+#if defined(__linux__)
+	/* placing the threads, the CPUs are the allowed ones */
+	if (tp->cfg.cpu_mask || (tp->cfg.flags & (FYTPCF_PIN_THREADS | FYTPCF_NUMA_GROUP))) {
+		if (fy_thread_allowed_cpus(&tp->cfg, num_cpus, &allowed))
+			goto err_out;
+		num_cpus = (unsigned int)CPU_COUNT(&allowed);
+	}
+#endif
+
+	if (!tp->cfg.num_threads)
+		num_threads = num_cpus;
+	else
 		num_threads = tp->cfg.num_threads;
 
 	tp->num_threads = num_threads;
 
+#if defined(__linux__)
+	if (tp->cfg.cpu_mask || (tp->cfg.flags & (FYTPCF_PIN_THREADS | FYTPCF_NUMA_GROUP))) {
+		pl = malloc(sizeof(*pl) + sizeof(pl->sets[0]) * num_threads);
+		if (!pl)
+			goto err_out;
+		pl->allowed = allowed;
+		tp->num_nodes = fy_thread_cpu_nodes(pl->cpu_node);
+	}
+#endif
+
+	/*
+	 * Spinning only pays when the waker can run at the same time,
+	 * and hardly when the pool oversubscribes the CPUs.
+	 */
+	if (num_cpus < 2)
+		tp->spin_max = 0;
+	else if (num_threads > num_cpus)
+		tp->spin_max = FY_THREAD_SPIN_MIN;
+	else
+		tp->spin_max = FY_THREAD_SPIN_MAX;
+	atomic_store(&tp->join_spin, tp->spin_max ? FY_THREAD_SPIN_MIN : 0);
+
 	num_threads_words = FY_BIT64_COUNT(tp->num_threads);
 	thread_bitmask_size = FY_BIT64_SIZE(tp->num_threads);
 
@@ -460,6 +914,16 @@ int fy_thread_pool_setup(struct fy_thread_pool *tp, const struct fy_thread_pool_
 	loot_offset = size;
 	size = FY_CACHELINE_SIZE_ALIGN(size + thread_bitmask_size);
 
+	/* the work deques, one per thread plus the inject deque */
+	deques_offset = size;
+	if (tp->cfg.flags & FYTPCF_DEQUE_MODE)
+		size = FY_CACHELINE_SIZE_ALIGN(size + sizeof(*tp->deques) * (tp->num_threads + 1));
+
+	/* the thread bitmasks of each node, only when there's more than one */
+	nodes_offset = size;
+	if (tp->num_nodes > 1)
+		size = FY_CACHELINE_SIZE_ALIGN(size + thread_bitmask_size * tp->num_nodes);
+
 	/* allocate everything in one go */
 	tp->threads = fy_cacheline_alloc(size);
 	if (!tp->threads)
@@ -480,27 +944,72 @@ int fy_thread_pool_setup(struct fy_thread_pool *tp, const struct fy_thread_pool_
 
 	/* the lootp's are zero */
 
+	if (tp->num_nodes > 1)
+		tp->nodep = (void *)tp->threads + nodes_offset;
+
+	if (tp->cfg.flags & FYTPCF_DEQUE_MODE) {
+		/* the deques are empty (top == bottom == 0) */
+		tp->deques = (void *)tp->threads + deques_offset;
+		tp->inject = tp->deques + tp->num_threads;
+
+		pthread_mutex_init(&tp->inject_lock, NULL);
+#if !(defined(__linux__) && !defined(FY_THREAD_PORTABLE))
+		pthread_mutex_init(&tp->park_lock, NULL);
+		pthread_cond_init(&tp->park_cond, NULL);
+#endif
+	}
+
 	for (i = 0, t = tp->threads; i < tp->num_threads; i++, t++) {
 
 		t->tp = tp;
 		t->id = i;
+		t->cpu = -1;
+		t->node = -1;
+		if (tp->deques)
+			t->dq = tp->deques + i;
+		atomic_store(&t->spin, tp->spin_max ? FY_THREAD_SPIN_MIN : 0);
+		atomic_store(&t->wait_spin, tp->spin_max ? FY_THREAD_SPIN_MIN : 0);
 
 		fy_thread_init_sync(t);
 	}
 
-	start_routine = !(tp->cfg.flags & FYTPCF_STEAL_MODE) ?
-				fy_worker_thread_standard :
-				fy_worker_thread_steal;
+#if defined(__linux__)
+	if (pl)
+		fy_thread_pool_place(tp, pl);
+#endif
+
+	if (tp->cfg.flags & FYTPCF_DEQUE_MODE)
+		start_routine = fy_worker_thread_deque;
+	else if (tp->cfg.flags & FYTPCF_STEAL_MODE)
+		start_routine = fy_worker_thread_steal;
+	else
+		start_routine = fy_worker_thread_standard;
 
 	for (i = 0, t = tp->threads; i < tp->num_threads; i++, t++) {
 		rc = pthread_create(&t->tid, NULL, start_routine, t);
 		if (rc)
 			goto err_out;
+#if defined(__linux__)
+		if (pl) {
+			rc = pthread_setaffinity_np(t->tid, sizeof(pl->sets[i]), &pl->sets[i]);
+			if (rc)
+				goto err_out;
+		}
+#endif
 	}
 
+#if defined(__linux__)
+	if (pl)
+		free(pl);
+#endif
+
 	return 0;
 
 err_out:
+#if defined(__linux__)
+	if (pl)
+		free(pl);
+#endif
 	fy_thread_pool_cleanup(tp);
 	return -1;
 }
@@ -547,17 +1056,135 @@ const struct fy_thread_pool_cfg *fy_thread_pool_get_cfg(struct fy_thread_pool *t
 	return &tp->cfg;
 }
 
-void fy_thread_work_join(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn)
+int fy_thread_pool_get_thread_cpu(struct fy_thread_pool *tp, unsigned int id)
+{
+	if (!tp || id >= tp->num_threads)
+		return -1;
+
+	return tp->threads[id].cpu;
+}
+
+int fy_thread_pool_get_thread_node(struct fy_thread_pool *tp, unsigned int id)
+{
+	if (!tp || id >= tp->num_threads)
+		return -1;
+
+	return tp->threads[id].node;
+}
+
+int fy_thread_pool_mem_node(struct fy_thread_pool *tp, const void *addr)
+{
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+	int node;
+
+	/* no point without threads on different nodes */
+	if (!tp || !tp->nodep || !addr)
+		return -1;
+
+	/* the node the page at addr is on */
+	node = -1;
+	if (syscall(SYS_get_mempolicy, &node, NULL, 0, addr, FY_MPOL_F_NODE | FY_MPOL_F_ADDR))
+		return -1;
+
+	return node;
+#else
+	(void)tp;
+	(void)addr;
+	return -1;
+#endif
+}
+
+static void fy_thread_stats_read(struct fy_thread_stats_atomic *sa, struct fy_thread_stats *s)
+{
+	s->jobs = atomic_load_explicit(&sa->jobs, memory_order_relaxed);
+	s->steals = atomic_load_explicit(&sa->steals, memory_order_relaxed);
+	s->spins = atomic_load_explicit(&sa->spins, memory_order_relaxed);
+	s->spin_hits = atomic_load_explicit(&sa->spin_hits, memory_order_relaxed);
+	s->parks = atomic_load_explicit(&sa->parks, memory_order_relaxed);
+	s->wakes = atomic_load_explicit(&sa->wakes, memory_order_relaxed);
+	s->wake_latency_ns = atomic_load_explicit(&sa->wake_latency_ns, memory_order_relaxed);
+	s->wake_latency_max_ns = atomic_load_explicit(&sa->wake_latency_max_ns, memory_order_relaxed);
+}
+
+static void fy_thread_stats_clear(struct fy_thread_stats_atomic *sa)
+{
+	/* the threads may be running, so no memset */
+	atomic_store_explicit(&sa->jobs, 0, memory_order_relaxed);
+	atomic_store_explicit(&sa->steals, 0, memory_order_relaxed);
+	atomic_store_explicit(&sa->spins, 0, memory_order_relaxed);
+	atomic_store_explicit(&sa->spin_hits, 0, memory_order_relaxed);
+	atomic_store_explicit(&sa->parks, 0, memory_order_relaxed);
+	atomic_store_explicit(&sa->wakes, 0, memory_order_relaxed);
+	atomic_store_explicit(&sa->wake_latency_ns, 0, memory_order_relaxed);
+	atomic_store_explicit(&sa->wake_latency_max_ns, 0, memory_order_relaxed);
+}
+
+static void fy_thread_stats_accumulate(struct fy_thread_stats *total, const struct fy_thread_stats *s)
+{
+	total->jobs += s->jobs;
+	total->steals += s->steals;
+	total->spins += s->spins;
+	total->spin_hits += s->spin_hits;
+	total->parks += s->parks;
+	total->wakes += s->wakes;
+	total->wake_latency_ns += s->wake_latency_ns;
+	if (s->wake_latency_max_ns > total->wake_latency_max_ns)
+		total->wake_latency_max_ns = s->wake_latency_max_ns;
+}
+
+int fy_thread_pool_get_stats(struct fy_thread_pool *tp, struct fy_thread_stats *total, struct fy_thread_stats *threads)
+{
+	struct fy_thread_stats s;
+	unsigned int i;
+
+	if (!tp)
+		return -1;
+
+	/* the total starts from the threads outside the pool */
+	if (total)
+		fy_thread_stats_read(&tp->ext_stats, total);
+
+	for (i = 0; i < tp->num_threads; i++) {
+		fy_thread_stats_read(&tp->threads[i].stats, &s);
+		if (threads)
+			threads[i] = s;
+		if (total)
+			fy_thread_stats_accumulate(total, &s);
+	}
+
+	return 0;
+}
+
+void fy_thread_pool_reset_stats(struct fy_thread_pool *tp)
+{
+	unsigned int i;
+
+	if (!tp)
+		return;
+
+	fy_thread_stats_clear(&tp->ext_stats);
+	for (i = 0; i < tp->num_threads; i++)
+		fy_thread_stats_clear(&tp->threads[i].stats);
+}
+
+void fy_thread_work_join_node(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn, int node)
 {
-	if (!(tp->cfg.flags & FYTPCF_STEAL_MODE))
-		fy_thread_work_join_standard(tp, works, work_count, check_fn);
+	if (tp && (tp->cfg.flags & FYTPCF_DEQUE_MODE))
+		fy_thread_work_join_deque(tp, works, work_count, check_fn);
+	else if (!tp || !(tp->cfg.flags & FYTPCF_STEAL_MODE))
+		fy_thread_work_join_standard(tp, works, work_count, check_fn, node);
 	else if (work_count == 2)
-		fy_thread_work_join_steal_2(tp, works, check_fn);
+		fy_thread_work_join_steal_2(tp, works, check_fn, node);
 	else
-		fy_thread_work_join_steal(tp, works, work_count, check_fn);
+		fy_thread_work_join_steal(tp, works, work_count, check_fn, node);
 }
 
-void fy_thread_args_join(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_work_check_fn check_fn, void **args, size_t count)
+void fy_thread_work_join(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn)
+{
+	fy_thread_work_join_node(tp, works, work_count, check_fn, -1);
+}
+
+void fy_thread_args_join_node(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_work_check_fn check_fn, void **args, size_t count, int node)
 {
 	struct fy_thread_work *works;
 	size_t i;
@@ -572,10 +1199,15 @@ void fy_thread_args_join(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_work_
 		works[i].arg = args ? args[i] : NULL;
 	}
 
-	fy_thread_work_join(tp, works, count, check_fn);
+	fy_thread_work_join_node(tp, works, count, check_fn, node);
 }
 
-void fy_thread_arg_array_join(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_work_check_fn check_fn, void *args, size_t argsize, size_t count)
+void fy_thread_args_join(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_work_check_fn check_fn, void **args, size_t count)
+{
+	fy_thread_args_join_node(tp, fn, check_fn, args, count, -1);
+}
+
+void fy_thread_arg_array_join_node(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_work_check_fn check_fn, void *args, size_t argsize, size_t count, int node)
 {
 	struct fy_thread_work *works;
 	size_t i;
@@ -591,7 +1223,12 @@ void fy_thread_arg_array_join(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_
 		args += argsize;
 	}
 
-	fy_thread_work_join(tp, works, count, check_fn);
+	fy_thread_work_join_node(tp, works, count, check_fn, node);
+}
+
+void fy_thread_arg_array_join(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_work_check_fn check_fn, void *args, size_t argsize, size_t count)
+{
+	fy_thread_arg_array_join_node(tp, fn, check_fn, args, argsize, count, -1);
 }
 
 void fy_thread_arg_join(struct fy_thread_pool *tp, fy_work_exec_fn fn, fy_work_check_fn check_fn, void *arg, size_t count)
@@ -628,13 +1265,14 @@ static void *fy_worker_thread_standard(void *arg)
 
 	while ((work = fy_worker_wait_for_work(t)) != WORK_SHUTDOWN) {
 		work->fn(work->arg);
+		fy_thread_stat_add(&t->stats.jobs, 1);
 		fy_worker_signal_work_done(t, work);
 	}
 
 	return NULL;
 }
 
-static void fy_thread_work_join_standard(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn)
+static void fy_thread_work_join_standard(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn, int node)
 {
 	struct fy_thread_work **direct_work, **thread_work, *w;
 	struct fy_thread **threads, *t;
@@ -660,7 +1298,7 @@ static void fy_thread_work_join_standard(struct fy_thread_pool *tp, struct fy_th
 
 		t = NULL;
 		if (!check_fn || check_fn(w->arg))
-			t = fy_thread_reserve_internal(tp);
+			t = fy_thread_reserve_internal_node(tp, node);
 
 		if (t) {
 			threads[thread_work_count] = t;
@@ -781,13 +1419,32 @@ static inline bool fy_work_pool_signal(struct fy_work_pool *wp)
 	return false;
 }
 
-static inline void fy_work_pool_wait(struct fy_work_pool *wp)
+static inline void fy_work_pool_wait(struct fy_thread_pool *tp, struct fy_work_pool *wp)
 {
+	struct fy_thread_stats_atomic *st;
+	unsigned int i, limit;
 	int rc __FY_DEBUG_UNUSED__;
 
-	if (!wp)
+	if (!wp || !atomic_load(&wp->work_left))
 		return;
 
+	st = fy_thread_pool_current_stats(tp);
+
+	/* spin for a while, the remaining work might be about to complete */
+	limit = fy_thread_spin_limit(&tp->join_spin);
+	for (i = 0; i < limit; i++) {
+		if (!atomic_load_explicit(&wp->work_left, memory_order_acquire))
+			break;
+		fy_cpu_relax();
+	}
+	fy_thread_stat_add(&st->spins, i);
+	fy_thread_spin_adapt(tp, &tp->join_spin, i < limit);
+	if (i < limit) {
+		fy_thread_stat_add(&st->spin_hits, 1);
+		return;
+	}
+	fy_thread_stat_add(&st->parks, 1);
+
 	/* if there's any work left, wait for it */
 	while (atomic_load(&wp->work_left) > 0) {
 #if defined(__linux__) && !defined(FY_THREAD_PORTABLE)
@@ -811,6 +1468,7 @@ static inline void fy_worker_thread_steal_execute(struct fy_thread *t, struct fy
 	wp = w->wp;
 	assert(wp);
 	w->fn(w->arg);
+	fy_thread_stat_add(&t->stats.jobs, 1);
 	TDBG("%s: T#%u worker executed W:%p\n", __func__, t->id, w);
 
 	signalled = fy_work_pool_signal(wp);
@@ -845,8 +1503,10 @@ static inline struct fy_thread_work *fy_worker_thread_steal_work(struct fy_threa
 				t = tp->threads + slot;
 				if ((w = atomic_load(&t->next_work)) != NULL) {
 					w_exp = w;
-					if (atomic_compare_exchange_strong(&t->next_work, &w_exp, NULL))
+					if (atomic_compare_exchange_strong(&t->next_work, &w_exp, NULL)) {
+						fy_thread_stat_add(&t_thief->stats.steals, 1);
 						return w;
+					}
 				}
 			}
 			v = exp;
@@ -905,7 +1565,7 @@ static void *fy_worker_thread_steal(void *arg)
 	return NULL;
 }
 
-static void fy_thread_work_join_steal(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn)
+static void fy_thread_work_join_steal(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn, int node)
 {
 	struct fy_work_pool wp_local, *wp;
 	struct fy_thread_work *dw, *expw;
@@ -944,7 +1604,7 @@ static void fy_thread_work_join_steal(struct fy_thread_pool *tp, struct fy_threa
 
 		has_loot = false;
 		if (work_count > 0 && (!check_fn || check_fn(works->arg))) {
-			while (work_count > 0 && (tw = fy_thread_reserve_internal(tp)) != NULL) {
+			while (work_count > 0 && (tw = fy_thread_reserve_internal_node(tp, node)) != NULL) {
 
 				assert(!works->wp);
 
@@ -1033,13 +1693,13 @@ static void fy_thread_work_join_steal(struct fy_thread_pool *tp, struct fy_threa
 
 	TDBG("%s: T#%d wait WP:%p\n", __func__, tid, wp);
 
-	fy_work_pool_wait(wp);
+	fy_work_pool_wait(tp, wp);
 	fy_work_pool_cleanup(wp);
 
 	TDBG("%s: T#%d done WP:%p\n", __func__, tid, wp);
 }
 
-static void fy_thread_work_join_steal_2(struct fy_thread_pool *tp, struct fy_thread_work works[2], fy_work_check_fn check_fn)
+static void fy_thread_work_join_steal_2(struct fy_thread_pool *tp, struct fy_thread_work works[2], fy_work_check_fn check_fn, int node)
 {
 	struct fy_work_pool wp_local, *wp;
 	struct fy_thread_work *expw;
@@ -1069,7 +1729,7 @@ static void fy_thread_work_join_steal_2(struct fy_thread_pool *tp, struct fy_thr
 	pushed = false;
 	has_loot = false;
 	if (!check_fn || check_fn(works->arg)) {
-		if ((tw = fy_thread_reserve_internal(tp)) != NULL) {
+		if ((tw = fy_thread_reserve_internal_node(tp, node)) != NULL) {
 
 			assert(!works[1].wp);
 
@@ -1149,8 +1809,387 @@ static void fy_thread_work_join_steal_2(struct fy_thread_pool *tp, struct fy_thr
 
 	TDBG("%s: T#%d wait WP:%p\n", __func__, tid, wp);
 
-	fy_work_pool_wait(wp);
+	fy_work_pool_wait(tp, wp);
 	fy_work_pool_cleanup(wp);
 
 	TDBG("%s: T#%d done WP:%p\n", __func__, tid, wp);
 }
+
+/*
+ * the work stealing deque implementation
+ *
+ * Every worker owns a Chase-Lev deque; spawned work is pushed at the
+ * bottom of the spawning worker's deque and popped back LIFO, while
+ * idle workers steal the oldest (and usually biggest) work from the
+ * top of a randomly selected victim. Work spawned by threads outside
+ * the pool goes to the inject deque, which is only ever stolen from.
+ *
+ * The spawned work is accounted in the frame of the work that spawned
+ * it (or in a per thread root frame for outside threads), and syncing
+ * executes other work while waiting for the frame to drain.
+ */
+
+/* the frame of the currently executing work */
+static __thread struct fy_work_pool *fy_work_frame;
+/* the frame of threads outside of any pool */
+static __thread struct fy_work_pool fy_work_frame_root;
+/* victim selection state */
+static __thread uint32_t fy_thread_rng;
+
+static inline int fy_work_deque_push(struct fy_work_deque *dq, struct fy_thread_work *w)
+{
+	int64_t b, t;
+
+	b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+	t = atomic_load_explicit(&dq->top, memory_order_acquire);
+	if (b - t >= FY_WORK_DEQUE_SIZE)
+		return -1;
+
+	/* publishes the work (and its contents) to the thieves */
+	atomic_store_explicit(&dq->buf[b & (FY_WORK_DEQUE_SIZE - 1)], w, memory_order_relaxed);
+	atomic_store_explicit(&dq->bottom, b + 1, memory_order_release);
+
+	return 0;
+}
+
+static inline struct fy_thread_work *fy_work_deque_pop(struct fy_work_deque *dq)
+{
+	struct fy_thread_work *w;
+	int64_t b, t;
+
+	b = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+
+	/* empty */
+	if (t > b) {
+		atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+		return NULL;
+	}
+
+	w = atomic_load_explicit(&dq->buf[b & (FY_WORK_DEQUE_SIZE - 1)], memory_order_relaxed);
+	if (t == b) {
+		/* the last one, race against the thieves */
+		if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+					memory_order_seq_cst, memory_order_relaxed))
+			w = NULL;
+		atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+	}
+
+	return w;
+}
+
+static inline struct fy_thread_work *fy_work_deque_steal(struct fy_work_deque *dq)
+{
+	struct fy_thread_work *w;
+	int64_t b, t;
+
+	t = atomic_load_explicit(&dq->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+	if (t >= b)
+		return NULL;
+
+	w = atomic_load_explicit(&dq->buf[t & (FY_WORK_DEQUE_SIZE - 1)], memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+				memory_order_seq_cst, memory_order_relaxed))
+		return NULL;
+
+	return w;
+}
+
+static inline uint32_t fy_thread_rand(void)
+{
+	uint32_t x;
+
+	/* xorshift32, seeded by the (per thread) address of the state */
+	x = fy_thread_rng;
+	if (!x)
+		x = (uint32_t)(uintptr_t)&fy_thread_rng | 1;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	fy_thread_rng = x;
+
+	return x;
+}
+
+static struct fy_thread_work *fy_thread_deque_find_work(struct fy_thread_pool *tp, struct fy_thread *t)
+{
+	struct fy_work_deque *dq;
+	struct fy_thread_work *w;
+	const uint64_t *mask;
+	unsigned int i, n, idx;
+
+	/* own work first, newest first */
+	if (t && (w = fy_work_deque_pop(t->dq)) != NULL)
+		return w;
+
+	/* then the threads of the same node, their work is cache/memory local */
+	if (t && t->node >= 0 && tp->nodep) {
+		mask = tp->nodep + (size_t)t->node * FY_BIT64_COUNT(tp->num_threads);
+		n = tp->num_threads;
+		idx = fy_thread_rand() % n;
+		for (i = 0; i < n; i++, idx = idx + 1 < n ? idx + 1 : 0) {
+			if (idx == t->id || !(mask[idx / 64] & FY_BIT64(idx & 63)))
+				continue;
+			w = fy_work_deque_steal(tp->deques + idx);
+			if (w) {
+				fy_thread_stat_add(&t->stats.steals, 1);
+				return w;
+			}
+		}
+	}
+
+	/* steal, starting from a random victim; the inject deque is the last */
+	n = tp->num_threads + 1;
+	idx = fy_thread_rand() % n;
+	for (i = 0; i < n; i++, idx = idx + 1 < n ? idx + 1 : 0) {
+		dq = tp->deques + idx;
+		if (t && dq == t->dq)
+			continue;
+		w = fy_work_deque_steal(dq);
+		if (w) {
+			fy_thread_stat_add(t ? &t->stats.steals : &tp->ext_stats.steals, 1);
+			return w;
+		}
+	}
+
+	return NULL;
+}
+
+static inline void fy_thread_deque_signal(struct fy_thread_pool *tp, struct fy_work_pool *wp)
+{
+	/* the frame may go away as soon as it drains, do not touch it afterwards */
+	if (atomic_fetch_sub(&wp->work_left, 1) == 1 &&
+	    atomic_load(&tp->sync_sleepers) > 0)
+		fy_thread_pool_wake(tp, &tp->sync_seq, true);
+}
+
+static void fy_thread_deque_sync(struct fy_thread_pool *tp, struct fy_work_pool *wp);
+
+static void fy_thread_deque_execute(struct fy_thread_pool *tp, struct fy_thread *t, struct fy_thread_work *w)
+{
+	struct fy_work_pool frame, *wp, *parent;
+
+	wp = w->wp;
+	assert(wp);
+
+	parent = fy_work_frame;
+	atomic_store(&frame.work_left, 0);
+	fy_work_frame = &frame;
+
+	w->fn(w->arg);
+	fy_thread_stat_add(t ? &t->stats.jobs : &tp->ext_stats.jobs, 1);
+
+	/* implicit sync of everything spawned by this work */
+	fy_thread_deque_sync(tp, &frame);
+	fy_work_frame = parent;
+
+	fy_thread_deque_signal(tp, wp);
+}
+
+static void fy_thread_deque_spawn(struct fy_thread_pool *tp, struct fy_work_pool *wp, struct fy_thread_work *w)
+{
+	struct fy_thread *t;
+	int rc;
+
+	w->wp = wp;
+	atomic_fetch_add(&wp->work_left, 1);
+
+	t = pthread_getspecific(tp->key);
+	if (t)
+		rc = fy_work_deque_push(t->dq, w);
+	else {
+		pthread_mutex_lock(&tp->inject_lock);
+		rc = fy_work_deque_push(tp->inject, w);
+		pthread_mutex_unlock(&tp->inject_lock);
+	}
+
+	/* the deque is full, execute directly */
+	if (rc) {
+		fy_thread_deque_execute(tp, t, w);
+		return;
+	}
+
+	/* pairs with the sleepers increase of a parking worker */
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&tp->sleepers, memory_order_relaxed) > 0) {
+		atomic_store(&tp->wake_ns, fy_thread_now_ns());
+		fy_thread_pool_wake(tp, &tp->wake_seq, false);
+	}
+}
+
+static void fy_thread_deque_sync(struct fy_thread_pool *tp, struct fy_work_pool *wp)
+{
+	struct fy_thread_stats_atomic *st;
+	struct fy_thread *t;
+	struct fy_thread_work *w;
+	unsigned int spin;
+	uint32_t seq;
+
+	if (!atomic_load(&wp->work_left))
+		return;
+
+	t = pthread_getspecific(tp->key);
+	st = t ? &t->stats : &tp->ext_stats;
+	spin = 0;
+	while (atomic_load(&wp->work_left) > 0) {
+
+		/* help while waiting */
+		w = fy_thread_deque_find_work(tp, t);
+		if (w) {
+			if (spin) {
+				fy_thread_stat_add(&st->spins, spin);
+				fy_thread_stat_add(&st->spin_hits, 1);
+				fy_thread_spin_adapt(tp, &tp->join_spin, true);
+				spin = 0;
+			}
+			fy_thread_deque_execute(tp, t, w);
+			continue;
+		}
+
+		if (spin < fy_thread_spin_limit(&tp->join_spin)) {
+			spin++;
+			fy_cpu_relax();
+			continue;
+		}
+		fy_thread_stat_add(&st->spins, spin);
+		fy_thread_spin_adapt(tp, &tp->join_spin, false);
+		spin = 0;
+
+		/* nothing to do, the remaining work is executing elsewhere */
+		fy_thread_stat_add(&st->parks, 1);
+		seq = atomic_load(&tp->sync_seq);
+		atomic_fetch_add(&tp->sync_sleepers, 1);
+		if (atomic_load(&wp->work_left) > 0)
+			fy_thread_pool_park(tp, &tp->sync_seq, seq);
+		atomic_fetch_sub(&tp->sync_sleepers, 1);
+	}
+}
+
+static void *fy_worker_thread_deque(void *arg)
+{
+	struct fy_thread *t = arg;
+	struct fy_thread_pool *tp;
+	struct fy_thread_work *w;
+	unsigned int spin;
+	uint64_t park_ns, wake_ns;
+	uint32_t seq;
+
+	tp = t->tp;
+
+	/* store per thread info */
+	pthread_setspecific(tp->key, t);
+
+	TDBG("%s: T#%u in deque mode\n", __func__, t->id);
+
+	spin = 0;
+	while (!atomic_load(&tp->shutdown)) {
+
+		w = fy_thread_deque_find_work(tp, t);
+		if (w) {
+			if (spin) {
+				fy_thread_stat_add(&t->stats.spins, spin);
+				fy_thread_stat_add(&t->stats.spin_hits, 1);
+				fy_thread_spin_adapt(tp, &t->spin, true);
+				spin = 0;
+			}
+			fy_thread_deque_execute(tp, t, w);
+			continue;
+		}
+
+		if (spin < fy_thread_spin_limit(&t->spin)) {
+			spin++;
+			fy_cpu_relax();
+			continue;
+		}
+		fy_thread_stat_add(&t->stats.spins, spin);
+		fy_thread_spin_adapt(tp, &t->spin, false);
+		spin = 0;
+
+		/* announce that we're going to sleep, then check again */
+		fy_thread_stat_add(&t->stats.parks, 1);
+		park_ns = fy_thread_now_ns();
+		seq = atomic_load(&tp->wake_seq);
+		atomic_fetch_add(&tp->sleepers, 1);
+		w = fy_thread_deque_find_work(tp, t);
+		if (!w && !atomic_load(&tp->shutdown)) {
+			fy_thread_pool_park(tp, &tp->wake_seq, seq);
+			wake_ns = atomic_load(&tp->wake_ns);
+			if (wake_ns > park_ns)
+				fy_thread_stat_wake(&t->stats, wake_ns);
+		}
+		atomic_fetch_sub(&tp->sleepers, 1);
+
+		if (w)
+			fy_thread_deque_execute(tp, t, w);
+	}
+
+	TDBG("%s: T#%u leaving deque mode\n", __func__, t->id);
+
+	return NULL;
+}
+
+static void fy_thread_work_join_deque(struct fy_thread_pool *tp, struct fy_thread_work *works, size_t work_count, fy_work_check_fn check_fn)
+{
+	struct fy_work_pool frame, *parent;
+	struct fy_thread_work *w;
+	bool *direct;
+	size_t i;
+
+	/* just a single (or no) work, or no threads? execute directly */
+	if (work_count <= 1 || !tp->num_threads) {
+		for (i = 0, w = works; i < work_count; i++, w++)
+			w->fn(w->arg);
+		return;
+	}
+
+	direct = alloca(work_count * sizeof(*direct));
+
+	parent = fy_work_frame;
+	atomic_store(&frame.work_left, 0);
+	fy_work_frame = &frame;
+
+	/* spawn in reverse, so that the first ones are popped back first */
+	for (i = work_count - 1; i > 0; i--) {
+		w = works + i;
+		direct[i] = check_fn && !check_fn(w->arg);
+		if (!direct[i])
+			fy_thread_deque_spawn(tp, &frame, w);
+	}
+
+	works[0].fn(works[0].arg);
+
+	for (i = 1; i < work_count; i++) {
+		if (direct[i])
+			works[i].fn(works[i].arg);
+	}
+
+	fy_thread_deque_sync(tp, &frame);
+	fy_work_frame = parent;
+}
+
+int fy_thread_spawn(struct fy_thread_pool *tp, struct fy_thread_work *work)
+{
+	if (!work || !work->fn)
+		return -1;
+
+	/* not in deque mode? execute directly */
+	if (!tp || !(tp->cfg.flags & FYTPCF_DEQUE_MODE) || !tp->num_threads) {
+		work->fn(work->arg);
+		return 0;
+	}
+
+	fy_thread_deque_spawn(tp, fy_work_frame ? fy_work_frame : &fy_work_frame_root, work);
+	return 0;
+}
+
+void fy_thread_sync(struct fy_thread_pool *tp)
+{
+	if (!tp || !(tp->cfg.flags & FYTPCF_DEQUE_MODE))
+		return;
+
+	fy_thread_deque_sync(tp, fy_work_frame ? fy_work_frame : &fy_work_frame_root);
+}
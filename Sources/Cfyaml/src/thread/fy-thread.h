@@ -43,12 +43,50 @@ struct fy_work_pool {
 #endif
 };
 
+/* number of entries of each work deque (must be a power of two) */
+#define FY_WORK_DEQUE_SIZE	1024
+
+/* bounds of the adaptive number of spins before parking */
+#define FY_THREAD_SPIN_MIN	16
+#define FY_THREAD_SPIN_MAX	4096
+
+/* maximum number of NUMA nodes considered for placement */
+#define FY_THREAD_MAX_NODES	64
+
+/* the statistics counters (see struct fy_thread_stats) */
+struct fy_thread_stats_atomic {
+	_Atomic(uint64_t) jobs;
+	_Atomic(uint64_t) steals;
+	_Atomic(uint64_t) spins;
+	_Atomic(uint64_t) spin_hits;
+	_Atomic(uint64_t) parks;
+	_Atomic(uint64_t) wakes;
+	_Atomic(uint64_t) wake_latency_ns;
+	_Atomic(uint64_t) wake_latency_max_ns;
+};
+
+/*
+ * Chase-Lev work stealing deque of fixed size.
+ * The owner pushes and pops at the bottom, thieves steal from the top.
+ */
+struct fy_work_deque {
+	_Atomic(int64_t) top FY_CACHELINE_ALIGN;
+	_Atomic(int64_t) bottom FY_CACHELINE_ALIGN;
+	_Atomic(struct fy_thread_work *) buf[FY_WORK_DEQUE_SIZE] FY_CACHELINE_ALIGN;
+};
+
 struct fy_thread {
 	struct fy_thread_pool *tp;
 	unsigned int id;
 	pthread_t tid;
+	int cpu;			/* the CPU pinned on, -1 if not pinned */
+	int node;			/* the NUMA node, -1 if not bound to one */
 	_Atomic(struct fy_thread_work *)work;
 	_Atomic(struct fy_thread_work *)next_work;
+	struct fy_work_deque *dq;	/* deque mode only */
+	_Atomic(unsigned int) spin;	/* adaptive spins waiting for work */
+	_Atomic(unsigned int) wait_spin;	/* adaptive spins waiting for the work to complete */
+	_Atomic(uint64_t) wake_ns;	/* when the parked thread was woken */
 #if defined(__linux__) && !defined(FY_THREAD_PORTABLE)
 	_Atomic(uint32_t) submit;
 	_Atomic(uint32_t) done;
@@ -58,6 +96,8 @@ struct fy_thread {
 	pthread_mutex_t wait_lock;
 	pthread_cond_t wait_cond;
 #endif
+	/* in a cache line of its own, it's updated all the time */
+	struct fy_thread_stats_atomic stats FY_CACHELINE_ALIGN;
 };
 
 struct fy_thread_pool {
@@ -67,6 +107,32 @@ struct fy_thread_pool {
 	_Atomic(uint64_t) *freep;
 	_Atomic(uint64_t) *lootp;
 	pthread_key_t key;
+
+	/* placement */
+	uint64_t *cpu_mask;		/* private copy of cfg.cpu_mask */
+	unsigned int num_nodes;		/* number of NUMA nodes (highest id + 1) */
+	uint64_t *nodep;		/* thread bitmask per node, NULL with a single node */
+
+	/* spinning, 0 when it doesn't pay off (i.e. a single CPU) */
+	unsigned int spin_max;
+	_Atomic(unsigned int) join_spin;	/* adaptive spins of joins and syncs */
+	/* statistics of the threads outside the pool */
+	struct fy_thread_stats_atomic ext_stats;
+
+	/* deque mode */
+	struct fy_work_deque *deques;	/* num_threads + 1, the last is the inject deque */
+	struct fy_work_deque *inject;	/* work spawned by threads outside the pool */
+	pthread_mutex_t inject_lock;
+	_Atomic(bool) shutdown;
+	_Atomic(unsigned int) sleepers;		/* idle workers parked */
+	_Atomic(unsigned int) sync_sleepers;	/* syncs parked */
+	_Atomic(uint32_t) wake_seq;
+	_Atomic(uint32_t) sync_seq;
+	_Atomic(uint64_t) wake_ns;	/* when the last idle worker wake was issued */
+#if !(defined(__linux__) && !defined(FY_THREAD_PORTABLE))
+	pthread_mutex_t park_lock;
+	pthread_cond_t park_cond;
+#endif
 };
 
 /* those are internal only */
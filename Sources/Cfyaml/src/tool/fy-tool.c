@@ -92,6 +92,7 @@
 #define OPT_STRIP_EMPTY_KV		2019
 #define OPT_DISABLE_MMAP		2020
 #define OPT_TSV_FORMAT			2021
+#define OPT_PARALLEL			2022
 
 #define OPT_DISABLE_DIAG		3000
 #define OPT_ENABLE_DIAG			3001
@@ -170,6 +171,7 @@ static struct option lopts[] = {
 	{"allow-duplicate-keys",no_argument,		0,	OPT_ALLOW_DUPLICATE_KEYS },
 	{"strip-empty-kv",	no_argument,		0,	OPT_STRIP_EMPTY_KV },
 	{"tsv-format",		no_argument,		0,	OPT_TSV_FORMAT },
+	{"parallel",		no_argument,		0,	OPT_PARALLEL },
 	{"to",			required_argument,	0,	'T' },
 	{"from",		required_argument,	0,	'F' },
 	{"quiet",		no_argument,		0,	'q' },
@@ -322,6 +324,7 @@ static void display_usage(FILE *fp, char *progname, int tool_mode)
 							FROM_DEFAULT);
 		fprintf(fp, "\t--dump-pathexpr          : Dump the path expresion before the results\n");
 		fprintf(fp, "\t--noexec                 : Do not execute the expression\n");
+		fprintf(fp, "\t--parallel               : Execute the expression in parallel (when possible)\n");
 	}
 
 	if (tool_mode == OPT_TOOL || tool_mode == OPT_COMPOSE) {
@@ -1430,7 +1433,7 @@ compose_process_event(struct fy_parser *fyp, struct fy_event *fye, struct fy_pat
 					fy_path_in_mapping_value(path) ? 'V' : '-',
 				fy_path_in_collection_root(path) ? '/' : '-',
 				fy_path_depth(path),
-				fy_path_get_text_alloca(path));
+				fy_path_get_text0(path));
 	}
 
 	switch (fye->type) {
@@ -1939,6 +1942,7 @@ int main(int argc, char *argv[])
 	struct fy_node *fyn_start;
 	bool dump_pathexpr = false;
 	bool noexec = false;
+	bool parallel = false;
 	bool null_output = false;
 	bool stdin_input;
 	void *res_iter;
@@ -2200,6 +2204,9 @@ int main(int argc, char *argv[])
 		case OPT_NOEXEC:
 			noexec = true;
 			break;
+		case OPT_PARALLEL:
+			parallel = true;
+			break;
 		case OPT_NULL_OUTPUT:
 			null_output = true;
 			break;
@@ -2795,6 +2802,8 @@ int main(int argc, char *argv[])
 
 		memset(&xcfg, 0, sizeof(xcfg));
 		xcfg.diag = diag;
+		if (parallel)
+			xcfg.flags |= FYPXCF_PARALLEL;
 
 		fypx = fy_path_exec_create(&xcfg);
 		if (!fypx) {
@@ -95,6 +95,8 @@ FORCE_INLINE void* XXH_memcpy(void* dest, const void* src, size_t size)
 {
     return memcpy(dest,src,size);
 }
+// for the XXH3 loop selection
+#include <stdatomic.h>
 
 //**************************************
 // Basic Types
@@ -1879,3 +1881,479 @@ void XXH256_digest (const XXH256_state_t* state_in, void* out)
     else
         return XXH256_digest_endian(state_in, XXH_bigEndian, (unsigned long long*)out);
 }
+
+
+//****************************
+// XXH3 (64 bits)
+//****************************
+// Output compatible with XXH3_64bits() and XXH3_64bits_withSeed() of xxHash v0.8.
+// Inputs of up to 240 bytes are handled by short scalar paths (the common case for keys),
+// longer inputs go through the stripe accumulation loop which is selected once at
+// runtime among the portable, SSE2 and AVX2 implementations.
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && \
+    defined(TARGET_HAS_SSE2) && !defined(FY_NO_BLAKE3)
+// the CPU feature probing is shared with the BLAKE3 backend selection
+#  define XXH3_DISPATCH_X86 1
+#  include <immintrin.h>
+#  include "blake3.h"
+#  if defined(TARGET_HAS_AVX2)
+#    define XXH3_DISPATCH_AVX2 1
+#  endif
+#endif
+
+#define PRIME_MX1 0x165667919E3779F9ULL
+#define PRIME_MX2 0x9FB21C651E98DF25ULL
+
+#define XXH3_SECRET_SIZE        192
+#define XXH3_SECRET_SIZE_MIN    136
+#define XXH3_STRIPE_LEN          64
+#define XXH3_SECRET_CONSUME_RATE  8
+#define XXH3_ACC_NB               8
+#define XXH3_MIDSIZE_MAX        240
+#define XXH3_MIDSIZE_STARTOFFSET  3
+#define XXH3_MIDSIZE_LASTOFFSET  17
+#define XXH3_SECRET_LASTACC_START 7
+#define XXH3_SECRET_MERGEACCS_START 11
+
+#if defined(__GNUC__)
+#  define XXH3_ALIGN(n) __attribute__((aligned(n)))
+#elif defined(_MSC_VER)
+#  define XXH3_ALIGN(n) __declspec(align(n))
+#else
+#  define XXH3_ALIGN(n)
+#endif
+
+XXH3_ALIGN(64) static const BYTE XXH3_kSecret[XXH3_SECRET_SIZE] =
+{
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+FORCE_INLINE U32 XXH3_readLE32(const void* ptr)
+{
+    U32 v;
+
+    memcpy(&v, ptr, sizeof(v));
+    return XXH_CPU_LITTLE_ENDIAN ? v : XXH_swap32(v);
+}
+
+FORCE_INLINE U64 XXH3_readLE64(const void* ptr)
+{
+    U64 v;
+
+    memcpy(&v, ptr, sizeof(v));
+    return XXH_CPU_LITTLE_ENDIAN ? v : XXH_swap64(v);
+}
+
+FORCE_INLINE void XXH3_writeLE64(void* ptr, U64 v)
+{
+    if (!XXH_CPU_LITTLE_ENDIAN)
+        v = XXH_swap64(v);
+    memcpy(ptr, &v, sizeof(v));
+}
+
+// 64x64 -> 128 bits multiply, folded back to 64 bits by xoring the halves
+FORCE_INLINE U64 XXH3_mul128_fold64(U64 lhs, U64 rhs)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t const product = (__uint128_t)lhs * rhs;
+
+    return (U64)product ^ (U64)(product >> 64);
+#else
+    U64 const lo_lo = (U64)(U32)lhs * (U32)rhs;
+    U64 const hi_lo = (lhs >> 32) * (U32)rhs;
+    U64 const lo_hi = (U64)(U32)lhs * (rhs >> 32);
+    U64 const hi_hi = (lhs >> 32) * (rhs >> 32);
+    U64 const cross = (lo_lo >> 32) + (U32)hi_lo + lo_hi;
+    U64 const upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    U64 const lower = (cross << 32) | (U32)lo_lo;
+
+    return lower ^ upper;
+#endif
+}
+
+FORCE_INLINE U64 XXH64_avalanche(U64 h64)
+{
+    h64 ^= h64 >> 33;
+    h64 *= PRIME64_2;
+    h64 ^= h64 >> 29;
+    h64 *= PRIME64_3;
+    h64 ^= h64 >> 32;
+    return h64;
+}
+
+FORCE_INLINE U64 XXH3_avalanche(U64 h64)
+{
+    h64 ^= h64 >> 37;
+    h64 *= PRIME_MX1;
+    h64 ^= h64 >> 32;
+    return h64;
+}
+
+FORCE_INLINE U64 XXH3_rrmxmx(U64 h64, U64 len)
+{
+    h64 ^= XXH_rotl64(h64, 49) ^ XXH_rotl64(h64, 24);
+    h64 *= PRIME_MX2;
+    h64 ^= (h64 >> 35) + len;
+    h64 *= PRIME_MX2;
+    return h64 ^ (h64 >> 28);
+}
+
+FORCE_INLINE U64 XXH3_len_1to3_64b(const BYTE* input, size_t len, const BYTE* secret, U64 seed)
+{
+    BYTE const c1 = input[0];
+    BYTE const c2 = input[len >> 1];
+    BYTE const c3 = input[len - 1];
+    U32 const combined = ((U32)c1 << 16) | ((U32)c2 << 24) | ((U32)c3 << 0) | ((U32)len << 8);
+    U64 const bitflip = (XXH3_readLE32(secret) ^ XXH3_readLE32(secret + 4)) + seed;
+
+    return XXH64_avalanche((U64)combined ^ bitflip);
+}
+
+FORCE_INLINE U64 XXH3_len_4to8_64b(const BYTE* input, size_t len, const BYTE* secret, U64 seed)
+{
+    U32 input1, input2;
+    U64 bitflip, input64;
+
+    seed ^= (U64)XXH_swap32((U32)seed) << 32;
+    input1 = XXH3_readLE32(input);
+    input2 = XXH3_readLE32(input + len - 4);
+    bitflip = (XXH3_readLE64(secret + 8) ^ XXH3_readLE64(secret + 16)) - seed;
+    input64 = input2 + ((U64)input1 << 32);
+
+    return XXH3_rrmxmx(input64 ^ bitflip, len);
+}
+
+FORCE_INLINE U64 XXH3_len_9to16_64b(const BYTE* input, size_t len, const BYTE* secret, U64 seed)
+{
+    U64 const bitflip1 = (XXH3_readLE64(secret + 24) ^ XXH3_readLE64(secret + 32)) + seed;
+    U64 const bitflip2 = (XXH3_readLE64(secret + 40) ^ XXH3_readLE64(secret + 48)) - seed;
+    U64 const input_lo = XXH3_readLE64(input) ^ bitflip1;
+    U64 const input_hi = XXH3_readLE64(input + len - 8) ^ bitflip2;
+    U64 const acc = len + XXH_swap64(input_lo) + input_hi + XXH3_mul128_fold64(input_lo, input_hi);
+
+    return XXH3_avalanche(acc);
+}
+
+FORCE_INLINE U64 XXH3_len_0to16_64b(const BYTE* input, size_t len, const BYTE* secret, U64 seed)
+{
+    if (len > 8)
+        return XXH3_len_9to16_64b(input, len, secret, seed);
+    if (len >= 4)
+        return XXH3_len_4to8_64b(input, len, secret, seed);
+    if (len)
+        return XXH3_len_1to3_64b(input, len, secret, seed);
+    return XXH64_avalanche(seed ^ (XXH3_readLE64(secret + 56) ^ XXH3_readLE64(secret + 64)));
+}
+
+FORCE_INLINE U64 XXH3_mix16B(const BYTE* input, const BYTE* secret, U64 seed)
+{
+    U64 const input_lo = XXH3_readLE64(input);
+    U64 const input_hi = XXH3_readLE64(input + 8);
+
+    return XXH3_mul128_fold64(input_lo ^ (XXH3_readLE64(secret) + seed),
+                              input_hi ^ (XXH3_readLE64(secret + 8) - seed));
+}
+
+FORCE_INLINE U64 XXH3_len_17to128_64b(const BYTE* input, size_t len, const BYTE* secret, U64 seed)
+{
+    U64 acc = len * PRIME64_1;
+
+    if (len > 32)
+    {
+        if (len > 64)
+        {
+            if (len > 96)
+            {
+                acc += XXH3_mix16B(input + 48, secret + 96, seed);
+                acc += XXH3_mix16B(input + len - 64, secret + 112, seed);
+            }
+            acc += XXH3_mix16B(input + 32, secret + 64, seed);
+            acc += XXH3_mix16B(input + len - 48, secret + 80, seed);
+        }
+        acc += XXH3_mix16B(input + 16, secret + 32, seed);
+        acc += XXH3_mix16B(input + len - 32, secret + 48, seed);
+    }
+    acc += XXH3_mix16B(input, secret, seed);
+    acc += XXH3_mix16B(input + len - 16, secret + 16, seed);
+
+    return XXH3_avalanche(acc);
+}
+
+static U64 XXH3_len_129to240_64b(const BYTE* input, size_t len, const BYTE* secret, U64 seed)
+{
+    U64 acc = len * PRIME64_1;
+    U64 acc_end;
+    unsigned int const nbRounds = (unsigned int)len / 16;
+    unsigned int i;
+
+    for (i = 0; i < 8; i++)
+        acc += XXH3_mix16B(input + (16 * i), secret + (16 * i), seed);
+    acc_end = XXH3_mix16B(input + len - 16, secret + XXH3_SECRET_SIZE_MIN - XXH3_MIDSIZE_LASTOFFSET, seed);
+    acc = XXH3_avalanche(acc);
+    for (i = 8; i < nbRounds; i++)
+        acc_end += XXH3_mix16B(input + (16 * i), secret + (16 * (i - 8)) + XXH3_MIDSIZE_STARTOFFSET, seed);
+
+    return XXH3_avalanche(acc + acc_end);
+}
+
+// the long input loop; accumulate_512 and scramble are the only parts that differ per instruction set
+typedef void (*XXH3_accumulate_512_f)(U64* acc, const BYTE* input, const BYTE* secret);
+typedef void (*XXH3_scramble_f)(U64* acc, const BYTE* secret);
+typedef void (*XXH3_hashLong_loop_f)(U64* acc, const BYTE* input, size_t len, const BYTE* secret);
+
+FORCE_INLINE void XXH3_hashLong_loop_internal(U64* acc, const BYTE* input, size_t len, const BYTE* secret,
+                                              XXH3_accumulate_512_f accumulate_512, XXH3_scramble_f scramble)
+{
+    size_t const nbStripesPerBlock = (XXH3_SECRET_SIZE - XXH3_STRIPE_LEN) / XXH3_SECRET_CONSUME_RATE;
+    size_t const block_len = XXH3_STRIPE_LEN * nbStripesPerBlock;
+    size_t const nb_blocks = (len - 1) / block_len;
+    size_t n, s, nbStripes;
+    const BYTE* p;
+
+    for (n = 0; n < nb_blocks; n++)
+    {
+        p = input + n * block_len;
+        for (s = 0; s < nbStripesPerBlock; s++)
+            accumulate_512(acc, p + s * XXH3_STRIPE_LEN, secret + s * XXH3_SECRET_CONSUME_RATE);
+        scramble(acc, secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+    }
+
+    // last partial block
+    nbStripes = ((len - 1) - (block_len * nb_blocks)) / XXH3_STRIPE_LEN;
+    p = input + nb_blocks * block_len;
+    for (s = 0; s < nbStripes; s++)
+        accumulate_512(acc, p + s * XXH3_STRIPE_LEN, secret + s * XXH3_SECRET_CONSUME_RATE);
+
+    // last stripe
+    accumulate_512(acc, input + len - XXH3_STRIPE_LEN,
+                   secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN - XXH3_SECRET_LASTACC_START);
+}
+
+FORCE_INLINE void XXH3_accumulate_512_scalar(U64* acc, const BYTE* input, const BYTE* secret)
+{
+    size_t i;
+    U64 data_val, data_key;
+
+    for (i = 0; i < XXH3_ACC_NB; i++)
+    {
+        data_val = XXH3_readLE64(input + 8 * i);
+        data_key = data_val ^ XXH3_readLE64(secret + 8 * i);
+        acc[i ^ 1] += data_val;
+        acc[i] += (U32)data_key * (data_key >> 32);
+    }
+}
+
+FORCE_INLINE void XXH3_scramble_scalar(U64* acc, const BYTE* secret)
+{
+    size_t i;
+    U64 acc64;
+
+    for (i = 0; i < XXH3_ACC_NB; i++)
+    {
+        acc64 = acc[i];
+        acc64 ^= acc64 >> 47;
+        acc64 ^= XXH3_readLE64(secret + 8 * i);
+        acc64 *= PRIME32_1;
+        acc[i] = acc64;
+    }
+}
+
+static void XXH3_hashLong_loop_scalar(U64* acc, const BYTE* input, size_t len, const BYTE* secret)
+{
+    XXH3_hashLong_loop_internal(acc, input, len, secret,
+                                XXH3_accumulate_512_scalar, XXH3_scramble_scalar);
+}
+
+#if defined(XXH3_DISPATCH_X86)
+
+// acc must be 16 byte aligned
+__attribute__((target("sse2")))
+FORCE_INLINE void XXH3_accumulate_512_sse2(U64* acc, const BYTE* input, const BYTE* secret)
+{
+    __m128i* const xacc = (__m128i*)acc;
+    __m128i data_vec, key_vec, data_key, data_key_lo, product, data_swap, sum;
+    size_t i;
+
+    for (i = 0; i < XXH3_STRIPE_LEN / sizeof(__m128i); i++)
+    {
+        data_vec = _mm_loadu_si128((const __m128i*)input + i);
+        key_vec = _mm_loadu_si128((const __m128i*)secret + i);
+        data_key = _mm_xor_si128(data_vec, key_vec);
+        data_key_lo = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        product = _mm_mul_epu32(data_key, data_key_lo);
+        data_swap = _mm_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+        sum = _mm_add_epi64(xacc[i], data_swap);
+        xacc[i] = _mm_add_epi64(product, sum);
+    }
+}
+
+__attribute__((target("sse2")))
+FORCE_INLINE void XXH3_scramble_sse2(U64* acc, const BYTE* secret)
+{
+    __m128i* const xacc = (__m128i*)acc;
+    const __m128i prime32 = _mm_set1_epi32((int)PRIME32_1);
+    __m128i acc_vec, data_vec, key_vec, data_key, data_key_hi, prod_lo, prod_hi;
+    size_t i;
+
+    for (i = 0; i < XXH3_STRIPE_LEN / sizeof(__m128i); i++)
+    {
+        acc_vec = xacc[i];
+        data_vec = _mm_xor_si128(acc_vec, _mm_srli_epi64(acc_vec, 47));
+        key_vec = _mm_loadu_si128((const __m128i*)secret + i);
+        data_key = _mm_xor_si128(data_vec, key_vec);
+        data_key_hi = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        prod_lo = _mm_mul_epu32(data_key, prime32);
+        prod_hi = _mm_mul_epu32(data_key_hi, prime32);
+        xacc[i] = _mm_add_epi64(prod_lo, _mm_slli_epi64(prod_hi, 32));
+    }
+}
+
+__attribute__((target("sse2")))
+static void XXH3_hashLong_loop_sse2(U64* acc, const BYTE* input, size_t len, const BYTE* secret)
+{
+    XXH3_hashLong_loop_internal(acc, input, len, secret,
+                                XXH3_accumulate_512_sse2, XXH3_scramble_sse2);
+}
+
+#if defined(XXH3_DISPATCH_AVX2)
+
+// acc must be 32 byte aligned
+__attribute__((target("avx2")))
+FORCE_INLINE void XXH3_accumulate_512_avx2(U64* acc, const BYTE* input, const BYTE* secret)
+{
+    __m256i* const xacc = (__m256i*)acc;
+    __m256i data_vec, key_vec, data_key, data_key_lo, product, data_swap, sum;
+    size_t i;
+
+    for (i = 0; i < XXH3_STRIPE_LEN / sizeof(__m256i); i++)
+    {
+        data_vec = _mm256_loadu_si256((const __m256i*)input + i);
+        key_vec = _mm256_loadu_si256((const __m256i*)secret + i);
+        data_key = _mm256_xor_si256(data_vec, key_vec);
+        data_key_lo = _mm256_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        product = _mm256_mul_epu32(data_key, data_key_lo);
+        data_swap = _mm256_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+        sum = _mm256_add_epi64(xacc[i], data_swap);
+        xacc[i] = _mm256_add_epi64(product, sum);
+    }
+}
+
+__attribute__((target("avx2")))
+FORCE_INLINE void XXH3_scramble_avx2(U64* acc, const BYTE* secret)
+{
+    __m256i* const xacc = (__m256i*)acc;
+    const __m256i prime32 = _mm256_set1_epi32((int)PRIME32_1);
+    __m256i acc_vec, data_vec, key_vec, data_key, data_key_hi, prod_lo, prod_hi;
+    size_t i;
+
+    for (i = 0; i < XXH3_STRIPE_LEN / sizeof(__m256i); i++)
+    {
+        acc_vec = xacc[i];
+        data_vec = _mm256_xor_si256(acc_vec, _mm256_srli_epi64(acc_vec, 47));
+        key_vec = _mm256_loadu_si256((const __m256i*)secret + i);
+        data_key = _mm256_xor_si256(data_vec, key_vec);
+        data_key_hi = _mm256_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        prod_lo = _mm256_mul_epu32(data_key, prime32);
+        prod_hi = _mm256_mul_epu32(data_key_hi, prime32);
+        xacc[i] = _mm256_add_epi64(prod_lo, _mm256_slli_epi64(prod_hi, 32));
+    }
+}
+
+__attribute__((target("avx2")))
+static void XXH3_hashLong_loop_avx2(U64* acc, const BYTE* input, size_t len, const BYTE* secret)
+{
+    XXH3_hashLong_loop_internal(acc, input, len, secret,
+                                XXH3_accumulate_512_avx2, XXH3_scramble_avx2);
+}
+
+#endif
+
+#endif
+
+static XXH3_hashLong_loop_f XXH3_hashLong_loop_select(void)
+{
+#if defined(XXH3_DISPATCH_X86)
+    uint64_t backends = blake3_get_detected_backends();
+
+#  if defined(XXH3_DISPATCH_AVX2)
+    if (backends & B3BF_AVX2)
+        return XXH3_hashLong_loop_avx2;
+#  endif
+    if (backends & B3BF_SSE2)
+        return XXH3_hashLong_loop_sse2;
+#endif
+    return XXH3_hashLong_loop_scalar;
+}
+
+// selected on first use; racing threads all store the same pointer
+static _Atomic(XXH3_hashLong_loop_f) XXH3_hashLong_loop;
+
+static U64 XXH3_hashLong_64b(const BYTE* input, size_t len, U64 seed)
+{
+    XXH3_ALIGN(64) U64 acc[XXH3_ACC_NB] =
+    {
+        PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+        PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+    };
+    XXH3_ALIGN(64) BYTE customSecret[XXH3_SECRET_SIZE];
+    const BYTE* secret = XXH3_kSecret;
+    XXH3_hashLong_loop_f loop;
+    U64 result;
+    size_t i;
+
+    if (seed)
+    {
+        for (i = 0; i < XXH3_SECRET_SIZE / 16; i++)
+        {
+            XXH3_writeLE64(customSecret + 16 * i, XXH3_readLE64(XXH3_kSecret + 16 * i) + seed);
+            XXH3_writeLE64(customSecret + 16 * i + 8, XXH3_readLE64(XXH3_kSecret + 16 * i + 8) - seed);
+        }
+        secret = customSecret;
+    }
+
+    loop = atomic_load_explicit(&XXH3_hashLong_loop, memory_order_relaxed);
+    if (!loop)
+    {
+        loop = XXH3_hashLong_loop_select();
+        atomic_store_explicit(&XXH3_hashLong_loop, loop, memory_order_relaxed);
+    }
+    loop(acc, input, len, secret);
+
+    // merge the accumulators
+    result = len * PRIME64_1;
+    for (i = 0; i < XXH3_ACC_NB / 2; i++)
+        result += XXH3_mul128_fold64(acc[2 * i] ^ XXH3_readLE64(secret + XXH3_SECRET_MERGEACCS_START + 16 * i),
+                                     acc[2 * i + 1] ^ XXH3_readLE64(secret + XXH3_SECRET_MERGEACCS_START + 16 * i + 8));
+
+    return XXH3_avalanche(result);
+}
+
+unsigned long long XXH3_64bits_withSeed (const void* input, size_t len, unsigned long long seed)
+{
+    const BYTE* p = (const BYTE*)input;
+
+    if (len <= 16)
+        return XXH3_len_0to16_64b(p, len, XXH3_kSecret, seed);
+    if (len <= 128)
+        return XXH3_len_17to128_64b(p, len, XXH3_kSecret, seed);
+    if (len <= XXH3_MIDSIZE_MAX)
+        return XXH3_len_129to240_64b(p, len, XXH3_kSecret, seed);
+    return XXH3_hashLong_64b(p, len, seed);
+}
+
+unsigned long long XXH3_64bits (const void* input, size_t len)
+{
+    return XXH3_64bits_withSeed(input, len, 0);
+}
@@ -97,6 +97,8 @@ unsigned int       XXH32 (const void* input, size_t length, unsigned seed);
 unsigned long long XXH64 (const void* input, size_t length, unsigned long long seed);
 void 		   XXH128 (const void* input, size_t length, unsigned long long seed, void* out);
 void 		   XXH256 (const void* input, size_t length, unsigned long long seed, void* out);
+unsigned long long XXH3_64bits (const void* input, size_t length);
+unsigned long long XXH3_64bits_withSeed (const void* input, size_t length, unsigned long long seed);
 
 /*
 XXH32() :
@@ -113,6 +115,10 @@ XXH128():
 XXH256():
     Calculate the 256-bits hash of sequence of length "len" stored at memory address "input".
     Output is stored in the 32 byte array "out"
+XXH3_64bits(), XXH3_64bits_withSeed() :
+    Calculate the 64-bits XXH3 hash of sequence of length "len" stored at memory address "input".
+    Much faster than XXH32/XXH64 for short inputs; long inputs use SSE2/AVX2 when the CPU has them.
+    Results are identical to the XXH3 64-bits hash of the upstream xxHash (v0.8).
 */
 
 
@@ -17,6 +17,7 @@
 #include <getopt.h>
 #include <unistd.h>
 #include <limits.h>
+#include <errno.h>
 
 #include <check.h>
 
@@ -272,6 +273,114 @@ START_TEST(doc_build_mapping)
 }
 END_TEST
 
+START_TEST(doc_build_filtered)
+{
+	static const char *yaml =
+		"spec:\n"
+		"  replicas: 3\n"
+		"  ? { complex: key }\n"
+		"  : skipped\n"
+		"  template:\n"
+		"    metadata: { name: foo }\n"
+		"    containers: [ a, b ]\n"
+		"  other: [ 1, 2, 3 ]\n"
+		"status: { x: 1 }\n"
+		"items: [ { name: a }, { name: b, extra: 1 } ]\n"
+		"---\n"
+		"full: document\n";
+	static const char * const paths[] = {
+		"/spec/template",
+		"/items/1/name",
+		NULL
+	};
+	struct fy_parse_cfg cfg = { .flags = FYPCF_DEFAULT_DOC };
+	struct fy_parser *fyp;
+	struct fy_document *fyd, *fyd_expect;
+
+	fyp = fy_parser_create(&cfg);
+	ck_assert_ptr_ne(fyp, NULL);
+
+	ck_assert(!fy_parser_set_string(fyp, yaml, FY_NT));
+
+	/* only the selected subtrees are built */
+	fyd = fy_parse_load_document_filtered(fyp, paths);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	fyd_expect = fy_document_build_from_string(NULL,
+			"{ spec: { template: { metadata: { name: foo }, containers: [ a, b ] } }, "
+			"items: [ { name: b } ] }", FY_NT);
+	ck_assert_ptr_ne(fyd_expect, NULL);
+
+	ck_assert(fy_node_compare(fy_document_root(fyd), fy_document_root(fyd_expect)));
+
+	fy_document_destroy(fyd_expect);
+	fy_parse_document_destroy(fyp, fyd);
+
+	/* the next document is loaded in full */
+	fyd = fy_parse_load_document(fyp);
+	ck_assert_ptr_ne(fyd, NULL);
+	ck_assert(fy_node_compare_string(fy_document_root(fyd), "{ full: document }", FY_NT));
+	fy_parse_document_destroy(fyp, fyd);
+
+	fy_parser_destroy(fyp);
+}
+END_TEST
+
+START_TEST(doc_builder_filter)
+{
+	static const char *yaml =
+		"a: { b: 1, c: 2 }\n"
+		"d: [ x, y, z ]\n"
+		"---\n"
+		"a: { b: 3, c: 4 }\n"
+		"d: [ u, v ]\n"
+		"---\n"
+		"a: 5\n";
+	static const char * const cfg_paths[] = { "/a/c", NULL };
+	static const char * const paths[] = { "/d/1", NULL };
+	struct fy_parse_cfg cfg = { .flags = FYPCF_DEFAULT_DOC };
+	struct fy_document_builder_cfg dcfg;
+	struct fy_document_builder *fydb;
+	struct fy_parser *fyp;
+	struct fy_document *fyd;
+
+	fyp = fy_parser_create(&cfg);
+	ck_assert_ptr_ne(fyp, NULL);
+	ck_assert(!fy_parser_set_string(fyp, yaml, FY_NT));
+
+	/* the filter of the configuration */
+	memset(&dcfg, 0, sizeof(dcfg));
+	dcfg.parse_cfg = cfg;
+	dcfg.filter_paths = cfg_paths;
+	fydb = fy_document_builder_create(&dcfg);
+	ck_assert_ptr_ne(fydb, NULL);
+
+	fyd = fy_document_builder_load_document(fydb, fyp);
+	ck_assert_ptr_ne(fyd, NULL);
+	ck_assert(fy_node_compare_string(fy_document_root(fyd), "{ a: { c: 2 } }", FY_NT));
+	fy_document_destroy(fyd);
+
+	/* replaced by another one */
+	ck_assert_int_eq(fy_document_builder_set_filter(fydb, paths), 0);
+	fyd = fy_document_builder_load_document(fydb, fyp);
+	ck_assert_ptr_ne(fyd, NULL);
+	ck_assert(fy_node_compare_string(fy_document_root(fyd), "{ d: [ v ] }", FY_NT));
+	fy_document_destroy(fyd);
+
+	/* and cleared */
+	ck_assert_int_eq(fy_document_builder_set_filter(fydb, NULL), 0);
+	fyd = fy_document_builder_load_document(fydb, fyp);
+	ck_assert_ptr_ne(fyd, NULL);
+	ck_assert(fy_node_compare_string(fy_document_root(fyd), "{ a: 5 }", FY_NT));
+	fy_document_destroy(fyd);
+
+	ck_assert_ptr_eq(fy_document_builder_load_document(fydb, fyp), NULL);
+
+	fy_document_builder_destroy(fydb);
+	fy_parser_destroy(fyp);
+}
+END_TEST
+
 START_TEST(doc_path_access)
 {
 	struct fy_document *fyd;
@@ -303,6 +412,74 @@ START_TEST(doc_path_access)
 }
 END_TEST
 
+START_TEST(doc_path_handle)
+{
+	static const struct {
+		const char *path;
+		enum fy_node_walk_flags flags;
+	} paths[] = {
+		{ "/",				FYNWF_DONT_FOLLOW },
+		{ "/foo",			FYNWF_DONT_FOLLOW },
+		{ "bar",			FYNWF_DONT_FOLLOW },
+		{ "baz/frob",			FYNWF_DONT_FOLLOW },
+		{ "/frooz/0",			FYNWF_DONT_FOLLOW },
+		{ "/frooz/[1]/key",		FYNWF_DONT_FOLLOW },
+		{ "/frooz/-1/key",		FYNWF_DONT_FOLLOW },
+		{ "/frooz/2",			FYNWF_DONT_FOLLOW },
+		{ "/\"zero\\0zero\"",		FYNWF_DONT_FOLLOW },
+		{ "/{ key2: value2 }/key3",	FYNWF_DONT_FOLLOW },
+		{ "/foo/bar",			FYNWF_DONT_FOLLOW },
+		{ "/nothere",			FYNWF_DONT_FOLLOW },
+		{ "/ref/frob",			FYNWF_DONT_FOLLOW },
+		{ "/ref/frob",			FYNWF_FOLLOW },
+		{ "/ref/",			FYNWF_FOLLOW },
+		{ "/merged/frob",		FYNWF_FOLLOW },
+		{ "/merged/other",		FYNWF_FOLLOW },
+		{ "*anchor/frob",		FYNWF_FOLLOW },
+		{ "",				FYNWF_PTR_JSON },
+		{ "/foo",			FYNWF_PTR_JSON },
+		{ "/frooz/1/key",		FYNWF_PTR_JSON },
+		{ "/a~1b",			FYNWF_PTR_JSON },
+		{ "/a%20b",			FYNWF_PTR_JSON | FYNWF_URI_ENCODED },
+		{ "foo",			FYNWF_PTR_JSON },
+	};
+	struct fy_document *fyd;
+	struct fy_node_path_handle *fynph;
+	struct fy_node *fyn_root, *fyn;
+	unsigned int i;
+
+	fyd = fy_document_build_from_string(NULL, "{ "
+		"foo: 10, bar : 20, baz: &anchor { frob: boo }, "
+		"frooz: [ seq1, { key: value} ], \"zero\\0zero\" : 0, "
+		"{ key2: value2 }: { key3: value3 }, "
+		"ref: *anchor, merged: { <<: *anchor, other: 1 }, "
+		"a/b: slash, \"a b\": space "
+		"}", FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+	fyn_root = fy_document_root(fyd);
+
+	/* a handle must resolve to the same node as the path */
+	for (i = 0; i < sizeof(paths)/sizeof(paths[0]); i++) {
+		fynph = fy_node_path_handle_create(paths[i].path, FY_NT, paths[i].flags);
+		ck_assert_ptr_ne(fynph, NULL);
+
+		fyn = fy_node_by_path(fyn_root, paths[i].path, FY_NT, paths[i].flags);
+		ck_assert_ptr_eq(fy_node_by_path_handle(fyn_root, fynph), fyn);
+
+		fy_node_path_handle_destroy(fynph);
+	}
+
+	/* and can be reused */
+	fynph = fy_node_path_handle_create("/baz/frob", FY_NT, FYNWF_DONT_FOLLOW);
+	ck_assert_ptr_ne(fynph, NULL);
+	ck_assert(fy_node_compare_string(fy_node_by_path_handle(fyn_root, fynph), "boo", FY_NT) == true);
+	ck_assert(fy_node_compare_string(fy_node_by_path_handle(fyn_root, fynph), "boo", FY_NT) == true);
+	fy_node_path_handle_destroy(fynph);
+
+	fy_document_destroy(fyd);
+}
+END_TEST
+
 START_TEST(doc_path_node)
 {
 	struct fy_document *fyd;
@@ -1125,6 +1302,71 @@ START_TEST(doc_sort)
 }
 END_TEST
 
+START_TEST(doc_digest)
+{
+	struct fy_document *fyd1, *fyd2, *fyd3;
+	struct fy_node *fyn;
+	uint8_t d1[FY_NODE_DIGEST_LEN], d2[FY_NODE_DIGEST_LEN], d3[FY_NODE_DIGEST_LEN];
+	int ret;
+
+	/* same content, different formatting, comments and key order */
+	fyd1 = fy_document_build_from_string(NULL, "a: [ 1, 2 ]\nb: { c: 'x' }\n", FY_NT);
+	ck_assert_ptr_ne(fyd1, NULL);
+	fyd2 = fy_document_build_from_string(NULL, "# comment\nb:\n  c: x\na:\n- 1\n- \"2\"\n", FY_NT);
+	ck_assert_ptr_ne(fyd2, NULL);
+
+	ret = fy_node_digest(fy_document_root(fyd1), 0, d1);
+	ck_assert_int_eq(ret, 0);
+	ret = fy_node_digest(fy_document_root(fyd2), 0, d2);
+	ck_assert_int_eq(ret, 0);
+	ck_assert(!memcmp(d1, d2, FY_NODE_DIGEST_LEN));
+
+	/* unless the key order is significant */
+	ret = fy_node_digest(fy_document_root(fyd1), FYNDF_KEY_ORDER, d1);
+	ck_assert_int_eq(ret, 0);
+	ret = fy_node_digest(fy_document_root(fyd2), FYNDF_KEY_ORDER, d2);
+	ck_assert_int_eq(ret, 0);
+	ck_assert(memcmp(d1, d2, FY_NODE_DIGEST_LEN));
+
+	/* a change deep inside must not use the stale memoized digests */
+	fyn = fy_node_by_path(fy_document_root(fyd1), "/b", FY_NT, FYNWF_DONT_FOLLOW);
+	ck_assert_ptr_ne(fyn, NULL);
+	ret = fy_node_mapping_append(fyn,
+			fy_node_build_from_string(fyd1, "d", FY_NT),
+			fy_node_build_from_string(fyd1, "y", FY_NT));
+	ck_assert_int_eq(ret, 0);
+
+	ret = fy_node_digest(fy_document_root(fyd1), 0, d1);
+	ck_assert_int_eq(ret, 0);
+	ret = fy_node_digest(fy_document_root(fyd2), 0, d2);
+	ck_assert_int_eq(ret, 0);
+	ck_assert(memcmp(d1, d2, FY_NODE_DIGEST_LEN));
+
+	fyd3 = fy_document_build_from_string(NULL, "b: { d: y, c: x }\na: [ 1, 2 ]\n", FY_NT);
+	ck_assert_ptr_ne(fyd3, NULL);
+	ret = fy_node_digest(fy_document_root(fyd3), FYNDF_NO_MEMO, d3);
+	ck_assert_int_eq(ret, 0);
+	ck_assert(!memcmp(d1, d3, FY_NODE_DIGEST_LEN));
+
+	/* scalar boundaries and types are part of the digest */
+	fyn = fy_node_build_from_string(fyd3, "[ a, b ]", FY_NT);
+	ck_assert_ptr_ne(fyn, NULL);
+	ret = fy_node_digest(fyn, 0, d1);
+	ck_assert_int_eq(ret, 0);
+	fy_node_free(fyn);
+	fyn = fy_node_build_from_string(fyd3, "[ ab ]", FY_NT);
+	ck_assert_ptr_ne(fyn, NULL);
+	ret = fy_node_digest(fyn, 0, d2);
+	ck_assert_int_eq(ret, 0);
+	fy_node_free(fyn);
+	ck_assert(memcmp(d1, d2, FY_NODE_DIGEST_LEN));
+
+	fy_document_destroy(fyd3);
+	fy_document_destroy(fyd2);
+	fy_document_destroy(fyd1);
+}
+END_TEST
+
 static char *join_docs(const char *tgt_text, const char *tgt_path,
 		       const char *src_text, const char *src_path,
 		       const char *emit_path)
@@ -1922,6 +2164,305 @@ START_TEST(scanf_check)
 }
 END_TEST
 
+START_TEST(ypath_parallel)
+{
+	struct fy_document *fyd;
+	struct fy_node *fyn_root, *fyn_seq, *fyn_map, *fyn;
+	struct fy_path_expr *expr;
+	struct fy_thread_pool_cfg tcfg;
+	struct fy_thread_pool *tp;
+	struct fy_path_exec_cfg xcfg;
+	struct fy_path_exec *fypx_s, *fypx_p;
+	void *iter_s, *iter_p;
+	struct fy_node *fyn_s, *fyn_p;
+	int i, ret, count;
+
+	/* build a document large enough to go parallel */
+	fyd = fy_document_create(NULL);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	fyn_root = fy_node_create_mapping(fyd);
+	ck_assert_ptr_ne(fyn_root, NULL);
+	fy_document_set_root(fyd, fyn_root);
+
+	fyn_seq = fy_node_create_sequence(fyd);
+	ck_assert_ptr_ne(fyn_seq, NULL);
+	ret = fy_node_mapping_append(fyn_root, fy_node_create_scalar(fyd, "items", FY_NT), fyn_seq);
+	ck_assert_int_eq(ret, 0);
+
+	for (i = 0; i < 2000; i++) {
+		fyn_map = fy_node_buildf(fyd, "{ id: %d, spec: { kind: k%d } }", i, i % 5);
+		ck_assert_ptr_ne(fyn_map, NULL);
+		ret = fy_node_sequence_append(fyn_seq, fyn_map);
+		ck_assert_int_eq(ret, 0);
+	}
+
+	expr = fy_path_expr_build_from_string(NULL, "/**/spec/kind", FY_NT);
+	ck_assert_ptr_ne(expr, NULL);
+
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.flags = FYTPCF_STEAL_MODE;
+	tcfg.num_threads = 4;
+	tp = fy_thread_pool_create(&tcfg);
+	ck_assert_ptr_ne(tp, NULL);
+
+	/* serial */
+	fypx_s = fy_path_exec_create(NULL);
+	ck_assert_ptr_ne(fypx_s, NULL);
+
+	/* parallel */
+	memset(&xcfg, 0, sizeof(xcfg));
+	xcfg.flags = FYPXCF_PARALLEL;
+	xcfg.tp = tp;
+	fypx_p = fy_path_exec_create(&xcfg);
+	ck_assert_ptr_ne(fypx_p, NULL);
+
+	ret = fy_path_exec_execute(fypx_s, expr, fyn_root);
+	ck_assert_int_eq(ret, 0);
+	ret = fy_path_exec_execute(fypx_p, expr, fyn_root);
+	ck_assert_int_eq(ret, 0);
+
+	/* the results must be identical and in document order */
+	count = 0;
+	iter_s = iter_p = NULL;
+	do {
+		fyn_s = fy_path_exec_results_iterate(fypx_s, &iter_s);
+		fyn_p = fy_path_exec_results_iterate(fypx_p, &iter_p);
+		ck_assert_ptr_eq(fyn_s, fyn_p);
+		if (fyn_s)
+			count++;
+	} while (fyn_s);
+	ck_assert_int_eq(count, 2000);
+
+	fyn = fy_node_by_path(fyn_root, "/items/1999/spec/kind", FY_NT, FYNWF_DONT_FOLLOW);
+	ck_assert_ptr_ne(fyn, NULL);
+	iter_p = NULL;
+	for (i = 0; i < 2000; i++)
+		fyn_p = fy_path_exec_results_iterate(fypx_p, &iter_p);
+	ck_assert_ptr_eq(fyn_p, fyn);
+
+	fy_path_exec_destroy(fypx_p);
+	fy_path_exec_destroy(fypx_s);
+	fy_thread_pool_destroy(tp);
+	fy_path_expr_free(expr);
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+struct spawn_fib {
+	struct fy_thread_pool *tp;
+	unsigned int n;
+	unsigned long result;
+};
+
+static void spawn_fib_work(void *arg)
+{
+	struct spawn_fib *f = arg, sub[2];
+	struct fy_thread_work works[2];
+	int i;
+
+	if (f->n < 2) {
+		f->result = f->n;
+		return;
+	}
+
+	memset(works, 0, sizeof(works));
+	for (i = 0; i < 2; i++) {
+		sub[i].tp = f->tp;
+		sub[i].n = f->n - 1 - i;
+		sub[i].result = 0;
+		works[i].fn = spawn_fib_work;
+		works[i].arg = &sub[i];
+		fy_thread_spawn(f->tp, &works[i]);
+	}
+	fy_thread_sync(f->tp);
+
+	f->result = sub[0].result + sub[1].result;
+}
+
+static void join_sum_work(void *arg)
+{
+	unsigned long *p = arg;
+
+	*p = *p * 2 + 1;
+}
+
+START_TEST(thread_spawn_sync)
+{
+	struct fy_thread_pool_cfg tcfg;
+	struct fy_thread_pool *tp;
+	struct fy_thread_work works[256];
+	struct spawn_fib fibs[8];
+	unsigned long vals[256];
+	unsigned int i;
+	int ret;
+
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.flags = FYTPCF_DEQUE_MODE;
+	tcfg.num_threads = 4;
+	tp = fy_thread_pool_create(&tcfg);
+	ck_assert_ptr_ne(tp, NULL);
+
+	/* reserving threads is not possible in deque mode */
+	ck_assert_ptr_eq(fy_thread_reserve(tp), NULL);
+
+	/* nested spawns, from outside of the pool */
+	memset(works, 0, sizeof(works));
+	for (i = 0; i < 8; i++) {
+		fibs[i].tp = tp;
+		fibs[i].n = 16 + i;
+		fibs[i].result = 0;
+		works[i].fn = spawn_fib_work;
+		works[i].arg = &fibs[i];
+		ret = fy_thread_spawn(tp, &works[i]);
+		ck_assert_int_eq(ret, 0);
+	}
+	fy_thread_sync(tp);
+
+	ck_assert_uint_eq(fibs[0].result, 987);
+	ck_assert_uint_eq(fibs[7].result, 28657);
+
+	/* joins go through the deques too */
+	for (i = 0; i < 256; i++)
+		vals[i] = i;
+	fy_thread_arg_array_join(tp, join_sum_work, NULL, vals, sizeof(vals[0]), 256);
+	for (i = 0; i < 256; i++)
+		ck_assert_uint_eq(vals[i], i * 2 + 1);
+
+	fy_thread_pool_destroy(tp);
+
+	/* without a deque mode pool the work is executed directly */
+	fibs[0].tp = NULL;
+	fibs[0].n = 10;
+	fibs[0].result = 0;
+	memset(works, 0, sizeof(works[0]));
+	works[0].fn = spawn_fib_work;
+	works[0].arg = &fibs[0];
+	ret = fy_thread_spawn(NULL, &works[0]);
+	ck_assert_int_eq(ret, 0);
+	ck_assert_uint_eq(fibs[0].result, 55);
+}
+END_TEST
+
+START_TEST(thread_pool_stats)
+{
+	struct fy_thread_pool_cfg tcfg;
+	struct fy_thread_pool *tp;
+	struct fy_thread_stats total, threads[4], sum;
+	unsigned long vals[256];
+	unsigned int i;
+	int ret;
+
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.flags = FYTPCF_DEQUE_MODE;
+	tcfg.num_threads = 4;
+	tp = fy_thread_pool_create(&tcfg);
+	ck_assert_ptr_ne(tp, NULL);
+
+	for (i = 0; i < 256; i++)
+		vals[i] = i;
+
+	fy_thread_pool_reset_stats(tp);
+	fy_thread_arg_array_join(tp, join_sum_work, NULL, vals, sizeof(vals[0]), 256);
+
+	/* all but the first work are spawned, and each is executed once */
+	ret = fy_thread_pool_get_stats(tp, &total, threads);
+	ck_assert_int_eq(ret, 0);
+	ck_assert_uint_eq(total.jobs, 255);
+
+	memset(&sum, 0, sizeof(sum));
+	for (i = 0; i < 4; i++) {
+		sum.jobs += threads[i].jobs;
+		sum.parks += threads[i].parks;
+		ck_assert(threads[i].wake_latency_max_ns <= total.wake_latency_max_ns);
+	}
+	ck_assert(sum.jobs <= total.jobs);
+	ck_assert(sum.parks <= total.parks);
+	ck_assert(total.spin_hits <= total.spins);
+
+	fy_thread_pool_reset_stats(tp);
+	ret = fy_thread_pool_get_stats(tp, &total, NULL);
+	ck_assert_int_eq(ret, 0);
+	ck_assert_uint_eq(total.jobs, 0);
+	ck_assert_uint_eq(total.steals, 0);
+
+	ck_assert_int_eq(fy_thread_pool_get_stats(NULL, &total, NULL), -1);
+
+	fy_thread_pool_destroy(tp);
+}
+END_TEST
+
+START_TEST(thread_pool_placement)
+{
+	struct fy_thread_pool_cfg tcfg;
+	struct fy_thread_pool *tp;
+	uint64_t mask;
+	unsigned long vals[256];
+	int i, num_threads, cpu, node;
+
+	/* pinned to the allowed CPUs of the first 64, grouped per node */
+	mask = (uint64_t)-1;
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.flags = FYTPCF_STEAL_MODE | FYTPCF_PIN_THREADS | FYTPCF_NUMA_GROUP;
+	tcfg.num_threads = 0;
+	tcfg.cpu_mask = &mask;
+	tcfg.cpu_mask_bits = 64;
+	tp = fy_thread_pool_create(&tcfg);
+	ck_assert_ptr_ne(tp, NULL);
+
+	/* the pool keeps its own copy of the mask */
+	mask = 0;
+	ck_assert_ptr_ne(fy_thread_pool_get_cfg(tp)->cpu_mask, &mask);
+
+	num_threads = fy_thread_pool_get_num_threads(tp);
+	ck_assert_int_gt(num_threads, 0);
+	for (i = 0; i < num_threads; i++) {
+		cpu = fy_thread_pool_get_thread_cpu(tp, i);
+		node = fy_thread_pool_get_thread_node(tp, i);
+#if defined(__linux__)
+		ck_assert(cpu >= 0 && cpu < 64);
+		ck_assert_int_ge(node, 0);
+#else
+		ck_assert_int_eq(cpu, -1);
+		ck_assert_int_eq(node, -1);
+#endif
+	}
+	ck_assert_int_eq(fy_thread_pool_get_thread_cpu(tp, num_threads), -1);
+
+	/* a preferred node is only a hint */
+	for (i = 0; i < 256; i++)
+		vals[i] = i;
+	node = fy_thread_pool_mem_node(tp, vals);
+	ck_assert_int_ge(node, -1);
+	fy_thread_arg_array_join_node(tp, join_sum_work, NULL, vals, sizeof(vals[0]), 256, node);
+	fy_thread_arg_array_join_node(tp, join_sum_work, NULL, vals, sizeof(vals[0]), 256, 0);
+	for (i = 0; i < 256; i++)
+		ck_assert_uint_eq(vals[i], (i * 2 + 1) * 2 + 1);
+
+	fy_thread_pool_destroy(tp);
+
+	/* no threads are placed without the flags or a mask */
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.num_threads = 2;
+	tp = fy_thread_pool_create(&tcfg);
+	ck_assert_ptr_ne(tp, NULL);
+	ck_assert_int_eq(fy_thread_pool_get_thread_cpu(tp, 0), -1);
+	ck_assert_int_eq(fy_thread_pool_get_thread_node(tp, 0), -1);
+	ck_assert_int_eq(fy_thread_pool_mem_node(tp, vals), -1);
+	fy_thread_pool_destroy(tp);
+
+#if defined(__linux__)
+	/* no CPUs allowed at all */
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.flags = FYTPCF_PIN_THREADS;
+	tcfg.cpu_mask = &mask;
+	tcfg.cpu_mask_bits = 64;
+	tp = fy_thread_pool_create(&tcfg);
+	ck_assert_ptr_eq(tp, NULL);
+#endif
+}
+END_TEST
+
 START_TEST(token_test) {
         struct fy_document *fyd;
         struct fy_node *fyn_sequence, *fyn_mapping, *fyn_scalar;
@@ -1996,6 +2537,527 @@ START_TEST(token_test) {
 }
 END_TEST
 
+/* deterministic test content for the BLAKE3 tests */
+static void blake3_test_fill(uint8_t *data, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		data[i] = (uint8_t)(i * 7 + (i >> 8));
+}
+
+static void blake3_test_write_file(const char *path, const uint8_t *data, size_t size)
+{
+	FILE *fp;
+
+	fp = fopen(path, "wb");
+	ck_assert_ptr_ne(fp, NULL);
+	ck_assert_int_eq(fwrite(data, 1, size, fp), size);
+	ck_assert_int_eq(fclose(fp), 0);
+}
+
+START_TEST(blake3_state_save_restore)
+{
+	static const size_t splits[] = { 0, 1, 64, 1000, 1024, 1025, 4096, 50000, 65536, 99999 };
+	static uint8_t data[100000];
+	struct fy_blake3_hasher_cfg cfg;
+	struct fy_blake3_hasher *fyh, *fyh2, *fyhk;
+	uint8_t state[FY_BLAKE3_STATE_MAX_SIZE], bad[FY_BLAKE3_STATE_MAX_SIZE];
+	uint8_t expected[FY_BLAKE3_OUT_LEN], key[FY_BLAKE3_KEY_LEN];
+	size_t size, i;
+	int rc;
+
+	blake3_test_fill(data, sizeof(data));
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.num_threads = -1;
+	fyh = fy_blake3_hasher_create(&cfg);
+	ck_assert_ptr_ne(fyh, NULL);
+	fyh2 = fy_blake3_hasher_create(&cfg);
+	ck_assert_ptr_ne(fyh2, NULL);
+
+	memcpy(expected, fy_blake3_hash(fyh, data, sizeof(data)), FY_BLAKE3_OUT_LEN);
+
+	/* save, restore on another hasher, append the rest, same as one-shot */
+	for (i = 0; i < sizeof(splits)/sizeof(splits[0]); i++) {
+		fy_blake3_hasher_reset(fyh);
+		fy_blake3_hasher_update(fyh, data, splits[i]);
+
+		size = fy_blake3_hasher_save_state(fyh, NULL, 0);
+		ck_assert_int_ge(size, 112);
+		ck_assert_int_le(size, FY_BLAKE3_STATE_MAX_SIZE);
+		ck_assert_int_eq(fy_blake3_hasher_save_state(fyh, state, sizeof(state)), size);
+
+		rc = fy_blake3_hasher_restore_state(fyh2, state, size);
+		ck_assert_int_eq(rc, 0);
+		fy_blake3_hasher_update(fyh2, data + splits[i], sizeof(data) - splits[i]);
+		ck_assert(!memcmp(fy_blake3_hasher_finalize(fyh2), expected, FY_BLAKE3_OUT_LEN));
+	}
+
+	/* a state with chaining values on the stack */
+	fy_blake3_hasher_reset(fyh);
+	fy_blake3_hasher_update(fyh, data, 50000);
+	size = fy_blake3_hasher_save_state(fyh, state, sizeof(state));
+	ck_assert_int_gt(size, 112);
+
+	/* truncated */
+	ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh2, state, size - 1), -1);
+	ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh2, state, size - FY_BLAKE3_OUT_LEN), -1);
+	ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh2, state, 16), -1);
+
+	/* bad magic */
+	memcpy(bad, state, size);
+	bad[0] ^= 1;
+	ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh2, bad, size), -1);
+
+	/* block buffer length out of range */
+	memcpy(bad, state, size);
+	bad[5] = 65;
+	ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh2, bad, size), -1);
+
+	/* stack depth not matching the size */
+	memcpy(bad, state, size);
+	bad[7]++;
+	ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh2, bad, size), -1);
+
+	/* a keyed hasher does not accept a plain hasher state */
+	memset(key, 0x5a, sizeof(key));
+	cfg.key = key;
+	fyhk = fy_blake3_hasher_create(&cfg);
+	ck_assert_ptr_ne(fyhk, NULL);
+	ck_assert_int_eq(fy_blake3_hasher_restore_state(fyhk, state, size), -1);
+	fy_blake3_hasher_destroy(fyhk);
+
+	/* the failures did not break the hasher */
+	ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh2, state, size), 0);
+	fy_blake3_hasher_update(fyh2, data + 50000, sizeof(data) - 50000);
+	ck_assert(!memcmp(fy_blake3_hasher_finalize(fyh2), expected, FY_BLAKE3_OUT_LEN));
+
+	fy_blake3_hasher_destroy(fyh2);
+	fy_blake3_hasher_destroy(fyh);
+}
+END_TEST
+
+START_TEST(blake3_file_resume)
+{
+	static uint8_t data[100000];
+	struct fy_blake3_hasher_cfg cfg;
+	struct fy_blake3_hasher *fyh;
+	uint8_t state[FY_BLAKE3_STATE_MAX_SIZE];
+	uint8_t expected[FY_BLAKE3_OUT_LEN];
+	char path[] = "/tmp/libfyaml-test-b3-XXXXXX";
+	const uint8_t *hash;
+	size_t size, split = 50001;
+	int fd, mode;
+
+	blake3_test_fill(data, sizeof(data));
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	/* with mmap and with buffered reads */
+	for (mode = 0; mode < 2; mode++) {
+		memset(&cfg, 0, sizeof(cfg));
+		cfg.num_threads = -1;
+		cfg.no_mmap = mode == 1;
+		fyh = fy_blake3_hasher_create(&cfg);
+		ck_assert_ptr_ne(fyh, NULL);
+
+		/* hash the first part of the file and keep the state */
+		blake3_test_write_file(path, data, split);
+		memcpy(expected, fy_blake3_hash(fyh, data, split), FY_BLAKE3_OUT_LEN);
+		hash = fy_blake3_hash_file(fyh, path);
+		ck_assert_ptr_ne(hash, NULL);
+		ck_assert(!memcmp(hash, expected, FY_BLAKE3_OUT_LEN));
+		size = fy_blake3_hasher_save_state(fyh, state, sizeof(state));
+		ck_assert_int_le(size, sizeof(state));
+
+		/* appended, resuming hashes the whole file */
+		blake3_test_write_file(path, data, sizeof(data));
+		memcpy(expected, fy_blake3_hash(fyh, data, sizeof(data)), FY_BLAKE3_OUT_LEN);
+		ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh, state, size), 0);
+		hash = fy_blake3_hash_file_resume(fyh, path);
+		ck_assert_ptr_ne(hash, NULL);
+		ck_assert(!memcmp(hash, expected, FY_BLAKE3_OUT_LEN));
+
+		/* the already hashed part changed, resume fails and a full hash is needed */
+		data[split - 1] ^= 0xff;
+		blake3_test_write_file(path, data, sizeof(data));
+		memcpy(expected, fy_blake3_hash(fyh, data, sizeof(data)), FY_BLAKE3_OUT_LEN);
+		ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh, state, size), 0);
+		ck_assert_ptr_eq(fy_blake3_hash_file_resume(fyh, path), NULL);
+		hash = fy_blake3_hash_file(fyh, path);
+		ck_assert_ptr_ne(hash, NULL);
+		ck_assert(!memcmp(hash, expected, FY_BLAKE3_OUT_LEN));
+		data[split - 1] ^= 0xff;
+
+		/* truncated below the state */
+		blake3_test_write_file(path, data, split - 100);
+		ck_assert_int_eq(fy_blake3_hasher_restore_state(fyh, state, size), 0);
+		ck_assert_ptr_eq(fy_blake3_hash_file_resume(fyh, path), NULL);
+
+		fy_blake3_hasher_destroy(fyh);
+	}
+
+	unlink(path);
+}
+END_TEST
+
+START_TEST(blake3_stream_pipelined)
+{
+	/* the internal pool, and external pools in both scheduling modes */
+	static const unsigned int tp_flags[] = {
+		0,
+		FYTPCF_STEAL_MODE,
+		FYTPCF_DEQUE_MODE,
+	};
+	/* small buffers for many pipeline rounds, and the default ones */
+	static const struct {
+		size_t file_buffer;
+		size_t size;
+	} cases[] = {
+		{ 65536,	3 * 65536	},	/* whole buffers */
+		{ 65536,	3 * 65536 + 1	},
+		{ 65536,	(1 << 20) + 12345 },
+		{ 0,		(9 << 20) + 777	},	/* past two 4MB buffers */
+	};
+	struct fy_blake3_hasher_cfg cfg;
+	struct fy_thread_pool_cfg tcfg;
+	struct fy_thread_pool *tp;
+	struct fy_blake3_hasher *fyh, *fyh_ref;
+	uint8_t expected[FY_BLAKE3_OUT_LEN];
+	char path[] = "/tmp/libfyaml-test-b3-XXXXXX";
+	const uint8_t *hash;
+	uint8_t *data;
+	unsigned int i, j;
+	int fd;
+
+	data = malloc(cases[sizeof(cases)/sizeof(cases[0]) - 1].size);
+	ck_assert_ptr_ne(data, NULL);
+	blake3_test_fill(data, cases[sizeof(cases)/sizeof(cases[0]) - 1].size);
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	/* the reference is a single threaded hash of the memory */
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.num_threads = -1;
+	fyh_ref = fy_blake3_hasher_create(&cfg);
+	ck_assert_ptr_ne(fyh_ref, NULL);
+
+	for (i = 0; i < sizeof(tp_flags)/sizeof(tp_flags[0]); i++) {
+
+		tp = NULL;
+		if (tp_flags[i]) {
+			memset(&tcfg, 0, sizeof(tcfg));
+			tcfg.flags = tp_flags[i];
+			tcfg.num_threads = 4;
+			tp = fy_thread_pool_create(&tcfg);
+			ck_assert_ptr_ne(tp, NULL);
+		}
+
+		for (j = 0; j < sizeof(cases)/sizeof(cases[0]); j++) {
+
+			blake3_test_write_file(path, data, cases[j].size);
+			memcpy(expected, fy_blake3_hash(fyh_ref, data, cases[j].size), FY_BLAKE3_OUT_LEN);
+
+			/* no mmap and a pool, the reads overlap the hashing */
+			memset(&cfg, 0, sizeof(cfg));
+			cfg.no_mmap = true;
+			cfg.file_buffer = cases[j].file_buffer;
+			cfg.tp = tp;
+			cfg.num_threads = 4;
+			fyh = fy_blake3_hasher_create(&cfg);
+			ck_assert_ptr_ne(fyh, NULL);
+
+			hash = fy_blake3_hash_file(fyh, path);
+			ck_assert_ptr_ne(hash, NULL);
+			ck_assert(!memcmp(hash, expected, FY_BLAKE3_OUT_LEN));
+
+			fy_blake3_hasher_destroy(fyh);
+		}
+
+		if (tp)
+			fy_thread_pool_destroy(tp);
+	}
+
+	fy_blake3_hasher_destroy(fyh_ref);
+	unlink(path);
+	free(data);
+}
+END_TEST
+
+START_TEST(blake3_hash_files)
+{
+	/* more than a batch of small files, a large one and a missing one */
+	enum { NFILES = 300, MISSING = 150, LARGE = 200, LARGE_SIZE = 300000 };
+	static const int num_threads[] = { -1, 4 };
+	static uint8_t data[LARGE_SIZE];
+	static uint8_t outputs[NFILES][FY_BLAKE3_OUT_LEN];
+	static char paths[NFILES][64];
+	const char *filenames[NFILES];
+	int errs[NFILES];
+	struct fy_blake3_hasher_cfg cfg;
+	struct fy_blake3_hasher *fyh;
+	char dir[] = "/tmp/libfyaml-test-b3-XXXXXX";
+	const uint8_t *hash;
+	unsigned int i, j;
+
+	blake3_test_fill(data, sizeof(data));
+
+	ck_assert_ptr_ne(mkdtemp(dir), NULL);
+
+	for (i = 0; i < NFILES; i++) {
+		snprintf(paths[i], sizeof(paths[i]), "%s/f%03u", dir, i);
+		filenames[i] = paths[i];
+		if (i == MISSING)
+			continue;
+		blake3_test_write_file(paths[i], data, i == LARGE ? LARGE_SIZE : (i * 131) % 5000);
+	}
+
+	for (j = 0; j < sizeof(num_threads)/sizeof(num_threads[0]); j++) {
+		memset(&cfg, 0, sizeof(cfg));
+		cfg.num_threads = num_threads[j];
+		fyh = fy_blake3_hasher_create(&cfg);
+		ck_assert_ptr_ne(fyh, NULL);
+
+		memset(outputs, 0, sizeof(outputs));
+		memset(errs, 0xff, sizeof(errs));
+		ck_assert_int_eq(fy_blake3_hash_files(fyh, filenames, NFILES, outputs, errs), -1);
+
+		/* in order, and the same as hashing each file on its own */
+		for (i = 0; i < NFILES; i++) {
+			hash = fy_blake3_hash_file(fyh, filenames[i]);
+			if (i == MISSING) {
+				ck_assert_ptr_eq(hash, NULL);
+				ck_assert_int_eq(errs[i], ENOENT);
+				continue;
+			}
+			ck_assert_ptr_ne(hash, NULL);
+			ck_assert_int_eq(errs[i], 0);
+			ck_assert(!memcmp(outputs[i], hash, FY_BLAKE3_OUT_LEN));
+		}
+
+		/* without the missing file all succeed, errs is optional */
+		ck_assert_int_eq(fy_blake3_hash_files(fyh, filenames, MISSING, outputs, NULL), 0);
+		ck_assert_int_eq(fy_blake3_hash_files(fyh, filenames, 0, NULL, NULL), 0);
+
+		fy_blake3_hasher_destroy(fyh);
+	}
+
+	for (i = 0; i < NFILES; i++) {
+		if (i != MISSING)
+			unlink(paths[i]);
+	}
+	rmdir(dir);
+}
+END_TEST
+
+START_TEST(blake3_outboard)
+{
+	/* around the chunk (1K) and the group (1K and 16K) boundaries */
+	static const size_t sizes[] = {
+		0, 1, 1023, 1024, 1025, 2048, 16383, 16384, 16385,
+		3 * 16384 + 100, 65536, 131073
+	};
+	static const unsigned int group_logs[] = { 0, FY_BLAKE3_OUTBOARD_GROUP_LOG };
+	static uint8_t data[131073];
+	struct fy_blake3_hasher_cfg cfg;
+	struct fy_blake3_hasher *fyh;
+	uint8_t root[FY_BLAKE3_OUT_LEN], *outboard;
+	const uint8_t *hash;
+	size_t size, obsize, off, len, ranges[3][2];
+	unsigned int i, j, k;
+
+	blake3_test_fill(data, sizeof(data));
+
+	memset(&cfg, 0, sizeof(cfg));
+	fyh = fy_blake3_hasher_create(&cfg);
+	ck_assert_ptr_ne(fyh, NULL);
+
+	for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+		for (j = 0; j < sizeof(group_logs)/sizeof(group_logs[0]); j++) {
+			size = sizes[i];
+
+			obsize = fy_blake3_outboard_size(size, group_logs[j]);
+			ck_assert_int_ge(obsize, 16);
+			outboard = malloc(obsize);
+			ck_assert_ptr_ne(outboard, NULL);
+
+			/* the root is the plain hash of the content */
+			hash = fy_blake3_outboard_encode(fyh, data, size, group_logs[j], outboard, obsize);
+			ck_assert_ptr_ne(hash, NULL);
+			memcpy(root, hash, FY_BLAKE3_OUT_LEN);
+			ck_assert(!memcmp(root, fy_blake3_hash(fyh, data, size), FY_BLAKE3_OUT_LEN));
+
+			ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, 0, size), 0);
+
+			/* a too short outboard buffer */
+			ck_assert_ptr_eq(fy_blake3_outboard_encode(fyh, data, size, group_logs[j], outboard, obsize - 1), NULL);
+
+			if (!size) {
+				free(outboard);
+				continue;
+			}
+
+			/* first byte, last byte, and a range in the middle */
+			ranges[0][0] = 0;
+			ranges[0][1] = 1;
+			ranges[1][0] = size - 1;
+			ranges[1][1] = 1;
+			ranges[2][0] = size / 2;
+			ranges[2][1] = size - size / 2 < 3000 ? size - size / 2 : 3000;
+
+			for (k = 0; k < 3; k++) {
+				off = ranges[k][0];
+				len = ranges[k][1];
+
+				ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, off, len), 0);
+
+				/* a flipped byte inside the range fails */
+				data[off + len / 2] ^= 0x01;
+				ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, off, len), -1);
+				data[off + len / 2] ^= 0x01;
+			}
+
+			/* a range past the end fails */
+			ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, size - 1, 2), -1);
+
+			/* corrupted outboard header */
+			outboard[0] ^= 0x01;
+			ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, 0, size), -1);
+			outboard[0] ^= 0x01;
+
+			/* corrupted root parent node, which is on the path of every range */
+			if (obsize > 16) {
+				outboard[16] ^= 0x01;
+				ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, 0, 1), -1);
+				ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, size - 1, 1), -1);
+				outboard[16] ^= 0x01;
+				outboard[obsize - 1] ^= 0x01;
+				ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, 0, size), -1);
+				outboard[obsize - 1] ^= 0x01;
+			}
+
+			ck_assert_int_eq(fy_blake3_outboard_verify(fyh, root, outboard, obsize, data, 0, size), 0);
+
+			free(outboard);
+		}
+	}
+
+	fy_blake3_hasher_destroy(fyh);
+}
+END_TEST
+
+/* the path texts as produced by the full per-event rebuild of the path */
+static const struct {
+	enum fy_event_type type;
+	const char *text;
+} compose_path_expected[] = {
+	{ FYET_STREAM_START,	"/" },
+	{ FYET_DOCUMENT_START,	"/" },
+	{ FYET_MAPPING_START,	"/" },
+	{ FYET_SCALAR,		"/.key(top)" },
+	{ FYET_MAPPING_START,	"/top/" },
+	{ FYET_SCALAR,		"/top/.key(list)" },
+	{ FYET_SEQUENCE_START,	"/top/list/" },
+	{ FYET_MAPPING_START,	"/top/list/0/" },
+	{ FYET_SCALAR,		"/top/list/0/.key(name)" },
+	{ FYET_SCALAR,		"/top/list/0/name" },
+	{ FYET_SCALAR,		"/top/list/0/.key(quoted key)" },
+	{ FYET_SCALAR,		"/top/list/0/quoted key" },
+	{ FYET_SCALAR,		"/top/list/0/.key(single)" },
+	{ FYET_MAPPING_START,	"/top/list/0/single/" },
+	{ FYET_SCALAR,		"/top/list/0/single/.key(inner)" },
+	{ FYET_SEQUENCE_START,	"/top/list/0/single/inner/" },
+	{ FYET_SCALAR,		"/top/list/0/single/inner/0" },
+	{ FYET_SCALAR,		"/top/list/0/single/inner/1" },
+	{ FYET_SEQUENCE_END,	"/top/list/0/single/inner/" },
+	{ FYET_MAPPING_END,	"/top/list/0/single/" },
+	{ FYET_MAPPING_END,	"/top/list/0/" },
+	{ FYET_SCALAR,		"/top/list/1" },
+	{ FYET_SEQUENCE_START,	"/top/list/2/" },
+	{ FYET_SCALAR,		"/top/list/2/0" },
+	{ FYET_MAPPING_START,	"/top/list/2/1/" },
+	{ FYET_SCALAR,		"/top/list/2/1/.key(d)" },
+	{ FYET_SCALAR,		"/top/list/2/1/d" },
+	{ FYET_MAPPING_END,	"/top/list/2/1/" },
+	{ FYET_SEQUENCE_END,	"/top/list/2/" },
+	{ FYET_SEQUENCE_END,	"/top/list/" },
+	{ FYET_SCALAR,		"/top/.key(after)" },
+	{ FYET_SCALAR,		"/top/after" },
+	{ FYET_MAPPING_END,	"/top/" },
+	{ FYET_SCALAR,		"/.key(second)" },
+	{ FYET_SCALAR,		"/second" },
+	{ FYET_MAPPING_END,	"/" },
+	{ FYET_DOCUMENT_END,	"/" },
+	{ FYET_STREAM_END,	"/" },
+};
+
+static enum fy_composer_return
+compose_path_check(struct fy_parser *fyp, struct fy_event *fye,
+		   struct fy_path *path, void *userdata)
+{
+	unsigned int *countp = userdata;
+	unsigned int idx = (*countp)++;
+	const char *text0;
+	char *text;
+
+	ck_assert(idx < sizeof(compose_path_expected)/sizeof(compose_path_expected[0]));
+	ck_assert_int_eq(fye->type, compose_path_expected[idx].type);
+
+	/* the borrowed, incrementally maintained text */
+	text0 = fy_path_get_text0(path);
+	ck_assert_ptr_ne(text0, NULL);
+	ck_assert_str_eq(text0, compose_path_expected[idx].text);
+
+	/* and the allocated copy */
+	text = fy_path_get_text(path);
+	ck_assert_ptr_ne(text, NULL);
+	ck_assert_str_eq(text, compose_path_expected[idx].text);
+	free(text);
+
+	return FYCR_OK_CONTINUE;
+}
+
+START_TEST(compose_path_text)
+{
+	static const char yaml[] =
+		"top:\n"
+		"  list:\n"
+		"    - name: one\n"
+		"      \"quoted key\": 1\n"
+		"      'single': { inner: [a, b] }\n"
+		"    - plain\n"
+		"    - [c, { d: e }]\n"
+		"  after: 2\n"
+		"second: last\n";
+	struct fy_parse_cfg cfg;
+	struct fy_parser *fyp;
+	unsigned int count = 0;
+	int rc;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.flags = FYPCF_QUIET;
+
+	fyp = fy_parser_create(&cfg);
+	ck_assert_ptr_ne(fyp, NULL);
+
+	rc = fy_parser_set_string(fyp, yaml, sizeof(yaml) - 1);
+	ck_assert_int_eq(rc, 0);
+
+	rc = fy_parse_compose(fyp, compose_path_check, &count);
+	ck_assert_int_eq(rc, 0);
+
+	/* every event was seen */
+	ck_assert_int_eq(count, sizeof(compose_path_expected)/sizeof(compose_path_expected[0]));
+
+	fy_parser_destroy(fyp);
+}
+END_TEST
+
 TCase *libfyaml_case_core(void)
 {
 	TCase *tc;
@@ -2007,9 +3069,12 @@ TCase *libfyaml_case_core(void)
 	tcase_add_test(tc, doc_build_scalar);
 	tcase_add_test(tc, doc_build_sequence);
 	tcase_add_test(tc, doc_build_mapping);
+	tcase_add_test(tc, doc_build_filtered);
+	tcase_add_test(tc, doc_builder_filter);
 
 	tcase_add_test(tc, doc_path_access);
 	tcase_add_test(tc, doc_path_node);
+	tcase_add_test(tc, doc_path_handle);
 	tcase_add_test(tc, doc_path_parent);
 	tcase_add_test(tc, doc_short_path);
 	tcase_add_test(tc, doc_scalar_path);
@@ -2031,6 +3096,7 @@ TCase *libfyaml_case_core(void)
 	tcase_add_test(tc, doc_insert_remove_map);
 
 	tcase_add_test(tc, doc_sort);
+	tcase_add_test(tc, doc_digest);
 
 	tcase_add_test(tc, doc_join_scalar_to_scalar);
 	tcase_add_test(tc, doc_join_scalar_to_map);
@@ -2065,6 +3131,19 @@ TCase *libfyaml_case_core(void)
 
 	tcase_add_test(tc, scanf_check);
 
+	tcase_add_test(tc, ypath_parallel);
+	tcase_add_test(tc, thread_spawn_sync);
+	tcase_add_test(tc, thread_pool_stats);
+	tcase_add_test(tc, thread_pool_placement);
+
+	tcase_add_test(tc, blake3_state_save_restore);
+	tcase_add_test(tc, blake3_file_resume);
+	tcase_add_test(tc, blake3_stream_pipelined);
+	tcase_add_test(tc, blake3_hash_files);
+	tcase_add_test(tc, blake3_outboard);
+
+	tcase_add_test(tc, compose_path_text);
+
         tcase_add_test(tc, token_test);
 
 	return tc;
@@ -17,6 +17,7 @@
 #include <getopt.h>
 #include <unistd.h>
 #include <limits.h>
+#include <stdbool.h>
 
 #include <check.h>
 
@@ -112,6 +113,781 @@ START_TEST(emit_simple)
 }
 END_TEST
 
+struct test_buffered_data {
+	char buf[4096];
+	size_t count;
+	int calls;
+	bool runs_ok;
+};
+
+static int buffered_output(struct fy_emitter *emit, enum fy_emitter_write_type type,
+			   const char *str, int len, void *userdata)
+{
+	struct test_buffered_data *data = userdata;
+	const struct fy_emitter_write_run *runs;
+	unsigned int i, count;
+	int total;
+
+	if (data->count + len >= sizeof(data->buf))
+		return -1;
+	memcpy(data->buf + data->count, str, len);
+	data->count += len;
+	data->buf[data->count] = '\0';
+	data->calls++;
+
+	/* the runs must cover the chunk exactly */
+	runs = fy_emitter_get_write_runs(emit, &count);
+	if (!runs || !count || runs[0].type != type)
+		data->runs_ok = false;
+	for (i = 0, total = 0; runs && i < count; i++)
+		total += runs[i].len;
+	if (total != len)
+		data->runs_ok = false;
+
+	return len;
+}
+
+START_TEST(emit_buffered)
+{
+	static const char *yaml = "foo: &anchor [ 1, 2, 'three' ]\nbar: *anchor\n";
+	/* a tiny buffer forces flushes and pass through writes */
+	static const size_t sizes[] = { 4096, 4 };
+	struct test_buffered_data data;
+	struct fy_emitter_cfg cfg;
+	struct fy_emitter *emit;
+	struct fy_document *fyd;
+	char *expected;
+	unsigned int i;
+	int rc;
+
+	fyd = fy_document_build_from_string(NULL, yaml, FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	expected = fy_emit_document_to_string(fyd, FYECF_DEFAULT);
+	ck_assert_ptr_ne(expected, NULL);
+
+	for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+
+		memset(&data, 0, sizeof(data));
+		data.runs_ok = true;
+
+		memset(&cfg, 0, sizeof(cfg));
+		cfg.output = buffered_output;
+		cfg.userdata = &data;
+		cfg.flags = FYECF_DEFAULT;
+
+		emit = fy_emitter_create(&cfg);
+		ck_assert_ptr_ne(emit, NULL);
+
+		rc = fy_emitter_set_output_buffer(emit, sizes[i], true);
+		ck_assert_int_eq(rc, 0);
+
+		rc = fy_emit_document(emit, fyd);
+		ck_assert_int_eq(rc, 0);
+
+		rc = fy_emitter_flush(emit);
+		ck_assert_int_eq(rc, 0);
+
+		/* with a large buffer everything arrives in one chunk at document end */
+		if (i == 0)
+			ck_assert_int_eq(data.calls, 1);
+		else
+			ck_assert_int_gt(data.calls, 1);
+		ck_assert(data.runs_ok);
+		ck_assert_str_eq(data.buf, expected);
+
+		fy_emitter_destroy(emit);
+	}
+
+	free(expected);
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+START_TEST(emit_to_fp_gather)
+{
+	struct fy_document *fyd;
+	struct fy_node *fyn;
+	char *expected, *buf;
+	FILE *fp;
+	long size;
+	int i, rc;
+
+	/* enough long scalars to be gathered, and to overflow the iovec array */
+	fyd = fy_document_create(NULL);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	fyn = fy_node_create_sequence(fyd);
+	ck_assert_ptr_ne(fyn, NULL);
+	fy_document_set_root(fyd, fyn);
+
+	for (i = 0; i < 1000; i++) {
+		rc = fy_node_sequence_append(fyn,
+				fy_node_buildf(fyd, "{ key-%d: 'a long enough single quoted scalar %d', "
+						    "plain-%d: a long enough plain scalar that is written directly }",
+						    i, i, i));
+		ck_assert_int_eq(rc, 0);
+	}
+
+	expected = fy_emit_document_to_string(fyd, FYECF_DEFAULT);
+	ck_assert_ptr_ne(expected, NULL);
+
+	fp = tmpfile();
+	ck_assert_ptr_ne(fp, NULL);
+
+	/* stdio buffered output before and after must stay in order */
+	fputs("#", fp);
+	rc = fy_emit_document_to_fp(fyd, FYECF_DEFAULT, fp);
+	ck_assert_int_eq(rc, 0);
+	fputs("#", fp);
+
+	fflush(fp);
+	size = ftell(fp);
+	ck_assert_int_eq(size, (long)strlen(expected) + 2);
+
+	buf = malloc(size + 1);
+	ck_assert_ptr_ne(buf, NULL);
+	rewind(fp);
+	ck_assert_int_eq(fread(buf, 1, size, fp), size);
+	buf[size] = '\0';
+	fclose(fp);
+
+	ck_assert_int_eq(buf[0], '#');
+	ck_assert_int_eq(buf[size - 1], '#');
+	buf[size - 1] = '\0';
+	ck_assert_str_eq(buf + 1, expected);
+
+	free(buf);
+	free(expected);
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+START_TEST(emit_json_escapes)
+{
+	static const struct {
+		const char *yaml;
+		const char *json;
+	} cases[] = {
+		{ "plain text", "\"plain text\"" },
+		{ "'quote \" and \\ back'", "\"quote \\\" and \\\\ back\"" },
+		{ "\"tab\\tnl\\nbell\\a\"", "\"tab\\tnl\\nbell\\u0007\"" },
+		{ "\"del\\x7f nbsp\\u00a0 \\U0001F600\"", "\"del\\u007F nbsp\\u00A0 \\uD83D\\uDE00\"" },
+		{ "{ key with spaces: [ 1, null, 'a\\b' ] }",
+		  "{\"key with spaces\": [1, null, \"a\\\\b\"]}" },
+	};
+	struct fy_document *fyd;
+	char *buf;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+		fyd = fy_document_build_from_string(NULL, cases[i].yaml, FY_NT);
+		ck_assert_ptr_ne(fyd, NULL);
+
+		buf = fy_emit_document_to_string(fyd, FYECF_MODE_JSON_ONELINE | FYECF_NO_ENDING_NEWLINE);
+		ck_assert_ptr_ne(buf, NULL);
+		ck_assert_str_eq(buf, cases[i].json);
+
+		free(buf);
+		fy_document_destroy(fyd);
+	}
+}
+END_TEST
+
+static int parallel_output(struct fy_emitter *emit, enum fy_emitter_write_type type,
+			   const char *str, int len, void *userdata)
+{
+	struct test_emitter_data *data = userdata;
+
+	/* keep the output contiguous */
+	if (collect_output(emit, type, str, len, data) != len)
+		return -1;
+	data->count--;
+	return len;
+}
+
+START_TEST(emit_parallel)
+{
+	static const enum fy_emitter_cfg_flags modes[] = {
+		FYECF_DEFAULT,
+		FYECF_MODE_BLOCK,
+		FYECF_MODE_FLOW,
+		FYECF_MODE_JSON | FYECF_SORT_KEYS,
+		FYECF_MODE_FLOW_ONELINE,
+	};
+	struct test_emitter_data data;
+	struct fy_document *fyd;
+	struct fy_node *fyn, *fynm;
+	char *expected;
+	unsigned int i;
+	int j, rc;
+
+	/* a large sequence of mappings, with a large mapping inside */
+	fyd = fy_document_create(NULL);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	fyn = fy_node_create_sequence(fyd);
+	ck_assert_ptr_ne(fyn, NULL);
+	fy_document_set_root(fyd, fyn);
+
+	for (j = 0; j < 200; j++) {
+		rc = fy_node_sequence_append(fyn,
+				fy_node_buildf(fyd, "{ key-%d: 'quoted %d', seq-%d: [ %d, \"two\" ], "
+						    "folded-%d: a long enough plain scalar that must be "
+						    "folded when it is output in the block modes }",
+						    j, j, j, j, j));
+		ck_assert_int_eq(rc, 0);
+	}
+
+	fynm = fy_node_create_mapping(fyd);
+	ck_assert_ptr_ne(fynm, NULL);
+	for (j = 0; j < 100; j++) {
+		rc = fy_node_mapping_append(fynm,
+				fy_node_buildf(fyd, "k%03d", 99 - j),
+				fy_node_buildf(fyd, "[ %d, { x: y } ]", j));
+		ck_assert_int_eq(rc, 0);
+	}
+	rc = fy_node_sequence_append(fyn, fynm);
+	ck_assert_int_eq(rc, 0);
+
+	for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++) {
+
+		expected = fy_emit_document_to_string(fyd, modes[i]);
+		ck_assert_ptr_ne(expected, NULL);
+
+		memset(&data, 0, sizeof(data));
+		data.cfg.output = parallel_output;
+		data.cfg.userdata = &data;
+		data.cfg.flags = modes[i];
+		data.emit = fy_emitter_create(&data.cfg);
+		ck_assert_ptr_ne(data.emit, NULL);
+
+		rc = fy_emitter_set_parallel(data.emit, NULL, 16);
+		ck_assert_int_eq(rc, 0);
+
+		rc = fy_emit_document(data.emit, fyd);
+		ck_assert_int_eq(rc, 0);
+
+		ck_assert_ptr_ne(data.buf, NULL);
+		ck_assert_str_eq(data.buf, expected);
+
+		cleanup_test_emitter(&data);
+		free(expected);
+	}
+
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+struct parallel_diag {
+	char buf[4096];
+	size_t len;
+};
+
+static void parallel_diag_output(struct fy_diag *diag, void *user, const char *buf, size_t len)
+{
+	struct parallel_diag *pd = user;
+
+	(void)diag;
+	if (len > sizeof(pd->buf) - 1 - pd->len)
+		len = sizeof(pd->buf) - 1 - pd->len;
+	memcpy(pd->buf + pd->len, buf, len);
+	pd->len += len;
+	pd->buf[pd->len] = '\0';
+}
+
+START_TEST(emit_parallel_error)
+{
+	/* non scalar keys fail in JSON mode, at the top or in nested mappings */
+	static const struct {
+		const char *key;
+		const char *value;
+	} bad[] = {
+		{ "[ k%d ]",	"1"			},
+		{ "k%03d",	"{ [ x%d ]: y }"	},
+	};
+	struct parallel_diag pd;
+	struct test_emitter_data data;
+	struct fy_diag_cfg dcfg;
+	struct fy_diag *diag;
+	struct fy_document *fyd;
+	struct fy_node *fyn;
+	char *serial, *serial_diag;
+	unsigned int i;
+	int j, k, rc;
+
+	memset(&pd, 0, sizeof(pd));
+
+	fy_diag_cfg_default(&dcfg);
+	dcfg.fp = NULL;
+	dcfg.output_fn = parallel_diag_output;
+	dcfg.user = &pd;
+	dcfg.colorize = false;
+	diag = fy_diag_create(&dcfg);
+	ck_assert_ptr_ne(diag, NULL);
+
+	for (i = 0; i < sizeof(bad)/sizeof(bad[0]); i++) {
+
+		fyd = fy_document_create(NULL);
+		ck_assert_ptr_ne(fyd, NULL);
+		rc = fy_document_set_diag(fyd, diag);
+		ck_assert_int_eq(rc, 0);
+
+		fyn = fy_node_create_mapping(fyd);
+		ck_assert_ptr_ne(fyn, NULL);
+		fy_document_set_root(fyd, fyn);
+
+		for (j = 0; j < 100; j++) {
+			if (j == 30 || j == 70)
+				rc = fy_node_mapping_append(fyn,
+						fy_node_buildf(fyd, bad[i].key, j),
+						fy_node_buildf(fyd, bad[i].value, j));
+			else
+				rc = fy_node_mapping_append(fyn,
+						fy_node_buildf(fyd, "k%03d", j),
+						fy_node_buildf(fyd, "%d", j));
+			ck_assert_int_eq(rc, 0);
+		}
+
+		/* serial first, then in parallel; output and diagnostics must match */
+		serial = serial_diag = NULL;
+		for (k = 0; k < 2; k++) {
+			pd.len = 0;
+			pd.buf[0] = '\0';
+
+			memset(&data, 0, sizeof(data));
+			data.cfg.output = parallel_output;
+			data.cfg.userdata = &data;
+			/* sorted, so that it's not the fast JSON path */
+			data.cfg.flags = FYECF_MODE_JSON | FYECF_SORT_KEYS;
+			data.emit = fy_emitter_create(&data.cfg);
+			ck_assert_ptr_ne(data.emit, NULL);
+
+			if (k) {
+				rc = fy_emitter_set_parallel(data.emit, NULL, 16);
+				ck_assert_int_eq(rc, 0);
+			}
+
+			(void)fy_emit_document(data.emit, fyd);
+			ck_assert_ptr_ne(data.buf, NULL);
+
+			if (!k) {
+				ck_assert(pd.len > 0);
+				serial = strdup(data.buf);
+				serial_diag = strdup(pd.buf);
+			} else {
+				ck_assert_str_eq(data.buf, serial);
+				ck_assert_str_eq(pd.buf, serial_diag);
+			}
+
+			cleanup_test_emitter(&data);
+		}
+
+		free(serial_diag);
+		free(serial);
+		fy_document_destroy(fyd);
+	}
+
+	fy_diag_unref(diag);
+}
+END_TEST
+
+START_TEST(emit_rope)
+{
+	static const enum fy_emit_rope_flags rope_flags[] = {
+		FYERF_DEFAULT,
+		FYERF_CONTIGUOUS,
+	};
+	struct fy_emitter *emit;
+	struct fy_document *fyd;
+	struct fy_node *fyn;
+	char *expected, *buf;
+	const char *data;
+	void *iter;
+	size_t len, size, total;
+	unsigned int j, segments;
+	FILE *fp;
+	int i, rc;
+
+	/* large enough for a few segments */
+	fyd = fy_document_create(NULL);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	fyn = fy_node_create_sequence(fyd);
+	ck_assert_ptr_ne(fyn, NULL);
+	fy_document_set_root(fyd, fyn);
+
+	for (i = 0; i < 5000; i++) {
+		rc = fy_node_sequence_append(fyn,
+				fy_node_buildf(fyd, "{ key-%d: 'a long enough single quoted scalar %d' }", i, i));
+		ck_assert_int_eq(rc, 0);
+	}
+
+	expected = fy_emit_document_to_string(fyd, FYECF_DEFAULT);
+	ck_assert_ptr_ne(expected, NULL);
+	size = strlen(expected);
+
+	for (j = 0; j < sizeof(rope_flags)/sizeof(rope_flags[0]); j++) {
+
+		emit = fy_emit_to_rope(FYECF_DEFAULT, rope_flags[j]);
+		ck_assert_ptr_ne(emit, NULL);
+
+		rc = fy_emit_document(emit, fyd);
+		ck_assert_int_eq(rc, 0);
+
+		ck_assert_int_eq(fy_emit_rope_size(emit), size);
+
+		/* the segments in order are the output */
+		total = 0;
+		segments = 0;
+		iter = NULL;
+		while ((data = fy_emit_rope_iterate(emit, &iter, &len)) != NULL) {
+			ck_assert_int_le(total + len, size);
+			ck_assert(!memcmp(data, expected + total, len));
+			total += len;
+			segments++;
+		}
+		ck_assert_int_eq(total, size);
+		if (rope_flags[j] & FYERF_CONTIGUOUS)
+			ck_assert_int_eq(segments, 1);
+		else
+			ck_assert_int_gt(segments, 1);
+
+		/* and so is what's written out */
+		fp = tmpfile();
+		ck_assert_ptr_ne(fp, NULL);
+
+		rc = fy_emit_rope_write(emit, fileno(fp));
+		ck_assert_int_eq(rc, 0);
+
+		buf = malloc(size + 1);
+		ck_assert_ptr_ne(buf, NULL);
+		rewind(fp);
+		ck_assert_int_eq(fread(buf, 1, size + 1, fp), size);
+		buf[size] = '\0';
+		fclose(fp);
+
+		ck_assert_str_eq(buf, expected);
+		free(buf);
+
+		fy_emitter_destroy(emit);
+	}
+
+	free(expected);
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+START_TEST(emit_canonical)
+{
+	struct test_emitter_data data;
+	struct fy_document *fyd;
+	struct fy_node *fyn, *fyn_key;
+	char *expected;
+	int i, j, rc;
+
+	fyd = fy_document_build_from_string(NULL,
+			"zeta: 1\n"
+			"&a alpha: 2\n"
+			"? [ seq, key ]\n"
+			": 3\n"
+			"\"beta\\tquoted\": 4\n"
+			"*a : 5\n"
+			"? { map: key }\n"
+			": 6\n"
+			"beta: 7\n"
+			"nested: { z: 1, y: 2, x: [ c, b, a ] }\n", FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	for (i = 0; i < 3; i++) {
+
+		/* the canonical output is the sorted keys output */
+		expected = fy_emit_document_to_string(fyd, FYECF_SORT_KEYS);
+		ck_assert_ptr_ne(expected, NULL);
+
+		/* twice, the second time using the cached order */
+		for (j = 0; j < 2; j++) {
+			memset(&data, 0, sizeof(data));
+			data.cfg.output = parallel_output;
+			data.cfg.userdata = &data;
+			data.cfg.flags = FYECF_DEFAULT;
+			data.emit = fy_emitter_create(&data.cfg);
+			ck_assert_ptr_ne(data.emit, NULL);
+
+			rc = fy_emitter_set_canonical(data.emit, true);
+			ck_assert_int_eq(rc, 0);
+
+			rc = fy_emit_document(data.emit, fyd);
+			ck_assert_int_eq(rc, 0);
+			ck_assert_ptr_ne(data.buf, NULL);
+			ck_assert_str_eq(data.buf, expected);
+
+			cleanup_test_emitter(&data);
+		}
+		free(expected);
+
+		/* modifications must be reflected */
+		fyn = fy_document_root(fyd);
+		switch (i) {
+		case 0:
+			rc = fy_node_mapping_append(fyn,
+					fy_node_build_from_string(fyd, "aardvark", FY_NT),
+					fy_node_build_from_string(fyd, "8", FY_NT));
+			ck_assert_int_eq(rc, 0);
+			break;
+		case 1:
+			fyn_key = fy_node_build_from_string(fyd, "zeta", FY_NT);
+			ck_assert_ptr_ne(fyn_key, NULL);
+			/* the lookup key is consumed */
+			fy_node_free(fy_node_mapping_remove_by_key(fyn, fyn_key));
+			break;
+		}
+	}
+
+	expected = fy_emit_document_to_string(fyd, FYECF_MODE_FLOW_ONELINE | FYECF_SORT_KEYS);
+	ck_assert_ptr_ne(expected, NULL);
+	ck_assert_str_eq(expected,
+			"{{map: key}: 6, [seq, key]: 3, *a : 5, aardvark: 8, &a alpha: 2, beta: 7, "
+			"\"beta\\tquoted\": 4, nested: {x: [c, b, a], y: 2, z: 1}}\n");
+	free(expected);
+
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+static char *emit_canonical_string(struct fy_document *fyd)
+{
+	struct test_emitter_data data;
+	char *buf;
+	int rc;
+
+	memset(&data, 0, sizeof(data));
+	data.cfg.output = parallel_output;
+	data.cfg.userdata = &data;
+	data.cfg.flags = FYECF_DEFAULT;
+	data.emit = fy_emitter_create(&data.cfg);
+	ck_assert_ptr_ne(data.emit, NULL);
+
+	rc = fy_emitter_set_canonical(data.emit, true);
+	ck_assert_int_eq(rc, 0);
+
+	rc = fy_emit_document(data.emit, fyd);
+	ck_assert_int_eq(rc, 0);
+	ck_assert_ptr_ne(data.buf, NULL);
+
+	/* the buffer is taken over from the emitter data */
+	buf = data.buf;
+	data.buf = NULL;
+	cleanup_test_emitter(&data);
+
+	return buf;
+}
+
+START_TEST(emit_canonical_key_replace)
+{
+	struct fy_document *fyd;
+	char *before, *after, *expected;
+	int rc;
+
+	/* the alias key sorts first, and as "z" (last) after it's resolved */
+	fyd = fy_document_build_from_string(NULL,
+			"k: &x z\n"
+			"m: 2\n"
+			"*x : 1\n", FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	/* caches the order of the root mapping */
+	before = emit_canonical_string(fyd);
+
+	/* the alias key is replaced in place by a copy of the anchored node */
+	rc = fy_document_resolve(fyd);
+	ck_assert_int_eq(rc, 0);
+
+	after = emit_canonical_string(fyd);
+	expected = fy_emit_document_to_string(fyd, FYECF_SORT_KEYS);
+	ck_assert_ptr_ne(expected, NULL);
+	ck_assert_str_eq(after, expected);
+	ck_assert_str_ne(after, before);
+
+	free(expected);
+	free(after);
+	free(before);
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+START_TEST(emit_sort_keys_order)
+{
+	static const char *expected =
+		"{a: 2, a-b: 1, beta: 4, \"beta\\t\": 3, plain: y, plain-simple: x}\n";
+	struct test_emitter_data data;
+	struct fy_document *fyd;
+	char *buf;
+	int rc;
+
+	/* keys that are prefixes of other keys, in direct and non-direct forms */
+	fyd = fy_document_build_from_string(NULL,
+			"a-b  : 1\n"
+			"a: 2\n"
+			"\"beta\\t\": 3\n"
+			"beta: 4\n"
+			"plain-simple  :  x\n"
+			"plain: y\n", FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+
+	/* the shorter key always sorts first */
+	buf = fy_emit_document_to_string(fyd, FYECF_MODE_FLOW_ONELINE | FYECF_SORT_KEYS);
+	ck_assert_ptr_ne(buf, NULL);
+	ck_assert_str_eq(buf, expected);
+	free(buf);
+
+	/* same order when canonical */
+	memset(&data, 0, sizeof(data));
+	data.cfg.output = parallel_output;
+	data.cfg.userdata = &data;
+	data.cfg.flags = FYECF_MODE_FLOW_ONELINE;
+	data.emit = fy_emitter_create(&data.cfg);
+	ck_assert_ptr_ne(data.emit, NULL);
+
+	rc = fy_emitter_set_canonical(data.emit, true);
+	ck_assert_int_eq(rc, 0);
+
+	rc = fy_emit_document(data.emit, fyd);
+	ck_assert_int_eq(rc, 0);
+	ck_assert_ptr_ne(data.buf, NULL);
+	ck_assert_str_eq(data.buf, expected);
+
+	cleanup_test_emitter(&data);
+
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+/* the same content, either via events or via the direct interface */
+static int emit_raw_content(struct fy_emitter *emit, bool raw)
+{
+	int rc = 0;
+
+#define EMIT_RAW_OR_EVENT(_raw, ...) \
+	do { \
+		if (!rc) \
+			rc = raw ? (_raw) : fy_emit_eventf(emit, __VA_ARGS__); \
+	} while (0)
+
+	rc = fy_emit_eventf(emit, FYET_STREAM_START);
+	if (!rc)
+		rc = fy_emit_eventf(emit, FYET_DOCUMENT_START, 1, NULL, NULL);
+
+	EMIT_RAW_OR_EVENT(fy_emit_mapping_start_raw(emit, FYNS_ANY),
+			  FYET_MAPPING_START, FYNS_ANY, NULL, NULL);
+
+	/* the anchor is only available via events */
+	if (!rc)
+		rc = fy_emit_eventf(emit, FYET_SCALAR, FYSS_PLAIN, "anchored", FY_NT, NULL, NULL);
+	if (!rc)
+		rc = fy_emit_eventf(emit, FYET_SCALAR, FYSS_DOUBLE_QUOTED, "value\n", FY_NT, "a", NULL);
+
+	EMIT_RAW_OR_EVENT(fy_emit_scalar_raw(emit, FYSS_PLAIN, "alias", FY_NT),
+			  FYET_SCALAR, FYSS_PLAIN, "alias", FY_NT, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_alias_raw(emit, "a"),
+			  FYET_ALIAS, "a");
+
+	EMIT_RAW_OR_EVENT(fy_emit_scalar_raw(emit, FYSS_SINGLE_QUOTED, "seq-xx", 3),
+			  FYET_SCALAR, FYSS_SINGLE_QUOTED, "seq-xx", (size_t)3, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_sequence_start_raw(emit, FYNS_BLOCK),
+			  FYET_SEQUENCE_START, FYNS_BLOCK, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_scalar_raw(emit, FYSS_LITERAL, "line1\nline2\n", FY_NT),
+			  FYET_SCALAR, FYSS_LITERAL, "line1\nline2\n", FY_NT, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_sequence_start_raw(emit, FYNS_ANY),
+			  FYET_SEQUENCE_START, FYNS_ANY, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_sequence_end_raw(emit),
+			  FYET_SEQUENCE_END);
+	EMIT_RAW_OR_EVENT(fy_emit_mapping_start_raw(emit, FYNS_FLOW),
+			  FYET_MAPPING_START, FYNS_FLOW, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_scalar_raw(emit, FYSS_ANY, "x", 1),
+			  FYET_SCALAR, FYSS_ANY, "x", (size_t)1, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_scalar_raw(emit, FYSS_ANY, "", 0),
+			  FYET_SCALAR, FYSS_ANY, "", (size_t)0, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_mapping_end_raw(emit),
+			  FYET_MAPPING_END);
+	EMIT_RAW_OR_EVENT(fy_emit_sequence_end_raw(emit),
+			  FYET_SEQUENCE_END);
+
+	/* a complex key */
+	EMIT_RAW_OR_EVENT(fy_emit_sequence_start_raw(emit, FYNS_FLOW),
+			  FYET_SEQUENCE_START, FYNS_FLOW, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_scalar_raw(emit, FYSS_PLAIN, "k1", FY_NT),
+			  FYET_SCALAR, FYSS_PLAIN, "k1", FY_NT, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_scalar_raw(emit, FYSS_PLAIN, "k2", FY_NT),
+			  FYET_SCALAR, FYSS_PLAIN, "k2", FY_NT, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_sequence_end_raw(emit),
+			  FYET_SEQUENCE_END);
+	EMIT_RAW_OR_EVENT(fy_emit_mapping_start_raw(emit, FYNS_ANY),
+			  FYET_MAPPING_START, FYNS_ANY, NULL, NULL);
+	EMIT_RAW_OR_EVENT(fy_emit_mapping_end_raw(emit),
+			  FYET_MAPPING_END);
+
+	EMIT_RAW_OR_EVENT(fy_emit_mapping_end_raw(emit),
+			  FYET_MAPPING_END);
+
+#undef EMIT_RAW_OR_EVENT
+
+	if (!rc)
+		rc = fy_emit_eventf(emit, FYET_DOCUMENT_END, 1);
+	if (!rc)
+		rc = fy_emit_eventf(emit, FYET_STREAM_END);
+
+	return rc;
+}
+
+START_TEST(emit_raw)
+{
+	static const enum fy_emitter_cfg_flags modes[] = {
+		FYECF_DEFAULT,
+		FYECF_MODE_BLOCK,
+		FYECF_MODE_FLOW,
+		FYECF_MODE_FLOW_ONELINE,
+	};
+	struct test_emitter_data data, data_raw;
+	unsigned int i;
+	int rc;
+
+	for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++) {
+
+		memset(&data, 0, sizeof(data));
+		data.cfg.output = parallel_output;
+		data.cfg.userdata = &data;
+		data.cfg.flags = modes[i];
+		data.emit = fy_emitter_create(&data.cfg);
+		ck_assert_ptr_ne(data.emit, NULL);
+
+		rc = emit_raw_content(data.emit, false);
+		ck_assert_int_eq(rc, 0);
+
+		memset(&data_raw, 0, sizeof(data_raw));
+		data_raw.cfg.output = parallel_output;
+		data_raw.cfg.userdata = &data_raw;
+		data_raw.cfg.flags = modes[i];
+		data_raw.emit = fy_emitter_create(&data_raw.cfg);
+		ck_assert_ptr_ne(data_raw.emit, NULL);
+
+		rc = emit_raw_content(data_raw.emit, true);
+		ck_assert_int_eq(rc, 0);
+
+		ck_assert_ptr_ne(data.buf, NULL);
+		ck_assert_ptr_ne(data_raw.buf, NULL);
+		ck_assert_str_eq(data_raw.buf, data.buf);
+
+		/* unbalanced end */
+		rc = fy_emit_sequence_end_raw(data_raw.emit);
+		ck_assert_int_ne(rc, 0);
+
+		cleanup_test_emitter(&data_raw);
+		cleanup_test_emitter(&data);
+	}
+}
+END_TEST
+
 TCase *libfyaml_case_emit(void)
 {
 	TCase *tc;
@@ -119,6 +895,16 @@ TCase *libfyaml_case_emit(void)
 	tc = tcase_create("emit");
 
 	tcase_add_test(tc, emit_simple);
+	tcase_add_test(tc, emit_buffered);
+	tcase_add_test(tc, emit_to_fp_gather);
+	tcase_add_test(tc, emit_json_escapes);
+	tcase_add_test(tc, emit_parallel);
+	tcase_add_test(tc, emit_parallel_error);
+	tcase_add_test(tc, emit_raw);
+	tcase_add_test(tc, emit_rope);
+	tcase_add_test(tc, emit_canonical);
+	tcase_add_test(tc, emit_canonical_key_replace);
+	tcase_add_test(tc, emit_sort_keys_order);
 
 	return tc;
 }
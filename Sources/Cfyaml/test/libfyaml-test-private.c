@@ -22,6 +22,10 @@
 
 #include <libfyaml.h>
 #include "fy-parse.h"
+#include "fy-doc.h"
+#include "fy-token.h"
+#include "fy-emit-accum.h"
+#include "xxhash.h"
 
 static const struct fy_parse_cfg default_parse_cfg = {
 	.search_path = "",
@@ -152,6 +156,378 @@ START_TEST(parse_simple)
 }
 END_TEST
 
+START_TEST(scan_plain_analyze)
+{
+	static const struct {
+		const char *data;
+		bool direct_output;
+		int set, clear;
+	} cases[] = {
+		/* trailing breaks are not part of the content */
+		{ "plain\n\n", true, FYTTAF_CAN_BE_PLAIN | FYTTAF_CAN_BE_SIMPLE_KEY | FYTTAF_DIRECT_OUTPUT,
+		  FYTTAF_HAS_LB | FYTTAF_HAS_WS },
+		{ "two words  \n", false, FYTTAF_CAN_BE_PLAIN | FYTTAF_HAS_WS, FYTTAF_HAS_LB },
+		{ "multi\n line", false, FYTTAF_CAN_BE_PLAIN | FYTTAF_HAS_WS, FYTTAF_HAS_LB },
+		{ "'quoted ---'", true, FYTTAF_CAN_BE_SINGLE_QUOTED | FYTTAF_DIRECT_OUTPUT, FYTTAF_QUOTE_AT_0 },
+		{ "\"\\ttab\"", false, FYTTAF_HAS_WS | FYTTAF_CAN_BE_DOUBLE_QUOTED, FYTTAF_CAN_BE_PLAIN },
+	};
+	struct fy_parser ctx, *fyp = &ctx;
+	const struct fy_parse_cfg *cfg = &default_parse_cfg;
+	struct fy_input_cfg fyic;
+	struct fy_token *fyt;
+	unsigned int i;
+	int rc, aflags;
+
+	for (i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+
+		memset(&fyic, 0, sizeof(fyic));
+		fyic.type = fyit_memory;
+		fyic.memory.data = cases[i].data;
+		fyic.memory.size = strlen(cases[i].data);
+
+		rc = fy_parse_setup(fyp, cfg);
+		ck_assert_int_eq(rc, 0);
+
+		rc = fy_parse_input_append(fyp, &fyic);
+		ck_assert_int_eq(rc, 0);
+
+		/* STREAM_START */
+		fyt = fy_scan(fyp);
+		ck_assert_ptr_ne(fyt, NULL);
+		ck_assert(fyt->type == FYTT_STREAM_START);
+		fy_token_unref(fyt);
+
+		/* SCALAR */
+		fyt = fy_scan(fyp);
+		ck_assert_ptr_ne(fyt, NULL);
+		ck_assert(fyt->type == FYTT_SCALAR);
+		ck_assert(fyt->handle.direct_output == cases[i].direct_output);
+
+		/* the analysis is the same whether done directly or cached */
+		aflags = fy_token_text_analyze(fyt);
+		ck_assert_int_eq(aflags & cases[i].set, cases[i].set);
+		ck_assert_int_eq(aflags & cases[i].clear, 0);
+		ck_assert_int_eq(fy_token_text_analyze(fyt), aflags);
+		fy_token_unref(fyt);
+
+		fy_parse_cleanup(fyp);
+	}
+}
+END_TEST
+
+START_TEST(emit_accum_pool)
+{
+	struct fy_emit_accum_stats before, after;
+	struct fy_emit_accum ea;
+	char buf[1000], *big;
+	int rc;
+
+	memset(buf, 'x', sizeof(buf));
+
+	fy_emit_accum_get_stats(&before);
+
+	/* a store outgrowing the inplace buffer is pooled on cleanup */
+	fy_emit_accum_init(&ea, NULL, 0, 0, fylb_cr_nl);
+	rc = fy_emit_accum_utf8_write_raw(&ea, buf, sizeof(buf));
+	ck_assert_int_eq(rc, 0);
+	fy_emit_accum_cleanup(&ea);
+
+	fy_emit_accum_get_stats(&after);
+	ck_assert_int_eq(after.pool_misses, before.pool_misses + 1);
+	ck_assert_int_eq(after.pooled, before.pooled + 1);
+
+	/* and reused without an allocation by the next one */
+	fy_emit_accum_init(&ea, NULL, 0, 0, fylb_cr_nl);
+	rc = fy_emit_accum_utf8_write_raw(&ea, buf, sizeof(buf) / 2);
+	ck_assert_int_eq(rc, 0);
+	ck_assert_int_ge(ea.alloc, sizeof(buf));
+
+	fy_emit_accum_get_stats(&before);
+	ck_assert_int_eq(before.pool_hits, after.pool_hits + 1);
+	ck_assert_int_eq(before.grows, after.grows);
+	ck_assert_int_eq(before.pooled, after.pooled - 1);
+
+	/* growing further reallocates */
+	rc = fy_emit_accum_utf8_write_raw(&ea, buf, sizeof(buf));
+	ck_assert_int_eq(rc, 0);
+	fy_emit_accum_get_stats(&after);
+	ck_assert_int_eq(after.grows, before.grows + 1);
+	fy_emit_accum_cleanup(&ea);
+
+	/* huge stores are not pooled */
+	big = malloc(FY_EMIT_ACCUM_POOL_MAX_SIZE * 2);
+	ck_assert_ptr_ne(big, NULL);
+	fy_emit_accum_get_stats(&before);
+	ck_assert(!fy_emit_accum_pool_put(big, FY_EMIT_ACCUM_POOL_MAX_SIZE * 2));
+	free(big);
+	fy_emit_accum_get_stats(&after);
+	ck_assert_int_eq(after.trims, before.trims + 1);
+	ck_assert_int_eq(after.pooled, before.pooled);
+
+	/* a large store is trimmed when it's no longer needed */
+	big = malloc(FY_EMIT_ACCUM_POOL_TRIM_MIN * 2);
+	ck_assert_ptr_ne(big, NULL);
+	ck_assert(fy_emit_accum_pool_put(big, FY_EMIT_ACCUM_POOL_TRIM_MIN * 2));
+	fy_emit_accum_get_stats(&before);
+	fy_emit_accum_pool_trim();
+	fy_emit_accum_get_stats(&after);
+	ck_assert_int_eq(after.trims, before.trims + 1);
+	ck_assert_int_eq(after.pooled, before.pooled - 1);
+	ck_assert_int_eq(after.pooled_size, before.pooled_size - FY_EMIT_ACCUM_POOL_TRIM_MIN * 2);
+
+	/* releasing the thread's pool frees all the pooled stores */
+	big = malloc(4096);
+	ck_assert_ptr_ne(big, NULL);
+	ck_assert(fy_emit_accum_pool_put(big, 4096));
+	fy_emit_accum_pool_release_thread();
+	fy_emit_accum_get_stats(&after);
+	ck_assert_int_eq(after.pooled, 0);
+	ck_assert_int_eq(after.pooled_size, 0);
+
+	/* and the pool is still usable afterwards */
+	big = malloc(4096);
+	ck_assert_ptr_ne(big, NULL);
+	ck_assert(fy_emit_accum_pool_put(big, 4096));
+	fy_emit_accum_get_stats(&after);
+	ck_assert_int_eq(after.pooled, 1);
+	fy_emit_accum_pool_release_thread();
+}
+END_TEST
+
+START_TEST(token_cmp_sort_order)
+{
+	struct fy_document *fyd;
+	struct fy_node *fyn;
+	struct fy_node_pair *fynp, *fynp_prev;
+	void *iter;
+
+	/* prefix keys, with and without direct output (trailing spaces, escapes) */
+	fyd = fy_document_build_from_string(NULL,
+			"a-b  : 1\n"
+			"a: 2\n"
+			"\"beta\\t\": 3\n"
+			"beta: 4\n"
+			"'beta  ': 5\n"
+			"plain-simple  :  x\n"
+			"plain: y\n", FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+	fyn = fy_document_root(fyd);
+
+	/* the default sort and the token comparison must agree */
+	ck_assert_int_eq(fy_node_sort(fyn, NULL, NULL), 0);
+
+	fynp_prev = NULL;
+	iter = NULL;
+	while ((fynp = fy_node_mapping_iterate(fyn, &iter)) != NULL) {
+		if (fynp_prev) {
+			ck_assert_int_lt(fy_token_cmp(fynp_prev->key->scalar, fynp->key->scalar), 0);
+			ck_assert_int_gt(fy_token_cmp(fynp->key->scalar, fynp_prev->key->scalar), 0);
+		}
+		fynp_prev = fynp;
+	}
+
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+START_TEST(xxh3_known_answers)
+{
+	/* upstream xxHash v0.8 results, covering every length class */
+	static const struct {
+		size_t len;
+		unsigned long long hash;
+		unsigned long long hash_seeded;
+	} kat[] = {
+		{    0, 0x2d06800538d394c2ULL, 0x602b0e2cd6662c8bULL },
+		{    1, 0xdd02fbe6d2c66464ULL, 0x02c81ac06ca6090eULL },
+		{    3, 0xfa5d50cea89b057eULL, 0x64061fbb97c5cc4fULL },
+		{    4, 0x93db640eba2c608fULL, 0xec8951ffd9ae3bddULL },
+		{    8, 0x9ffc59ccc6c331d1ULL, 0x85cbb5296f4a5a8aULL },
+		{    9, 0x48290a7787c70703ULL, 0x95a018f9895b5572ULL },
+		{   16, 0x28dcf3b69367ebfaULL, 0x9888faa575763ef0ULL },
+		{   17, 0xe5cbc90df6ec394bULL, 0x6a0b1102ae0a51ecULL },
+		{  128, 0x67c3ed4a37f89c11ULL, 0x84820de408f16617ULL },
+		{  129, 0x50971e3b11474effULL, 0xffd32bfc2fb04c03ULL },
+		{  240, 0x0a0bf331bc9470cbULL, 0x7212fee65f963dffULL },
+		{  241, 0xd020fdcde3530fd2ULL, 0x7e63e8b287576e93ULL },
+		{ 1024, 0xadefdedbf2f4e6bfULL, 0x1e9fa5465095cdcaULL },
+		{ 1025, 0x5c46427bf629a9c1ULL, 0x01ab13b846cd3226ULL },
+		{ 2500, 0x64ab90bf556dc6f3ULL, 0x8bd1943ac37ef539ULL },
+	};
+	static const unsigned long long seed = 0x9e3779b97f4a7c15ULL;
+	static unsigned char buf[4096 + 1];
+	unsigned int gen, i;
+
+	for (i = 0, gen = 2654435761U; i < 4096; i++, gen *= 2246822519U)
+		buf[i] = gen >> 24;
+
+	for (i = 0; i < sizeof(kat)/sizeof(kat[0]); i++) {
+		ck_assert(XXH3_64bits(buf, kat[i].len) == kat[i].hash);
+		ck_assert(XXH3_64bits_withSeed(buf, kat[i].len, 0) == kat[i].hash);
+		ck_assert(XXH3_64bits_withSeed(buf, kat[i].len, seed) == kat[i].hash_seeded);
+	}
+
+	/* unaligned input */
+	memmove(buf + 1, buf, 4096);
+	for (i = 0; i < sizeof(kat)/sizeof(kat[0]); i++) {
+		ck_assert(XXH3_64bits(buf + 1, kat[i].len) == kat[i].hash);
+		ck_assert(XXH3_64bits_withSeed(buf + 1, kat[i].len, seed) == kat[i].hash_seeded);
+	}
+}
+END_TEST
+
+START_TEST(doc_accel_lookup)
+{
+	struct fy_document *fyd;
+	struct fy_node *fyn, *fyn_inner, *fyn_key, *fyn_value;
+	struct fy_node_pair *fynp;
+	char key[16];
+	int i, rc;
+
+	/* a document from the builder, the mappings have accelerators */
+	fyd = fy_document_build_from_string(NULL,
+			"k0: 0\n"
+			"k1: 1\n"
+			"outer: { inner: 2 }\n"
+			"k3: 3\n", FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+	ck_assert(fy_document_is_accelerated(fyd));
+
+	fyn = fy_document_root(fyd);
+	ck_assert_ptr_ne(fyn->xl, NULL);
+
+	/* the keys are found via the accelerator of their own mapping */
+	fyn_key = fy_node_create_scalar(fyd, "outer", FY_NT);
+	ck_assert_ptr_ne(fyn_key, NULL);
+	fynp = (struct fy_node_pair *)fy_accel_lookup(fyn->xl, fyn_key);
+	ck_assert_ptr_ne(fynp, NULL);
+	ck_assert_str_eq(fy_node_get_scalar0(fynp->key), "outer");
+
+	fyn_inner = fynp->value;
+	ck_assert_ptr_ne(fyn_inner->xl, NULL);
+	ck_assert_ptr_eq(fy_accel_lookup(fyn_inner->xl, fyn_key), NULL);
+	fy_node_free(fyn_key);
+
+	fyn_key = fy_node_create_scalar(fyd, "inner", FY_NT);
+	ck_assert_ptr_ne(fyn_key, NULL);
+	ck_assert_ptr_ne(fy_accel_lookup(fyn_inner->xl, fyn_key), NULL);
+	ck_assert_ptr_eq(fy_accel_lookup(fyn->xl, fyn_key), NULL);
+	fy_node_free(fyn_key);
+
+	fy_document_destroy(fyd);
+
+	/* an empty document is accelerated too */
+	fyd = fy_document_create(NULL);
+	ck_assert_ptr_ne(fyd, NULL);
+	ck_assert(fy_document_is_accelerated(fyd));
+
+	fyn = fy_node_create_mapping(fyd);
+	ck_assert_ptr_ne(fyn, NULL);
+	ck_assert_ptr_ne(fyn->xl, NULL);
+	rc = fy_document_set_root(fyd, fyn);
+	ck_assert_int_eq(rc, 0);
+
+	for (i = 0; i < 64; i++) {
+		snprintf(key, sizeof(key), "key-%d", i);
+		rc = fy_node_mapping_append(fyn,
+				fy_node_create_scalar_copy(fyd, key, FY_NT),
+				fy_node_buildf(fyd, "%d", i));
+		ck_assert_int_eq(rc, 0);
+	}
+
+	fyn_key = fy_node_create_scalar(fyd, "key-42", FY_NT);
+	ck_assert_ptr_ne(fyn_key, NULL);
+	fynp = (struct fy_node_pair *)fy_accel_lookup(fyn->xl, fyn_key);
+	ck_assert_ptr_ne(fynp, NULL);
+	ck_assert_str_eq(fy_node_get_scalar0(fynp->value), "42");
+	fy_node_free(fyn_key);
+
+	fy_document_destroy(fyd);
+
+	/* resolution drops the anchor accelerators, the mappings keep theirs */
+	fyd = fy_document_build_from_string(NULL,
+			"a: &x { b: 1 }\n"
+			"c: *x\n", FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+	rc = fy_document_resolve(fyd);
+	ck_assert_int_eq(rc, 0);
+	ck_assert_ptr_eq(fyd->axl, NULL);
+	ck_assert_ptr_eq(fyd->naxl, NULL);
+
+	fyn = fy_document_root(fyd);
+	fyn_value = fy_node_mapping_lookup_value_by_simple_key(fyn, "c", FY_NT);
+	ck_assert_ptr_ne(fyn_value, NULL);
+	ck_assert_str_eq(fy_node_get_scalar0(fy_node_by_path(fyn_value, "/b", FY_NT, FYNWF_DONT_FOLLOW)), "1");
+
+	/* freeing nodes after resolution must not touch the anchor accelerators */
+	fy_node_free(fy_node_mapping_remove_by_key(fyn, fy_node_create_scalar(fyd, "a", FY_NT)));
+	ck_assert_ptr_eq(fy_node_mapping_lookup_value_by_simple_key(fyn, "a", FY_NT), NULL);
+
+	fy_document_destroy(fyd);
+}
+END_TEST
+
+START_TEST(doc_digest_memo)
+{
+	struct fy_document *fyd;
+	struct fy_node *fyn, *fyn_scalar;
+	struct fy_node_digest_memo *memo;
+	uint8_t d[FY_NODE_DIGEST_LEN], dk[FY_NODE_DIGEST_LEN], dt[FY_NODE_DIGEST_LEN];
+	int i, rc;
+
+	fyd = fy_document_build_from_string(NULL, "{ b: [ 1, { c: d } ], a: x }", FY_NT);
+	ck_assert_ptr_ne(fyd, NULL);
+	fyn = fy_document_root(fyd);
+	fyn_scalar = fy_node_by_path(fyn, "/a", FY_NT, FYNWF_DONT_FOLLOW);
+	ck_assert_ptr_ne(fyn_scalar, NULL);
+
+	rc = fy_node_digest(fyn, 0, d);
+	ck_assert_int_eq(rc, 0);
+	memo = atomic_load(&fyn->digest);
+	ck_assert_ptr_ne(memo, NULL);
+	ck_assert(atomic_load(&memo->state) & FY_NODE_DIGEST_MEMO_VALID(0));
+	ck_assert(!(atomic_load(&memo->state) & FY_NODE_DIGEST_MEMO_VALID(1)));
+
+	/* the other key order goes in its own slot of the same memo */
+	rc = fy_node_digest(fyn, FYNDF_KEY_ORDER, dk);
+	ck_assert_int_eq(rc, 0);
+	ck_assert_ptr_eq(atomic_load(&fyn->digest), memo);
+	ck_assert(atomic_load(&memo->state) & FY_NODE_DIGEST_MEMO_VALID(1));
+
+	/* switching back and forth only reads the memo */
+	for (i = 0; i < 4; i++) {
+		rc = fy_node_digest(fyn, (i & 1) ? FYNDF_KEY_ORDER : 0, dt);
+		ck_assert_int_eq(rc, 0);
+		ck_assert(!memcmp(dt, (i & 1) ? dk : d, sizeof(dt)));
+		ck_assert_ptr_eq(atomic_load(&fyn->digest), memo);
+	}
+	ck_assert(!memcmp(memo->digest[0], d, sizeof(d)));
+	ck_assert(!memcmp(memo->digest[1], dk, sizeof(dk)));
+
+	/* a scalar digest is shared by both key orders */
+	memo = atomic_load(&fyn_scalar->digest);
+	ck_assert_ptr_ne(memo, NULL);
+	ck_assert(atomic_load(&memo->state) & FY_NODE_DIGEST_MEMO_VALID(0));
+	ck_assert(!(atomic_load(&memo->state) & FY_NODE_DIGEST_MEMO_VALID(1)));
+	rc = fy_node_digest(fyn_scalar, 0, d);
+	ck_assert_int_eq(rc, 0);
+	rc = fy_node_digest(fyn_scalar, FYNDF_KEY_ORDER, dk);
+	ck_assert_int_eq(rc, 0);
+	ck_assert(!memcmp(d, dk, sizeof(d)));
+
+	/* a change drops the memo of the node and its parents */
+	rc = fy_node_sequence_append(fy_node_by_path(fyn, "/b", FY_NT, FYNWF_DONT_FOLLOW),
+				     fy_node_create_scalar(fyd, "2", FY_NT));
+	ck_assert_int_eq(rc, 0);
+	ck_assert_ptr_eq(atomic_load(&fyn->digest), NULL);
+	rc = fy_node_digest(fyn, FYNDF_KEY_ORDER, dt);
+	ck_assert_int_eq(rc, 0);
+	ck_assert(memcmp(dt, dk, sizeof(dt)));
+
+	fy_document_destroy(fyd);
+}
+END_TEST
+
 TCase *libfyaml_case_private(void)
 {
 	TCase *tc;
@@ -161,6 +537,12 @@ TCase *libfyaml_case_private(void)
 	tcase_add_test(tc, parser_setup);
 	tcase_add_test(tc, scan_simple);
 	tcase_add_test(tc, parse_simple);
+	tcase_add_test(tc, scan_plain_analyze);
+	tcase_add_test(tc, emit_accum_pool);
+	tcase_add_test(tc, token_cmp_sort_order);
+	tcase_add_test(tc, xxh3_known_answers);
+	tcase_add_test(tc, doc_accel_lookup);
+	tcase_add_test(tc, doc_digest_memo);
 
 	return tc;
 }
@@ -51,8 +51,9 @@ internal enum Libfyaml {
     }
     defer { fy_diag_unref(diag) }
 
+    // Coalesce the emitter's many small writes so `output` is called once per chunk
     var cfg = fy_emitter_cfg(
-      flags: flags,
+      flags: flags | FYECF_OUTPUT_BUFFERED,
       output: output,
       userdata: UnsafeMutableRawPointer(mutating: writer),
       diag: diag